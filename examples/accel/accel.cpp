@@ -168,15 +168,13 @@ void Accel::Run(void)
             }
         }
 
-        this->coord.x = xyz[0];
-        this->coord.y = xyz[1];
-        this->coord.z = xyz[2];
+        this->coord.Write({xyz[0], xyz[1], xyz[2]});
 
     #   if CONFIG_ACCEL_DEBUG
         printk("x: %d, y: %d, z: %d\n",
-            static_cast<int>(coord.x),
-            static_cast<int>(coord.y),
-            static_cast<int>(coord.z)
+            static_cast<int>(xyz[0]),
+            static_cast<int>(xyz[1]),
+            static_cast<int>(xyz[2])
         );
     #   endif
     }
@@ -196,11 +194,13 @@ void Accel::Display(Dashboard::Window &window)
     printk("In Accel::Display\n");
 #   endif
 
+    Coordinates coord = this->coord.Read();
+
     window.Print("+---------------+\n");
     window.Print("| Accelerometer |\n");
-    window.Print("|    x:%4d     |\n", static_cast<int8_t>(this->coord.x));
-    window.Print("|    y:%4d     |\n", static_cast<int8_t>(this->coord.y));
-    window.Print("|    z:%4d     |\n", static_cast<int8_t>(this->coord.z));
+    window.Print("|    x:%4d     |\n", static_cast<int8_t>(coord.x));
+    window.Print("|    y:%4d     |\n", static_cast<int8_t>(coord.y));
+    window.Print("|    z:%4d     |\n", static_cast<int8_t>(coord.z));
     window.Print("+---------------+\n");
 
 #   if CONFIG_ACCEL_DEBUG
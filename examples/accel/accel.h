@@ -19,13 +19,14 @@
  */
 #pragma once
 
-#include <atomic>
 #include <cstddef>
+#include <cstdint>
 
 #include <device.h>
 #include <kernel.h>
 
 #include "examples/dashboard/dashboard.h"
+#include "examples/utils.h"
 
 namespace NimbeLink::Examples
 {
@@ -53,24 +54,19 @@ class NimbeLink::Examples::Accel : public Dashboard::Element
         // Our I2C device
         struct device *i2cDevice = nullptr;
 
-        // Array to store xyz acceleration values
-        //
-        // Achieves thread safety with atomic values instead of mutexes.
+        // Struct to store xyz acceleration values
         struct Coordinates
         {
-            std::atomic<uint8_t> x = 0;
-            std::atomic<uint8_t> y = 0;
-            std::atomic<uint8_t> z = 0;
-        } coord;
+            uint8_t x;
+            uint8_t y;
+            uint8_t z;
+        };
 
-        // Assertions to check if the values are actually atomic operations and
-        // not using locks
+        // Our latest acceleration values
         //
-        // Another option is to use normal data types (uint8_t, int, etc.) and
-        // mutexes.
-        static_assert(decltype(coord.x)::is_always_lock_free, "Atomic variables x isn't lock-free!");
-        static_assert(decltype(coord.y)::is_always_lock_free, "Atomic variables y isn't lock-free!");
-        static_assert(decltype(coord.z)::is_always_lock_free, "Atomic variables z isn't lock-free!");
+        // Achieves thread safety without mutexes, and all three values are
+        // always from the same sample.
+        Utils::SeqLock<Coordinates> coord{{0, 0, 0}};
 
     private:
         static void Handler(void *arg1, void *arg2, void *arg3);
@@ -0,0 +1,774 @@
+/**
+ * \file
+ *
+ * \brief A shared worker that runs AT commands for every widget
+ *
+ *  Commands are queued by priority and run one at a time from a single
+ *  thread, which keeps them in order and keeps response buffers off of each
+ *  widget's stack. Identical queries that are waiting or running at the same
+ *  time share a single run, and a few slow-changing queries are answered from
+ *  a cache for a while after they've run.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <kernel.h>
+
+#if CONFIG_AT_SERVICE_CACHE
+#   include <at_cmd.h>
+#   include <at_notif.h>
+#endif
+
+#include "examples/at/at_service.h"
+#include "examples/utils.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Zephyr thread handler
+ *
+ * \param *arg1
+ *      A pointer to our AT service object
+ * \param *arg2
+ *      Unused
+ * \param *arg3
+ *      Unused
+ *
+ * \return none
+ */
+void AtService::Handler(void *arg1, void *arg2, void *arg3)
+{
+    (void)arg2;
+    (void)arg3;
+
+    AtService *service = static_cast<AtService *>(arg1);
+
+    if (service == nullptr)
+    {
+        return;
+    }
+
+    service->Run();
+}
+
+/**
+ * \brief Creates a new AT service
+ *
+ * \param none
+ *
+ * \return none
+ */
+AtService::AtService(void)
+{
+    k_mutex_init(&this->lock);
+    k_sem_init(&this->queued, 0, CONFIG_AT_SERVICE_QUEUE_DEPTH);
+
+    // Run ahead of the widgets, which are all waiting on us whenever we have
+    // something to do
+    this->threadId = k_thread_create(
+        &this->thread,
+        this->stack,
+        std::size(this->stack),
+        AtService::Handler,
+        static_cast<void *>(this),
+        nullptr,
+        nullptr,
+        K_LOWEST_APPLICATION_THREAD_PRIO - 1,
+        0,
+        0
+    );
+}
+
+/**
+ * \brief Gets if a command only asks for something, which makes it safe to
+ *        share a single run of it
+ *
+ *  Read commands ("AT+CFUN?"), test commands ("AT+CFUN=?") and commands
+ *  without parameters ("AT+CESQ") are queries, while anything that sets a
+ *  value ("AT+CFUN=1") is not.
+ *
+ * \param command
+ *      The command
+ *
+ * \return bool
+ *      Whether or not the command is a query
+ */
+bool AtService::IsQuery(std::string_view command)
+{
+    return ((command.find('=') == std::string_view::npos) || (command.back() == '?'));
+}
+
+/**
+ * \brief Finds a request for a command that's waiting or running
+ *
+ *  Must be called with our lock held.
+ *
+ * \param command
+ *      The command
+ *
+ * \return nullptr
+ *      The command isn't waiting or running
+ * \return Request *
+ *      The request
+ */
+AtService::Request *AtService::Find(std::string_view command)
+{
+    for (Request &request : this->requests)
+    {
+        if (request.used && (std::string_view(request.command, request.length) == command))
+        {
+            return &request;
+        }
+    }
+
+    return nullptr;
+}
+
+#if CONFIG_AT_SERVICE_CACHE
+/**
+ * \brief AT notification handler
+ *
+ * \param *context
+ *      A pointer to our AT service object
+ * \param *notification
+ *      The notification
+ *
+ * \return none
+ */
+void AtService::NotificationHandler(void *context, const char *notification)
+{
+    AtService *service = static_cast<AtService *>(context);
+
+    if ((service == nullptr) || (notification == nullptr))
+    {
+        return;
+    }
+
+    service->Notify(notification);
+}
+
+/**
+ * \brief Finds a command that can be answered from the cache
+ *
+ * \param command
+ *      The command
+ *
+ * \return -1
+ *      The command isn't cached
+ * \return int
+ *      The command's cache entry
+ */
+int AtService::FindCacheable(std::string_view command)
+{
+    for (std::size_t i = 0; i < std::size(AtService::Cacheables); i++)
+    {
+        if (AtService::Cacheables[i].command == command)
+        {
+            return static_cast<int>(i);
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * \brief Answers a command from the cache, if it's there and fresh
+ *
+ *  Must be called with our lock held, which stays held while the callback
+ *  runs so the response can't be replaced out from under it.
+ *
+ * \param index
+ *      The command's cache entry
+ * \param callback
+ *      What to call with the response
+ * \param *context
+ *      What to pass to the callback
+ *
+ * \return bool
+ *      Whether or not the command was answered
+ */
+bool AtService::Lookup(int index, Callback callback, void *context)
+{
+    const Cached &cached = this->cached[index];
+
+    if (!cached.valid || (k_uptime_get() >= cached.expires))
+    {
+        this->cacheStats.misses++;
+
+        return false;
+    }
+
+    this->cacheStats.hits++;
+
+    Response response = {};
+
+    response.text = std::string_view(cached.text, cached.length);
+
+    callback(context, response);
+
+    return true;
+}
+
+/**
+ * \brief Keeps a command's response in the cache
+ *
+ *  Must be called with our lock held. Failed and cut short responses aren't
+ *  kept, and neither is a response if the entry was thrown out while the
+ *  command was running, since the response may be from before the change. A
+ *  response that a notification would throw out is only kept if we'll hear
+ *  that notification, as otherwise nothing would tell us it's gone stale.
+ *
+ * \param index
+ *      The command's cache entry
+ * \param generation
+ *      The entry's generation when the command started running
+ * \param &response
+ *      The response
+ *
+ * \return none
+ */
+void AtService::Store(int index, uint32_t generation, const Response &response)
+{
+    Cached &cached = this->cached[index];
+
+    if (!response.Succeeded() ||
+        (!AtService::Cacheables[index].changedBy.empty() && !cached.watched) ||
+        response.truncated ||
+        (std::size(response.text) > sizeof(cached.text)) ||
+        (cached.generation != generation))
+    {
+        return;
+    }
+
+    response.text.copy(cached.text, std::size(response.text));
+
+    cached.length = static_cast<uint8_t>(std::size(response.text));
+    cached.expires = k_uptime_get() + AtService::Cacheables[index].ttl;
+    cached.valid = true;
+}
+
+/**
+ * \brief Throws out a command's cached response
+ *
+ *  Must be called with our lock held.
+ *
+ * \param index
+ *      The command's cache entry
+ *
+ * \return none
+ */
+void AtService::Invalidate(int index)
+{
+    Cached &cached = this->cached[index];
+
+    if (cached.valid)
+    {
+        this->cacheStats.invalidations++;
+    }
+
+    cached.valid = false;
+    cached.generation++;
+}
+
+/**
+ * \brief Notes whether a command that succeeded turned a notification we
+ *        rely on on or off
+ *
+ *  Must be called with our lock held. Any nonzero mode counts as on.
+ *
+ * \param command
+ *      The command
+ *
+ * \return none
+ */
+void AtService::Watch(std::string_view command)
+{
+    for (std::size_t i = 0; i < std::size(AtService::Cacheables); i++)
+    {
+        std::string_view reportedBy = AtService::Cacheables[i].reportedBy;
+
+        if (!reportedBy.empty() && (command.substr(0, std::size(reportedBy)) == reportedBy))
+        {
+            this->cached[i].watched = (this->notifying && (command.substr(std::size(reportedBy)) != "0"));
+        }
+    }
+}
+
+/**
+ * \brief Throws out any cached responses a notification says have changed
+ *
+ * \param notification
+ *      The notification
+ *
+ * \return none
+ */
+void AtService::Notify(std::string_view notification)
+{
+    std::string_view line;
+
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+    for (std::size_t i = 0; i < std::size(AtService::Cacheables); i++)
+    {
+        const Cacheable &cacheable = AtService::Cacheables[i];
+
+        if (!cacheable.changedBy.empty() && Utils::At::FindLine(notification, cacheable.changedBy, line))
+        {
+            this->Invalidate(static_cast<int>(i));
+        }
+    }
+
+    k_mutex_unlock(&this->lock);
+}
+
+/**
+ * \brief Gets how well the cache is doing
+ *
+ * \param none
+ *
+ * \return CacheStats
+ *      The cache's counters
+ */
+AtService::CacheStats AtService::GetCacheStats(void)
+{
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+    CacheStats stats = this->cacheStats;
+
+    k_mutex_unlock(&this->lock);
+
+    return stats;
+}
+#endif
+
+/**
+ * \brief Gets the next request to run
+ *
+ *  Must be called with our lock held.
+ *
+ * \param none
+ *
+ * \return nullptr
+ *      Nothing is waiting
+ * \return Request *
+ *      The waiting request with the highest priority, oldest first
+ */
+AtService::Request *AtService::Next(void)
+{
+    Request *next = nullptr;
+
+    for (Request &request : this->requests)
+    {
+        if (!request.used || request.running)
+        {
+            continue;
+        }
+
+        if ((next == nullptr) ||
+            (request.priority > next->priority) ||
+            ((request.priority == next->priority) && (static_cast<int32_t>(request.order - next->order) < 0)))
+        {
+            next = &request;
+        }
+    }
+
+    return next;
+}
+
+#if CONFIG_AT_SERVICE_METRICS
+/**
+ * \brief Gets the metrics for a command, making room for them if needed
+ *
+ *  Must be called with our lock held. Commands are told apart by as much of
+ *  them as fits in a metric's name.
+ *
+ * \param command
+ *      The command
+ *
+ * \return nullptr
+ *      There's no room for the command's metrics
+ * \return Metric *
+ *      The command's metrics
+ */
+AtService::Metric *AtService::GetMetric(std::string_view command)
+{
+    command = command.substr(0, sizeof(Metric::command) - 1);
+
+    for (Metric &metric : this->metrics)
+    {
+        if ((metric.command[0] != '\0') && (command == metric.command))
+        {
+            return &metric;
+        }
+    }
+
+    for (Metric &metric : this->metrics)
+    {
+        if (metric.command[0] == '\0')
+        {
+            command.copy(metric.command, std::size(command));
+            metric.command[std::size(command)] = '\0';
+
+            return &metric;
+        }
+    }
+
+    return nullptr;
+}
+#endif
+
+/**
+ * \brief Queues a command to run
+ *
+ *  If the same query is already waiting or running, the callback is added to
+ *  it instead, and gets the same response. The callback is called from our
+ *  thread, and may submit more commands.
+ *
+ *  A query with a fresh response in the cache is answered right away instead,
+ *  with the callback called from the submitter's thread before this returns,
+ *  unless the caller needs to hear from the modem itself.
+ *
+ * \param command
+ *      The command to run
+ * \param callback
+ *      What to call with the response
+ * \param *context
+ *      What to pass to the callback
+ * \param priority
+ *      How soon the command should run
+ * \param fresh
+ *      Whether or not the modem has to be asked, even if the response is
+ *      cached
+ *
+ * \return 0
+ *      The command was queued
+ * \return -1
+ *      The command is too long or the queue is full
+ */
+int AtService::Submit(std::string_view command, Callback callback, void *context, Priority priority, bool fresh)
+{
+    if (command.empty() || (std::size(command) >= MaxCommand) || (callback == nullptr))
+    {
+        return -1;
+    }
+
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+#   if CONFIG_AT_SERVICE_CACHE
+    int index = AtService::FindCacheable(command);
+
+    if ((index >= 0) && !fresh && this->Lookup(index, callback, context))
+    {
+        k_mutex_unlock(&this->lock);
+
+        return 0;
+    }
+#   endif
+
+    if (AtService::IsQuery(command))
+    {
+        Request *request = this->Find(command);
+
+        if ((request != nullptr) && (request->waiterCount < MaxWaiters))
+        {
+            request->waiters[request->waiterCount++] = {callback, context};
+
+            // A waiting request runs as soon as its most urgent caller needs
+            // it to
+            if (!request->running && (priority > request->priority))
+            {
+                request->priority = priority;
+            }
+
+        #   if CONFIG_AT_SERVICE_METRICS
+            Metric *metric = this->GetMetric(command);
+
+            if (metric != nullptr)
+            {
+                metric->coalesced++;
+            }
+        #   endif
+
+            k_mutex_unlock(&this->lock);
+
+            return 0;
+        }
+    }
+
+    Request *request = std::find_if(std::begin(this->requests), std::end(this->requests), [](const Request &request) {
+        return !request.used;
+    });
+
+    if (request == std::end(this->requests))
+    {
+        this->rejected++;
+
+        k_mutex_unlock(&this->lock);
+
+    #   if CONFIG_AT_SERVICE_DEBUG
+        printk("AT queue full, dropping ");
+        Utils::Print(command);
+        printk("\n");
+    #   endif
+
+        return -1;
+    }
+
+    command.copy(request->command, std::size(command));
+    request->command[std::size(command)] = '\0';
+    request->length = static_cast<uint8_t>(std::size(command));
+    request->priority = priority;
+    request->used = true;
+    request->running = false;
+    request->submitted = k_uptime_get();
+    request->order = this->submissions++;
+    request->waiters[0] = {callback, context};
+    request->waiterCount = 1;
+
+    k_mutex_unlock(&this->lock);
+
+    k_sem_give(&this->queued);
+
+    return 0;
+}
+
+/**
+ * \brief Runs a request and hands its response to everyone waiting on it
+ *
+ * \param &request
+ *      The request, which has been marked as running
+ *
+ * \return none
+ */
+void AtService::Process(Request &request)
+{
+    int64_t started = k_uptime_get();
+
+    Response response = {};
+    uint32_t actual = 0;
+
+#   if CONFIG_AT_SERVICE_CACHE
+    int index = AtService::FindCacheable(std::string_view(request.command, request.length));
+    uint32_t generation = 0;
+
+    if (index >= 0)
+    {
+        k_mutex_lock(&this->lock, K_FOREVER);
+
+        generation = this->cached[index].generation;
+
+        k_mutex_unlock(&this->lock);
+    }
+#   endif
+
+    response.ret = this->backend.Run(
+        &response.result,
+        &response.error,
+        request.command,
+        request.length,
+        this->response,
+        sizeof(this->response),
+        &actual
+    );
+
+    response.latency = static_cast<uint32_t>(k_uptime_get() - started);
+
+    // A response that filled the buffer may have been cut short
+    response.truncated = (actual >= sizeof(this->response));
+
+    this->response[sizeof(this->response) - 1] = '\0';
+
+    if (response.ret == 0)
+    {
+        response.text = std::string_view(this->response, strnlen(this->response, sizeof(this->response)));
+    }
+
+#   if CONFIG_AT_SERVICE_DEBUG
+    printk("%s took %u ms\n", request.command, static_cast<unsigned int>(response.latency));
+
+    if (response.truncated)
+    {
+        printk("%s response truncated\n", request.command);
+    }
+#   endif
+
+    // Let go of the request before calling anyone back, so they can submit
+    // more, and so anyone who asks for the same thing from here on gets a
+    // fresh run
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+    Waiter waiters[MaxWaiters];
+    std::size_t count = request.waiterCount;
+
+    std::copy_n(request.waiters, count, waiters);
+
+#   if CONFIG_AT_SERVICE_CACHE
+    if (index >= 0)
+    {
+        this->Store(index, generation, response);
+    }
+    else if (!AtService::IsQuery(std::string_view(request.command, request.length)))
+    {
+        // Anything that sets something may change what any of the cached
+        // queries would say, such as AT+CFUN=4 deregistering us
+        for (std::size_t i = 0; i < std::size(this->cached); i++)
+        {
+            this->Invalidate(static_cast<int>(i));
+        }
+
+        if (response.Succeeded())
+        {
+            this->Watch(std::string_view(request.command, request.length));
+        }
+    }
+#   endif
+
+#   if CONFIG_AT_SERVICE_METRICS
+    Metric *metric = this->GetMetric(std::string_view(request.command, request.length));
+
+    if (metric != nullptr)
+    {
+        metric->runs++;
+        metric->totalWait += static_cast<uint32_t>(started - request.submitted);
+        metric->totalRun += response.latency;
+        metric->maxRun = std::max(metric->maxRun, response.latency);
+    }
+#   endif
+
+    request.used = false;
+    request.running = false;
+
+    k_mutex_unlock(&this->lock);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        waiters[i].callback(waiters[i].context, response);
+    }
+}
+
+#if CONFIG_AT_SERVICE_METRICS
+/**
+ * \brief Prints how each command has been doing
+ *
+ * \param none
+ *
+ * \return none
+ */
+void AtService::Print(void)
+{
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+    printk("AT commands (%u rejected):\n", static_cast<unsigned int>(this->rejected));
+
+#   if CONFIG_AT_SERVICE_CACHE
+    printk("  cache: %u hits, %u misses, %u invalidated\n",
+        static_cast<unsigned int>(this->cacheStats.hits),
+        static_cast<unsigned int>(this->cacheStats.misses),
+        static_cast<unsigned int>(this->cacheStats.invalidations)
+    );
+#   endif
+
+    for (const Metric &metric : this->metrics)
+    {
+        if (metric.runs == 0)
+        {
+            continue;
+        }
+
+        printk("  %-15s %u runs, %u shared, run avg %u ms max %u ms, wait avg %u ms\n",
+            metric.command,
+            static_cast<unsigned int>(metric.runs),
+            static_cast<unsigned int>(metric.coalesced),
+            static_cast<unsigned int>(metric.totalRun / metric.runs),
+            static_cast<unsigned int>(metric.maxRun),
+            static_cast<unsigned int>(metric.totalWait / metric.runs)
+        );
+    }
+
+    k_mutex_unlock(&this->lock);
+}
+#endif
+
+/**
+ * \brief Runs queued commands as they come in
+ *
+ * \param none
+ *
+ * \return none
+ */
+void AtService::Run(void)
+{
+#   if CONFIG_AT_SERVICE_CACHE
+    // Notifications let us throw out cached responses as soon as they change,
+    // rather than waiting for them to expire, and anything only they'd tell
+    // us about isn't cached without them; these are fine to call more than
+    // once, such as when the widgets set them up too
+    int err = at_cmd_init();
+
+    if (!err)
+    {
+        err = at_notif_init();
+    }
+
+    if (!err)
+    {
+        err = at_notif_register_handler(this, AtService::NotificationHandler);
+    }
+
+    k_mutex_lock(&this->lock, K_FOREVER);
+
+    this->notifying = !err;
+
+    k_mutex_unlock(&this->lock);
+
+#   if CONFIG_AT_SERVICE_DEBUG
+    if (err)
+    {
+        printk("Failed to set up AT notifications, registration queries won't be cached, err %d\n", err);
+    }
+#   endif
+#   endif
+
+    while (true)
+    {
+        k_sem_take(&this->queued, K_FOREVER);
+
+        k_mutex_lock(&this->lock, K_FOREVER);
+
+        Request *request = this->Next();
+
+        if (request != nullptr)
+        {
+            request->running = true;
+        }
+
+        k_mutex_unlock(&this->lock);
+
+        if (request == nullptr)
+        {
+            continue;
+        }
+
+        this->Process(*request);
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        if (k_uptime_get() >= this->nextPrint)
+        {
+            this->Print();
+
+            this->nextPrint = k_uptime_get() + K_SECONDS(CONFIG_AT_SERVICE_METRICS_RATE);
+        }
+    #   endif
+    }
+}
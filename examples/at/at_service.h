@@ -0,0 +1,344 @@
+/**
+ * \file
+ *
+ * \brief A shared worker that runs AT commands for every widget
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/backend.h"
+#include "nimbelink/sdk/secure_services/at.h"
+
+#if CONFIG_AT_BACKEND_RECORD
+#include "examples/at/recorder.h"
+#endif
+
+#if CONFIG_AT_BACKEND_REPLAY
+#include "examples/at/replay.h"
+#include CONFIG_AT_BACKEND_REPLAY_TRANSCRIPT
+#endif
+
+namespace NimbeLink::Examples
+{
+    class AtService;
+}
+
+class NimbeLink::Examples::AtService
+{
+    public:
+        /**
+         * \brief How soon a command should run, relative to others waiting
+         */
+        enum class Priority : uint8_t
+        {
+            Low,
+            Normal,
+            High,
+        };
+
+        /**
+         * \brief The outcome of a command
+         *
+         *  The text points into the worker's buffer, so it's only good until
+         *  the callback it was given to returns.
+         */
+        struct Response
+        {
+            // What running the command returned, which is 0 if the modem
+            // processed it
+            int32_t ret;
+
+            // What the modem said about it, which is 0 for OK
+            NimbeLink::Sdk::SecureServices::At::Result result;
+            NimbeLink::Sdk::SecureServices::At::Error error;
+
+            std::string_view text;
+
+            // Whether or not the response didn't fit in the worker's buffer
+            bool truncated;
+
+            // How long the modem took to respond, in milliseconds
+            uint32_t latency;
+
+            /**
+             * \brief Gets if the command succeeded
+             *
+             * \param none
+             *
+             * \return bool
+             *      Whether or not the modem processed the command and said OK
+             */
+            bool Succeeded(void) const
+            {
+                return ((this->ret == 0) && (this->result == 0));
+            }
+        };
+
+        // What's called with a command's response, from the worker's thread
+        using Callback = void (*)(void *context, const Response &response);
+
+        // The longest command that can be submitted
+        static constexpr const std::size_t MaxCommand = 32;
+
+        // The most callers that can share a single run of a command
+        static constexpr const std::size_t MaxWaiters = 4;
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        // The most different commands we keep latencies for
+        static constexpr const std::size_t MaxMetrics = 8;
+    #   endif
+
+    #   if CONFIG_AT_SERVICE_CACHE
+        // The longest response we'll keep in the cache
+        static constexpr const std::size_t MaxCached = 64;
+
+        /**
+         * \brief How well the cache is doing
+         */
+        struct CacheStats
+        {
+            uint32_t hits;
+            uint32_t misses;
+            uint32_t invalidations;
+        };
+    #   endif
+
+    private:
+        // Someone waiting on a command's response
+        struct Waiter
+        {
+            Callback callback;
+            void *context;
+        };
+
+        // A command waiting to run, or running
+        struct Request
+        {
+            char command[MaxCommand];
+            uint8_t length;
+            Priority priority;
+            bool used;
+            bool running;
+
+            // When this was submitted and what order it came in, which
+            // breaks ties between requests with the same priority
+            int64_t submitted;
+            uint32_t order;
+
+            Waiter waiters[MaxWaiters];
+            uint8_t waiterCount;
+        };
+
+    #   if CONFIG_AT_SERVICE_CACHE
+        // A query that changes slowly enough that its response can be
+        // reused for a while, along with the notification that means it's
+        // changed and the command that turns that notification on, if there
+        // is one
+        struct Cacheable
+        {
+            std::string_view command;
+            int32_t ttl;
+            std::string_view changedBy;
+            std::string_view reportedBy;
+        };
+
+        static constexpr const Cacheable Cacheables[] = {
+            {"AT+CFUN?",        K_SECONDS(CONFIG_AT_SERVICE_CACHE_CFUN_TTL),        {},         {}},
+            {"AT+CEREG?",       K_SECONDS(CONFIG_AT_SERVICE_CACHE_CEREG_TTL),       "+CEREG:",  "AT+CEREG="},
+            {"AT+COPS?",        K_SECONDS(CONFIG_AT_SERVICE_CACHE_COPS_TTL),        "+CEREG:",  "AT+CEREG="},
+            {"AT#SIMSELECT?",   K_SECONDS(CONFIG_AT_SERVICE_CACHE_SIMSELECT_TTL),   {},         {}},
+        };
+
+        // A kept response
+        //
+        // The generation changes whenever the response is thrown out, so a
+        // run that started before then doesn't get kept. A response that's
+        // thrown out by a notification is only kept while we'd hear that
+        // notification, which is once it's been turned on through us.
+        struct Cached
+        {
+            bool valid;
+            bool watched;
+            uint32_t generation;
+            int64_t expires;
+            uint8_t length;
+            char text[MaxCached];
+        };
+    #   endif
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        // How a command has been doing, in milliseconds
+        struct Metric
+        {
+            char command[16];
+            uint32_t runs;
+            uint32_t coalesced;
+            uint32_t totalWait;
+            uint32_t totalRun;
+            uint32_t maxRun;
+        };
+    #   endif
+
+        // Our Zephyr stack
+        //
+        // C++ isn't a big fan of placing a class' member in a section, so
+        // we'll reproduce what the Zephyr library does when someone uses
+        // K_THREAD_STACK_DEFINE().
+        //
+        // Callbacks run on this stack, so it needs room for parsing
+        // responses.
+        __attribute__((aligned(STACK_ALIGN))) struct _k_thread_stack_element stack[1536 + MPU_GUARD_ALIGN_AND_SIZE];
+
+        // Our Zephyr thread
+        struct k_thread thread;
+
+        // Our thread's ID
+        k_tid_t threadId;
+
+        // How our commands get answered
+    #   if CONFIG_AT_BACKEND_REPLAY
+        AtReplay backend{AtTranscript::Exchanges, CONFIG_AT_BACKEND_REPLAY_SCALE};
+    #   elif CONFIG_AT_BACKEND_RECORD
+        SecureAtBackend modem;
+        AtRecorder backend{this->modem};
+    #   else
+        SecureAtBackend backend;
+    #   endif
+
+        // Guards our requests and metrics
+        struct k_mutex lock;
+
+        // Counts the requests waiting to run
+        struct k_sem queued;
+
+        Request requests[CONFIG_AT_SERVICE_QUEUE_DEPTH] = {};
+        uint32_t submissions = 0;
+
+        // Responses are read here rather than on each caller's stack
+        char response[CONFIG_AT_SERVICE_RESPONSE_SIZE];
+
+        // How many requests were turned away because the queue was full
+        uint32_t rejected = 0;
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        Metric metrics[MaxMetrics] = {};
+        int64_t nextPrint = 0;
+    #   endif
+
+    #   if CONFIG_AT_SERVICE_CACHE
+        Cached cached[std::size(Cacheables)] = {};
+        CacheStats cacheStats = {};
+
+        // Whether or not notifications are coming to us
+        bool notifying = false;
+    #   endif
+
+    private:
+        static void Handler(void *arg1, void *arg2, void *arg3);
+
+    #   if CONFIG_AT_SERVICE_CACHE
+        static void NotificationHandler(void *context, const char *notification);
+
+        static int FindCacheable(std::string_view command);
+
+        bool Lookup(int index, Callback callback, void *context);
+        void Store(int index, uint32_t generation, const Response &response);
+        void Invalidate(int index);
+        void Watch(std::string_view command);
+        void Notify(std::string_view notification);
+    #   endif
+
+        static bool IsQuery(std::string_view command);
+
+        Request *Find(std::string_view command);
+        Request *Next(void);
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        Metric *GetMetric(std::string_view command);
+    #   endif
+
+        void Process(Request &request);
+
+        void Run(void);
+
+    public:
+        AtService(void);
+
+        int Submit(std::string_view command, Callback callback, void *context, Priority priority = Priority::Normal, bool fresh = false);
+
+        /**
+         * \brief Runs a command and waits for its response
+         *
+         *  The receiver is called with the response from the worker's thread,
+         *  while we wait, so it can fill in anything on our stack without
+         *  needing a buffer for the whole response. This can't be called
+         *  from a callback, as the worker would be waiting on itself.
+         *
+         * \param command
+         *      The command to run
+         * \param &&receiver
+         *      What to call with the response
+         * \param priority
+         *      How soon the command should run
+         * \param fresh
+         *      Whether or not the modem has to be asked, even if the
+         *      response is cached
+         *
+         * \return 0
+         *      The command succeeded
+         * \return -1
+         *      The command couldn't be queued, wasn't processed or failed
+         */
+        template <typename Receiver>
+        int Execute(std::string_view command, Receiver &&receiver, Priority priority = Priority::Normal, bool fresh = false)
+        {
+            struct Call
+            {
+                Receiver &receiver;
+                struct k_sem done;
+                int status;
+            } call = {receiver, {}, -1};
+
+            k_sem_init(&call.done, 0, 1);
+
+            auto callback = [](void *context, const Response &response) {
+                Call *call = static_cast<Call *>(context);
+
+                call->status = response.Succeeded() ? 0 : -1;
+                call->receiver(response);
+
+                k_sem_give(&call->done);
+            };
+
+            if (this->Submit(command, callback, &call, priority, fresh) != 0)
+            {
+                return -1;
+            }
+
+            k_sem_take(&call.done, K_FOREVER);
+
+            return call.status;
+        }
+
+    #   if CONFIG_AT_SERVICE_CACHE
+        CacheStats GetCacheStats(void);
+    #   endif
+
+    #   if CONFIG_AT_SERVICE_METRICS
+        void Print(void);
+    #   endif
+};
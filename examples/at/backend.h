@@ -0,0 +1,84 @@
+/**
+ * \file
+ *
+ * \brief The interface the AT service runs commands through
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "nimbelink/sdk/secure_services/at.h"
+
+namespace NimbeLink::Examples
+{
+    class AtBackend;
+    class SecureAtBackend;
+}
+
+// Interface class for the ways the AT service can get commands answered
+//
+// This takes the same arguments as the secure AT service, so the modem can be
+// swapped out for something that runs off of the device. Backends are only
+// ever called from the AT service's thread, one command at a time.
+class NimbeLink::Examples::AtBackend
+{
+    public:
+        virtual int32_t Run(
+            NimbeLink::Sdk::SecureServices::At::Result *result,
+            NimbeLink::Sdk::SecureServices::At::Error *error,
+            const char *command,
+            uint32_t length,
+            char *response,
+            uint32_t size,
+            uint32_t *actual
+        ) = 0;
+};
+
+// Runs commands on the modem, through the secure AT service
+class NimbeLink::Examples::SecureAtBackend : public AtBackend
+{
+    public:
+        /**
+         * \brief Runs a command on the modem
+         *
+         * \param *result
+         *      Where to store the command's result
+         * \param *error
+         *      Where to store the command's error, if it failed
+         * \param *command
+         *      The command
+         * \param length
+         *      The length of the command
+         * \param *response
+         *      Where to store the command's response
+         * \param size
+         *      The size of the response buffer
+         * \param *actual
+         *      Where to store the length of the response
+         *
+         * \return 0
+         *      The modem processed the command
+         * \return !0
+         *      The command couldn't be run
+         */
+        int32_t Run(
+            NimbeLink::Sdk::SecureServices::At::Result *result,
+            NimbeLink::Sdk::SecureServices::At::Error *error,
+            const char *command,
+            uint32_t length,
+            char *response,
+            uint32_t size,
+            uint32_t *actual
+        ) override
+        {
+            return NimbeLink::Sdk::SecureServices::At::RunCommand(result, error, command, length, response, size, actual);
+        }
+};
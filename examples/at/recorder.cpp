@@ -0,0 +1,151 @@
+/**
+ * \file
+ *
+ * \brief Records the AT commands another backend runs
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/recorder.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Prints text in quotes, escaping anything that would break up a
+ *        transcript line
+ *
+ * \param text
+ *      The text to print
+ *
+ * \return none
+ */
+void AtRecorder::PrintEscaped(std::string_view text)
+{
+    static constexpr const char Hex[] = "0123456789abcdef";
+
+    // Escaped text is printed in chunks rather than a character at a time,
+    // leaving room for the longest escape and a terminator at the end of each
+    char chunk[64];
+    std::size_t used = 0;
+
+    printk("\"");
+
+    for (char c : text)
+    {
+        uint8_t byte = static_cast<uint8_t>(c);
+
+        if (byte == '\r')
+        {
+            chunk[used++] = '\\';
+            chunk[used++] = 'r';
+        }
+        else if (byte == '\n')
+        {
+            chunk[used++] = '\\';
+            chunk[used++] = 'n';
+        }
+        else if ((byte == '"') || (byte == '\\'))
+        {
+            chunk[used++] = '\\';
+            chunk[used++] = c;
+        }
+        else if ((byte < ' ') || (byte > '~'))
+        {
+            chunk[used++] = '\\';
+            chunk[used++] = 'x';
+            chunk[used++] = Hex[byte >> 4];
+            chunk[used++] = Hex[byte & 0x0F];
+        }
+        else
+        {
+            chunk[used++] = c;
+        }
+
+        if (used > (sizeof(chunk) - 6))
+        {
+            chunk[used] = '\0';
+
+            printk("%s", chunk);
+
+            used = 0;
+        }
+    }
+
+    chunk[used] = '\0';
+
+    printk("%s\"", chunk);
+}
+
+/**
+ * \brief Runs a command on our backend and prints the exchange
+ *
+ * \param *result
+ *      Where to store the command's result
+ * \param *error
+ *      Where to store the command's error, if it failed
+ * \param *command
+ *      The command
+ * \param length
+ *      The length of the command
+ * \param *response
+ *      Where to store the command's response
+ * \param size
+ *      The size of the response buffer
+ * \param *actual
+ *      Where to store the length of the response
+ *
+ * \return int32_t
+ *      What our backend returned
+ */
+int32_t AtRecorder::Run(
+    NimbeLink::Sdk::SecureServices::At::Result *result,
+    NimbeLink::Sdk::SecureServices::At::Error *error,
+    const char *command,
+    uint32_t length,
+    char *response,
+    uint32_t size,
+    uint32_t *actual
+)
+{
+    int64_t started = k_uptime_get();
+
+    int32_t ret = this->backend.Run(result, error, command, length, response, size, actual);
+
+    uint32_t latency = static_cast<uint32_t>(k_uptime_get() - started);
+
+    // Only what made it into the buffer can be recorded
+    std::string_view text;
+
+    if ((ret == 0) && (size > 0))
+    {
+        text = std::string_view(response, strnlen(response, size));
+    }
+
+    printk("@AT %u %d %d %d ",
+        static_cast<unsigned int>(latency),
+        static_cast<int>(ret),
+        static_cast<int>(*result),
+        static_cast<int>(error->cmeError)
+    );
+
+    AtRecorder::PrintEscaped(std::string_view(command, length));
+
+    printk(" ");
+
+    AtRecorder::PrintEscaped(text);
+
+    printk("\n");
+
+    return ret;
+}
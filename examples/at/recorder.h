@@ -0,0 +1,65 @@
+/**
+ * \file
+ *
+ * \brief Records the AT commands another backend runs
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "examples/at/backend.h"
+
+namespace NimbeLink::Examples
+{
+    class AtRecorder;
+}
+
+// Prints every command another backend runs, along with its response and how
+// long it took, as a transcript a replay can be built from
+//
+// Each exchange is printed on a single line:
+//
+//  @AT <latency> <ret> <result> <error> "<command>" "<response>"
+//
+// with the latency in milliseconds, and with quotes, backslashes and anything
+// unprintable in the command and response escaped.
+class NimbeLink::Examples::AtRecorder : public AtBackend
+{
+    private:
+        // The backend that actually runs commands
+        AtBackend &backend;
+
+    private:
+        static void PrintEscaped(std::string_view text);
+
+    public:
+        /**
+         * \brief Creates a new AT recorder
+         *
+         * \param &backend
+         *      The backend that runs commands
+         *
+         * \return none
+         */
+        constexpr AtRecorder(AtBackend &backend):
+            backend(backend) {}
+
+        int32_t Run(
+            NimbeLink::Sdk::SecureServices::At::Result *result,
+            NimbeLink::Sdk::SecureServices::At::Error *error,
+            const char *command,
+            uint32_t length,
+            char *response,
+            uint32_t size,
+            uint32_t *actual
+        ) override;
+};
@@ -0,0 +1,157 @@
+/**
+ * \file
+ *
+ * \brief Answers AT commands from a recorded transcript
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/replay.h"
+#include "examples/utils.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Gets where a command left off in the transcript
+ *
+ * \param command
+ *      The command, which must be in the transcript
+ *
+ * \return nullptr
+ *      The command doesn't have a place of its own
+ * \return Cursor *
+ *      The command's place
+ */
+AtReplay::Cursor *AtReplay::GetCursor(std::string_view command)
+{
+    for (Cursor &cursor : this->cursors)
+    {
+        if (cursor.command == command)
+        {
+            return &cursor;
+        }
+    }
+
+    for (Cursor &cursor : this->cursors)
+    {
+        if (cursor.command.empty())
+        {
+            return &cursor;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * \brief Answers a command with its next recorded response
+ *
+ * \param *result
+ *      Where to store the command's result
+ * \param *error
+ *      Where to store the command's error, if it failed
+ * \param *command
+ *      The command
+ * \param length
+ *      The length of the command
+ * \param *response
+ *      Where to store the command's response
+ * \param size
+ *      The size of the response buffer
+ * \param *actual
+ *      Where to store the length of the response
+ *
+ * \return -1
+ *      The command isn't in the transcript
+ * \return int32_t
+ *      What the command returned when it was recorded
+ */
+int32_t AtReplay::Run(
+    NimbeLink::Sdk::SecureServices::At::Result *result,
+    NimbeLink::Sdk::SecureServices::At::Error *error,
+    const char *command,
+    uint32_t length,
+    char *response,
+    uint32_t size,
+    uint32_t *actual
+)
+{
+    std::string_view wanted(command, length);
+
+    const Exchange *exchange = nullptr;
+
+    // Commands only get a place once they're found, so ones that aren't in
+    // the transcript don't use any up
+    Cursor *cursor = nullptr;
+
+    if (!wanted.empty())
+    {
+        cursor = this->GetCursor(wanted);
+    }
+
+    std::size_t start = ((cursor != nullptr) && !cursor->command.empty()) ? cursor->next : 0;
+
+    for (std::size_t i = 0; i < this->count; i++)
+    {
+        std::size_t index = (start + i) % this->count;
+
+        if (this->exchanges[index].command == wanted)
+        {
+            exchange = &this->exchanges[index];
+
+            break;
+        }
+    }
+
+    if ((exchange != nullptr) && (cursor != nullptr))
+    {
+        // The transcript's copy of the command outlives the caller's
+        cursor->command = exchange->command;
+        cursor->next = static_cast<std::size_t>(exchange - this->exchanges) + 1;
+    }
+
+    if (exchange == nullptr)
+    {
+    #   if CONFIG_AT_SERVICE_DEBUG
+        Utils::Print(wanted);
+        printk(" isn't in the AT transcript\n");
+    #   endif
+
+        return -1;
+    }
+
+    if (this->scale != 0)
+    {
+        k_sleep(static_cast<int32_t>((static_cast<uint64_t>(exchange->latency) * this->scale) / 100));
+    }
+
+    *result = exchange->result;
+    error->cmeError = exchange->error;
+
+    if (size > 0)
+    {
+        std::size_t copied = std::min(std::size(exchange->response), static_cast<std::size_t>(size - 1));
+
+        exchange->response.copy(response, copied);
+        response[copied] = '\0';
+    }
+
+    if (actual != nullptr)
+    {
+        *actual = static_cast<uint32_t>(std::size(exchange->response));
+    }
+
+    return exchange->ret;
+}
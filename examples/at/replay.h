@@ -0,0 +1,108 @@
+/**
+ * \file
+ *
+ * \brief Answers AT commands from a recorded transcript
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "examples/at/backend.h"
+
+namespace NimbeLink::Examples
+{
+    class AtReplay;
+}
+
+// Answers commands with the responses recorded by an AtRecorder, without a
+// modem, so the widgets can be run and timed the same way every time, such
+// as on native_posix
+//
+// Each command is answered by the next exchange in the transcript that has
+// the same command, starting from where that command's last one left off and
+// wrapping around at the end, so a polling loop can keep going past the end
+// of its recording. Every command keeps its own place, so commands that come
+// in a different order than they were recorded in still get their responses
+// in the order they were recorded.
+class NimbeLink::Examples::AtReplay : public AtBackend
+{
+    public:
+        /**
+         * \brief A recorded command and its response
+         */
+        struct Exchange
+        {
+            std::string_view command;
+
+            int32_t ret;
+            int32_t result;
+            int32_t error;
+
+            // How long the modem took, in milliseconds
+            uint32_t latency;
+
+            std::string_view response;
+        };
+
+        // The most different commands that keep their own place; any
+        // others start looking from the beginning every time
+        static constexpr const std::size_t MaxCommands = 16;
+
+    private:
+        // Where to start looking for a command's next exchange
+        struct Cursor
+        {
+            std::string_view command;
+            std::size_t next;
+        };
+
+        const Exchange *exchanges;
+        std::size_t count;
+
+        // How long to take for each exchange, as a percent of how long the
+        // modem took
+        uint32_t scale;
+
+        Cursor cursors[MaxCommands] = {};
+
+    private:
+        Cursor *GetCursor(std::string_view command);
+
+    public:
+        /**
+         * \brief Creates a new AT replay
+         *
+         * \param (&exchanges)[]
+         *      The transcript to replay
+         * \param scale
+         *      How long to take for each exchange, as a percent of how long the
+         *      modem took, with 0 answering right away
+         *
+         * \return none
+         */
+        template <std::size_t Count>
+        constexpr AtReplay(const Exchange (&exchanges)[Count], uint32_t scale):
+            exchanges(exchanges),
+            count(Count),
+            scale(scale) {}
+
+        int32_t Run(
+            NimbeLink::Sdk::SecureServices::At::Result *result,
+            NimbeLink::Sdk::SecureServices::At::Error *error,
+            const char *command,
+            uint32_t length,
+            char *response,
+            uint32_t size,
+            uint32_t *actual
+        ) override;
+};
@@ -11,15 +11,19 @@
  * subject to third party license terms as specified in this software, and such
  * portions are excluded from the preceding copyright notice of NimbeLink Corp.
  */
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 
+#include <at_cmd.h>
+#include <at_notif.h>
 #include <kernel.h>
 
 #include "examples/cell/cell.h"
-#include "nimbelink/sdk/secure_services/at.h"
+#include "examples/cell/plmn.h"
 
 using namespace NimbeLink::Examples;
 
@@ -57,12 +61,20 @@ void Cell::Handler(void *arg1, void *arg2, void *arg3)
 /**
  * \brief Creates a new cell instance
  *
- * \param none
+ * \param &at
+ *      What to ask the modem through
  *
  * \return none
  */
-Cell::Cell(void)
+Cell::Cell(AtService &at):
+    at(at)
 {
+    k_mutex_init(&this->updating);
+
+#   if CONFIG_CELL_NOTIFICATIONS
+    k_sem_init(&this->wake, 0, 1);
+#   endif
+
     // Create our thread
     this->threadId = k_thread_create(
         &this->thread,
@@ -79,157 +91,779 @@ Cell::Cell(void)
 }
 
 /**
- * \brief Sends the CESQ command to the modem to get cell status
+ * \brief Checks if an AT command's response is worth parsing
  *
- * \param none
+ * \param *command
+ *      The command that was run
+ * \param &response
+ *      Its response
  *
- * \return none
+ * \return bool
+ *      Whether or not the command was processed and succeeded
+ */
+bool Cell::Check(const char *command, const AtService::Response &response)
+{
+    // If the AT command was not successfully processed or failed, stop
+    if (!response.Succeeded())
+    {
+    #   if CONFIG_CELL_DEBUG
+        if (response.ret != 0)
+        {
+            printk("%s was not processed\n", command);
+        }
+        else
+        {
+            Utils::PrintError(command, response.result, response.error);
+        }
+    #   else
+        (void)command;
+    #   endif
+
+        return false;
+    }
+
+#   if CONFIG_CELL_DEBUG
+    // A response that filled the buffer may have been cut short, which the
+    // parser treats the same as a field that's missing
+    if (response.truncated)
+    {
+        printk("%s response truncated\n", command);
+    }
+
+    printk("resp: ");
+    Utils::Print(response.text);
+    printk("\n");
+#   endif
+
+    return true;
+}
+
+/**
+ * \brief Runs an AT command and waits for it
+ *
+ *  The parser is called with the response from the AT service's thread,
+ *  while we wait, so the response doesn't need a buffer on our stack.
+ *
+ * \param *command
+ *      The command to run
+ * \param &&parser
+ *      What to call with the response, if the command succeeded
+ *
+ * \return 0
+ *      Success
+ * \return -1
+ *      The command wasn't processed or failed
  */
-void Cell::Rsrpq(void)
+template <typename Parser>
+int Cell::Query(const char *command, Parser &&parser)
 {
-    char resp[100];
+    atomic_inc(&this->roundTrips);
+
+    return this->at.Execute(command, [command, &parser](const AtService::Response &response) {
+        if (Cell::Check(command, response))
+        {
+            parser(response.text);
+        }
+    });
+}
 
-    NimbeLink::Sdk::SecureServices::At::Result result;
-    NimbeLink::Sdk::SecureServices::At::Error error;
+/**
+ * \brief Sends an AT command without waiting for it
+ *
+ *  The callback is given us as its context, and is called from the AT
+ *  service's thread once the response comes in.
+ *
+ * \param *command
+ *      The command to run
+ * \param callback
+ *      What to call with the response
+ *
+ * \return 0
+ *      The command was queued
+ * \return -1
+ *      The command couldn't be queued
+ */
+int Cell::Submit(const char *command, AtService::Callback callback)
+{
+    atomic_inc(&this->roundTrips);
 
-    // Get the cellular status
-    //
-    // CESQ: 99,99,255,x,y
-    int32_t ret = NimbeLink::Sdk::SecureServices::At::RunCommand(&result, &error, "AT+CESQ", 7, resp, 100, nullptr);
+    int err = this->at.Submit(command, callback, this);
 
-    // If the AT command was not successfully processed, stop
-    if (ret != 0)
+#   if CONFIG_CELL_DEBUG
+    if (err != 0)
     {
-    #   if CONFIG_CELL_DEBUG
-        printk("AT+CESQ was not processed");
-    #   endif
+        printk("Failed to queue %s\n", command);
+    }
+#   endif
 
-        return;
+    return err;
+}
+
+/**
+ * \brief Gets a signal level from a reported value
+ *
+ * \param value
+ *      The reported value
+ *
+ * \return uint8_t
+ *      The signal level, with anything out of range as good as unknown, which
+ *      is 255
+ */
+uint8_t Cell::ToLevel(int32_t value)
+{
+    return static_cast<uint8_t>(((value >= 0) && (value <= 255)) ? value : 255);
+}
+
+/**
+ * \brief Adds a signal sample to our history
+ *
+ *  Samples are only added while updating, so the history only has one
+ *  writer at a time.
+ *
+ * \param &data
+ *      The cell data with the sample
+ *
+ * \return none
+ */
+void Cell::Record(const CellData &data)
+{
+#   if CONFIG_CELL_HISTORY
+    // Unknown signal levels would throw off the statistics
+    if ((data.rsrp != 255) && (data.rsrq != 255))
+    {
+        this->history.Add(data.rsrp, data.rsrq);
     }
+#   else
+    (void)data;
+#   endif
+}
 
-    // If AT command failed, stop
-    if (result != 0)
+/**
+ * \brief Changes our cell data and publishes it
+ *
+ *  Whatever the updater leaves in the data is published in one go, and is
+ *  added to our history if the updater says it has a new signal sample.
+ *
+ * \param &&updater
+ *      What to change the data with
+ *
+ * \return none
+ */
+template <typename Updater>
+void Cell::Update(Updater &&updater)
+{
+    k_mutex_lock(&this->updating, K_FOREVER);
+
+    CellData data = this->data.Read();
+
+    if (updater(data))
     {
-    #   if CONFIG_CELL_DEBUG
-        PrintError("AT+CESQ", result, error);
-    #   endif
+        this->Record(data);
+    }
+
+    this->data.Write(data);
+
+    k_mutex_unlock(&this->updating);
+}
+
+/**
+ * \brief Gets the rsrp and rsrq from a CESQ response
+ *
+ * \param resp
+ *      The response
+ * \param &data
+ *      The cell data to fill in
+ *
+ * \return bool
+ *      Whether or not the response had the rsrp and rsrq
+ */
+bool Cell::ParseRsrpq(std::string_view resp, CellData &data)
+{
+    Utils::At::Value values[std::size(Utils::At::Cesq.fields)];
 
+    // Check to make sure that the desired result string was returned before
+    // setting the struct values
+    if (Utils::At::Parse(resp, Utils::At::Cesq, values) != static_cast<int>(std::size(values)))
+    {
+        return false;
+    }
+
+    data.rsrp = Cell::ToLevel(values[0].integer);
+    data.rsrq = Cell::ToLevel(values[1].integer);
+
+    return true;
+}
+
+/**
+ * \brief Gets the carrier from a COPS response
+ *
+ * \param resp
+ *      The response
+ * \param &data
+ *      The cell data to fill in
+ *
+ * \return none
+ */
+void Cell::ParseCarrier(std::string_view resp, CellData &data)
+{
+    Utils::At::Value values[std::size(Utils::At::Cops.fields)];
+
+    // Without an operator, there's no MCCMNC to go by
+    if (Utils::At::Parse(resp, Utils::At::Cops, values) != static_cast<int>(std::size(values)))
+    {
         return;
     }
 
+    std::string_view plmn = values[0].text;
+
 #   if CONFIG_CELL_DEBUG
-    printk("resp: %s\n", resp);
+    printk("MCCMNC: ");
+    Utils::Print(plmn);
+    printk("\n");
+#   endif
+
+    data.carrier = Plmn::Lookup(plmn);
+}
+
+#if CONFIG_CELL_NOTIFICATIONS
+/**
+ * \brief Handles an AT notification
+ *
+ * \param *context
+ *      A pointer to our cell object
+ * \param *response
+ *      The notification
+ *
+ * \return none
+ */
+void Cell::NotificationHandler(void *context, const char *response)
+{
+    Cell *cell = static_cast<Cell *>(context);
+
+    if ((cell == nullptr) || (response == nullptr))
+    {
+        return;
+    }
+
+    cell->Notify(response);
+}
+
+/**
+ * \brief Takes in a notification and wakes up our thread if it's one of ours
+ *
+ *  This runs on the AT notification thread, so nothing's sent to the modem
+ *  here. The notification is only noted down for our own thread to act on.
+ *
+ * \param notification
+ *      The notification
+ *
+ * \return none
+ */
+void Cell::Notify(std::string_view notification)
+{
+    Utils::At::Value signal[std::size(Utils::At::CesqNotification.fields)];
+    Utils::At::Value registration[std::size(Utils::At::Cereg.fields)];
+
+#   if CONFIG_CELL_EXTENDED
+    NeighborCells neighbors;
 #   endif
 
-    const char comma[2] = ",";
+    if (Utils::At::Parse(notification, Utils::At::CesqNotification, signal) == static_cast<int>(std::size(signal)))
+    {
+        atomic_set(&this->signal, Cell::ToLevel(signal[0].integer) | (Cell::ToLevel(signal[1].integer) << 8));
+        atomic_or(&this->events, SignalChanged);
+    }
+    else if (Utils::At::Parse(notification, Utils::At::Cereg, registration) == static_cast<int>(std::size(registration)))
+    {
+        atomic_set(&this->registration, registration[0].integer);
+        atomic_or(&this->events, RegistrationChanged);
+    }
+#   if CONFIG_CELL_EXTENDED
+    else if (Cell::ParseNeighbors(notification, neighbors))
+    {
+        this->measured.Write(neighbors);
+        atomic_or(&this->events, NeighborsChanged);
+    }
+#   endif
+    else
+    {
+        return;
+    }
 
-    char *tok = strtok(resp, comma);
+    k_sem_give(&this->wake);
+}
 
-    char *rsrp = nullptr;
-    char *rsrq = nullptr;
+/**
+ * \brief Asks the modem to tell us when the signal or registration changes
+ *
+ * \param none
+ *
+ * \return bool
+ *      Whether or not we'll get notifications
+ */
+bool Cell::Subscribe(void)
+{
+    // These are fine to call more than once, such as when the socket example
+    // has already set them up
+    int err = at_cmd_init();
 
-    // Ideally:
-    //
-    // tok = CESQ: 99
-    // tok = 99
-    // tok = 255
-    // tok = x
-    // tok = y
-    // tok = nullptr
-    while (tok != nullptr)
+    if (!err)
     {
-        rsrq = rsrp;
-        rsrp = tok;
+        err = at_notif_init();
+    }
 
-        tok = strtok(nullptr, comma);
+    if (!err)
+    {
+        err = at_notif_register_handler(this, Cell::NotificationHandler);
     }
 
-    // Check to make sure that the desired result string was returned before
-    // setting the struct values
-    if (rsrp != nullptr)
+    if (err)
     {
-        this->data.rsrp = static_cast<uint8_t>(atoi(rsrp));
+    #   if CONFIG_CELL_DEBUG
+        printk("Failed to set up AT notifications, err %d\n", err);
+    #   endif
+
+        return false;
     }
 
-    if (rsrq != nullptr)
+    auto ignore = [](std::string_view resp) {
+        (void)resp;
+    };
+
+    if ((this->Query("AT%CESQ=1", ignore) != 0) ||
+        (this->Query("AT+CEREG=1", ignore) != 0))
     {
-        this->data.rsrq = static_cast<uint8_t>(atoi(rsrq));
+        at_notif_deregister_handler(this, Cell::NotificationHandler);
+
+        return false;
     }
+
+    return true;
 }
 
 /**
- * \brief Sends the COPS command to the modem to get carrier info
+ * \brief Updates our cell data from the notifications we've gotten
  *
  * \param none
  *
  * \return none
  */
-void Cell::Carrier(void)
+void Cell::Apply(void)
 {
-    char resp[100];
+    atomic_val_t events = atomic_set(&this->events, 0);
 
-    NimbeLink::Sdk::SecureServices::At::Result result;
-    NimbeLink::Sdk::SecureServices::At::Error error;
+    if (events & SignalChanged)
+    {
+        atomic_val_t signal = atomic_get(&this->signal);
 
-    // get the MCC MNC codes
-    int32_t ret = NimbeLink::Sdk::SecureServices::At::RunCommand(&result, &error, "AT+COPS?", 8, resp, 100, nullptr);
-    // +COPS: x,y,"MCCMNC",z
+        this->Update([signal](CellData &data) {
+            data.rsrp = static_cast<uint8_t>(signal & 0xFF);
+            data.rsrq = static_cast<uint8_t>((signal >> 8) & 0xFF);
 
-    // If the AT command was not successfully processed, stop
-    if (ret != 0)
+            return true;
+        });
+    }
+
+    if (events & RegistrationChanged)
     {
-    #   if CONFIG_CELL_DEBUG
-        printk("AT+COPS? was not processed");
-    #   endif
+        atomic_val_t registration = atomic_get(&this->registration);
+
+        // The notification doesn't say who we're registered with, so that's
+        // still worth asking about, but only when it could have changed
+        if ((registration == 1) || (registration == 5))
+        {
+            this->Submit("AT+COPS?", Cell::CarrierReceived);
+        }
+        else
+        {
+            this->Update([](CellData &data) {
+                data.carrier = Carrier::UKN;
+
+                return false;
+            });
+        }
+    }
+
+#   if CONFIG_CELL_EXTENDED
+    if (events & NeighborsChanged)
+    {
+        ExtendedData extended = this->extended.Read();
 
+        extended.neighbors = this->measured.Read();
+
+        this->extended.Write(extended);
+    }
+#   endif
+
+    this->wakes++;
+}
+#endif
+
+#if CONFIG_CELL_NOTIFICATIONS
+/**
+ * \brief Takes in the carrier we registered with
+ *
+ * \param *context
+ *      A pointer to our cell object
+ * \param &response
+ *      The AT+COPS? response
+ *
+ * \return none
+ */
+void Cell::CarrierReceived(void *context, const AtService::Response &response)
+{
+    Cell *cell = static_cast<Cell *>(context);
+
+    if (!Cell::Check("AT+COPS?", response))
+    {
         return;
     }
 
-    // If the AT command failed
-    if (result != 0)
+    cell->Update([cell, &response](CellData &data) {
+        cell->ParseCarrier(response.text, data);
+
+        return false;
+    });
+}
+#endif
+
+#if CONFIG_CELL_COMBINED_AT
+/**
+ * \brief Takes in a poll's signal and carrier
+ *
+ * \param *context
+ *      A pointer to our cell object
+ * \param &response
+ *      The AT+CESQ;+COPS? response
+ *
+ * \return none
+ */
+void Cell::Polled(void *context, const AtService::Response &response)
+{
+    Cell *cell = static_cast<Cell *>(context);
+
+    // Anything we can't get this time keeps its last value
+    if (!Cell::Check("AT+CESQ;+COPS?", response))
     {
-    #   if CONFIG_CELL_DEBUG
-        PrintError("AT+COPS?", result, error);
-    #   endif
+        return;
     }
 
-#   if CONFIG_CELL_DEBUG
-    printk("resp: %s\n", resp);
+    cell->Update([cell, &response](CellData &data) {
+        bool sampled = Cell::ParseRsrpq(response.text, data);
+
+        cell->ParseCarrier(response.text, data);
+
+        return sampled;
+    });
+}
+#else
+/**
+ * \brief Takes in a poll's signal and asks for its carrier
+ *
+ * \param *context
+ *      A pointer to our cell object
+ * \param &response
+ *      The AT+CESQ response
+ *
+ * \return none
+ */
+void Cell::SignalPolled(void *context, const AtService::Response &response)
+{
+    Cell *cell = static_cast<Cell *>(context);
+
+    cell->sampled = Cell::Check("AT+CESQ", response) && Cell::ParseRsrpq(response.text, cell->polled);
+
+    // The carrier's only asked for once the signal's in, so its callback
+    // always comes second, even when its response was cached
+    if (cell->Submit("AT+COPS?", Cell::CarrierPolled) != 0)
+    {
+        cell->Publish({});
+    }
+}
+
+/**
+ * \brief Takes in a poll's carrier
+ *
+ * \param *context
+ *      A pointer to our cell object
+ * \param &response
+ *      The AT+COPS? response
+ *
+ * \return none
+ */
+void Cell::CarrierPolled(void *context, const AtService::Response &response)
+{
+    Cell *cell = static_cast<Cell *>(context);
+
+    cell->Publish(Cell::Check("AT+COPS?", response) ? response.text : std::string_view());
+}
+
+/**
+ * \brief Publishes a poll's signal and carrier together
+ *
+ *  Anything we couldn't get this time keeps its last value.
+ *
+ * \param carrier
+ *      The AT+COPS? response, or nothing if we didn't get one
+ *
+ * \return none
+ */
+void Cell::Publish(std::string_view carrier)
+{
+    this->Update([this, carrier](CellData &data) {
+        if (this->sampled)
+        {
+            data.rsrp = this->polled.rsrp;
+            data.rsrq = this->polled.rsrq;
+        }
+
+        this->ParseCarrier(carrier, data);
+
+        return this->sampled;
+    });
+}
+#endif
+
+/**
+ * \brief Asks the modem for the cell status and carrier info
+ *
+ *  Nothing waits on the poll. Its responses are taken in and published from
+ *  the AT service's thread as they come in, so we're free to pick up
+ *  notifications in the meantime.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Cell::Poll(void)
+{
+#   if CONFIG_CELL_COMBINED_AT
+    // Both queries go to the modem as a single command, which saves a trip
+    // through the secure services and the modem, and each query's part of
+    // the response comes back on its own line, which the parser finds by
+    // its prefix
+    this->Submit("AT+CESQ;+COPS?", Cell::Polled);
+#   else
+    this->Submit("AT+CESQ", Cell::SignalPolled);
 #   endif
 
-    const char quote[2] = "\"";
+    this->polls++;
+}
+
+#if CONFIG_CELL_EXTENDED
+/**
+ * \brief Gets the serving cell details from a %XMONITOR response
+ *
+ *  Anything the response doesn't have, such as everything but the
+ *  registration status when we aren't registered, is left unknown.
+ *
+ * \param resp
+ *      The response
+ * \param &serving
+ *      The serving cell details to fill in
+ *
+ * \return none
+ */
+void Cell::ParseMonitor(std::string_view resp, ServingCell &serving)
+{
+    serving = UnknownServingCell;
+
+    std::string_view line;
+
+    if (!Utils::At::FindLine(resp, Utils::At::Xmonitor.prefix, line))
+    {
+        return;
+    }
 
-    // +COPS: x,y,"
-    char *tok = strtok(resp, quote);
+    Utils::At::FieldReader reader(line);
+    std::string_view field;
 
-    while (tok != nullptr)
+    // Take each field as it comes, which only needs room for one of them
+    for (std::size_t index = 0; reader.Next(field); index++)
     {
-    #   if CONFIG_CELL_DEBUG
-        printk("tok: %s\n", tok);
-    #   endif
+        int32_t value;
+
+        switch (index)
+        {
+            case 0:
+                if (Utils::At::ToInteger(field, value))
+                {
+                    serving.registration = Cell::ToLevel(value);
+                }
+                break;
+            case 3:
+                if (std::size(field) < sizeof(serving.plmn))
+                {
+                    field.copy(serving.plmn, std::size(field));
+                    serving.plmn[std::size(field)] = '\0';
+                }
+                break;
+            case 4:
+                if (Utils::At::ToInteger(field, value, 16) && (value >= 0) && (value <= 0xFFFF))
+                {
+                    serving.tac = static_cast<uint16_t>(value);
+                }
+                break;
+            case 6:
+                if (Utils::At::ToInteger(field, value) && (value >= 0) && (value < 255))
+                {
+                    serving.band = static_cast<uint8_t>(value);
+                }
+                break;
+            case 7:
+                if (Utils::At::ToInteger(field, value, 16) && (value >= 0))
+                {
+                    serving.cellId = static_cast<uint32_t>(value);
+                }
+                break;
+            case 9:
+                if (Utils::At::ToInteger(field, value) && (value >= 0))
+                {
+                    serving.earfcn = static_cast<uint32_t>(value);
+                }
+                break;
+            case 10:
+                if (Utils::At::ToInteger(field, value))
+                {
+                    serving.rsrp = Cell::ToLevel(value);
+                }
+                break;
+            case 11:
+                if (Utils::At::ToInteger(field, value))
+                {
+                    serving.snr = Cell::ToLevel(value);
+                }
+                break;
+        }
+    }
+}
 
-        tok = strtok(nullptr, quote);
+/**
+ * \brief Gets the neighbor cells from a %NCELLMEAS notification
+ *
+ *  Neighbors past the most we keep are dropped.
+ *
+ * \param notification
+ *      The notification
+ * \param &neighbors
+ *      The neighbor cells to fill in
+ *
+ * \return bool
+ *      Whether or not this was a successful measurement
+ */
+bool Cell::ParseNeighbors(std::string_view notification, NeighborCells &neighbors)
+{
+    // The serving cell's measurements come before the neighbors', and we
+    // already have those from %XMONITOR
+    static constexpr const std::size_t ServingFields = 9;
+
+    std::string_view line;
 
-        break;
+    if (!Utils::At::FindLine(notification, Utils::At::Ncellmeas, line))
+    {
+        return false;
     }
 
-    if (tok == nullptr)
+    Utils::At::FieldReader reader(line);
+    std::string_view field;
+    int32_t status;
+
+    if (!reader.NextInteger(status) || (status != 0))
     {
-        return;
+        return false;
     }
 
-    if (strcmp(tok, "311480") == 0)
+    for (std::size_t i = 0; i < ServingFields; i++)
+    {
+        if (!reader.Next(field))
+        {
+            return false;
+        }
+    }
+
+    neighbors.count = 0;
+
+    while (neighbors.count < std::size(neighbors.cells))
+    {
+        int32_t earfcn;
+        int32_t physicalCellId;
+        int32_t rsrp;
+        int32_t rsrq;
+
+        // Each neighbor ends with its time difference, which we don't keep,
+        // but which tells a whole neighbor apart from anything trailing
+        if (!reader.NextInteger(earfcn) ||
+            !reader.NextInteger(physicalCellId) ||
+            !reader.NextInteger(rsrp) ||
+            !reader.NextInteger(rsrq) ||
+            !reader.Next(field))
+        {
+            break;
+        }
+
+        neighbors.cells[neighbors.count++] = {
+            static_cast<uint32_t>(earfcn),
+            static_cast<uint16_t>(physicalCellId),
+            Cell::ToLevel(rsrp),
+            Cell::ToLevel(rsrq),
+        };
+    }
+
+    return true;
+}
+
+/**
+ * \brief Gets the extended cell details from the modem
+ *
+ *  The serving cell details are published right away. Neighbor cells are
+ *  measured in the background and come back as a notification, so they're
+ *  only asked for if we're getting notifications.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Cell::Measure(void)
+{
+    ExtendedData extended = this->extended.Read();
+
+    if (this->Query("AT%XMONITOR", [&extended](std::string_view resp) { Cell::ParseMonitor(resp, extended.serving); }) == 0)
     {
-        this->data.carrier = Carrier::VZW;
+        this->extended.Write(extended);
     }
-    else if (strcmp(tok, "310410") == 0)
+
+#   if CONFIG_CELL_NOTIFICATIONS
+    if (this->notifying)
     {
-        this->data.carrier = Carrier::ATT;
+        this->Query("AT%NCELLMEAS", [](std::string_view resp) {
+            (void)resp;
+        });
     }
-    else if (strcmp(tok, "311260") == 0)
+#   endif
+}
+#endif
+
+/**
+ * \brief Waits until it's time to do something
+ *
+ * \param timeout
+ *      The most time to wait, in milliseconds
+ *
+ * \return bool
+ *      Whether or not a notification woke us up
+ */
+bool Cell::Wait(int32_t timeout)
+{
+#   if CONFIG_CELL_NOTIFICATIONS
+    if (this->notifying)
     {
-        this->data.carrier = Carrier::TMB;
+        return (k_sem_take(&this->wake, timeout) == 0);
     }
+#   endif
+
+    k_sleep(timeout);
+
+    return false;
 }
 
 /**
@@ -241,23 +875,78 @@ void Cell::Carrier(void)
  */
 void Cell::Run(void)
 {
-    while (true)
+    int32_t interval = K_SECONDS(CONFIG_CELL_POLL_RATE);
+
+#   if CONFIG_CELL_NOTIFICATIONS
+    this->notifying = this->Subscribe();
+
+    // The modem tells us when something changes, so only poll if it's been
+    // quiet for long enough that a notification might've been lost
+    if (this->notifying)
     {
-        // Populate the rsrp and rsrq values of the pqr array
-        this->Rsrpq();
+        interval = K_SECONDS(CONFIG_CELL_FALLBACK_RATE);
+    }
+#   endif
+
+    // Populate the rsrp, rsrq and carrier values
+    this->Poll();
 
-        // Populate the carrier value of the pqr array
-        this->Carrier();
+    int64_t nextPoll = k_uptime_get() + interval;
 
+#   if CONFIG_CELL_EXTENDED
+    int64_t nextMeasure = k_uptime_get();
+#   endif
+
+    while (true)
+    {
     #   if CONFIG_CELL_DEBUG
+        CellData data = this->data.Read();
+
         printk("rsrp: %d, rsrq: %d, MCCMNC: %s\n",
-            static_cast<uint8_t>(this->data.rsrp),
-            static_cast<uint8_t>(this->data.rsrq),
-            Cell::GetCarrierString(this->data.carrier)
+            data.rsrp,
+            data.rsrq,
+            Cell::GetCarrierString(data.carrier)
         );
+
+        printk("%u AT round trips over %u polls\n",
+            static_cast<unsigned int>(atomic_get(&this->roundTrips)),
+            static_cast<unsigned int>(this->polls)
+        );
+
+    #   if CONFIG_CELL_NOTIFICATIONS
+        printk("%u notification wakes\n", static_cast<unsigned int>(this->wakes));
     #   endif
+    #   endif
+
+        int64_t next = nextPoll;
+
+    #   if CONFIG_CELL_EXTENDED
+        if (k_uptime_get() >= nextMeasure)
+        {
+            this->Measure();
+
+            nextMeasure = k_uptime_get() + K_SECONDS(CONFIG_CELL_EXTENDED_RATE);
+        }
+
+        next = std::min(next, nextMeasure);
+    #   endif
+
+        // Wait until we're ready to sample again, or until the modem tells
+        // us something's changed
+        if (this->Wait(static_cast<int32_t>(std::max<int64_t>(next - k_uptime_get(), 0))))
+        {
+        #   if CONFIG_CELL_NOTIFICATIONS
+            this->Apply();
+        #   endif
+
+            continue;
+        }
+
+        if (k_uptime_get() >= nextPoll)
+        {
+            this->Poll();
 
-        // Wait until we're ready to sample again
-        k_sleep(K_SECONDS(CONFIG_CELL_POLL_RATE));
+            nextPoll = k_uptime_get() + interval;
+        }
     }
 }
@@ -13,11 +13,16 @@
  */
 #pragma once
 
-#include <atomic>
+#include <array>
 #include <cstddef>
+#include <string>
 
 #include <kernel.h>
 
+#if CONFIG_CELL_HISTORY
+#include "examples/cell/history.h"
+#endif
+#include "examples/at/at_service.h"
 #include "examples/utils.h"
 #include "examples/dashboard/dashboard.h"
 #include "nimbelink/sdk/secure_services/at.h"
@@ -38,6 +43,27 @@ class NimbeLink::Examples::Cell
             VZW,
             ATT,
             TMB,
+            USC,
+            ROG,
+            BEL,
+            TEL,
+            TCL,
+            VOD,
+            TEF,
+            THR,
+            EE,
+            DTK,
+            ORA,
+            SFR,
+            FRE,
+            BYT,
+            KPN,
+            TIM,
+            NTT,
+            SFB,
+            KDI,
+            TLS,
+            OPT,
             UKN,
         };
 
@@ -46,11 +72,64 @@ class NimbeLink::Examples::Cell
          */
         struct CellData
         {
-            std::atomic<uint8_t> rsrp = 0;
-            std::atomic<uint8_t> rsrq = 0;
-            std::atomic<enum Carrier> carrier;
+            uint8_t rsrp;
+            uint8_t rsrq;
+            enum Carrier carrier;
         };
 
+    #   if CONFIG_CELL_EXTENDED
+        /**
+         * \brief Details of the cell we're registered to, from %XMONITOR
+         *
+         *  The rsrp is on the same scale as in CellData, and the snr is as
+         *  the modem reports it, which is the SNR in dB plus 24.
+         */
+        struct ServingCell
+        {
+            uint8_t registration;
+            char plmn[7];
+            uint16_t tac;
+            uint8_t band;
+            uint8_t rsrp;
+            uint8_t snr;
+            uint32_t cellId;
+            uint32_t earfcn;
+        };
+
+        /**
+         * \brief A neighbor cell's measurements, from %NCELLMEAS
+         */
+        struct NeighborCell
+        {
+            uint32_t earfcn;
+            uint16_t physicalCellId;
+            uint8_t rsrp;
+            uint8_t rsrq;
+        };
+
+        /**
+         * \brief The neighbor cells from the latest measurement
+         */
+        struct NeighborCells
+        {
+            uint8_t count;
+            NeighborCell cells[CONFIG_CELL_NEIGHBORS];
+        };
+
+        /**
+         * \brief Extended cellular information
+         */
+        struct ExtendedData
+        {
+            ServingCell serving;
+            NeighborCells neighbors;
+        };
+
+        // Serving cell details before we've heard anything, or when we
+        // aren't registered
+        static constexpr const ServingCell UnknownServingCell = {255, "", 0xFFFF, 0, 255, 255, 0xFFFFFFFF, 0xFFFFFFFF};
+    #   endif
+
         /**
          * \brief Gets the string representing the carrier
          *
@@ -62,19 +141,46 @@ class NimbeLink::Examples::Cell
          */
         static const char *GetCarrierString(enum Carrier carrier)
         {
-            switch (carrier)
+            // Indexed by carrier, so these have to stay in the same order as
+            // the enum
+            static constexpr const char *Strings[] = {
+                "VZW",
+                "ATT",
+                "TMB",
+                "USC",
+                "ROG",
+                "BEL",
+                "TEL",
+                "TCL",
+                "VOD",
+                "TEF",
+                "THR",
+                "EE",
+                "DTK",
+                "ORA",
+                "SFR",
+                "FRE",
+                "BYT",
+                "KPN",
+                "TIM",
+                "NTT",
+                "SFB",
+                "KDI",
+                "TLS",
+                "OPT",
+                "UKN",
+            };
+
+            static_assert(std::size(Strings) == (static_cast<std::size_t>(Carrier::UKN) + 1), "Carrier strings don't match the carriers");
+
+            std::size_t index = static_cast<std::size_t>(carrier);
+
+            if (index >= std::size(Strings))
             {
-                case Carrier::VZW:
-                    return "VZW";
-                case Carrier::ATT:
-                    return "ATT";
-                case Carrier::TMB:
-                    return "TMB";
-                case Carrier::UKN:
-                    return "UKN";
+                return "N/A";
             }
 
-            return "N/A";
+            return Strings[index];
         };
 
     private:
@@ -83,7 +189,7 @@ class NimbeLink::Examples::Cell
         // C++ isn't a big fan of placing a class' member in a section, so
         // we'll reproduce what the Zephyr library does when someone uses
         // K_THREAD_STACK_DEFINE().
-        __attribute__((aligned(STACK_ALIGN))) struct _k_thread_stack_element stack[512 + MPU_GUARD_ALIGN_AND_SIZE];
+        __attribute__((aligned(STACK_ALIGN))) struct _k_thread_stack_element stack[768 + MPU_GUARD_ALIGN_AND_SIZE];
 
         // Our Zephyr thread
         struct k_thread thread;
@@ -91,39 +197,179 @@ class NimbeLink::Examples::Cell
         // Our thread's ID
         k_tid_t threadId;
 
-        // Struct to store cell data
-        struct CellData data = {255, 255, Carrier::UKN};
+        // What we ask the modem through
+        AtService &at;
+
+        // Our cell data, which is published a whole poll at a time so
+        // readers never see values from two different polls
+        Utils::SeqLock<CellData> data{{255, 255, Carrier::UKN}};
+
+        // Polls finish on the AT service's thread and notifications are
+        // picked up on ours, so this keeps their updates to our data and
+        // history from running over each other
+        struct k_mutex updating;
+
+    #   if !CONFIG_CELL_COMBINED_AT
+        // The signal from the poll under way, which is held onto until the
+        // carrier comes in so the two are published together
+        CellData polled{255, 255, Carrier::UKN};
+        bool sampled = false;
+    #   endif
+
+    #   if CONFIG_CELL_HISTORY
+    public:
+        // Our signal history, with a short and a long window
+        using SignalHistory = History<CONFIG_CELL_HISTORY_DEPTH, 2>;
+
+        static constexpr const std::size_t ShortWindow = 0;
+        static constexpr const std::size_t LongWindow = 1;
+
+    private:
+        SignalHistory history{{K_SECONDS(CONFIG_CELL_HISTORY_SHORT_WINDOW), K_SECONDS(CONFIG_CELL_HISTORY_LONG_WINDOW)}};
+    #   endif
+
+    #   if CONFIG_CELL_EXTENDED
+        // Our extended cell data
+        Utils::SeqLock<ExtendedData> extended{{UnknownServingCell, {}}};
+    #   endif
+
+    #   if CONFIG_CELL_NOTIFICATIONS
+        // What notifications have told us about that our thread hasn't
+        // picked up yet
+        static constexpr const atomic_val_t SignalChanged = BIT(0);
+        static constexpr const atomic_val_t RegistrationChanged = BIT(1);
+        static constexpr const atomic_val_t NeighborsChanged = BIT(2);
+
+        atomic_t events = ATOMIC_INIT(0);
+
+        // The latest signal from a %CESQ notification, with the rsrp in the
+        // low byte and the rsrq in the next one, so they change together
+        atomic_t signal = ATOMIC_INIT(0);
 
-        // Assertions to check if the values are actually atomic operations and
-        // not using locks
+        // The latest registration status from a +CEREG notification
+        atomic_t registration = ATOMIC_INIT(0);
+
+    #   if CONFIG_CELL_EXTENDED
+        // The latest neighbor cells from a %NCELLMEAS notification, which
+        // only the notification handler writes
+        Utils::SeqLock<NeighborCells> measured;
+    #   endif
+
+        // Given whenever a notification comes in
+        struct k_sem wake;
+
+        // Whether or not the modem is sending us notifications
+        bool notifying = false;
+
+        // How many times notifications have woken us up
+        uint32_t wakes = 0;
+    #   endif
+
+        // How many AT commands we've run and how many times we've polled,
+        // which shows how many round trips to the modem each poll takes
         //
-        // Another option is to use normal data types (uint8_t, int, etc.) and
-        // mutexes.
-        static_assert(decltype(data.rsrp)::is_always_lock_free, "Atomic variable rsrp isn't lock-free!");
-        static_assert(decltype(data.rsrq)::is_always_lock_free, "Atomic variable rsrq isn't lock-free!");
-        static_assert(decltype(data.carrier)::is_always_lock_free, "Atomic variable carrier isn't lock-free!");
+        // Polls send some of their commands from the AT service's thread.
+        atomic_t roundTrips = ATOMIC_INIT(0);
+        uint32_t polls = 0;
 
     private:
         static void Handler(void *arg1, void *arg2, void *arg3);
 
-        void Rsrpq(void);
-        void Carrier(void);
+    #   if CONFIG_CELL_NOTIFICATIONS
+        static void NotificationHandler(void *context, const char *response);
+
+        void Notify(std::string_view notification);
+        bool Subscribe(void);
+        void Apply(void);
+    #   endif
+
+        static bool Check(const char *command, const AtService::Response &response);
+
+        template <typename Parser>
+        int Query(const char *command, Parser &&parser);
+
+        int Submit(const char *command, AtService::Callback callback);
+
+        static uint8_t ToLevel(int32_t value);
+
+        void Record(const CellData &data);
+
+        template <typename Updater>
+        void Update(Updater &&updater);
+
+        static bool ParseRsrpq(std::string_view resp, CellData &data);
+        void ParseCarrier(std::string_view resp, CellData &data);
+
+    #   if CONFIG_CELL_NOTIFICATIONS
+        static void CarrierReceived(void *context, const AtService::Response &response);
+    #   endif
+
+    #   if CONFIG_CELL_COMBINED_AT
+        static void Polled(void *context, const AtService::Response &response);
+    #   else
+        static void SignalPolled(void *context, const AtService::Response &response);
+        static void CarrierPolled(void *context, const AtService::Response &response);
+
+        void Publish(std::string_view carrier);
+    #   endif
+
+        void Poll(void);
+
+    #   if CONFIG_CELL_EXTENDED
+        static void ParseMonitor(std::string_view resp, ServingCell &serving);
+        static bool ParseNeighbors(std::string_view notification, NeighborCells &neighbors);
+
+        void Measure(void);
+    #   endif
+
+        bool Wait(int32_t timeout);
 
         void Run(void);
 
     public:
-        Cell(void);
+        Cell(AtService &at);
+
+        /**
+         * \brief Gets a snapshot of our cell data
+         *
+         * \param none
+         *
+         * \return struct CellData
+         *      Our cell data from the latest poll
+         */
+        struct CellData GetData(void) const
+        {
+            return this->data.Read();
+        }
+
+    #   if CONFIG_CELL_EXTENDED
+        /**
+         * \brief Gets a snapshot of our extended cell data
+         *
+         * \param none
+         *
+         * \return struct ExtendedData
+         *      Our serving cell details and neighbor cells from the latest
+         *      measurements
+         */
+        struct ExtendedData GetExtended(void) const
+        {
+            return this->extended.Read();
+        }
+    #   endif
 
+    #   if CONFIG_CELL_HISTORY
         /**
-         * \brief Gets our cell data
+         * \brief Gets our signal history
          *
          * \param none
          *
-         * \return struct CellData *
-         *      Our cell data
+         * \return const SignalHistory &
+         *      Our signal history
          */
-        struct CellData *GetStruct(void)
+        const SignalHistory &GetHistory(void) const
         {
-            return &this->data;
+            return this->history;
         }
+    #   endif
 };
@@ -0,0 +1,369 @@
+/**
+ * \file
+ *
+ * \brief A history of cell signal samples with rolling statistics
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+
+#include "examples/utils.h"
+
+namespace NimbeLink::Examples
+{
+    template <std::size_t Capacity, std::size_t Windows>
+    class History;
+}
+
+// Keeps the most recent signal samples, along with statistics over the
+// samples within each of a few windows of time
+//
+// A single thread adds samples, and any number of threads can read from it.
+// Running totals are updated as each sample is added, and a reader drops
+// whatever's aged out of its copy of a window since then, so statistics stay
+// true to the window even when samples stop coming in. Everything's shared
+// through a SeqLock, so readers never block the writer: they pick out what
+// they want from the latest copy in place.
+template <std::size_t Capacity, std::size_t Windows>
+class NimbeLink::Examples::History
+{
+    public:
+        /**
+         * \brief A signal sample
+         */
+        struct Sample
+        {
+            uint32_t time;
+            uint8_t rsrp;
+            uint8_t rsrq;
+        };
+
+        /**
+         * \brief Statistics for one value over a window
+         */
+        struct Stats
+        {
+            uint32_t count;
+            uint8_t min;
+            uint8_t max;
+            float mean;
+            float variance;
+        };
+
+        /**
+         * \brief Statistics for each value over a window
+         */
+        struct Summary
+        {
+            Stats rsrp;
+            Stats rsrq;
+        };
+
+    private:
+        // Running totals for one value over a window
+        struct Accumulator
+        {
+            uint32_t count;
+            uint32_t sum;
+            uint32_t squares;
+            uint8_t min;
+            uint8_t max;
+        };
+
+        // A window of time, and the totals of the samples within it
+        struct Window
+        {
+            uint32_t length;
+            uint32_t first;
+            Accumulator rsrp;
+            Accumulator rsrq;
+        };
+
+        // Everything that changes when a sample is added
+        struct State
+        {
+            // Our samples, with the newest at index (total - 1) % Capacity
+            Sample samples[Capacity];
+            uint32_t total;
+
+            Window windows[Windows];
+        };
+
+        Utils::SeqLock<State> state;
+
+    private:
+        /**
+         * \brief Adds a value to a window's totals
+         *
+         * \param &accumulator
+         *      The totals
+         * \param value
+         *      The value to add
+         *
+         * \return none
+         */
+        static void Add(Accumulator &accumulator, uint8_t value)
+        {
+            if (accumulator.count == 0)
+            {
+                accumulator.min = value;
+                accumulator.max = value;
+            }
+
+            accumulator.count++;
+            accumulator.sum += value;
+            accumulator.squares += value * value;
+            accumulator.min = std::min(accumulator.min, value);
+            accumulator.max = std::max(accumulator.max, value);
+        }
+
+        /**
+         * \brief Removes a value from a window's totals
+         *
+         * \param &accumulator
+         *      The totals
+         * \param value
+         *      The value to remove
+         *
+         * \return bool
+         *      Whether or not the minimum or maximum needs to be found again
+         */
+        static bool Remove(Accumulator &accumulator, uint8_t value)
+        {
+            accumulator.count--;
+            accumulator.sum -= value;
+            accumulator.squares -= value * value;
+
+            return ((value == accumulator.min) || (value == accumulator.max));
+        }
+
+        /**
+         * \brief Turns a window's totals into statistics
+         *
+         * \param &accumulator
+         *      The totals
+         *
+         * \return Stats
+         *      The statistics
+         */
+        static Stats Summarize(const Accumulator &accumulator)
+        {
+            if (accumulator.count == 0)
+            {
+                return {0, 0, 0, 0.0f, 0.0f};
+            }
+
+            float mean = static_cast<float>(accumulator.sum) / accumulator.count;
+            float variance = (static_cast<float>(accumulator.squares) / accumulator.count) - (mean * mean);
+
+            return {accumulator.count, accumulator.min, accumulator.max, mean, std::max(variance, 0.0f)};
+        }
+
+        /**
+         * \brief Finds a window's minimums and maximums again
+         *
+         * \param &state
+         *      The samples
+         * \param &window
+         *      The window
+         * \param total
+         *      The number of samples added so far
+         *
+         * \return none
+         */
+        static void Rescan(const State &state, Window &window, uint32_t total)
+        {
+            window.rsrp.count = 0;
+            window.rsrq.count = 0;
+
+            uint32_t rsrpSum = window.rsrp.sum;
+            uint32_t rsrpSquares = window.rsrp.squares;
+            uint32_t rsrqSum = window.rsrq.sum;
+            uint32_t rsrqSquares = window.rsrq.squares;
+
+            for (uint32_t i = window.first; i != total; i++)
+            {
+                const Sample &sample = state.samples[i % Capacity];
+
+                Add(window.rsrp, sample.rsrp);
+                Add(window.rsrq, sample.rsrq);
+            }
+
+            // Only the minimums and maximums were wanted
+            window.rsrp.sum = rsrpSum;
+            window.rsrp.squares = rsrpSquares;
+            window.rsrq.sum = rsrqSum;
+            window.rsrq.squares = rsrqSquares;
+        }
+
+        /**
+         * \brief Drops samples from a window that have aged out of it
+         *
+         * \param &state
+         *      The samples
+         * \param &window
+         *      The window
+         * \param now
+         *      The current time
+         * \param oldest
+         *      The first sample that hasn't been or isn't about to be
+         *      overwritten
+         * \param total
+         *      The number of samples added so far
+         *
+         * \return none
+         */
+        static void Age(const State &state, Window &window, uint32_t now, uint32_t oldest, uint32_t total)
+        {
+            bool rescan = false;
+
+            while ((window.first != total) &&
+                ((window.first < oldest) || ((now - state.samples[window.first % Capacity].time) > window.length)))
+            {
+                const Sample &sample = state.samples[window.first % Capacity];
+
+                rescan |= Remove(window.rsrp, sample.rsrp);
+                rescan |= Remove(window.rsrq, sample.rsrq);
+
+                window.first++;
+            }
+
+            if (rescan)
+            {
+                Rescan(state, window, total);
+            }
+        }
+
+    public:
+        /**
+         * \brief Creates a new history
+         *
+         * \param (&lengths)[Windows]
+         *      The length of each window, in milliseconds
+         *
+         * \return none
+         */
+        History(const uint32_t (&lengths)[Windows])
+        {
+            this->state.Update([&lengths](State &state) {
+                for (std::size_t i = 0; i < Windows; i++)
+                {
+                    state.windows[i].length = lengths[i];
+                }
+            });
+        }
+
+        /**
+         * \brief Adds a sample
+         *
+         *  Only one thread may add samples.
+         *
+         * \param rsrp
+         *      The sample's RSRP
+         * \param rsrq
+         *      The sample's RSRQ
+         *
+         * \return none
+         */
+        void Add(uint8_t rsrp, uint8_t rsrq)
+        {
+            uint32_t now = k_uptime_get_32();
+
+            this->state.Update([now, rsrp, rsrq](State &state) {
+                // The first sample that will still be around once this one's
+                // in
+                uint32_t oldest = (state.total >= Capacity) ? (state.total + 1 - Capacity) : 0;
+
+                // Drop whatever's about to be overwritten or has aged out
+                for (std::size_t i = 0; i < Windows; i++)
+                {
+                    Age(state, state.windows[i], now, oldest, state.total);
+                }
+
+                state.samples[state.total % Capacity] = {now, rsrp, rsrq};
+                state.total++;
+
+                for (std::size_t i = 0; i < Windows; i++)
+                {
+                    Window &window = state.windows[i];
+
+                    Add(window.rsrp, rsrp);
+                    Add(window.rsrq, rsrq);
+                }
+            });
+        }
+
+        /**
+         * \brief Gets the statistics over a window, as of now
+         *
+         *  Samples that have aged out of the window since the last one was
+         *  added aren't counted.
+         *
+         * \param window
+         *      Which window to get the statistics of
+         *
+         * \return Summary
+         *      The statistics
+         */
+        Summary GetSummary(std::size_t window) const
+        {
+            window = std::min(window, Windows - 1);
+
+            uint32_t now = k_uptime_get_32();
+
+            return this->state.Read([window, now](const State &state) {
+                Window copy = state.windows[window];
+                uint32_t total = state.total;
+
+                // A copy torn by a sample being added gets thrown away, but
+                // it still mustn't send us walking off through the samples
+                if ((total - copy.first) > Capacity)
+                {
+                    return Summary{};
+                }
+
+                Age(state, copy, now, (total > Capacity) ? (total - Capacity) : 0, total);
+
+                return Summary{Summarize(copy.rsrp), Summarize(copy.rsrq)};
+            });
+        }
+
+        /**
+         * \brief Gets the most recent samples
+         *
+         * \param *samples
+         *      Where to put the samples, oldest first
+         * \param count
+         *      The most samples to get
+         *
+         * \return std::size_t
+         *      The number of samples gotten
+         */
+        std::size_t GetSamples(Sample *samples, std::size_t count) const
+        {
+            return this->state.Read([samples, count](const State &state) {
+                uint32_t total = state.total;
+
+                std::size_t available = std::min<std::size_t>({count, total, Capacity});
+
+                for (std::size_t i = 0; i < available; i++)
+                {
+                    samples[i] = state.samples[(total - available + i) % Capacity];
+                }
+
+                return available;
+            });
+        }
+};
@@ -0,0 +1,427 @@
+/**
+ * \file
+ *
+ * \brief Maps PLMN codes (MCC and MNC) to carriers
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "examples/cell/cell.h"
+
+namespace NimbeLink::Examples::Plmn
+{
+    /**
+     * \brief A PLMN code and the carrier it belongs to
+     */
+    struct Entry
+    {
+        uint32_t key;
+        Cell::Carrier carrier;
+    };
+
+    /**
+     * \brief Encodes a PLMN code as an integer
+     *
+     *  The key is MCC * 10000 + MNC, plus 1000 for two-digit MNCs, so that a
+     *  two-digit MNC like "01" doesn't collide with "001".
+     *
+     * \param plmn
+     *      The PLMN code's digits, such as "310410"
+     *
+     * \return 0
+     *      The PLMN code isn't 5 or 6 digits
+     * \return uint32_t
+     *      The key
+     */
+    static constexpr uint32_t Key(std::string_view plmn)
+    {
+        if ((std::size(plmn) != 5) && (std::size(plmn) != 6))
+        {
+            return 0;
+        }
+
+        uint32_t mcc = 0;
+        uint32_t mnc = 0;
+
+        for (std::size_t i = 0; i < std::size(plmn); i++)
+        {
+            if ((plmn[i] < '0') || (plmn[i] > '9'))
+            {
+                return 0;
+            }
+
+            uint32_t &part = (i < 3) ? mcc : mnc;
+
+            part = (part * 10) + (plmn[i] - '0');
+        }
+
+        return (mcc * 10000) + ((std::size(plmn) == 5) ? 1000 : 0) + mnc;
+    }
+
+    /**
+     * \brief Sorts entries by their key
+     *
+     * \param entries
+     *      The entries to sort
+     *
+     * \return std::array<Entry, Count>
+     *      The sorted entries
+     */
+    template <std::size_t Count>
+    static constexpr std::array<Entry, Count> Sort(std::array<Entry, Count> entries)
+    {
+        for (std::size_t i = 1; i < Count; i++)
+        {
+            Entry entry = entries[i];
+
+            std::size_t j = i;
+
+            for (; (j > 0) && (entries[j - 1].key > entry.key); j--)
+            {
+                entries[j] = entries[j - 1];
+            }
+
+            entries[j] = entry;
+        }
+
+        return entries;
+    }
+
+    // Known PLMN codes, sorted by key when compiled so they can be listed
+    // here in whatever order reads best
+    //
+    // Each of these countries lists every code assigned to the carriers we
+    // know, including those they picked up from networks they bought, so a
+    // device on any of them is named rather than reported as unknown.
+    static constexpr const auto Table = Sort(std::array{
+        // Verizon
+        Entry{Key("310004"), Cell::Carrier::VZW},
+        Entry{Key("310005"), Cell::Carrier::VZW},
+        Entry{Key("310006"), Cell::Carrier::VZW},
+        Entry{Key("310010"), Cell::Carrier::VZW},
+        Entry{Key("310012"), Cell::Carrier::VZW},
+        Entry{Key("310013"), Cell::Carrier::VZW},
+        Entry{Key("310590"), Cell::Carrier::VZW},
+        Entry{Key("310890"), Cell::Carrier::VZW},
+        Entry{Key("310910"), Cell::Carrier::VZW},
+        Entry{Key("311012"), Cell::Carrier::VZW},
+        Entry{Key("311110"), Cell::Carrier::VZW},
+        Entry{Key("311270"), Cell::Carrier::VZW},
+        Entry{Key("311271"), Cell::Carrier::VZW},
+        Entry{Key("311272"), Cell::Carrier::VZW},
+        Entry{Key("311273"), Cell::Carrier::VZW},
+        Entry{Key("311274"), Cell::Carrier::VZW},
+        Entry{Key("311275"), Cell::Carrier::VZW},
+        Entry{Key("311276"), Cell::Carrier::VZW},
+        Entry{Key("311277"), Cell::Carrier::VZW},
+        Entry{Key("311278"), Cell::Carrier::VZW},
+        Entry{Key("311279"), Cell::Carrier::VZW},
+        Entry{Key("311280"), Cell::Carrier::VZW},
+        Entry{Key("311281"), Cell::Carrier::VZW},
+        Entry{Key("311282"), Cell::Carrier::VZW},
+        Entry{Key("311283"), Cell::Carrier::VZW},
+        Entry{Key("311284"), Cell::Carrier::VZW},
+        Entry{Key("311285"), Cell::Carrier::VZW},
+        Entry{Key("311286"), Cell::Carrier::VZW},
+        Entry{Key("311287"), Cell::Carrier::VZW},
+        Entry{Key("311288"), Cell::Carrier::VZW},
+        Entry{Key("311289"), Cell::Carrier::VZW},
+        Entry{Key("311390"), Cell::Carrier::VZW},
+        Entry{Key("311480"), Cell::Carrier::VZW},
+        Entry{Key("311481"), Cell::Carrier::VZW},
+        Entry{Key("311482"), Cell::Carrier::VZW},
+        Entry{Key("311483"), Cell::Carrier::VZW},
+        Entry{Key("311484"), Cell::Carrier::VZW},
+        Entry{Key("311485"), Cell::Carrier::VZW},
+        Entry{Key("311486"), Cell::Carrier::VZW},
+        Entry{Key("311487"), Cell::Carrier::VZW},
+        Entry{Key("311488"), Cell::Carrier::VZW},
+        Entry{Key("311489"), Cell::Carrier::VZW},
+        Entry{Key("311590"), Cell::Carrier::VZW},
+        Entry{Key("312770"), Cell::Carrier::VZW},
+
+        // AT&T, including FirstNet and Cricket
+        Entry{Key("310016"), Cell::Carrier::ATT},
+        Entry{Key("310030"), Cell::Carrier::ATT},
+        Entry{Key("310070"), Cell::Carrier::ATT},
+        Entry{Key("310080"), Cell::Carrier::ATT},
+        Entry{Key("310090"), Cell::Carrier::ATT},
+        Entry{Key("310150"), Cell::Carrier::ATT},
+        Entry{Key("310170"), Cell::Carrier::ATT},
+        Entry{Key("310280"), Cell::Carrier::ATT},
+        Entry{Key("310380"), Cell::Carrier::ATT},
+        Entry{Key("310410"), Cell::Carrier::ATT},
+        Entry{Key("310560"), Cell::Carrier::ATT},
+        Entry{Key("310670"), Cell::Carrier::ATT},
+        Entry{Key("310680"), Cell::Carrier::ATT},
+        Entry{Key("310950"), Cell::Carrier::ATT},
+        Entry{Key("311070"), Cell::Carrier::ATT},
+        Entry{Key("311090"), Cell::Carrier::ATT},
+        Entry{Key("311180"), Cell::Carrier::ATT},
+        Entry{Key("311190"), Cell::Carrier::ATT},
+        Entry{Key("312090"), Cell::Carrier::ATT},
+        Entry{Key("312670"), Cell::Carrier::ATT},
+        Entry{Key("312680"), Cell::Carrier::ATT},
+        Entry{Key("313100"), Cell::Carrier::ATT},
+
+        // T-Mobile, including the former Sprint, MetroPCS and Clearwire networks
+        Entry{Key("310026"), Cell::Carrier::TMB},
+        Entry{Key("310120"), Cell::Carrier::TMB},
+        Entry{Key("310160"), Cell::Carrier::TMB},
+        Entry{Key("310200"), Cell::Carrier::TMB},
+        Entry{Key("310210"), Cell::Carrier::TMB},
+        Entry{Key("310220"), Cell::Carrier::TMB},
+        Entry{Key("310230"), Cell::Carrier::TMB},
+        Entry{Key("310240"), Cell::Carrier::TMB},
+        Entry{Key("310250"), Cell::Carrier::TMB},
+        Entry{Key("310260"), Cell::Carrier::TMB},
+        Entry{Key("310270"), Cell::Carrier::TMB},
+        Entry{Key("310310"), Cell::Carrier::TMB},
+        Entry{Key("310490"), Cell::Carrier::TMB},
+        Entry{Key("310530"), Cell::Carrier::TMB},
+        Entry{Key("310580"), Cell::Carrier::TMB},
+        Entry{Key("310660"), Cell::Carrier::TMB},
+        Entry{Key("310800"), Cell::Carrier::TMB},
+        Entry{Key("311260"), Cell::Carrier::TMB},
+        Entry{Key("311490"), Cell::Carrier::TMB},
+        Entry{Key("311660"), Cell::Carrier::TMB},
+        Entry{Key("311870"), Cell::Carrier::TMB},
+        Entry{Key("311880"), Cell::Carrier::TMB},
+        Entry{Key("311882"), Cell::Carrier::TMB},
+        Entry{Key("311940"), Cell::Carrier::TMB},
+        Entry{Key("312190"), Cell::Carrier::TMB},
+        Entry{Key("312250"), Cell::Carrier::TMB},
+        Entry{Key("312530"), Cell::Carrier::TMB},
+        Entry{Key("316010"), Cell::Carrier::TMB},
+
+        // US Cellular
+        Entry{Key("311220"), Cell::Carrier::USC},
+        Entry{Key("311221"), Cell::Carrier::USC},
+        Entry{Key("311222"), Cell::Carrier::USC},
+        Entry{Key("311223"), Cell::Carrier::USC},
+        Entry{Key("311224"), Cell::Carrier::USC},
+        Entry{Key("311225"), Cell::Carrier::USC},
+        Entry{Key("311226"), Cell::Carrier::USC},
+        Entry{Key("311227"), Cell::Carrier::USC},
+        Entry{Key("311228"), Cell::Carrier::USC},
+        Entry{Key("311229"), Cell::Carrier::USC},
+        Entry{Key("311580"), Cell::Carrier::USC},
+        Entry{Key("311581"), Cell::Carrier::USC},
+        Entry{Key("311582"), Cell::Carrier::USC},
+        Entry{Key("311583"), Cell::Carrier::USC},
+        Entry{Key("311584"), Cell::Carrier::USC},
+        Entry{Key("311585"), Cell::Carrier::USC},
+        Entry{Key("311586"), Cell::Carrier::USC},
+        Entry{Key("311587"), Cell::Carrier::USC},
+        Entry{Key("311588"), Cell::Carrier::USC},
+        Entry{Key("311589"), Cell::Carrier::USC},
+
+        // Canada
+        Entry{Key("302220"), Cell::Carrier::TEL},
+        Entry{Key("302221"), Cell::Carrier::TEL},
+        Entry{Key("302360"), Cell::Carrier::TEL},
+        Entry{Key("302361"), Cell::Carrier::TEL},
+        Entry{Key("302653"), Cell::Carrier::TEL},
+        Entry{Key("302657"), Cell::Carrier::TEL},
+        Entry{Key("302760"), Cell::Carrier::TEL},
+        Entry{Key("302610"), Cell::Carrier::BEL},
+        Entry{Key("302630"), Cell::Carrier::BEL},
+        Entry{Key("302640"), Cell::Carrier::BEL},
+        Entry{Key("302651"), Cell::Carrier::BEL},
+        Entry{Key("302660"), Cell::Carrier::BEL},
+        Entry{Key("302690"), Cell::Carrier::BEL},
+        Entry{Key("302320"), Cell::Carrier::ROG},
+        Entry{Key("302370"), Cell::Carrier::ROG},
+        Entry{Key("302720"), Cell::Carrier::ROG},
+
+        // Mexico
+        Entry{Key("334020"), Cell::Carrier::TCL},
+        Entry{Key("334030"), Cell::Carrier::TEF},
+        Entry{Key("334010"), Cell::Carrier::ATT},
+        Entry{Key("334040"), Cell::Carrier::ATT},
+        Entry{Key("334050"), Cell::Carrier::ATT},
+        Entry{Key("334070"), Cell::Carrier::ATT},
+        Entry{Key("334080"), Cell::Carrier::ATT},
+        Entry{Key("334090"), Cell::Carrier::ATT},
+
+        // United Kingdom
+        Entry{Key("23402"), Cell::Carrier::TEF},
+        Entry{Key("23410"), Cell::Carrier::TEF},
+        Entry{Key("23411"), Cell::Carrier::TEF},
+        Entry{Key("23415"), Cell::Carrier::VOD},
+        Entry{Key("23491"), Cell::Carrier::VOD},
+        Entry{Key("23492"), Cell::Carrier::VOD},
+        Entry{Key("23420"), Cell::Carrier::THR},
+        Entry{Key("23494"), Cell::Carrier::THR},
+        Entry{Key("23430"), Cell::Carrier::EE},
+        Entry{Key("23431"), Cell::Carrier::EE},
+        Entry{Key("23432"), Cell::Carrier::EE},
+        Entry{Key("23433"), Cell::Carrier::EE},
+        Entry{Key("23434"), Cell::Carrier::EE},
+        Entry{Key("23486"), Cell::Carrier::EE},
+
+        // Germany
+        Entry{Key("26201"), Cell::Carrier::DTK},
+        Entry{Key("26206"), Cell::Carrier::DTK},
+        Entry{Key("26202"), Cell::Carrier::VOD},
+        Entry{Key("26204"), Cell::Carrier::VOD},
+        Entry{Key("26209"), Cell::Carrier::VOD},
+        Entry{Key("26203"), Cell::Carrier::TEF},
+        Entry{Key("26205"), Cell::Carrier::TEF},
+        Entry{Key("26207"), Cell::Carrier::TEF},
+        Entry{Key("26208"), Cell::Carrier::TEF},
+        Entry{Key("26211"), Cell::Carrier::TEF},
+        Entry{Key("26277"), Cell::Carrier::TEF},
+
+        // France
+        Entry{Key("20801"), Cell::Carrier::ORA},
+        Entry{Key("20802"), Cell::Carrier::ORA},
+        Entry{Key("20891"), Cell::Carrier::ORA},
+        Entry{Key("20809"), Cell::Carrier::SFR},
+        Entry{Key("20810"), Cell::Carrier::SFR},
+        Entry{Key("20811"), Cell::Carrier::SFR},
+        Entry{Key("20813"), Cell::Carrier::SFR},
+        Entry{Key("20815"), Cell::Carrier::FRE},
+        Entry{Key("20816"), Cell::Carrier::FRE},
+        Entry{Key("20820"), Cell::Carrier::BYT},
+        Entry{Key("20821"), Cell::Carrier::BYT},
+        Entry{Key("20888"), Cell::Carrier::BYT},
+
+        // Netherlands
+        Entry{Key("20404"), Cell::Carrier::VOD},
+        Entry{Key("20408"), Cell::Carrier::KPN},
+        Entry{Key("20410"), Cell::Carrier::KPN},
+        Entry{Key("20412"), Cell::Carrier::KPN},
+        Entry{Key("20469"), Cell::Carrier::KPN},
+        Entry{Key("20402"), Cell::Carrier::DTK},
+        Entry{Key("20416"), Cell::Carrier::DTK},
+        Entry{Key("20420"), Cell::Carrier::DTK},
+
+        // Italy
+        Entry{Key("22201"), Cell::Carrier::TIM},
+        Entry{Key("22243"), Cell::Carrier::TIM},
+        Entry{Key("22248"), Cell::Carrier::TIM},
+        Entry{Key("22206"), Cell::Carrier::VOD},
+        Entry{Key("22210"), Cell::Carrier::VOD},
+
+        // Spain
+        Entry{Key("21401"), Cell::Carrier::VOD},
+        Entry{Key("21406"), Cell::Carrier::VOD},
+        Entry{Key("21403"), Cell::Carrier::ORA},
+        Entry{Key("21409"), Cell::Carrier::ORA},
+        Entry{Key("21405"), Cell::Carrier::TEF},
+        Entry{Key("21407"), Cell::Carrier::TEF},
+
+        // Japan
+        Entry{Key("44010"), Cell::Carrier::NTT},
+        Entry{Key("44000"), Cell::Carrier::SFB},
+        Entry{Key("44020"), Cell::Carrier::SFB},
+        Entry{Key("44021"), Cell::Carrier::SFB},
+        Entry{Key("44050"), Cell::Carrier::KDI},
+        Entry{Key("44051"), Cell::Carrier::KDI},
+        Entry{Key("44052"), Cell::Carrier::KDI},
+        Entry{Key("44053"), Cell::Carrier::KDI},
+        Entry{Key("44054"), Cell::Carrier::KDI},
+        Entry{Key("44055"), Cell::Carrier::KDI},
+        Entry{Key("44056"), Cell::Carrier::KDI},
+        Entry{Key("44070"), Cell::Carrier::KDI},
+        Entry{Key("44071"), Cell::Carrier::KDI},
+        Entry{Key("44072"), Cell::Carrier::KDI},
+        Entry{Key("44073"), Cell::Carrier::KDI},
+        Entry{Key("44074"), Cell::Carrier::KDI},
+        Entry{Key("44075"), Cell::Carrier::KDI},
+        Entry{Key("44076"), Cell::Carrier::KDI},
+
+        // Australia
+        Entry{Key("50501"), Cell::Carrier::TLS},
+        Entry{Key("50511"), Cell::Carrier::TLS},
+        Entry{Key("50571"), Cell::Carrier::TLS},
+        Entry{Key("50572"), Cell::Carrier::TLS},
+        Entry{Key("50502"), Cell::Carrier::OPT},
+        Entry{Key("50590"), Cell::Carrier::OPT},
+        Entry{Key("50503"), Cell::Carrier::VOD},
+        Entry{Key("50506"), Cell::Carrier::VOD},
+        Entry{Key("50512"), Cell::Carrier::VOD},
+    });
+
+    /**
+     * \brief Checks that entries are sorted with no duplicate keys
+     *
+     * \param &entries
+     *      The entries to check
+     *
+     * \return bool
+     *      Whether or not the entries are sorted and unique
+     */
+    template <std::size_t Count>
+    static constexpr bool IsValid(const std::array<Entry, Count> &entries)
+    {
+        for (std::size_t i = 0; i < Count; i++)
+        {
+            if ((entries[i].key == 0) || ((i > 0) && (entries[i - 1].key >= entries[i].key)))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static_assert(IsValid(Table), "PLMN table has an invalid or duplicate code");
+
+    /**
+     * \brief Finds the carrier a PLMN code belongs to
+     *
+     * \param plmn
+     *      The PLMN code's digits, such as "310410"
+     *
+     * \return Cell::Carrier
+     *      The carrier, or Cell::Carrier::UKN if it isn't known
+     */
+    static constexpr Cell::Carrier Lookup(std::string_view plmn)
+    {
+        uint32_t key = Key(plmn);
+
+        std::size_t low = 0;
+        std::size_t high = std::size(Table);
+
+        while (low < high)
+        {
+            std::size_t middle = low + ((high - low) / 2);
+
+            if (Table[middle].key == key)
+            {
+                return Table[middle].carrier;
+            }
+
+            if (Table[middle].key < key)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+
+        return Cell::Carrier::UKN;
+    }
+
+    static_assert(Lookup("310410") == Cell::Carrier::ATT, "PLMN lookup is broken");
+    static_assert(Lookup("26201") == Cell::Carrier::DTK, "PLMN lookup is broken");
+    static_assert(Lookup("23486") == Cell::Carrier::EE, "PLMN lookup is broken");
+    static_assert(Lookup("311588") == Cell::Carrier::USC, "PLMN lookup is broken");
+    static_assert(Lookup("262001") == Cell::Carrier::UKN, "PLMN lookup is broken");
+}
@@ -0,0 +1,397 @@
+/**
+ * \file
+ *
+ * \brief Sends console output with UARTE EasyDMA
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <device.h>
+#include <kernel.h>
+
+#if !CONFIG_ASYNC_CONSOLE_LOOPBACK
+#include <drivers/uart.h>
+#endif
+
+#include "examples/console/console.h"
+#include "examples/utils.h"
+
+#if CONFIG_ASYNC_CONSOLE_PRINTK
+// Zephyr doesn't declare this in a header, as only console drivers are
+// expected to use it
+extern "C" void __printk_hook_install(int (*fn)(int));
+#endif
+
+using namespace NimbeLink::Examples;
+
+AsyncConsole *AsyncConsole::printer = nullptr;
+
+/**
+ * \brief Creates a new async console
+ *
+ * \param none
+ *
+ * \return none
+ */
+AsyncConsole::AsyncConsole(void)
+{
+#   if CONFIG_ASYNC_CONSOLE_LOOPBACK
+    k_timer_init(&this->timer, AsyncConsole::TimerHandler, nullptr);
+    k_timer_user_data_set(&this->timer, this);
+
+    this->ready = true;
+#   else
+    this->uart = device_get_binding(CONFIG_UART_CONSOLE_ON_DEV_NAME);
+
+    // If the UART doesn't do async, keep everything on the regular console
+    if ((this->uart == nullptr) || (uart_callback_set(this->uart, AsyncConsole::UartHandler, this) != 0))
+    {
+        printk("Console UART doesn't support async, not using DMA\n");
+
+        return;
+    }
+
+    this->ready = true;
+#   endif
+
+#   if CONFIG_ASYNC_CONSOLE_PRINTK
+    AsyncConsole::printer = this;
+
+    __printk_hook_install(AsyncConsole::PrintkHook);
+#   endif
+
+#   if CONFIG_ASYNC_CONSOLE_METRICS
+    this->lastReport = k_uptime_get();
+
+    k_delayed_work_init(&this->report, AsyncConsole::ReportHandler);
+    k_delayed_work_submit(&this->report, K_SECONDS(CONFIG_ASYNC_CONSOLE_METRICS_RATE));
+#   endif
+}
+
+#if CONFIG_ASYNC_CONSOLE_PRINTK
+/**
+ * \brief Takes a character of printk() output
+ *
+ *  Output from an interrupt, which includes the fault and panic handlers,
+ *  is sent right away. The system may never get back to the UART's
+ *  interrupt to send it otherwise.
+ *
+ * \param c
+ *      The character
+ *
+ * \return int
+ *      The character
+ */
+int AsyncConsole::PrintkHook(int c)
+{
+    // Terminals want a carriage return with each new line, as the UART
+    // console driver would've sent
+    static constexpr const char NewLine[] = {'\r', '\n'};
+
+    char character = static_cast<char>(c);
+
+    const char *data = &character;
+    std::size_t length = 1;
+
+    if (character == '\n')
+    {
+        data = NewLine;
+        length = sizeof(NewLine);
+    }
+
+    if (k_is_in_isr())
+    {
+        AsyncConsole::printer->Poll(data, length);
+    }
+    else
+    {
+        AsyncConsole::printer->Write(data, length);
+    }
+
+    return c;
+}
+
+/**
+ * \brief Sends output right away, waiting on the UART for each byte
+ *
+ *  Anything queued that hasn't started sending goes first, so output stays
+ *  in order. The driver waits for a send that's already underway to
+ *  finish.
+ *
+ * \param *data
+ *      The output
+ * \param length
+ *      The length of the output
+ *
+ * \return none
+ */
+void AsyncConsole::Poll(const char *data, std::size_t length)
+{
+    unsigned int key = irq_lock();
+
+    std::size_t &filled = this->lengths[this->filling];
+
+    for (std::size_t i = 0; i < filled; i++)
+    {
+        uart_poll_out(this->uart, static_cast<unsigned char>(this->buffers[this->filling][i]));
+    }
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        uart_poll_out(this->uart, static_cast<unsigned char>(data[i]));
+    }
+
+    this->stats.bytes += static_cast<uint32_t>(filled + length);
+
+    filled = 0;
+
+    irq_unlock(key);
+}
+#endif
+
+#if CONFIG_ASYNC_CONSOLE_LOOPBACK
+/**
+ * \brief Finishes a pretend send
+ *
+ * \param *timer
+ *      The timer that expired
+ *
+ * \return none
+ */
+void AsyncConsole::TimerHandler(struct k_timer *timer)
+{
+    AsyncConsole *console = static_cast<AsyncConsole *>(k_timer_user_data_get(timer));
+
+    if (console == nullptr)
+    {
+        return;
+    }
+
+    console->Done(console->inFlight);
+}
+#else
+/**
+ * \brief Handles a UART event
+ *
+ * \param *event
+ *      The event
+ * \param *context
+ *      A pointer to our console object
+ *
+ * \return none
+ */
+void AsyncConsole::UartHandler(struct uart_event *event, void *context)
+{
+    AsyncConsole *console = static_cast<AsyncConsole *>(context);
+
+    if ((console == nullptr) || (event == nullptr))
+    {
+        return;
+    }
+
+    switch (event->type)
+    {
+        // An aborted send still got some of its buffer out
+        case UART_TX_DONE:
+        case UART_TX_ABORTED:
+        {
+            console->Done(event->data.tx.len);
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+#endif
+
+#if CONFIG_ASYNC_CONSOLE_METRICS
+/**
+ * \brief Prints our statistics from the system work queue
+ *
+ * \param *work
+ *      Our report's work item
+ *
+ * \return none
+ */
+void AsyncConsole::ReportHandler(struct k_work *work)
+{
+    struct k_delayed_work *report = Utils::GetContainer<struct k_delayed_work, struct k_work, &k_delayed_work::work>(work);
+
+    AsyncConsole *console = Utils::GetContainer<AsyncConsole, struct k_delayed_work, &AsyncConsole::report>(report);
+
+    console->Print();
+
+    k_delayed_work_submit(&console->report, K_SECONDS(CONFIG_ASYNC_CONSOLE_METRICS_RATE));
+}
+#endif
+
+/**
+ * \brief Starts sending the buffer we've been filling
+ *
+ *  Must be called with interrupts locked, while nothing is sending and with
+ *  something to send.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void AsyncConsole::Start(void)
+{
+    uint8_t index = this->filling;
+    std::size_t length = this->lengths[index];
+
+    // Fill the other buffer while this one's sent
+    this->filling ^= 1;
+    this->lengths[this->filling] = 0;
+
+    this->sending = true;
+    this->stats.transfers++;
+
+#   if CONFIG_ASYNC_CONSOLE_LOOPBACK
+    // Ten bits go out for each byte
+    uint64_t time = (static_cast<uint64_t>(length) * 10 * 1000) / CONFIG_ASYNC_CONSOLE_LOOPBACK_BAUD;
+
+    this->inFlight = length;
+
+    k_timer_start(&this->timer, std::max<int32_t>(static_cast<int32_t>(time), 1), 0);
+#   else
+    int err = uart_tx(this->uart, reinterpret_cast<const uint8_t *>(this->buffers[index]), length, K_FOREVER);
+
+    if (err)
+    {
+        this->sending = false;
+        this->stats.dropped += length;
+    }
+#   endif
+}
+
+/**
+ * \brief Notes that a send finished and starts sending anything waiting
+ *
+ *  This is called from an interrupt.
+ *
+ * \param length
+ *      The number of bytes sent
+ *
+ * \return none
+ */
+void AsyncConsole::Done(std::size_t length)
+{
+    unsigned int key = irq_lock();
+
+    this->sending = false;
+    this->stats.bytes += length;
+
+    if (this->lengths[this->filling] > 0)
+    {
+        this->Start();
+    }
+
+    irq_unlock(key);
+}
+
+/**
+ * \brief Queues up output to send
+ *
+ *  This never waits on the UART, and can be called from anywhere, including
+ *  interrupts.
+ *
+ * \param *data
+ *      The output
+ * \param length
+ *      The length of the output
+ *
+ * \return std::size_t
+ *      How much of the output was queued, with the rest dropped as both
+ *      buffers are busy
+ */
+std::size_t AsyncConsole::Write(const char *data, std::size_t length)
+{
+    if (!this->ready)
+    {
+        Utils::Print(std::string_view(data, length));
+
+        return length;
+    }
+
+    unsigned int key = irq_lock();
+
+    std::size_t &filled = this->lengths[this->filling];
+    std::size_t count = std::min(length, sizeof(this->buffers[0]) - filled);
+
+    std::memcpy(&this->buffers[this->filling][filled], data, count);
+
+    filled += count;
+
+    this->stats.dropped += static_cast<uint32_t>(length - count);
+
+    if (!this->sending && (filled > 0))
+    {
+        this->Start();
+    }
+
+    irq_unlock(key);
+
+    return count;
+}
+
+/**
+ * \brief Gets our statistics
+ *
+ * \param none
+ *
+ * \return Stats
+ *      Our statistics
+ */
+AsyncConsole::Stats AsyncConsole::GetStats(void)
+{
+    unsigned int key = irq_lock();
+
+    Stats stats = this->stats;
+
+    irq_unlock(key);
+
+    return stats;
+}
+
+#if CONFIG_ASYNC_CONSOLE_METRICS
+/**
+ * \brief Prints how much we've sent since the last print
+ *
+ * \param none
+ *
+ * \return none
+ */
+void AsyncConsole::Print(void)
+{
+    Stats stats = this->GetStats();
+    int64_t now = k_uptime_get();
+
+    uint32_t bytes = stats.bytes - this->reported.bytes;
+    uint32_t elapsed = static_cast<uint32_t>(std::max<int64_t>(now - this->lastReport, 1));
+
+    printk("Console: %u bytes/s, %u bytes in %u transfers, %u dropped\n",
+        static_cast<unsigned int>((static_cast<uint64_t>(bytes) * 1000) / elapsed),
+        static_cast<unsigned int>(bytes),
+        static_cast<unsigned int>(stats.transfers - this->reported.transfers),
+        static_cast<unsigned int>(stats.dropped - this->reported.dropped)
+    );
+
+    this->reported = stats;
+    this->lastReport = now;
+}
+#endif
@@ -0,0 +1,117 @@
+/**
+ * \file
+ *
+ * \brief Sends console output with UARTE EasyDMA
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <device.h>
+#include <kernel.h>
+
+#if !CONFIG_ASYNC_CONSOLE_LOOPBACK
+#include <drivers/uart.h>
+#endif
+
+namespace NimbeLink::Examples
+{
+    class AsyncConsole;
+}
+
+// Sends console output a whole buffer at a time, without the CPU feeding the
+// UART a byte at a time
+//
+// Output is copied into one of two buffers while the UART sends the other
+// with EasyDMA, so writers only ever wait for the copy. Once a send finishes,
+// whatever piled up in the meantime is sent next. Output that doesn't fit
+// while both buffers are busy is dropped and counted, rather than making a
+// writer wait.
+class NimbeLink::Examples::AsyncConsole
+{
+    public:
+        /**
+         * \brief Console statistics
+         */
+        struct Stats
+        {
+            // Bytes the UART finished sending
+            uint32_t bytes;
+
+            // Sends started
+            uint32_t transfers;
+
+            // Bytes dropped because both buffers were busy
+            uint32_t dropped;
+        };
+
+    private:
+        // The console printk() output goes to, as its hook has no context
+        static AsyncConsole *printer;
+
+        // The buffer being filled, while the other may be sending
+        char buffers[2][CONFIG_ASYNC_CONSOLE_BUFFER_SIZE];
+        std::size_t lengths[2] = {};
+        uint8_t filling = 0;
+        bool sending = false;
+
+        // Whether or not we have somewhere to send output
+        bool ready = false;
+
+    #   if CONFIG_ASYNC_CONSOLE_LOOPBACK
+        // Stands in for the UART, finishing each send after as long as it
+        // would've taken on the wire
+        struct k_timer timer;
+        std::size_t inFlight = 0;
+    #   else
+        struct device *uart = nullptr;
+    #   endif
+
+        Stats stats = {};
+
+    #   if CONFIG_ASYNC_CONSOLE_METRICS
+        struct k_delayed_work report;
+        Stats reported = {};
+        int64_t lastReport = 0;
+    #   endif
+
+    private:
+    #   if CONFIG_ASYNC_CONSOLE_PRINTK
+        static int PrintkHook(int c);
+
+        void Poll(const char *data, std::size_t length);
+    #   endif
+
+    #   if CONFIG_ASYNC_CONSOLE_LOOPBACK
+        static void TimerHandler(struct k_timer *timer);
+    #   else
+        static void UartHandler(struct uart_event *event, void *context);
+    #   endif
+
+    #   if CONFIG_ASYNC_CONSOLE_METRICS
+        static void ReportHandler(struct k_work *work);
+    #   endif
+
+        void Start(void);
+        void Done(std::size_t length);
+
+    public:
+        AsyncConsole(void);
+
+        std::size_t Write(const char *data, std::size_t length);
+
+        Stats GetStats(void);
+
+    #   if CONFIG_ASYNC_CONSOLE_METRICS
+        void Print(void);
+    #   endif
+};
@@ -9,6 +9,11 @@
  *
  *      http://ascii-table.com/ansi-escape-sequences-vt-100.php
  *
+ *  Elements draw into a shadow of the screen, and only the characters that
+ *  changed since the last update are sent to the console. They're sent in
+ *  one pass of uart_poll_out() straight to its UART, or as a single buffer
+ *  through the async console when that's enabled.
+ *
  * (C) NimbeLink Corp. 2020
  *
  * All rights reserved except as explicitly granted in the license agreement
@@ -19,9 +24,15 @@
  */
 #include <array>
 #include <cstddef>
+#include <initializer_list>
 
+#include <device.h>
 #include <kernel.h>
 
+#if CONFIG_UART_CONSOLE
+#include <drivers/uart.h>
+#endif
+
 #include "examples/dashboard/dashboard.h"
 #include "nimbelink/sdk/secure_services/at.h"
 
@@ -76,6 +87,11 @@ Dashboard::Dashboard(
     windowWidth(windowWidth),
     windowHeight(windowHeight)
 {
+    // Write frames to the console's UART ourselves, rather than formatting
+    // them a character at a time through printk()
+#   if CONFIG_UART_CONSOLE && !CONFIG_ASYNC_CONSOLE
+    this->console = device_get_binding(CONFIG_UART_CONSOLE_ON_DEV_NAME);
+#   endif
 
     // Create our thread
     this->threadId = k_thread_create(
@@ -93,7 +109,7 @@ Dashboard::Dashboard(
 }
 
 /**
- * \brief Moves the cursor to the upper left of the window object
+ * \brief Moves the window's cursor to its upper left
  *
  * \param none
  *
@@ -101,7 +117,8 @@ Dashboard::Dashboard(
  */
 void Dashboard::Window::Setup(void)
 {
-    printk("%c[%d;%dH", ESC, this->row + 2, this->column + 1);
+    this->x = this->column;
+    this->y = this->row;
 }
 
 /**
@@ -152,35 +169,304 @@ int Dashboard::Window::Print(int c, void *context)
  */
 void Dashboard::Window::Print(int c)
 {
-    printk("%c", c);
-
-    // if a new line was printed, reset back to the start of the window
     switch (c)
     {
+        // if a new line was printed, reset back to the start of the window
         case '\n':
         {
-            this->MoveCursor(this->column);
+            this->x = this->column;
+            this->y++;
+            break;
+        }
+
+        default:
+        {
+            this->dashboard.Put(this->x, this->y, static_cast<char>(c));
+            this->x++;
             break;
         }
     }
 }
 
 /**
- * \brief Moves the cursor to the right using VT100 ESC codes
+ * \brief Draws a character on the next frame
  *
- * \param count
- *      The number of places to move the cursor over
+ *  Anything that falls off of the screen is dropped.
+ *
+ * \param column
+ *      The column to draw at
+ * \param row
+ *      The row to draw at
+ * \param c
+ *      The character to draw
  *
  * \return none
  */
-void Dashboard::Window::MoveCursor(std::size_t count)
+void Dashboard::Put(std::size_t column, std::size_t row, char c)
 {
-    if (count > 1)
+    if ((column < Columns) && (row < Rows))
     {
-        printk("%c[%dC", ESC, count);
+        this->frame[row][column] = c;
     }
 }
 
+/**
+ * \brief Sends any waiting characters to the console
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Dashboard::Flush(void)
+{
+    if (this->outputLength == 0)
+    {
+        return;
+    }
+
+#   if CONFIG_DASHBOARD_BENCHMARK
+    uint32_t started = k_cycle_get_32();
+#   endif
+
+#   if CONFIG_ASYNC_CONSOLE
+    if (this->asyncConsole != nullptr)
+    {
+        if (this->asyncConsole->Write(this->output, this->outputLength) < this->outputLength)
+        {
+            this->lost = true;
+        }
+    }
+    else
+#   endif
+#   if CONFIG_UART_CONSOLE
+    if (this->console != nullptr)
+    {
+        // This skips printk()'s formatting and hooks, but still waits on the
+        // UART for each byte; the async console hands the whole buffer to
+        // the UART instead
+        for (std::size_t i = 0; i < this->outputLength; i++)
+        {
+            uart_poll_out(this->console, static_cast<unsigned char>(this->output[i]));
+        }
+    }
+    else
+#   endif
+    {
+        this->output[this->outputLength] = '\0';
+
+        printk("%s", this->output);
+    }
+
+#   if CONFIG_DASHBOARD_BENCHMARK
+    this->outputCycles += k_cycle_get_32() - started;
+#   endif
+
+    this->sent += this->outputLength;
+    this->outputLength = 0;
+}
+
+/**
+ * \brief Queues up a character to send to the console
+ *
+ * \param c
+ *      The character
+ *
+ * \return none
+ */
+void Dashboard::Emit(char c)
+{
+    // Leave room for the terminator
+    if (this->outputLength >= (sizeof(this->output) - 1))
+    {
+        this->Flush();
+    }
+
+    this->output[this->outputLength++] = c;
+}
+
+/**
+ * \brief Queues up a number to send to the console
+ *
+ * \param number
+ *      The number
+ *
+ * \return none
+ */
+void Dashboard::EmitNumber(std::size_t number)
+{
+    char digits[10];
+    std::size_t count = 0;
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + (number % 10));
+        number /= 10;
+    } while ((number > 0) && (count < sizeof(digits)));
+
+    while (count > 0)
+    {
+        this->Emit(digits[--count]);
+    }
+}
+
+/**
+ * \brief Queues up moving the console's cursor using VT100 ESC codes
+ *
+ * \param column
+ *      The column to move to
+ * \param row
+ *      The row to move to
+ *
+ * \return none
+ */
+void Dashboard::EmitMove(std::size_t column, std::size_t row)
+{
+    // The dashboard starts on the console's second row
+    this->Emit(ESC);
+    this->Emit('[');
+    this->EmitNumber(row + 2);
+    this->Emit(';');
+    this->EmitNumber(column + 1);
+    this->Emit('H');
+}
+
+/**
+ * \brief Sends the characters that changed since the last update
+ *
+ *  Changed characters close enough to each other on a row are reached by
+ *  printing the unchanged ones between them again, rather than by moving the
+ *  cursor.
+ *
+ * \param all
+ *      Whether to send everything that's been drawn, such as when something
+ *      else may have printed over the dashboard
+ *
+ * \return std::size_t
+ *      The number of bytes sent
+ */
+std::size_t Dashboard::Render(bool all)
+{
+    this->sent = 0;
+
+#   if CONFIG_DASHBOARD_BENCHMARK
+    this->outputCycles = 0;
+#   endif
+
+    // We don't know where the cursor is until we've moved it
+    std::size_t cursorColumn = Columns;
+    std::size_t cursorRow = Rows;
+
+    for (std::size_t row = 0; row < Rows; row++)
+    {
+        for (std::size_t column = 0; column < Columns; column++)
+        {
+            char c = this->frame[row][column];
+
+            if ((c == '\0') || (!all && (c == this->shown[row][column])))
+            {
+                continue;
+            }
+
+            if ((row != cursorRow) || (column != cursorColumn))
+            {
+                bool reprint = ((row == cursorRow) &&
+                                (column > cursorColumn) &&
+                                ((column - cursorColumn) <= MaxReprint));
+
+                for (std::size_t i = cursorColumn; reprint && (i < column); i++)
+                {
+                    reprint = (this->frame[row][i] != '\0');
+                }
+
+                if (reprint)
+                {
+                    for (std::size_t i = cursorColumn; i < column; i++)
+                    {
+                        this->Emit(this->frame[row][i]);
+                    }
+                }
+                else
+                {
+                    this->EmitMove(column, row);
+                }
+            }
+
+            this->Emit(c);
+            this->shown[row][column] = c;
+
+            cursorColumn = column + 1;
+            cursorRow = row;
+        }
+    }
+
+    this->Flush();
+
+    return this->sent;
+}
+
+#if CONFIG_DASHBOARD_BENCHMARK
+/**
+ * \brief Notes how long an update took, and prints the averages every so
+ *        often
+ *
+ *  Updates that sent everything are kept apart from those that only sent
+ *  changes. The time spent handing output over is split out from the time
+ *  spent working out what to send, as without the async console it's mostly
+ *  waiting on the UART for each byte.
+ *
+ * \param all
+ *      Whether the update sent everything
+ * \param drawCycles
+ *      The hardware cycles the elements took to draw
+ * \param sendCycles
+ *      The hardware cycles it took to work out and send the changes, of which
+ *      outputCycles were spent handing them over
+ * \param bytes
+ *      The number of bytes sent
+ *
+ * \return none
+ */
+void Dashboard::Measure(bool all, uint32_t drawCycles, uint32_t sendCycles, std::size_t bytes)
+{
+    Benchmark &benchmark = all ? this->full : this->changed;
+
+    benchmark.frames++;
+    benchmark.drawCycles += drawCycles;
+    benchmark.diffCycles += sendCycles - this->outputCycles;
+    benchmark.outputCycles += this->outputCycles;
+    benchmark.bytes += bytes;
+
+    if ((this->changed.frames + this->full.frames) < CONFIG_DASHBOARD_BENCHMARK_FRAMES)
+    {
+        return;
+    }
+
+    for (const Benchmark *current : {&this->changed, &this->full})
+    {
+        if (current->frames == 0)
+        {
+            continue;
+        }
+
+        uint32_t cycles = (current->drawCycles + current->diffCycles + current->outputCycles) / current->frames;
+
+        printk("Dashboard %s: %u frames, avg %u cycles (%u us; draw %u, diff %u, output %u), %u bytes\n",
+            (current == &this->full) ? "full" : "changes",
+            static_cast<unsigned int>(current->frames),
+            static_cast<unsigned int>(cycles),
+            static_cast<unsigned int>((static_cast<uint64_t>(cycles) * 1000000) / CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC),
+            static_cast<unsigned int>(current->drawCycles / current->frames),
+            static_cast<unsigned int>(current->diffCycles / current->frames),
+            static_cast<unsigned int>(current->outputCycles / current->frames),
+            static_cast<unsigned int>(current->bytes / current->frames)
+        );
+    }
+
+    this->changed = {};
+    this->full = {};
+}
+#endif
+
 /**
  * \brief Runs our dashboard example
  *
@@ -195,17 +481,53 @@ void Dashboard::Run(void)
         // Wait until we're ready to sample
         k_sleep(K_SECONDS(CONFIG_DASHBOARD_UPDATE_RATE));
 
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        uint32_t started = k_cycle_get_32();
+    #   endif
+
         for (std::size_t i = 0; i < this->size; i++)
         {
             std::size_t column = (i % this->windowColumns) * this->windowWidth;
-            std::size_t row = (i / this->windowRows) * this->windowHeight;
+            std::size_t row = (i / this->windowColumns) * this->windowHeight;
 
-            Window window(column, row);
+            Window window(*this, column, row);
 
             window.Setup();
 
             this->elements[i]->Display(window);
         }
+
+        // Every so often send everything again, in case other output has
+        // scrolled or printed over the dashboard, and right away if some of
+        // the last update was dropped
+        bool all = this->lost;
+
+        this->lost = false;
+
+    #   if CONFIG_DASHBOARD_FULL_REDRAW_RATE > 0
+        if (++this->updates >= CONFIG_DASHBOARD_FULL_REDRAW_RATE)
+        {
+            all = true;
+
+            this->updates = 0;
+        }
+    #   endif
+
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        uint32_t drawn = k_cycle_get_32();
+    #   endif
+
+        std::size_t sent = this->Render(all);
+
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        this->Measure(all, drawn - started, k_cycle_get_32() - drawn, sent);
+    #   endif
+
+    #   if CONFIG_DASHBOARD_DEBUG
+        printk("Dashboard sent %u bytes\n", static_cast<unsigned int>(sent));
+    #   else
+        (void)sent;
+    #   endif
     }
 }
 
@@ -225,3 +547,18 @@ void Dashboard::RegisterElement(Element &element)
     printk("Registered element %d\n", this->size - 1);
 #   endif
 }
+
+#if CONFIG_ASYNC_CONSOLE
+/**
+ * \brief Sends our updates through an async console
+ *
+ * \param &console
+ *      The console to send through
+ *
+ * \return none
+ */
+void Dashboard::SetConsole(AsyncConsole &console)
+{
+    this->asyncConsole = &console;
+}
+#endif
@@ -9,6 +9,11 @@
  *
  *      http://ascii-table.com/ansi-escape-sequences-vt-100.php
  *
+ *  Elements draw into a shadow of the screen, and only the characters that
+ *  changed since the last update are sent to the console. They're sent in
+ *  one pass of uart_poll_out() straight to its UART, or as a single buffer
+ *  through the async console when that's enabled.
+ *
  * (C) NimbeLink Corp. 2020
  *
  * All rights reserved except as explicitly granted in the license agreement
@@ -20,10 +25,16 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include <device.h>
 #include <kernel.h>
 
+#if CONFIG_ASYNC_CONSOLE
+#include "examples/console/console.h"
+#endif
+
 #define ESC 0x1B
 
 namespace NimbeLink::Examples
@@ -38,28 +49,38 @@ class NimbeLink::Examples::Dashboard
         class Window
         {
             private:
+                // The dashboard we're drawing on
+                Dashboard &dashboard;
+
                 // Defines the upper left corner
                 std::size_t column;
                 std::size_t row;
 
+                // Where the next character goes
+                std::size_t x;
+                std::size_t y;
+
             private:
                 static int Print(int c, void *context);
                 void Print(int c);
 
-                void MoveCursor(std::size_t count);
-
             public:
                 /**
                  * \brief Creates a new window
                  *
+                 * \param &dashboard
+                 *      The dashboard to draw on
                  * \param c
                  *      The upper-left column
                  * \param r
                  *      The upper-left row
                  */
-                constexpr Window(std::size_t column, std::size_t row):
+                constexpr Window(Dashboard &dashboard, std::size_t column, std::size_t row):
+                    dashboard(dashboard),
                     column(column),
-                    row(row) {}
+                    row(row),
+                    x(column),
+                    y(row) {}
 
                 void Setup(void);
                 void Print(const char *format, ...);
@@ -75,6 +96,29 @@ class NimbeLink::Examples::Dashboard
         };
 
     private:
+        // The size of the whole screen, in characters
+        static constexpr const std::size_t Columns = CONFIG_DASHBOARD_X * CONFIG_DASHBOARD_W;
+        static constexpr const std::size_t Rows = CONFIG_DASHBOARD_Y * CONFIG_DASHBOARD_H;
+
+        // The most unchanged characters we'll print again to get past them,
+        // since moving the cursor takes at least six bytes
+        static constexpr const std::size_t MaxReprint = 5;
+
+        // The longest cursor move, "ESC[rrr;cccH"
+        static constexpr const std::size_t MaxMove = 10;
+
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        // How long updates have been taking, in hardware cycles
+        struct Benchmark
+        {
+            uint32_t frames;
+            uint32_t drawCycles;
+            uint32_t diffCycles;
+            uint32_t outputCycles;
+            uint32_t bytes;
+        };
+    #   endif
+
         // Our Zephyr stack
         //
         // C++ isn't a big fan of placing a class' member in a section, so
@@ -100,9 +144,62 @@ class NimbeLink::Examples::Dashboard
         std::size_t windowWidth;
         std::size_t windowHeight;
 
+        // What the elements drew this update, and what's on the screen
+        //
+        // Characters that have never been drawn are left as '\0', so we don't
+        // draw over anything we don't own.
+        char frame[Rows][Columns] = {};
+        char shown[Rows][Columns] = {};
+
+        // Characters waiting to be sent to the console
+        //
+        // This fits a whole frame with a cursor move on each row, so an
+        // update normally goes out in a single flush.
+        char output[(Rows * (Columns + MaxMove)) + 1];
+        std::size_t outputLength = 0;
+
+        // What we send to, or nullptr to go through printk()
+        struct device *console = nullptr;
+
+    #   if CONFIG_ASYNC_CONSOLE
+        AsyncConsole *asyncConsole = nullptr;
+    #   endif
+
+        // Whether or not some of an update didn't make it out, which leaves
+        // the screen out of step with what we think is shown
+        bool lost = false;
+
+        // How many updates there have been since everything was drawn
+        uint32_t updates = 0;
+
+        // How many bytes this update has sent
+        std::size_t sent = 0;
+
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        // How long this update has spent handing its output over
+        uint32_t outputCycles = 0;
+
+        // Updates that sent only changes, and updates that sent everything
+        Benchmark changed = {};
+        Benchmark full = {};
+    #   endif
+
     private:
         static void Handler(void *arg1, void *arg2, void *arg3);
 
+        void Put(std::size_t column, std::size_t row, char c);
+
+        void Flush(void);
+        void Emit(char c);
+        void EmitNumber(std::size_t number);
+        void EmitMove(std::size_t column, std::size_t row);
+
+        std::size_t Render(bool all);
+
+    #   if CONFIG_DASHBOARD_BENCHMARK
+        void Measure(bool all, uint32_t drawCycles, uint32_t sendCycles, std::size_t bytes);
+    #   endif
+
         void Run(void);
 
     public:
@@ -114,4 +211,8 @@ class NimbeLink::Examples::Dashboard
         );
 
         void RegisterElement(Element &element);
+
+    #   if CONFIG_ASYNC_CONSOLE
+        void SetConsole(AsyncConsole &console);
+    #   endif
 };
@@ -34,12 +34,12 @@ using namespace NimbeLink::Examples;
  */
 void CellDisplay::Display(Dashboard::Window &window)
 {
-    Cell::CellData *data = this->cell.GetStruct();
+    Cell::CellData data = this->cell.GetData();
 
     window.Print("+--------------+\n");
     window.Print("|  Networking  |\n");
-    window.Print("|  rsrp:%4d   |\n", static_cast<uint8_t>(data->rsrp));
-    window.Print("|  rsrq:%4d   |\n", static_cast<uint8_t>(data->rsrq));
-    window.Print("| carrier: %s |\n", Cell::GetCarrierString(data->carrier));
+    window.Print("|  rsrp:%4d   |\n", data.rsrp);
+    window.Print("|  rsrq:%4d   |\n", data.rsrq);
+    window.Print("| carrier: %-3s |\n", Cell::GetCarrierString(data.carrier));
     window.Print("+--------------+\n");
 }
@@ -0,0 +1,206 @@
+/**
+ * \file
+ *
+ * \brief A minimal CBOR encoder for the socket applet's posts
+ *
+ *  Only what widget fields need is supported: maps, integers and text
+ *  strings. See RFC 7049 for the encoding.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace NimbeLink::Examples
+{
+    class CborWriter;
+}
+
+class NimbeLink::Examples::CborWriter
+{
+    public:
+        // The start of a map whose length isn't known up front
+        static constexpr const uint8_t MapStart = 0xBF;
+
+        // The end of a map whose length wasn't known up front
+        static constexpr const uint8_t Break = 0xFF;
+
+    private:
+        // CBOR's major types
+        enum MajorType : uint8_t
+        {
+            Unsigned = 0,
+            Negative = 1,
+            Text = 3,
+        };
+
+        // Where we write to
+        uint8_t *buffer;
+        std::size_t size;
+        std::size_t length;
+
+        // Whether we ran out of room
+        bool overflowed = false;
+
+    private:
+        /**
+         * \brief Writes bytes
+         *
+         * \param *data
+         *      The bytes to write
+         * \param count
+         *      The number of bytes to write
+         *
+         * \return none
+         */
+        void Write(const void *data, std::size_t count)
+        {
+            if (this->overflowed || (count > (this->size - this->length)))
+            {
+                this->overflowed = true;
+
+                return;
+            }
+
+            memcpy(&this->buffer[this->length], data, count);
+
+            this->length += count;
+        }
+
+        /**
+         * \brief Writes an item's header
+         *
+         * \param type
+         *      The item's major type
+         * \param value
+         *      The item's value or length
+         *
+         * \return none
+         */
+        void Header(MajorType type, uint32_t value)
+        {
+            uint8_t header[5];
+            std::size_t count;
+
+            header[0] = static_cast<uint8_t>(type << 5);
+
+            if (value < 24)
+            {
+                header[0] |= value;
+                count = 1;
+            }
+            else if (value <= UINT8_MAX)
+            {
+                header[0] |= 24;
+                header[1] = static_cast<uint8_t>(value);
+                count = 2;
+            }
+            else if (value <= UINT16_MAX)
+            {
+                header[0] |= 25;
+                header[1] = static_cast<uint8_t>(value >> 8);
+                header[2] = static_cast<uint8_t>(value);
+                count = 3;
+            }
+            else
+            {
+                header[0] |= 26;
+                header[1] = static_cast<uint8_t>(value >> 24);
+                header[2] = static_cast<uint8_t>(value >> 16);
+                header[3] = static_cast<uint8_t>(value >> 8);
+                header[4] = static_cast<uint8_t>(value);
+                count = 5;
+            }
+
+            this->Write(header, count);
+        }
+
+    public:
+        /**
+         * \brief Creates a new CBOR writer
+         *
+         * \param *buffer
+         *      The buffer to write to
+         * \param size
+         *      The size of the buffer
+         * \param length
+         *      How much of the buffer has already been written
+         *
+         * \return none
+         */
+        constexpr CborWriter(uint8_t *buffer, std::size_t size, std::size_t length = 0):
+            buffer(buffer),
+            size(size),
+            length(length) {}
+
+        /**
+         * \brief Gets how much of the buffer has been written
+         *
+         * \param none
+         *
+         * \return std::size_t
+         *      The length
+         */
+        std::size_t GetLength(void) const
+        {
+            return this->length;
+        }
+
+        /**
+         * \brief Gets whether everything written so far fit
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether everything fit
+         */
+        bool IsValid(void) const
+        {
+            return !this->overflowed;
+        }
+
+        /**
+         * \brief Writes a signed integer
+         *
+         * \param value
+         *      The integer
+         *
+         * \return none
+         */
+        void Integer(int32_t value)
+        {
+            if (value < 0)
+            {
+                // Negative integers are encoded as -1 - n
+                this->Header(Negative, static_cast<uint32_t>(-1 - value));
+            }
+            else
+            {
+                this->Header(Unsigned, static_cast<uint32_t>(value));
+            }
+        }
+
+        /**
+         * \brief Writes a text string
+         *
+         * \param string
+         *      The string
+         *
+         * \return none
+         */
+        void String(std::string_view string)
+        {
+            this->Header(Text, std::size(string));
+            this->Write(std::data(string), std::size(string));
+        }
+};
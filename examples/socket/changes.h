@@ -0,0 +1,246 @@
+/**
+ * \file
+ *
+ * \brief Picks out which of the widgets' fields are worth posting
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <kernel.h>
+
+#include "examples/socket/field.h"
+
+namespace NimbeLink::Examples
+{
+    template <std::size_t Slots, std::size_t Fields>
+    class ChangeFilter;
+}
+
+// Keeps a snapshot of what the server last acknowledged for each widget, and
+// only lets through fields that have moved past their deadband since
+//
+// What gets sent each cycle is held as pending until Commit() is called,
+// which should only happen once the server has acknowledged it. Every so
+// often, a heartbeat lets all of a widget's fields through regardless.
+template <std::size_t Slots, std::size_t Fields>
+class NimbeLink::Examples::ChangeFilter
+{
+    private:
+        // A field's value, with strings kept as a hash
+        struct Value
+        {
+            const char *name;
+            int32_t integer;
+            uint32_t hash;
+        };
+
+        // What we know about a widget's fields
+        struct Snapshot
+        {
+            Value values[Fields];
+            std::size_t count;
+            bool valid;
+
+            // When every field was last sent
+            int64_t heartbeat;
+        };
+
+        // How often to send every field, in milliseconds
+        int64_t heartbeatRate;
+
+        // When this cycle started
+        int64_t now = 0;
+
+        // How many widgets are having every field sent this cycle
+        std::size_t heartbeats = 0;
+
+        // What the server has acknowledged, and what we've sent since
+        Snapshot acked[Slots] = {};
+        Snapshot pending[Slots] = {};
+
+    private:
+        /**
+         * \brief Hashes a string
+         *
+         * \param *string
+         *      The string to hash
+         *
+         * \return uint32_t
+         *      The string's 32-bit FNV-1a hash
+         */
+        static uint32_t Hash(const char *string)
+        {
+            uint32_t hash = 2166136261u;
+
+            for (; (string != nullptr) && (*string != '\0'); string++)
+            {
+                hash = (hash ^ static_cast<uint8_t>(*string)) * 16777619u;
+            }
+
+            return hash;
+        }
+
+        /**
+         * \brief Gets if a field has moved past its deadband
+         *
+         * \param &field
+         *      The field
+         * \param &value
+         *      What was last acknowledged for the field
+         *
+         * \return bool
+         *      Whether or not the field has changed
+         */
+        static bool HasChanged(const Field &field, const Value &value)
+        {
+            if (field.name != value.name)
+            {
+                return true;
+            }
+
+            if (field.type == Field::Type::String)
+            {
+                return (Hash(field.string) != value.hash);
+            }
+
+            int64_t threshold = field.deadband;
+
+            if (field.relative)
+            {
+                threshold = (std::abs(static_cast<int64_t>(value.integer)) * field.deadband) / 100;
+            }
+
+            return (std::abs(static_cast<int64_t>(field.integer) - value.integer) > threshold);
+        }
+
+    public:
+        /**
+         * \brief Creates a new change filter
+         *
+         * \param heartbeatRate
+         *      How often to send every field, in milliseconds
+         *
+         * \return none
+         */
+        constexpr ChangeFilter(int64_t heartbeatRate):
+            heartbeatRate(heartbeatRate) {}
+
+        /**
+         * \brief Starts a new cycle of filtering
+         *
+         * \param none
+         *
+         * \return none
+         */
+        void Begin(void)
+        {
+            this->now = k_uptime_get();
+            this->heartbeats = 0;
+
+            // Anything that isn't sent this cycle stays at what was last
+            // acknowledged
+            for (std::size_t i = 0; i < Slots; i++)
+            {
+                this->pending[i] = this->acked[i];
+            }
+        }
+
+        /**
+         * \brief Gets how many widgets are having every field sent this
+         *        cycle
+         *
+         * \param none
+         *
+         * \return std::size_t
+         *      The number of widgets
+         */
+        std::size_t GetHeartbeats(void) const
+        {
+            return this->heartbeats;
+        }
+
+        /**
+         * \brief Removes a widget's fields that haven't changed
+         *
+         *  The fields that are left are moved to the front, in order.
+         *
+         * \param slot
+         *      Which widget the fields are from
+         * \param *fields
+         *      The widget's fields
+         * \param count
+         *      The number of fields
+         *
+         * \return std::size_t
+         *      The number of fields left
+         */
+        std::size_t Filter(std::size_t slot, Field *fields, std::size_t count)
+        {
+            if ((slot >= Slots) || (count > Fields))
+            {
+                return count;
+            }
+
+            const Snapshot &acked = this->acked[slot];
+            Snapshot &pending = this->pending[slot];
+
+            // If the widget's fields aren't what they were, start over
+            bool all = !acked.valid || (acked.count != count) || ((this->now - acked.heartbeat) >= this->heartbeatRate);
+
+            if (all)
+            {
+                pending.heartbeat = this->now;
+
+                this->heartbeats++;
+            }
+
+            std::size_t kept = 0;
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (!all && !HasChanged(fields[i], acked.values[i]))
+                {
+                    continue;
+                }
+
+                pending.values[i] = {
+                    fields[i].name,
+                    fields[i].integer,
+                    (fields[i].type == Field::Type::String) ? Hash(fields[i].string) : 0,
+                };
+
+                fields[kept++] = fields[i];
+            }
+
+            pending.count = count;
+            pending.valid = true;
+
+            return kept;
+        }
+
+        /**
+         * \brief Marks what was sent this cycle as acknowledged
+         *
+         * \param none
+         *
+         * \return none
+         */
+        void Commit(void)
+        {
+            for (std::size_t i = 0; i < Slots; i++)
+            {
+                this->acked[i] = this->pending[i];
+            }
+        }
+};
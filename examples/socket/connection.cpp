@@ -0,0 +1,682 @@
+/**
+ * \file
+ *
+ * \brief A persistent HTTP/1.1 keep-alive connection for the socket applet
+ *
+ *  Opening a TCP connection over LTE-M costs seconds of radio-on time, so we
+ *  keep a single connection open across posts and only reconnect once the
+ *  peer has closed it.
+ *
+ *  The socket is non-blocking, and connecting, sending and waiting for a
+ *  response each give up after their own timeout. Requests are pipelined,
+ *  so a request can be sent while responses to earlier ones are still on
+ *  their way, and those responses are read whenever Service() is called.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+#include <kernel.h>
+#include <net/socket.h>
+
+#include "examples/socket/connection.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Checks whether the peer has closed our connection
+ *
+ *  A keep-alive connection shouldn't have anything waiting to be read when
+ *  we aren't waiting on a response, so if the socket polls as readable the
+ *  peer either hung up or sent us something we don't care about anymore.
+ *
+ * \param none
+ *
+ * \return true
+ *      The connection can still be used
+ * \return false
+ *      The connection was closed by the peer
+ */
+bool Connection::IsAlive(void)
+{
+    struct pollfd sock[1];
+
+    sock[0].fd = this->socketId;
+    sock[0].events = POLLIN;
+
+    int ret = poll(sock, 1, 0);
+
+    if (ret < 0)
+    {
+        return false;
+    }
+
+    if (ret == 0)
+    {
+        return true;
+    }
+
+    if (sock[0].revents & (POLLHUP | POLLERR | POLLNVAL))
+    {
+        return false;
+    }
+
+    // A read of zero bytes means the peer has closed their end, and anything
+    // else is stale and gets dropped
+    return (recv(this->socketId, this->chunk, sizeof(this->chunk), 0) > 0);
+}
+
+/**
+ * \brief Waits for our socket to be ready
+ *
+ * \param events
+ *      The poll events to wait for
+ * \param deadline
+ *      The uptime to stop waiting at, in milliseconds
+ *
+ * \return >0
+ *      The socket is ready
+ * \return 0
+ *      The deadline passed
+ * \return <0
+ *      Error
+ */
+int Connection::Wait(short events, int64_t deadline)
+{
+    int64_t timeout = deadline - k_uptime_get();
+
+    if (timeout < 0)
+    {
+        timeout = 0;
+    }
+
+    struct pollfd sock[1];
+
+    sock[0].fd = this->socketId;
+    sock[0].events = events;
+
+    int ret = poll(sock, 1, static_cast<int>(timeout));
+
+    if (ret <= 0)
+    {
+        return ret;
+    }
+
+    if (sock[0].revents & (POLLERR | POLLNVAL))
+    {
+        return -1;
+    }
+
+    return ret;
+}
+
+/**
+ * \brief Checks whether a new connection needs to be opened
+ *
+ *  If the peer closed our connection since we last used it, our end is
+ *  closed as well.
+ *
+ * \param none
+ *
+ * \return true
+ *      Open() needs to be called before sending
+ * \return false
+ *      The current connection is still usable
+ */
+bool Connection::NeedsOpen(void)
+{
+    if (!this->IsOpen())
+    {
+        return true;
+    }
+
+    // Anything waiting to be read belongs to a response, and reading it
+    // will tell us if the peer has hung up
+    if (this->pending > 0)
+    {
+        this->Service(0);
+
+        return !this->IsOpen();
+    }
+
+    if (!this->IsAlive())
+    {
+    #   if CONFIG_SOCKET_DEBUG
+        printk("Connection closed by peer\n");
+    #   endif
+
+        this->Close();
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * \brief Opens our connection if it isn't already open
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int Connection::Open(void)
+{
+    if (!this->NeedsOpen())
+    {
+        return 0;
+    }
+
+#   if CONFIG_SOCKET_METRICS
+    int64_t start = k_uptime_get();
+#   endif
+
+    struct sockaddr_in address;
+
+    if (this->resolver.Resolve(this->host, address) != 0)
+    {
+        return -1;
+    }
+
+    address.sin_port = htons(this->port);
+
+    int socketId = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (socketId < 0)
+    {
+        printk("Unable to open socket\n");
+
+        return socketId;
+    }
+
+    this->socketId = socketId;
+
+    // Everything from here on waits with poll(), so that nothing can block
+    // us for longer than its timeout
+    if (fcntl(socketId, F_SETFL, O_NONBLOCK) < 0)
+    {
+        printk("Unable to make socket non-blocking\n");
+
+        this->Close();
+
+        return -1;
+    }
+
+    int err = connect(socketId, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+
+    if ((err != 0) && (errno == EINPROGRESS))
+    {
+        int ret = this->Wait(POLLOUT, k_uptime_get() + CONFIG_SOCKET_CONNECT_TIMEOUT);
+
+        if (ret == 0)
+        {
+            this->stats.timeouts++;
+        }
+
+        socklen_t length = sizeof(err);
+
+        if ((ret <= 0) || (getsockopt(socketId, SOL_SOCKET, SO_ERROR, &err, &length) != 0))
+        {
+            err = -1;
+        }
+    }
+
+    if (err != 0)
+    {
+        printk("Unable to connect to %s, err %d\n", this->host, err);
+
+        this->Close();
+
+        return -1;
+    }
+
+#   if CONFIG_SOCKET_DEBUG
+    printk("Connected to %s\n", this->host);
+#   endif
+
+#   if CONFIG_SOCKET_METRICS
+    if (this->metrics != nullptr)
+    {
+        this->metrics->connect.Add(k_uptime_get() - start);
+    }
+#   endif
+
+    return 0;
+}
+
+/**
+ * \brief Closes our connection
+ *
+ *  Any requests still waiting on responses are counted as failed.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Connection::Close(void)
+{
+    if (!this->IsOpen())
+    {
+        return;
+    }
+
+    close(this->socketId);
+
+    this->socketId = -1;
+
+    this->stats.failed += this->pending;
+    this->pending = 0;
+
+    this->response = {true, false, 0, -1, 0, 0};
+}
+
+/**
+ * \brief Sends a request over our connection
+ *
+ *  The request is gathered from each segment by the socket with sendmsg().
+ *  If we're already waiting on as many responses as we can track, this
+ *  waits for the oldest one first.
+ *
+ *  If the send fails, the connection is closed so that the next Open()
+ *  reconnects.
+ *
+ * \param *segments
+ *      The segments of the request to send, in order
+ * \param count
+ *      The number of segments
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int Connection::Send(const struct iovec *segments, std::size_t count)
+{
+    struct iovec remaining[MaxSegments];
+
+    if (count > std::size(remaining))
+    {
+        return -1;
+    }
+
+    if (this->pending >= MaxPending)
+    {
+        this->Receive(INT64_MAX, MaxPending - 1);
+    }
+
+    if (!this->IsOpen())
+    {
+        return -1;
+    }
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        remaining[i] = segments[i];
+    }
+
+    struct msghdr message = {};
+    message.msg_iov = remaining;
+    message.msg_iovlen = count;
+
+    int64_t deadline = k_uptime_get() + CONFIG_SOCKET_SEND_TIMEOUT;
+
+    while (message.msg_iovlen > 0)
+    {
+        ssize_t sent = sendmsg(this->socketId, &message, 0);
+
+        if ((sent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            int ret = this->Wait(POLLOUT, deadline);
+
+            if (ret > 0)
+            {
+                continue;
+            }
+
+            if (ret == 0)
+            {
+                this->stats.timeouts++;
+            }
+        }
+
+        if (sent <= 0)
+        {
+            this->Close();
+
+            return -1;
+        }
+
+        this->stats.bytes += sent;
+
+        // Skip past whatever made it out, which may have ended part way
+        // through a segment
+        while ((message.msg_iovlen > 0) && (static_cast<std::size_t>(sent) >= message.msg_iov->iov_len))
+        {
+            sent -= message.msg_iov->iov_len;
+
+            message.msg_iov++;
+            message.msg_iovlen--;
+        }
+
+        if (message.msg_iovlen > 0)
+        {
+            message.msg_iov->iov_base = static_cast<char *>(message.msg_iov->iov_base) + sent;
+            message.msg_iov->iov_len -= sent;
+        }
+    }
+
+#   if CONFIG_SOCKET_METRICS
+    this->sent[this->pending] = k_uptime_get();
+#   endif
+
+    if (this->pending++ == 0)
+    {
+        this->deadline = k_uptime_get() + CONFIG_SOCKET_RESPONSE_TIMEOUT;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Handles the response line in our line buffer
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Connection::ProcessLine(void)
+{
+    static constexpr const char Status[] = "HTTP/";
+    static constexpr const char ContentLength[] = "Content-Length:";
+    static constexpr const char ConnectionClose[] = "Connection: close";
+
+    this->line[this->response.lineLength] = '\0';
+
+#   if CONFIG_SOCKET_DEBUG
+    printk("%s\n", this->line);
+#   endif
+
+    // The status line looks like "HTTP/1.1 200 OK"
+    if (this->response.status == 0)
+    {
+    #   if CONFIG_SOCKET_METRICS
+        if (this->metrics != nullptr)
+        {
+            this->metrics->firstByte.Add(k_uptime_get() - this->sent[0]);
+        }
+    #   endif
+
+        const char *code = strchr(this->line, ' ');
+
+        if ((strncmp(this->line, Status, std::size(Status) - 1) == 0) && (code != nullptr))
+        {
+            this->response.status = atoi(code);
+        }
+
+        // Whatever this was, it wasn't a status we understand
+        if (this->response.status == 0)
+        {
+            this->response.status = -1;
+        }
+    }
+    else if (strncasecmp(this->line, ContentLength, std::size(ContentLength) - 1) == 0)
+    {
+        this->response.contentLength = atoi(&this->line[std::size(ContentLength) - 1]);
+    }
+    else if (strncasecmp(this->line, ConnectionClose, std::size(ConnectionClose) - 1) == 0)
+    {
+        this->response.closeAfter = true;
+    }
+}
+
+/**
+ * \brief Finishes up the response we were reading
+ *
+ * \param none
+ *
+ * \return 0
+ *      The connection can be used for the next response
+ * \return -1
+ *      The connection has to be closed
+ */
+int Connection::Complete(void)
+{
+    bool closeAfter = this->response.closeAfter;
+
+    if ((this->response.status >= 200) && (this->response.status < 300))
+    {
+        this->stats.succeeded++;
+    }
+    else
+    {
+        printk("Request failed with status %d\n", this->response.status);
+
+        this->stats.failed++;
+    }
+
+#   if CONFIG_SOCKET_METRICS
+    for (std::size_t i = 1; i < this->pending; i++)
+    {
+        this->sent[i - 1] = this->sent[i];
+    }
+#   endif
+
+    this->pending--;
+
+    // The next response can only start now, so it gets a full timeout of its
+    // own no matter how long it's been since its request went out
+    this->deadline = k_uptime_get() + CONFIG_SOCKET_RESPONSE_TIMEOUT;
+
+    this->response = {true, false, 0, -1, 0, 0};
+
+    return closeAfter ? -1 : 0;
+}
+
+/**
+ * \brief Parses response data as it comes in
+ *
+ *  If the response doesn't say how long its body is, or the peer asks for
+ *  it, the connection has to be closed after the response.
+ *
+ * \param *data
+ *      The response data
+ * \param length
+ *      The length of the response data
+ *
+ * \return 0
+ *      The connection can still be used
+ * \return -1
+ *      The connection has to be closed
+ */
+int Connection::Process(const char *data, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; i++)
+    {
+        // Whatever shows up when we aren't waiting on anything is dropped
+        if (this->pending == 0)
+        {
+            return 0;
+        }
+
+        if (!this->response.inHeaders)
+        {
+            std::size_t skipped = std::min(static_cast<std::size_t>(this->response.remaining), length - i);
+
+            this->response.remaining -= skipped;
+            i += skipped - 1;
+
+            if ((this->response.remaining == 0) && (this->Complete() != 0))
+            {
+                return -1;
+            }
+
+            continue;
+        }
+
+        char c = data[i];
+
+        if (c == '\r')
+        {
+            continue;
+        }
+
+        if (c != '\n')
+        {
+            // Anything past what we can hold isn't interesting to us
+            if (this->response.lineLength < (std::size(this->line) - 1))
+            {
+                this->line[this->response.lineLength++] = c;
+            }
+
+            continue;
+        }
+
+        // An empty line ends the headers
+        if (this->response.lineLength == 0)
+        {
+            this->response.inHeaders = false;
+
+            // Without a length, the body lasts until the peer closes the
+            // connection, so there's no telling where the next response
+            // would start
+            if (this->response.contentLength < 0)
+            {
+                this->response.closeAfter = true;
+                this->response.contentLength = 0;
+            }
+
+            this->response.remaining = this->response.contentLength;
+
+            if ((this->response.remaining == 0) && (this->Complete() != 0))
+            {
+                return -1;
+            }
+
+            continue;
+        }
+
+        this->ProcessLine();
+
+        this->response.lineLength = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Reads responses until we're waiting on few enough of them
+ *
+ *  If a response doesn't start, or stops arriving, within its timeout, the
+ *  connection is closed.
+ *
+ * \param until
+ *      The uptime to stop reading at, in milliseconds
+ * \param target
+ *      The number of responses to stop waiting at
+ *
+ * \return 0
+ *      The connection can still be used
+ * \return -1
+ *      The connection was closed
+ */
+int Connection::Receive(int64_t until, std::size_t target)
+{
+    do
+    {
+        if (!this->IsOpen())
+        {
+            return -1;
+        }
+
+        if (this->pending <= target)
+        {
+            return 0;
+        }
+
+        if (k_uptime_get() >= this->deadline)
+        {
+            printk("Timed out waiting for a response\n");
+
+            this->stats.timeouts++;
+
+            this->Close();
+
+            return -1;
+        }
+
+        int ret = this->Wait(POLLIN, std::min(this->deadline, until));
+
+        if (ret < 0)
+        {
+            this->Close();
+
+            return -1;
+        }
+
+        if (ret == 0)
+        {
+            continue;
+        }
+
+        ssize_t received = recv(this->socketId, this->chunk, sizeof(this->chunk), 0);
+
+        if ((received < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            continue;
+        }
+
+        if (received <= 0)
+        {
+        #   if CONFIG_SOCKET_DEBUG
+            printk("Connection closed by peer\n");
+        #   endif
+
+            this->Close();
+
+            return -1;
+        }
+
+        // The response is still arriving, so give it more time
+        this->deadline = k_uptime_get() + CONFIG_SOCKET_RESPONSE_TIMEOUT;
+
+        if (this->Process(this->chunk, received) != 0)
+        {
+            this->Close();
+
+            return -1;
+        }
+    } while (k_uptime_get() < until);
+
+    return 0;
+}
+
+/**
+ * \brief Reads any responses that have arrived
+ *
+ * \param timeout
+ *      How long to wait for the responses we're waiting on, in milliseconds
+ *
+ * \return 0
+ *      The connection can still be used
+ * \return -1
+ *      The connection was closed
+ */
+int Connection::Service(int32_t timeout)
+{
+    return this->Receive(k_uptime_get() + timeout, 0);
+}
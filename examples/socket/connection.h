@@ -0,0 +1,179 @@
+/**
+ * \file
+ *
+ * \brief A persistent HTTP/1.1 keep-alive connection for the socket applet
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+#include <net/socket.h>
+
+#include "examples/socket/resolver.h"
+#include "examples/socket/transport.h"
+
+namespace NimbeLink::Examples
+{
+    class Connection;
+}
+
+class NimbeLink::Examples::Connection
+{
+    public:
+        // The most segments a single Send() can gather from
+        static constexpr const std::size_t MaxSegments = 4;
+
+        // The most requests we'll send before waiting on their responses
+        static constexpr const std::size_t MaxPending = 4;
+
+        // Responses with a 2xx status count as succeeded, and requests that
+        // got any other status or no response at all count as failed
+        using Stats = Transport::Stats;
+
+    private:
+        // Our cache of resolved hosts
+        Resolver &resolver;
+
+        // The host and port we connect to
+        const char *host;
+        uint16_t port;
+
+        // Our socket's file descriptor, or -1 if we aren't connected
+        int socketId = -1;
+
+        // How many requests we're waiting on, and when the oldest of them
+        // has to have heard back by
+        //
+        // The server answers in order, so a request only starts waiting on
+        // its response once the ones ahead of it have been answered.
+        std::size_t pending = 0;
+        int64_t deadline = 0;
+
+    #   if CONFIG_SOCKET_METRICS
+        // When each request we're waiting on was sent, and where to record
+        // how long their responses took to start
+        int64_t sent[MaxPending] = {0};
+        Metrics *metrics = nullptr;
+    #   endif
+
+        // Where we are in the response we're currently reading
+        struct
+        {
+            bool inHeaders;
+            bool closeAfter;
+            int status;
+            int32_t contentLength;
+            int32_t remaining;
+            std::size_t lineLength;
+        } response = {true, false, 0, -1, 0, 0};
+
+        // Our response statistics
+        Stats stats;
+
+        // Small buffers for reading responses
+        //
+        // Responses are parsed as they stream in, so these don't need to
+        // hold an entire response.
+        char chunk[128] = {0};
+        char line[64] = {0};
+
+    private:
+        bool IsAlive(void);
+
+        int Wait(short events, int64_t deadline);
+
+        void ProcessLine(void);
+        int Complete(void);
+        int Process(const char *data, std::size_t length);
+        int Receive(int64_t until, std::size_t target);
+
+    public:
+        /**
+         * \brief Creates a new connection
+         *
+         * \param &resolver
+         *      The cache to resolve our host with
+         * \param *host
+         *      The host to connect to
+         * \param port
+         *      The port to connect to
+         *
+         * \return none
+         */
+        constexpr Connection(Resolver &resolver, const char *host, uint16_t port):
+            resolver(resolver),
+            host(host),
+            port(port) {}
+
+        /**
+         * \brief Gets if we currently have an open socket
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not we have an open socket
+         */
+        bool IsOpen(void) const
+        {
+            return (this->socketId >= 0);
+        }
+
+        /**
+         * \brief Gets how many requests are waiting on responses
+         *
+         * \param none
+         *
+         * \return std::size_t
+         *      The number of requests
+         */
+        std::size_t GetPending(void) const
+        {
+            return this->pending;
+        }
+
+        /**
+         * \brief Gets our response statistics
+         *
+         * \param none
+         *
+         * \return const Stats &
+         *      Our response statistics
+         */
+        const Stats &GetStats(void) const
+        {
+            return this->stats;
+        }
+
+    #   if CONFIG_SOCKET_METRICS
+        /**
+         * \brief Sets where to record connect and response times
+         *
+         * \param *metrics
+         *      Where to record times, or nullptr to stop recording them
+         *
+         * \return none
+         */
+        void SetMetrics(Metrics *metrics)
+        {
+            this->metrics = metrics;
+        }
+    #   endif
+
+        bool NeedsOpen(void);
+
+        int Open(void);
+        void Close(void);
+
+        int Send(const struct iovec *segments, std::size_t count);
+        int Service(int32_t timeout);
+};
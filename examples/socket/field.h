@@ -0,0 +1,43 @@
+/**
+ * \file
+ *
+ * \brief A single typed value a widget wants posted
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace NimbeLink::Examples
+{
+    struct Field;
+}
+
+struct NimbeLink::Examples::Field
+{
+    enum class Type
+    {
+        Integer,
+        String,
+    };
+
+    const char *name;
+    Type type;
+    int32_t integer;
+    const char *string;
+
+    // How far an integer can move from what was last posted before it's
+    // worth posting again, either as an absolute amount or as a percentage
+    // of what was last posted
+    //
+    // Strings are posted whenever they change.
+    int32_t deadband = 0;
+    bool relative = false;
+};
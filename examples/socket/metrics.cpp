@@ -0,0 +1,56 @@
+/**
+ * \file
+ *
+ * \brief Timing and traffic measurements for the socket applet
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstddef>
+
+#include <kernel.h>
+
+#include "examples/socket/metrics.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Prints a summary of some measurements
+ *
+ * \param *name
+ *      What was measured
+ * \param &samples
+ *      The measurements
+ *
+ * \return none
+ */
+template <std::size_t Count>
+void Metrics::Print(const char *name, const Samples<Count> &samples)
+{
+    printk("%s: p50 %u ms, p90 %u ms, max %u ms (%u samples)\n",
+        name,
+        static_cast<unsigned int>(samples.GetPercentile(50)),
+        static_cast<unsigned int>(samples.GetPercentile(90)),
+        static_cast<unsigned int>(samples.GetPercentile(100)),
+        static_cast<unsigned int>(samples.GetCount())
+    );
+}
+
+/**
+ * \brief Prints a summary of our measurements
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Metrics::Print(void) const
+{
+    Metrics::Print("Connect", this->connect);
+    Metrics::Print("First byte", this->firstByte);
+    Metrics::Print("Cycle", this->cycle);
+}
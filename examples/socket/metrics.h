@@ -0,0 +1,116 @@
+/**
+ * \file
+ *
+ * \brief Timing and traffic measurements for the socket applet
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+
+namespace NimbeLink::Examples
+{
+    class Metrics;
+}
+
+class NimbeLink::Examples::Metrics
+{
+    public:
+        // The most recent measurements of something, in milliseconds
+        template <std::size_t Count>
+        class Samples
+        {
+            private:
+                uint32_t values[Count] = {0};
+                std::size_t next = 0;
+                std::size_t count = 0;
+
+            public:
+                /**
+                 * \brief Adds a measurement, replacing the oldest if we're
+                 *        full
+                 *
+                 * \param value
+                 *      The measurement
+                 *
+                 * \return none
+                 */
+                void Add(uint32_t value)
+                {
+                    this->values[this->next] = value;
+
+                    this->next = (this->next + 1) % Count;
+                    this->count = std::min(this->count + 1, Count);
+                }
+
+                /**
+                 * \brief Gets how many measurements we have
+                 *
+                 * \param none
+                 *
+                 * \return std::size_t
+                 *      The number of measurements
+                 */
+                std::size_t GetCount(void) const
+                {
+                    return this->count;
+                }
+
+                /**
+                 * \brief Gets a percentile of our measurements
+                 *
+                 * \param percentile
+                 *      The percentile to get, from 0 to 100
+                 *
+                 * \return uint32_t
+                 *      The percentile, or 0 if we don't have any
+                 *      measurements
+                 */
+                uint32_t GetPercentile(uint8_t percentile) const
+                {
+                    if (this->count == 0)
+                    {
+                        return 0;
+                    }
+
+                    uint32_t sorted[Count];
+
+                    std::copy(this->values, this->values + this->count, sorted);
+                    std::sort(sorted, sorted + this->count);
+
+                    return sorted[((this->count - 1) * std::min<uint8_t>(percentile, 100)) / 100];
+                }
+        };
+
+        // How many measurements of each kind to keep
+        static constexpr const std::size_t Depth = 32;
+
+        // How long opening a connection took, including resolving the host
+        Samples<Depth> connect;
+
+        // How long it took for the start of a response to arrive after
+        // sending its request
+        Samples<Depth> firstByte;
+
+        // How long each posting cycle took, leaving out the wait between
+        // cycles
+        Samples<Depth> cycle;
+
+    private:
+        template <std::size_t Count>
+        static void Print(const char *name, const Samples<Count> &samples);
+
+    public:
+        void Print(void) const;
+};
@@ -0,0 +1,241 @@
+/**
+ * \file
+ *
+ * \brief Keeps track of the modem's network registration
+ *
+ *  The modem is asked to send +CEREG notifications whenever its registration
+ *  changes, so checking whether we can use the network doesn't take any AT
+ *  commands.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <string>
+
+#include <at_cmd.h>
+#include <at_notif.h>
+#include <kernel.h>
+
+#include "examples/socket/network.h"
+#include "examples/utils.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Handles an AT notification
+ *
+ * \param *context
+ *      A pointer to our network object
+ * \param *response
+ *      The notification
+ *
+ * \return none
+ */
+void Network::Handler(void *context, const char *response)
+{
+    Network *network = static_cast<Network *>(context);
+
+    if ((network == nullptr) || (response == nullptr))
+    {
+        return;
+    }
+
+    int status = Network::Parse(response, false);
+
+    if (status >= 0)
+    {
+        network->Update(status);
+    }
+}
+
+/**
+ * \brief Gets the registration status from a +CEREG response
+ *
+ *  Notifications start with the status ("+CEREG: <stat>[,...]"), while
+ *  responses to a query start with the notification setting
+ *  ("+CEREG: <n>,<stat>[,...]").
+ *
+ * \param response
+ *      The response
+ * \param query
+ *      Whether or not the response is to a query
+ *
+ * \return >=0
+ *      The registration status
+ * \return -1
+ *      The response isn't a +CEREG response
+ */
+int Network::Parse(std::string_view response, bool query)
+{
+    Utils::At::Value values[1];
+
+    if (Utils::At::Parse(response, query ? Utils::At::CeregQuery : Utils::At::Cereg, values) != 1)
+    {
+        return -1;
+    }
+
+    return static_cast<int>(values[0].integer);
+}
+
+/**
+ * \brief Updates our registration status
+ *
+ * \param status
+ *      The new registration status
+ *
+ * \return none
+ */
+void Network::Update(int status)
+{
+    atomic_val_t previous = atomic_set(&this->state, status);
+
+    if (previous != status)
+    {
+    #   if CONFIG_SOCKET_DEBUG
+        printk("Network registration changed from %d to %d\n", static_cast<int>(previous), status);
+    #   endif
+
+        k_sem_give(&this->changed);
+    }
+}
+
+/**
+ * \brief Asks the modem for its registration status
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return -1
+ *      Error
+ */
+int Network::Refresh(void)
+{
+    static constexpr const std::string_view command = "AT+CEREG?";
+
+    int status = -1;
+
+    // Whoever's refreshing is waiting on the status to change, so it has to
+    // come from the modem rather than the cache
+    this->at.Execute(command, [&status](const AtService::Response &response) {
+        if (response.Succeeded())
+        {
+            status = Network::Parse(response.text, true);
+        }
+    #   if CONFIG_SOCKET_DEBUG
+        else if (response.ret == 0)
+        {
+            NimbeLink::Examples::Utils::PrintError(command, response.result, response.error);
+        }
+    #   endif
+    }, AtService::Priority::Normal, true);
+
+    if (status < 0)
+    {
+        return -1;
+    }
+
+    this->Update(status);
+
+    return 0;
+}
+
+/**
+ * \brief Starts tracking the modem's registration
+ *
+ *  If AT notifications can't be set up, the modem is asked for its status
+ *  whenever we're waiting on it instead.
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int Network::Init(void)
+{
+    k_sem_init(&this->changed, 0, 1);
+
+    int err = at_cmd_init();
+
+    if (err)
+    {
+        printk("Failed to initialize AT commands, err %d\n", err);
+    }
+
+    if (!err)
+    {
+        err = at_notif_init();
+
+        if (err)
+        {
+            printk("Failed to initialize AT notifications, err %d\n", err);
+        }
+    }
+
+    if (!err)
+    {
+        err = at_notif_register_handler(this, Network::Handler);
+
+        if (err)
+        {
+            printk("Failed to register for AT notifications, err %d\n", err);
+        }
+    }
+
+    if (!err)
+    {
+        this->notifying = (this->at.Execute("AT+CEREG=1", [](const AtService::Response &response) {
+            (void)response;
+        }) == 0);
+    }
+
+    // Start off with wherever the modem's at now
+    this->Refresh();
+
+    return this->notifying ? 0 : -1;
+}
+
+/**
+ * \brief Waits for the modem to be registered to a network
+ *
+ * \param timeout
+ *      The most time to wait, in milliseconds
+ *
+ * \return bool
+ *      Whether or not the modem is registered
+ */
+bool Network::WaitRegistered(int32_t timeout)
+{
+    int64_t deadline = k_uptime_get() + timeout;
+
+    while (!this->IsRegistered())
+    {
+        int64_t remaining = deadline - k_uptime_get();
+
+        if (remaining <= 0)
+        {
+            return false;
+        }
+
+        if (this->notifying)
+        {
+            k_sem_take(&this->changed, static_cast<int32_t>(remaining));
+        }
+        else
+        {
+            k_sleep(static_cast<int32_t>(std::min<int64_t>(remaining, PollInterval)));
+
+            this->Refresh();
+        }
+    }
+
+    return true;
+}
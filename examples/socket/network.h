@@ -0,0 +1,113 @@
+/**
+ * \file
+ *
+ * \brief Keeps track of the modem's network registration
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+
+namespace NimbeLink::Examples
+{
+    class Network;
+}
+
+class NimbeLink::Examples::Network
+{
+    public:
+        /**
+         * \brief The modem's EPS registration status, as reported by +CEREG
+         */
+        enum class Registration : uint8_t
+        {
+            NotSearching    = 0,
+            Home            = 1,
+            Searching       = 2,
+            Denied          = 3,
+            Unknown         = 4,
+            Roaming         = 5,
+        };
+
+    private:
+        // How often to ask the modem for its status while waiting on it, if
+        // we aren't getting notifications
+        static constexpr const int32_t PollInterval = 1000;
+
+        // What we ask the modem through
+        AtService &at;
+
+        // Our current registration status
+        atomic_t state = ATOMIC_INIT(static_cast<atomic_val_t>(Registration::Unknown));
+
+        // Given each time our registration status changes
+        struct k_sem changed;
+
+        // Whether or not we're getting +CEREG notifications
+        bool notifying = false;
+
+    private:
+        static void Handler(void *context, const char *response);
+
+        static int Parse(std::string_view response, bool query);
+
+        void Update(int status);
+        int Refresh(void);
+
+    public:
+        /**
+         * \brief Creates a new network tracker
+         *
+         * \param &at
+         *      What to ask the modem through
+         *
+         * \return none
+         */
+        constexpr Network(AtService &at):
+            at(at),
+            changed() {}
+
+        /**
+         * \brief Gets the modem's registration status
+         *
+         * \param none
+         *
+         * \return Registration
+         *      The modem's registration status
+         */
+        Registration GetRegistration(void) const
+        {
+            return static_cast<Registration>(atomic_get(&this->state));
+        }
+
+        /**
+         * \brief Gets if the modem is registered to a network
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not the modem is registered
+         */
+        bool IsRegistered(void) const
+        {
+            Registration registration = this->GetRegistration();
+
+            return ((registration == Registration::Home) || (registration == Registration::Roaming));
+        }
+
+        int Init(void);
+
+        bool WaitRegistered(int32_t timeout);
+};
@@ -36,11 +36,96 @@ using namespace NimbeLink::Examples;
  */
 void CellPoster::Retrieve(char *buffer, uint16_t max_length)
 {
-    Cell::CellData *data = this->cell.GetStruct();
+    Cell::CellData data = this->cell.GetData();
 
-    snprintf(buffer, max_length, "rsrp=%d&rsrq=%d&carrier=%s",
-        static_cast<uint8_t>(data->rsrp),
-        static_cast<uint8_t>(data->rsrq),
-        Cell::GetCarrierString(data->carrier)
+    int length = snprintf(buffer, max_length, "rsrp=%d&rsrq=%d&carrier=%s",
+        data.rsrp,
+        data.rsrq,
+        Cell::GetCarrierString(data.carrier)
     );
+
+#   if CONFIG_CELL_EXTENDED
+    if ((length < 0) || (length >= max_length))
+    {
+        return;
+    }
+
+    Cell::ExtendedData extended = this->cell.GetExtended();
+
+    snprintf(buffer + length, max_length - length, "&band=%u&earfcn=%lu&cell_id=%lx&tac=%x&snr=%u&neighbors=%u",
+        static_cast<unsigned int>(extended.serving.band),
+        static_cast<unsigned long>(extended.serving.earfcn),
+        static_cast<unsigned long>(extended.serving.cellId),
+        static_cast<unsigned int>(extended.serving.tac),
+        static_cast<unsigned int>(extended.serving.snr),
+        static_cast<unsigned int>(extended.neighbors.count)
+    );
+#   else
+    (void)length;
+#   endif
+}
+
+/**
+ * \brief Passes along the cell's data as typed fields
+ *
+ * \param *fields
+ *      The fields to fill in
+ * \param count
+ *      The most fields to fill in
+ *
+ * \return std::size_t
+ *      The number of fields filled in
+ */
+std::size_t CellPoster::Collect(Socket::Field *fields, std::size_t count)
+{
+    std::size_t needed = 3;
+
+#   if CONFIG_CELL_EXTENDED
+    needed += 6;
+#   endif
+
+#   if CONFIG_CELL_HISTORY
+    needed += 3;
+#   endif
+
+    if (count < needed)
+    {
+        return 0;
+    }
+
+    Cell::CellData data = this->cell.GetData();
+
+    // Signal quality bounces around by a few steps even when sitting still
+    fields[0] = {"rsrp", Socket::Field::Type::Integer, data.rsrp, nullptr, 3};
+    fields[1] = {"rsrq", Socket::Field::Type::Integer, data.rsrq, nullptr, 2};
+    fields[2] = {"carrier", Socket::Field::Type::String, 0, Cell::GetCarrierString(data.carrier)};
+
+    std::size_t used = 3;
+
+#   if CONFIG_CELL_EXTENDED
+    // Unknown values are posted as-is, which keeps every field in the same
+    // place from one post to the next
+    Cell::ExtendedData extended = this->cell.GetExtended();
+
+    fields[used++] = {"band", Socket::Field::Type::Integer, extended.serving.band, nullptr};
+    fields[used++] = {"earfcn", Socket::Field::Type::Integer, static_cast<int32_t>(extended.serving.earfcn), nullptr};
+    fields[used++] = {"cell_id", Socket::Field::Type::Integer, static_cast<int32_t>(extended.serving.cellId), nullptr};
+    fields[used++] = {"tac", Socket::Field::Type::Integer, extended.serving.tac, nullptr};
+    fields[used++] = {"snr", Socket::Field::Type::Integer, extended.serving.snr, nullptr, 3};
+    fields[used++] = {"neighbors", Socket::Field::Type::Integer, extended.neighbors.count, nullptr};
+#   endif
+
+#   if CONFIG_CELL_HISTORY
+    // Post how the signal's been doing lately, not just where it is now
+    Cell::SignalHistory::Summary summary = this->cell.GetHistory().GetSummary(Cell::ShortWindow);
+
+    if (summary.rsrp.count > 0)
+    {
+        fields[used++] = {"rsrp_avg", Socket::Field::Type::Integer, static_cast<int32_t>(summary.rsrp.mean + 0.5f), nullptr, 2};
+        fields[used++] = {"rsrp_min", Socket::Field::Type::Integer, summary.rsrp.min, nullptr, 3};
+        fields[used++] = {"rsrp_max", Socket::Field::Type::Integer, summary.rsrp.max, nullptr, 3};
+    }
+#   endif
+
+    return used;
 }
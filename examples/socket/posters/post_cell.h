@@ -47,4 +47,5 @@ class NimbeLink::Examples::CellPoster : public Socket::Data
             cell(cell) {}
 
         void Retrieve(char *buffer, uint16_t max_length) override;
+        std::size_t Collect(Socket::Field *fields, std::size_t count) override;
 };
@@ -0,0 +1,285 @@
+/**
+ * \file
+ *
+ * \brief A bounded store-and-forward queue for data the socket applet
+ *        couldn't send
+ *
+ *  Records are kept in a ring of CONFIG_SOCKET_QUEUE_DEPTH slots. Once the
+ *  ring is full, the oldest record is dropped to make room for the newest.
+ *
+ *  Our head and tail are only written when a record is pushed and once per
+ *  replayed batch, rather than after every replayed record, to keep flash
+ *  writes down.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#include <kernel.h>
+
+#if !CONFIG_SOCKET_QUEUE_RAM
+#include <drivers/flash.h>
+#include <storage/flash_map.h>
+#endif
+
+#include "examples/socket/queue.h"
+
+using namespace NimbeLink::Examples;
+
+#if !CONFIG_SOCKET_QUEUE_RAM
+/**
+ * \brief Sets up NVS on the storage partition
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int UploadQueue::FlashStorage::Init(void)
+{
+    const struct flash_area *area;
+
+    int err = flash_area_open(DT_FLASH_AREA_STORAGE_ID, &area);
+
+    if (err != 0)
+    {
+        printk("Unable to open storage partition, err %d\n", err);
+
+        return err;
+    }
+
+    struct flash_pages_info info;
+
+    err = flash_get_page_info_by_offs(device_get_binding(DT_FLASH_DEV_NAME), area->fa_off, &info);
+
+    if (err != 0)
+    {
+        printk("Unable to get storage page info, err %d\n", err);
+
+        flash_area_close(area);
+
+        return err;
+    }
+
+    this->fs.offset = area->fa_off;
+    this->fs.sector_size = info.size;
+    this->fs.sector_count = area->fa_size / info.size;
+
+    flash_area_close(area);
+
+    err = nvs_init(&this->fs, DT_FLASH_DEV_NAME);
+
+    if (err != 0)
+    {
+        printk("Unable to initialize NVS, err %d\n", err);
+
+        return err;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Reads a record
+ *
+ * \param id
+ *      The record's ID
+ * \param *data
+ *      Where to read the record to
+ * \param length
+ *      The most to read
+ *
+ * \return >0
+ *      The record's full length
+ * \return <0
+ *      Error
+ */
+int UploadQueue::FlashStorage::Read(uint16_t id, void *data, std::size_t length)
+{
+    return nvs_read(&this->fs, id, data, length);
+}
+
+/**
+ * \brief Writes a record
+ *
+ *  NVS doesn't rewrite a record whose contents haven't changed.
+ *
+ * \param id
+ *      The record's ID
+ * \param *data
+ *      The record
+ * \param length
+ *      The record's length
+ *
+ * \return >=0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int UploadQueue::FlashStorage::Write(uint16_t id, const void *data, std::size_t length)
+{
+    return nvs_write(&this->fs, id, data, length);
+}
+#endif
+
+/**
+ * \brief Sets up our storage and picks up whatever was queued before a reset
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int UploadQueue::Init(void)
+{
+    int err = this->storage.Init();
+
+    if (err != 0)
+    {
+        return err;
+    }
+
+    this->ready = true;
+
+    // If nothing was saved, or what was saved doesn't make sense, start off
+    // empty
+    if ((this->storage.Read(StateId, &this->state, sizeof(this->state)) != sizeof(this->state)) ||
+        (this->GetCount() > Depth))
+    {
+        this->state.head = 0;
+        this->state.tail = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Adds a record to the end of the queue
+ *
+ *  If the queue is full, the oldest record is dropped.
+ *
+ * \param *data
+ *      The record
+ * \param length
+ *      The record's length
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int UploadQueue::Push(const char *data, std::size_t length)
+{
+    if (!this->ready || (length == 0))
+    {
+        return -1;
+    }
+
+    int err = this->storage.Write(GetId(this->state.tail), data, length);
+
+    if (err < 0)
+    {
+        printk("Unable to queue data, err %d\n", err);
+
+        return err;
+    }
+
+    if (this->GetCount() >= Depth)
+    {
+        this->state.head++;
+    }
+
+    this->state.tail++;
+
+    return this->Commit();
+}
+
+/**
+ * \brief Reads the oldest record without removing it
+ *
+ * \param *data
+ *      Where to read the record to
+ * \param length
+ *      The most to read
+ *
+ * \return >0
+ *      The record's length
+ * \return <0
+ *      The queue is empty or the record couldn't be read
+ */
+int UploadQueue::Peek(char *data, std::size_t length)
+{
+    if (!this->ready || (this->GetCount() == 0))
+    {
+        return -1;
+    }
+
+    int read = this->storage.Read(GetId(this->state.head), data, length);
+
+    // A record we can't read, or can't read all of, will never be sent, so
+    // skip past it
+    if ((read <= 0) || (static_cast<std::size_t>(read) > length))
+    {
+        this->Pop();
+
+        return -1;
+    }
+
+    return read;
+}
+
+/**
+ * \brief Removes the oldest record
+ *
+ *  This doesn't save the new state of the queue until Commit() is called.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void UploadQueue::Pop(void)
+{
+    if (this->GetCount() > 0)
+    {
+        this->state.head++;
+    }
+}
+
+/**
+ * \brief Saves the state of the queue
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int UploadQueue::Commit(void)
+{
+    if (!this->ready)
+    {
+        return -1;
+    }
+
+    int err = this->storage.Write(StateId, &this->state, sizeof(this->state));
+
+    if (err < 0)
+    {
+        return err;
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * \file
+ *
+ * \brief A bounded store-and-forward queue for data the socket applet
+ *        couldn't send
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <kernel.h>
+
+#if !CONFIG_SOCKET_QUEUE_RAM
+#include <fs/nvs.h>
+#endif
+
+namespace NimbeLink::Examples
+{
+    class UploadQueue;
+}
+
+class NimbeLink::Examples::UploadQueue
+{
+    public:
+        // Interface class for where queued records are kept
+        //
+        // Records are identified by a small ID, and writing a record replaces
+        // whatever was stored with that ID.
+        class Storage
+        {
+            public:
+                virtual int Init(void) = 0;
+                virtual int Read(uint16_t id, void *data, std::size_t length) = 0;
+                virtual int Write(uint16_t id, const void *data, std::size_t length) = 0;
+        };
+
+    #   if CONFIG_SOCKET_QUEUE_RAM
+        // Storage that keeps records in RAM
+        //
+        // Records don't survive a reset, but this doesn't need any flash,
+        // which makes it useful for running off-target.
+        template <std::size_t Count, std::size_t Size>
+        class RamStorage : public Storage
+        {
+            private:
+                struct
+                {
+                    std::size_t length;
+                    uint8_t data[Size];
+                } records[Count] = {};
+
+            public:
+                int Init(void) override
+                {
+                    return 0;
+                }
+
+                int Read(uint16_t id, void *data, std::size_t length) override
+                {
+                    if ((id >= Count) || (this->records[id].length == 0))
+                    {
+                        return -1;
+                    }
+
+                    length = std::min(length, this->records[id].length);
+
+                    memcpy(data, this->records[id].data, length);
+
+                    return static_cast<int>(this->records[id].length);
+                }
+
+                int Write(uint16_t id, const void *data, std::size_t length) override
+                {
+                    if ((id >= Count) || (length == 0) || (length > Size))
+                    {
+                        return -1;
+                    }
+
+                    memcpy(this->records[id].data, data, length);
+
+                    this->records[id].length = length;
+
+                    return static_cast<int>(length);
+                }
+        };
+    #   else
+        // Storage that keeps records in the flash storage partition
+        //
+        // NVS appends each write to its sectors and rotates through them,
+        // so writes are spread across the partition.
+        class FlashStorage : public Storage
+        {
+            private:
+                struct nvs_fs fs = {};
+
+            public:
+                int Init(void) override;
+                int Read(uint16_t id, void *data, std::size_t length) override;
+                int Write(uint16_t id, const void *data, std::size_t length) override;
+        };
+    #   endif
+
+    private:
+        // The ID our head and tail are stored under, with records following
+        static constexpr const uint16_t StateId = 0;
+
+        // The most records we'll hold before dropping the oldest
+        static constexpr const uint32_t Depth = CONFIG_SOCKET_QUEUE_DEPTH;
+
+        // Where our records are kept
+        Storage &storage;
+
+        // Our oldest record and the record after our newest one
+        //
+        // These only ever count up, and a record's ID comes from its position
+        // in the ring.
+        struct
+        {
+            uint32_t head;
+            uint32_t tail;
+        } state = {0, 0};
+
+        // Whether our storage was set up
+        bool ready = false;
+
+    private:
+        /**
+         * \brief Gets the storage ID of a record
+         *
+         * \param index
+         *      The record's index
+         *
+         * \return uint16_t
+         *      The record's storage ID
+         */
+        static constexpr uint16_t GetId(uint32_t index)
+        {
+            return static_cast<uint16_t>(StateId + 1 + (index % Depth));
+        }
+
+    public:
+        /**
+         * \brief Creates a new upload queue
+         *
+         * \param &storage
+         *      Where the queue's records are kept
+         *
+         * \return none
+         */
+        constexpr UploadQueue(Storage &storage):
+            storage(storage) {}
+
+        /**
+         * \brief Gets the number of records in the queue
+         *
+         * \param none
+         *
+         * \return uint32_t
+         *      The number of records
+         */
+        uint32_t GetCount(void) const
+        {
+            return this->state.tail - this->state.head;
+        }
+
+        int Init(void);
+
+        int Push(const char *data, std::size_t length);
+        int Peek(char *data, std::size_t length);
+        void Pop(void);
+        int Commit(void);
+};
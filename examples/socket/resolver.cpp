@@ -0,0 +1,172 @@
+/**
+ * \file
+ *
+ * \brief A small DNS resolution cache for the socket applet
+ *
+ *  getaddrinfo() doesn't tell us the record's TTL, so resolved addresses are
+ *  kept for CONFIG_SOCKET_DNS_TTL seconds. If a query fails, the last
+ *  address we resolved for the host is used instead.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#include <kernel.h>
+#include <net/socket.h>
+
+#include "examples/socket/resolver.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Finds a host's entry
+ *
+ * \param *host
+ *      The host whose entry to find
+ *
+ * \return nullptr
+ *      The host isn't in our cache
+ * \return Entry *
+ *      The host's entry
+ */
+Resolver::Entry *Resolver::Find(const char *host)
+{
+    for (std::size_t i = 0; i < std::size(this->entries); i++)
+    {
+        if (this->entries[i].valid && (strcmp(this->entries[i].host, host) == 0))
+        {
+            return &this->entries[i];
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * \brief Makes room for a new entry
+ *
+ *  An unused entry is preferred, otherwise the least recently used entry is
+ *  dropped.
+ *
+ * \param none
+ *
+ * \return Entry *
+ *      The entry to fill in
+ */
+Resolver::Entry *Resolver::Evict(void)
+{
+    Entry *oldest = &this->entries[0];
+
+    for (std::size_t i = 0; i < std::size(this->entries); i++)
+    {
+        if (!this->entries[i].valid)
+        {
+            return &this->entries[i];
+        }
+
+        if (this->entries[i].used < oldest->used)
+        {
+            oldest = &this->entries[i];
+        }
+    }
+
+    oldest->valid = false;
+
+    return oldest;
+}
+
+/**
+ * \brief Resolves a host's IPv4 address
+ *
+ * \param *host
+ *      The host to resolve
+ * \param &address
+ *      The resolved address
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      The host could not be resolved and we have no address for it
+ */
+int Resolver::Resolve(const char *host, struct sockaddr_in &address)
+{
+    int64_t now = k_uptime_get();
+
+    Entry *entry = this->Find(host);
+
+    if ((entry != nullptr) && (now < entry->expires))
+    {
+        this->stats.hits++;
+
+        entry->used = now;
+        address = entry->address;
+
+        return 0;
+    }
+
+    this->stats.misses++;
+
+    struct addrinfo *res;
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = 0;
+
+    int err = getaddrinfo(host, NULL, &hints, &res);
+
+    this->stats.missTime += static_cast<uint32_t>(k_uptime_get() - now);
+
+    if (err)
+    {
+        printk("unable to get address info, err %d\n", err);
+
+        // Fall back to the last address we knew about, if there was one
+        if (entry == nullptr)
+        {
+            return -1;
+        }
+
+        this->stats.fallbacks++;
+
+        entry->used = now;
+        address = entry->address;
+
+        return 0;
+    }
+
+    if (entry == nullptr)
+    {
+        // Hosts that don't fit can't be looked up again, so don't cache them
+        if (strlen(host) >= sizeof(Entry::host))
+        {
+            address = *reinterpret_cast<struct sockaddr_in *>(res->ai_addr);
+
+            freeaddrinfo(res);
+
+            return 0;
+        }
+
+        entry = this->Evict();
+
+        strcpy(entry->host, host);
+    }
+
+    entry->address = *reinterpret_cast<struct sockaddr_in *>(res->ai_addr);
+    entry->expires = now + K_SECONDS(CONFIG_SOCKET_DNS_TTL);
+    entry->used = now;
+    entry->valid = true;
+
+    freeaddrinfo(res);
+
+    address = entry->address;
+
+    return 0;
+}
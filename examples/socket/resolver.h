@@ -0,0 +1,86 @@
+/**
+ * \file
+ *
+ * \brief A small DNS resolution cache for the socket applet
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+#include <net/socket.h>
+
+namespace NimbeLink::Examples
+{
+    class Resolver;
+}
+
+class NimbeLink::Examples::Resolver
+{
+    public:
+        /**
+         * \brief Cache statistics
+         */
+        struct Stats
+        {
+            // Lookups answered from the cache
+            uint32_t hits = 0;
+
+            // Lookups that needed a DNS query
+            uint32_t misses = 0;
+
+            // Failed DNS queries answered with a stale address
+            uint32_t fallbacks = 0;
+
+            // Total time spent on DNS queries, in milliseconds
+            uint32_t missTime = 0;
+        };
+
+    private:
+        /**
+         * \brief A resolved host
+         */
+        struct Entry
+        {
+            char host[32];
+            struct sockaddr_in address;
+            int64_t expires;
+            int64_t used;
+            bool valid;
+        };
+
+        // Our cached hosts
+        Entry entries[2] = {};
+
+        // Our statistics
+        Stats stats;
+
+    private:
+        Entry *Find(const char *host);
+        Entry *Evict(void);
+
+    public:
+        int Resolve(const char *host, struct sockaddr_in &address);
+
+        /**
+         * \brief Gets our cache statistics
+         *
+         * \param none
+         *
+         * \return const Stats &
+         *      Our cache statistics
+         */
+        const Stats &GetStats(void) const
+        {
+            return this->stats;
+        }
+};
@@ -11,11 +11,10 @@
  * subject to third party license terms as specified in this software, and such
  * portions are excluded from the preceding copyright notice of NimbeLink Corp.
  */
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 
-#include <at_cmd.h>
-#include <at_notif.h>
 #include <kernel.h>
 #include <net/socket.h>
 
@@ -58,11 +57,13 @@ void Socket::Handler(void *arg1, void *arg2, void *arg3)
 /**
  * \brief Creates a new socket instance and thread
  *
- * \param none
+ * \param &at
+ *      What to ask the modem through
  *
  * \return none
  */
-Socket::Socket(void)
+Socket::Socket(AtService &at):
+    network(at)
 {
     // Create our thread
     this->threadId = k_thread_create(
@@ -80,168 +81,518 @@ Socket::Socket(void)
 }
 
 /**
- * \brief Initializes AT communications
+ * \brief sets up the socket
+ *
+ *  If our transport is still open from a previous post, it gets reused.
+ *  Otherwise, it's opened once the modem is registered to a network.
  *
  * \param none
  *
  * \return 0
- *      Success
- * \return <0
- *      Error
+ *      The transport is ready to use
+ * \return -1
+ *      The transport could not be set up
  */
-int Socket::AtCommsInit(void)
+int Socket::SetSocketUp(void)
 {
-    int err = at_cmd_init();
+    if (!this->transport.NeedsOpen())
+    {
+        return 0;
+    }
 
-    if (err)
+    // Don't bother trying if we know we can't reach the network
+    if (!this->network.WaitRegistered(CONFIG_SOCKET_NETWORK_TIMEOUT))
     {
-        printk("Failed to initialize AT commands, err %d\n", err);
+    #   if CONFIG_SOCKET_DEBUG
+        printk("Not registered to a network, status %d\n", static_cast<int>(this->network.GetRegistration()));
+    #   endif
+
+        return -1;
+    }
 
-        return err;
+    if (this->transport.Open() != 0)
+    {
+        return -1;
     }
 
-    err = at_notif_init();
+    return 0;
+}
 
-    if (err)
+/**
+ * \brief Posts the data in our transmit buffer using our transport
+ *
+ * \param length
+ *      The length of the data
+ *
+ * \return 0
+ *      The data was sent, and its response will be handled later
+ * \return -1
+ *      The data could not be sent
+ */
+int Socket::Post(std::size_t length)
+{
+    if (this->SetSocketUp() != 0)
     {
-        printk("Failed to initialize AT notifications, err %d\n", err);
+        return -1;
+    }
 
-        return err;
+    // If the send failed, the transport is closed, so try once more with a
+    // fresh one in case the peer dropped our connection on us
+    if (this->transport.Send(this->transmit, length) != 0)
+    {
+        if ((this->SetSocketUp() != 0) || (this->transport.Send(this->transmit, length) != 0))
+        {
+            return -1;
+        }
     }
 
+    // Don't wait on the response, but handle any earlier ones that have
+    // shown up
+    this->transport.Service(0);
+
     return 0;
 }
 
 /**
- * \brief Wrapper for sending AT commands
+ * \brief Waits for widgets to be due to be posted
+ *
+ *  Widgets that will be due within CONFIG_SOCKET_GROUP_WINDOW seconds are
+ *  posted early alongside the ones that are due, so that they share the
+ *  connection instead of waking the modem again shortly after.
+ *
+ * \param *due
+ *      Where to put the indices of the widgets to post, in priority order
+ *
+ * \return std::size_t
+ *      The number of widgets to post
+ */
+std::size_t Socket::Schedule(std::size_t *due)
+{
+    std::size_t count = this->count;
+
+    if (count == 0)
+    {
+        k_sleep(K_SECONDS(CONFIG_SOCKET_POST_RATE));
+
+        return 0;
+    }
+
+    int64_t next = this->entries[0].due;
+
+    for (std::size_t i = 1; i < count; i++)
+    {
+        next = std::min(next, this->entries[i].due);
+    }
+
+    int64_t now = k_uptime_get();
+
+    if (next > now)
+    {
+        k_sleep(static_cast<int32_t>(next - now));
+
+        now = k_uptime_get();
+    }
+
+    std::size_t found = 0;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        Entry &entry = this->entries[i];
+
+        if (entry.due > (now + K_SECONDS(CONFIG_SOCKET_GROUP_WINDOW)))
+        {
+            continue;
+        }
+
+        // Count from now rather than when it was due, so a widget that was
+        // posted late or early keeps its spacing
+        entry.due = now + entry.period;
+
+        // Keep the list sorted by priority, with ties going in the order the
+        // widgets registered
+        std::size_t j = found++;
+
+        for (; (j > 0) && (this->entries[due[j - 1]].priority < entry.priority); j--)
+        {
+            due[j] = due[j - 1];
+        }
+
+        due[j] = i;
+    }
+
+    return found;
+}
+
+/**
+ * \brief Posts the query string in our transmit buffer, saving it for later
+ *        if it can't be sent
+ *
+ *  If there's still queued data we haven't caught up on, this is queued
+ *  behind it instead, so the server gets everything in the order it
+ *  happened.
  *
- * \param command
- *      The command as a string
  * \param length
- *      The length to make the response buffer that is passed along with the
- *      command
- * \param expected
- *      The expected response from the command
+ *      The length of the query string
  *
  * \return 0
- *      Successful
- * \return 1
- *      Command failed or returned what was not expected
+ *      Success
+ * \return <0
+ *      The request could not be sent
  */
-uint8_t Socket::SendCommand(const char *command, int length, const char *expected)
+int Socket::Upload(std::size_t length)
 {
-    char resp[length];
-    NimbeLink::Sdk::SecureServices::At::Result result;
-    NimbeLink::Sdk::SecureServices::At::Error error;
+#   if CONFIG_SOCKET_DELTA
+    this->uploads++;
+#   endif
 
-    int32_t ret = NimbeLink::Sdk::SecureServices::At::RunCommand(&result, &error, command, strlen(command), resp, length, nullptr);
+#   if CONFIG_SOCKET_QUEUE
+    if (this->queue.GetCount() > 0)
+    {
+        this->queue.Push(this->transmit, length);
 
-#   if CONFIG_SOCKET_DEBUG
-    printk("Command: %s\n", command);
-    printk("ret: %d\n", ret);
+        return -1;
+    }
 #   endif
 
-    // If the AT command was not successfully processed, stop
-    if (ret != 0)
+    int err = this->Post(length);
+
+#   if CONFIG_SOCKET_QUEUE
+    if (err == -1)
     {
-        return 1;
+        this->queue.Push(this->transmit, length);
     }
+#   endif
 
-    // If the AT command failed, stop
-    if (result != 0)
+    return err;
+}
+
+#if CONFIG_SOCKET_QUEUE
+/**
+ * \brief Posts a batch of the data we previously couldn't send
+ *
+ *  This goes ahead of anything new, as whatever the server gets last is
+ *  what it shows.
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Socket::Replay(void)
+{
+    uint32_t replayed = 0;
+
+    while ((replayed < CONFIG_SOCKET_QUEUE_BATCH) && (this->queue.GetCount() > 0))
     {
-    #   if CONFIG_SOCKET_DEBUG
-        NimbeLink::Examples::Utils::PrintError(std::string_view(command), result, error);
-    #   endif
+        int length = this->queue.Peek(this->transmit, MAX_TRANSMISSION);
 
-        return 1;
+        if (length < 0)
+        {
+            continue;
+        }
+
+        // If we lost our connection, leave the rest for the next cycle
+        if (this->Post(length) == -1)
+        {
+            break;
+        }
+
+        this->queue.Pop();
+
+        replayed++;
     }
 
-    // If the AT command succeeded, but the response was not what was expected, stop
-    if (std::string_view(resp).find(std::string_view(expected)))
+    this->queue.Commit();
+
+#   if CONFIG_SOCKET_DEBUG
+    printk("Replayed %u queued posts, %u left\n",
+        static_cast<unsigned int>(replayed),
+        static_cast<unsigned int>(this->queue.GetCount())
+    );
+#   endif
+}
+#endif
+
+/**
+ * \brief Writes fields as a query string
+ *
+ * \param *buffer
+ *      The buffer to write to
+ * \param size
+ *      The size of the buffer
+ * \param *fields
+ *      The fields to write
+ * \param count
+ *      The number of fields
+ *
+ * \return std::size_t
+ *      The length of the query string, which fills the buffer if it was cut
+ *      short
+ */
+std::size_t Socket::FormatFields(char *buffer, std::size_t size, const Field *fields, std::size_t count)
+{
+    std::size_t length = 0;
+
+    buffer[0] = '\0';
+
+    for (std::size_t i = 0; (i < count) && (length < (size - 1)); i++)
     {
-    #   if CONFIG_SOCKET_DEBUG
-        printk("Expected %s, recieved %s\n", expected, resp);
-    #   endif
+        const char *separator = (i > 0) ? "&" : "";
 
-        return 1;
+        int written;
+
+        switch (fields[i].type)
+        {
+            case Field::Type::Integer:
+                written = snprintf(&buffer[length], size - length, "%s%s=%d", separator, fields[i].name, static_cast<int>(fields[i].integer));
+                break;
+            case Field::Type::String:
+            default:
+                written = snprintf(&buffer[length], size - length, "%s%s=%s", separator, fields[i].name, fields[i].string);
+                break;
+        }
+
+        if (written < 0)
+        {
+            break;
+        }
+
+        length = std::min(length + written, size - 1);
     }
 
-    // The AT command succeeded and the response was what we expected
-#   if CONFIG_SOCKET_DEBUG
-    printk("recieved %s\n", resp);
+    return length;
+}
+
+/**
+ * \brief Picks out which of a widget's fields to post this cycle
+ *
+ *  With CONFIG_SOCKET_DELTA, widgets that provide typed fields only have the
+ *  fields that changed kept, which can leave nothing to post. This is only
+ *  done once for each widget each cycle, as it's what's recorded as sent.
+ *
+ * \param index
+ *      Which registered widget to get the fields of
+ *
+ * \return >=0
+ *      The number of fields kept
+ * \return -1
+ *      The widget's data is posted as it writes it
+ */
+int Socket::Select(std::size_t index)
+{
+#   if CONFIG_SOCKET_DELTA
+    std::size_t count = this->entries[index].data->Collect(this->selected, std::size(this->selected));
+
+    if (count > 0)
+    {
+        return static_cast<int>(this->changes.Filter(index, this->selected, count));
+    }
+#   else
+    (void)index;
 #   endif
 
-    return 0;
+    return -1;
 }
 
 /**
- * \brief sets up the socket
+ * \brief Has a widget write its data as a query string
  *
- * \param none
+ * \param index
+ *      Which registered widget to get the data of
+ * \param selected
+ *      What Select() gave back for the widget this cycle
+ * \param *buffer
+ *      The buffer to write to
+ * \param size
+ *      The size of the buffer
  *
- * \return file descriptor of the socket if successful, -1 if not
+ * \return std::size_t
+ *      The length of the query string
  */
-int Socket::SetSocketUp(void)
+std::size_t Socket::Gather(std::size_t index, int selected, char *buffer, std::size_t size)
 {
-    // Struct that contains the AT command and the desired response for the
-    // command check connection
-    struct
+#   if CONFIG_SOCKET_DELTA
+    if (selected >= 0)
     {
-        std::string_view command;
-        std::string_view expected;
-    } commands[] = {
-        {"AT+CFUN?","+CFUN: 1"},
-        {"AT+CEREG?","+CEREG: 0,1"},
-    };
-
-    // Iterate through the struct and execute the commands with a 5 second
-    // pause between commands
-    for (std::size_t i = 0; i < std::size(commands); i++)
+        return this->FormatFields(buffer, size, this->selected, selected);
+    }
+#   else
+    (void)selected;
+#   endif
+
+    this->entries[index].data->Retrieve(buffer, size);
+
+    return strlen(buffer);
+}
+
+/**
+ * \brief Adds a widget's data to the batch in our transmit buffer
+ *
+ *  The widget writes its data directly behind what's already in the batch.
+ *  If it won't fit, the batch is posted first and the widget's data starts a
+ *  new one.
+ *
+ * \param length
+ *      The length of the batch's query string so far
+ * \param index
+ *      Which registered widget's data to add
+ *
+ * \return std::size_t
+ *      The new length of the batch's query string
+ */
+std::size_t Socket::Batch(std::size_t length, std::size_t index)
+{
+    int selected = this->Select(index);
+
+    // Leave room for the '&' separating this widget's data from the last's
+    std::size_t start = (length > 0) ? (length + 1) : 0;
+
+    if (start < (MAX_TRANSMISSION - 1))
     {
-        k_sleep(5000);
+        std::size_t added = this->Gather(index, selected, &this->transmit[start], MAX_TRANSMISSION - start);
 
-        if (SendCommand(std::data(commands[i].command), 100, std::data(commands[i].expected)) != 0)
+        // If the data filled up the rest of the buffer, it may have been cut
+        // short, so it'll have to go in its own request
+        if ((start + added) < (MAX_TRANSMISSION - 1))
         {
-            return -1;
+            if (added == 0)
+            {
+                return length;
+            }
+
+            if (start > 0)
+            {
+                this->transmit[length] = '&';
+            }
+
+            return start + added;
         }
     }
 
-    // Set up socket
-    struct addrinfo *res;
-    struct addrinfo hints;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-    hints.ai_protocol = 0;
+    // Only what was already in the batch gets sent, so there's no need to
+    // clean up what the widget wrote behind it
+    if (length > 0)
+    {
+        this->Upload(this->Finish(length));
+    }
+
+    return this->Gather(index, selected, this->transmit, MAX_TRANSMISSION);
+}
+
+/**
+ * \brief Writes fields to a CBOR map
+ *
+ * \param &writer
+ *      The writer to write with
+ * \param *fields
+ *      The fields to write
+ * \param count
+ *      The number of fields
+ *
+ * \return none
+ */
+void Socket::EncodeFields(CborWriter &writer, const Field *fields, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        writer.String(fields[i].name);
+
+        switch (fields[i].type)
+        {
+            case Field::Type::Integer:
+                writer.Integer(fields[i].integer);
+                break;
+            case Field::Type::String:
+                writer.String(fields[i].string);
+                break;
+        }
+    }
+}
+
+/**
+ * \brief Adds a widget's fields to the CBOR map in our transmit buffer
+ *
+ *  If the fields won't fit, the map is posted first and the widget's fields
+ *  start a new one. Widgets that don't provide fields are skipped.
+ *
+ * \param length
+ *      The length of the map so far, or 0 if there isn't one yet
+ * \param index
+ *      Which registered widget's fields to add
+ *
+ * \return std::size_t
+ *      The new length of the map
+ */
+std::size_t Socket::Encode(std::size_t length, std::size_t index)
+{
+    Field fields[MaxFields];
+
+    std::size_t count = this->entries[index].data->Collect(fields, std::size(fields));
 
-    int err = getaddrinfo(std::data("dweet.io"), NULL, &hints, &res);
+#   if CONFIG_SOCKET_DELTA
+    count = this->changes.Filter(index, fields, count);
+#   endif
+
+    if (count == 0)
+    {
+        return length;
+    }
 
-    if (err)
+    uint8_t *buffer = reinterpret_cast<uint8_t *>(this->transmit);
+
+    if (length == 0)
     {
-        printk("unable to get address info, err %d\n", err);
+        buffer[length++] = CborWriter::MapStart;
     }
 
-    ((struct sockaddr_in *)res->ai_addr)->sin_port = htons(HTTP_PORT);
+    // Leave room for the break that ends the map
+    CborWriter writer(buffer, MAX_TRANSMISSION - 1, length);
 
-    int socketId = socket(AF_INET, SOCK_STREAM, 0);
+    this->EncodeFields(writer, fields, count);
 
-    if (socketId < 0)
+    if (writer.IsValid())
     {
-        printk("Unable to open socket\n");
+        return writer.GetLength();
+    }
 
-        return socketId;
+    // Whatever the widget wrote past the end of the map gets overwritten by
+    // the map's break
+    if (length > 1)
+    {
+        this->Upload(this->Finish(length));
     }
 
-    err = connect(socketId, res->ai_addr, sizeof(struct sockaddr_in));
+    buffer[0] = CborWriter::MapStart;
+
+    CborWriter fresh(buffer, MAX_TRANSMISSION - 1, 1);
 
-    if (err != 0)
+    this->EncodeFields(fresh, fields, count);
+
+    if (!fresh.IsValid())
     {
-        printk("Unable to connect to dweet.io, err %d\n", err);
+        printk("Fields too large to post\n");
 
-        return err;
+        return 0;
     }
 
-    return socketId;
+    return fresh.GetLength();
+}
+
+/**
+ * \brief Finishes off the data in our transmit buffer so it can be sent
+ *
+ * \param length
+ *      The length of the data
+ *
+ * \return std::size_t
+ *      The finished length of the data
+ */
+std::size_t Socket::Finish(std::size_t length)
+{
+#   if CONFIG_SOCKET_CBOR
+    this->transmit[length++] = CborWriter::Break;
+#   endif
+
+    return length;
 }
 
 /**
@@ -253,68 +604,143 @@ int Socket::SetSocketUp(void)
  */
 void Socket::Run(void)
 {
+    this->network.Init();
+
+#   if CONFIG_SOCKET_QUEUE
+    this->queue.Init();
+#   endif
+
+#   if CONFIG_SOCKET_METRICS
+    this->transport.SetMetrics(&this->metrics);
+#   endif
+
     while (true)
     {
-        // For each widget that wants to be posted on the web, create a socket
-        // for it
-        for (std::size_t i = 0; i < std::size(datas); i++)
+        std::size_t length = 0;
+
+        // Wait until someone's ready to post
+        std::size_t due[MaxData];
+        std::size_t count = this->Schedule(due);
+
+    #   if CONFIG_SOCKET_METRICS
+        int64_t start = k_uptime_get();
+        uint32_t bytes = this->transport.GetStats().bytes;
+    #   endif
+
+    #   if CONFIG_SOCKET_QUEUE
+        // Catch up on what we missed before sending anything newer
+        if (this->queue.GetCount() > 0)
         {
-            // Check if there is actually a widget at this index and above
-            if (i >= this->registered)
-            {
-                break;
-            }
+            this->Replay();
+        }
+    #   endif
+
+    #   if CONFIG_SOCKET_DELTA
+        this->changes.Begin();
+
+        this->uploads = 0;
 
-            // Get the data that wants to be posted
-            char data[MAX_TRANSMISSION];
+        // The responses to anything still waiting on one, such as what was
+        // just caught up on, come in ahead of this cycle's
+        const Transport::Stats before = this->transport.GetStats();
+        const std::size_t ahead = this->transport.GetPending();
+    #   endif
 
-            this->datas[i]->Retrieve(data, MAX_TRANSMISSION);
+        // For each widget that's due to be posted on the web, either add its
+        // data to our batch or send a request for it
+        for (std::size_t n = 0; n < count; n++)
+        {
+            std::size_t i = due[n];
 
-        #   if CONFIG_SOCKET_DEBUG
-            printk("data: %s\n", data);
+        #   if CONFIG_SOCKET_METRICS
+            std::size_t previous = length;
         #   endif
 
-            // Set up the HTTP request ("POST ... HTTP/1.1\r\n\r\n<payload>")
-            char post[] = "POST /dweet/for/skywire_nano_socket_dial_widget";
+        #   if CONFIG_SOCKET_CBOR
+            length = this->Encode(length, i);
+        #   elif CONFIG_SOCKET_BATCH
+            length = this->Batch(length, i);
+        #   else
+            length = this->Gather(i, this->Select(i), this->transmit, MAX_TRANSMISSION);
+        #   endif
 
-            uint32_t payload_length = std::size(post) + std::size(" HTTP/1.1\r\n\r\n") + strlen(data);
-            char payload[payload_length];
+        #   if CONFIG_SOCKET_METRICS
+            // If the batch was sent to make room, this widget's data started
+            // a new one
+            this->posted[i] += (length >= previous) ? (length - previous) : length;
+        #   endif
 
-            snprintf(payload, payload_length, "%s?%s HTTP/1.1\r\n\r\n", post, data);
+        #   if !CONFIG_SOCKET_BATCH
+            if (length > 0)
+            {
+                this->Upload(this->Finish(length));
 
-        #   if CONFIG_SOCKET_DEBUG
-            printk("payload: %s", payload);
+                length = 0;
+            }
         #   endif
+        }
 
-            int send_sock = this->SetSocketUp();
+        if (length > 0)
+        {
+            this->Upload(this->Finish(length));
+        }
 
-            send(send_sock, payload, payload_length, 0);
+        // Give the responses to everything we sent a chance to arrive
+        this->transport.Service(CONFIG_SOCKET_RESPONSE_TIMEOUT);
 
-            struct pollfd sock[1];
+    #   if CONFIG_SOCKET_DELTA
+        // Only treat what we sent as seen if every upload this cycle got to
+        // the server and every response since was a success
+        const Transport::Stats &after = this->transport.GetStats();
 
-            sock[0].fd = send_sock;
-            sock[0].events = POLLIN;
+        if ((this->transport.GetPending() == 0) &&
+            (after.failed == before.failed) &&
+            (after.timeouts == before.timeouts) &&
+            ((after.succeeded - before.succeeded) == (ahead + this->uploads)))
+        {
+            this->changes.Commit();
+        }
 
-            if (poll(sock, 1, -1) < 0)
-            {
-                printk("Invalid poll return value\n");
-            }
+    #   if CONFIG_SOCKET_DEBUG
+        printk("%u widgets sent in full, %u uploads\n",
+            static_cast<unsigned int>(this->changes.GetHeartbeats()),
+            static_cast<unsigned int>(this->uploads)
+        );
+    #   endif
+    #   endif
 
-        #   if CONFIG_SOCKET_DEBUG
-            if (sock[0].revents & POLLIN)
-            {
-                char buffer[1024];
-                int valread = recv(send_sock, buffer, 1024, 0);
+    #   if CONFIG_SOCKET_DEBUG
+        const Resolver::Stats &stats = this->resolver.GetStats();
+
+        printk("DNS hits: %u, misses: %u, fallbacks: %u, time resolving: %u ms\n",
+            static_cast<unsigned int>(stats.hits),
+            static_cast<unsigned int>(stats.misses),
+            static_cast<unsigned int>(stats.fallbacks),
+            static_cast<unsigned int>(stats.missTime)
+        );
+
+        const Transport::Stats &responses = this->transport.GetStats();
+
+        printk("Posts succeeded: %u, failed: %u, timeouts: %u\n",
+            static_cast<unsigned int>(responses.succeeded),
+            static_cast<unsigned int>(responses.failed),
+            static_cast<unsigned int>(responses.timeouts)
+        );
+    #   endif
 
-                printk("Read %d, output:\n%s\n", valread, buffer);
-            }
-        #   endif
+    #   if CONFIG_SOCKET_METRICS
+        this->metrics.cycle.Add(k_uptime_get() - start);
+
+        this->metrics.Print();
 
-            close(send_sock);
+        printk("Bytes sent this cycle: %u\n", static_cast<unsigned int>(this->transport.GetStats().bytes - bytes));
+
+        for (std::size_t i = 0; i < this->count; i++)
+        {
+            printk("Widget %u data: %u bytes total\n", static_cast<unsigned int>(i), static_cast<unsigned int>(this->posted[i]));
         }
+    #   endif
 
-        // Wait until we're ready to send data again
-        k_sleep(K_SECONDS(CONFIG_SOCKET_POST_RATE));
     }
 }
 
@@ -323,21 +749,28 @@ void Socket::Run(void)
  *
  * \param &data
  *      The widget that wants to be posted and subclasses the Data class
+ * \param period
+ *      How often to post the widget's data, in milliseconds
+ * \param priority
+ *      Where the widget's data goes when posted along with others, with
+ *      higher priorities going first
  *
  * \return 0
  *      Succes
  * \return 1
  *      Full
  */
-bool Socket::RegisterData(Data &data)
+bool Socket::RegisterData(Data &data, int32_t period, uint8_t priority)
 {
-    if (this->size >= std::size(this->datas))
+    if (this->count >= std::size(this->entries))
     {
         return 1;
     }
 
-    this->datas[this->size++] = &data;
-    this->registered++;
+    // New widgets are due right away
+    this->entries[this->count] = {&data, period, priority, 0};
+
+    this->count++;
 
     return 0;
 }
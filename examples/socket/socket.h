@@ -23,16 +23,27 @@
 
 #include <string>
 
+#include "examples/at/at_service.h"
+#include "examples/socket/cbor.h"
+#if CONFIG_SOCKET_DELTA
+#include "examples/socket/changes.h"
+#endif
+#include "examples/socket/field.h"
+#if CONFIG_SOCKET_METRICS
+#include "examples/socket/metrics.h"
+#endif
+#include "examples/socket/network.h"
+#if CONFIG_SOCKET_QUEUE
+#include "examples/socket/queue.h"
+#endif
+#include "examples/socket/resolver.h"
+#if CONFIG_SOCKET_TRANSPORT_COAP
+#include "examples/socket/transports/coap.h"
+#else
+#include "examples/socket/transports/http.h"
+#endif
 #include "nimbelink/sdk/secure_services/at.h"
 
-#define HTTP_PORT 80
-#define HTTP_HEAD                                                   \
-    "POST /dweet/for/skywire_nano_socket_dial_widget HTTP/1.1\r\n"  \
-    "Host: dweet.io:80\r\n"                                         \
-    "Connection: close\r\n\r\n"
-#define HTTP_HEAD_LEN (sizeof(HTTP_HEAD) - 1)
-#define HTTP_HDR_END "\r\n\r\n"
-#define RECV_BUF_SIZE 2048
 #define MAX_TRANSMISSION 2000
 
 namespace NimbeLink::Examples
@@ -43,23 +54,54 @@ namespace NimbeLink::Examples
 class NimbeLink::Examples::Socket
 {
     public:
+        // A single typed value a widget wants posted
+        using Field = NimbeLink::Examples::Field;
+
         // Interface class for classes that want their data to be posted to the web
         //
         // This enforces overriding Retrieve, which populates a string with how
         // the widget wants to be posted to the web.
+        //
+        // Widgets can also override Collect to provide their data as typed
+        // fields, which is used when posting CBOR.
         class Data
         {
             public:
                 virtual void Retrieve(char *buffer, uint16_t max_length) = 0;
+
+                /**
+                 * \brief Gets the widget's data as typed fields
+                 *
+                 * \param *fields
+                 *      The fields to fill in
+                 * \param count
+                 *      The most fields to fill in
+                 *
+                 * \return std::size_t
+                 *      The number of fields filled in
+                 */
+                virtual std::size_t Collect(Field *fields, std::size_t count)
+                {
+                    (void)fields;
+                    (void)count;
+
+                    return 0;
+                }
         };
 
+        // The most fields a single widget can provide
+        static constexpr const std::size_t MaxFields = 12;
+
+        // The most widgets that can be registered
+        static constexpr const std::size_t MaxData = 10;
+
     private:
         // Our Zephyr stack
         //
         // C++ isn't a big fan of placing a class' member in a section, so
         // we'll reproduce what the Zephyr library does when someone uses
         // K_THREAD_STACK_DEFINE().
-        __attribute__((aligned(STACK_ALIGN))) struct _k_thread_stack_element stack[4096 + MPU_GUARD_ALIGN_AND_SIZE];
+        __attribute__((aligned(STACK_ALIGN))) struct _k_thread_stack_element stack[2048 + MPU_GUARD_ALIGN_AND_SIZE];
 
         // Our Zephyr thread
         struct k_thread thread;
@@ -67,25 +109,97 @@ class NimbeLink::Examples::Socket
         // Our thread's ID
         k_tid_t threadId;
 
+        // Our view of the modem's network registration
+        Network network;
+
+        // Our cache of resolved hosts
+        Resolver resolver;
+
+        // How we get our data to the server
+    #   if CONFIG_SOCKET_TRANSPORT_COAP
+        CoapTransport transport{this->resolver, CONFIG_SOCKET_HOST, CONFIG_SOCKET_PORT};
+    #   else
+        HttpTransport transport{this->resolver, CONFIG_SOCKET_HOST, CONFIG_SOCKET_PORT};
+    #   endif
+
+        // A registered widget and when it's next due to be posted
+        struct Entry
+        {
+            Data *data;
+            int32_t period;
+            uint8_t priority;
+            int64_t due;
+        };
+
         // List of objects that inherit from Data that want to be posted to the
         // web
-        Data *datas[10];
+        Entry entries[MaxData];
+        std::size_t count = 0;
+
+        // The buffer widgets write their data to, which is sent from directly
+        //
+        // This lives here rather than on our stack, which keeps the stack
+        // small.
+        char transmit[MAX_TRANSMISSION];
 
-        uint8_t size = 0;
-        uint8_t registered = 0;
+    #   if CONFIG_SOCKET_DELTA
+        // What the server has seen of each widget's fields
+        ChangeFilter<MaxData, MaxFields> changes{K_SECONDS(CONFIG_SOCKET_HEARTBEAT_RATE)};
+
+        // The fields of the widget being posted that are worth posting
+        //
+        // A widget's fields are only filtered once a cycle, but may need to
+        // be written out more than once, so they're kept here until then.
+        Field selected[MaxFields];
+
+        // How many uploads we've tried this cycle, which have to all be
+        // acknowledged before what's been sent is considered seen
+        uint32_t uploads = 0;
+    #   endif
+
+    #   if CONFIG_SOCKET_METRICS
+        // How long things are taking
+        Metrics metrics;
+
+        // How much data each widget has given us to post, not counting
+        // protocol overhead
+        uint32_t posted[MaxData] = {0};
+    #   endif
+
+    #   if CONFIG_SOCKET_QUEUE
+        // Where we keep data we couldn't send until we're able to again
+    #   if CONFIG_SOCKET_QUEUE_RAM
+        UploadQueue::RamStorage<CONFIG_SOCKET_QUEUE_DEPTH + 1, MAX_TRANSMISSION> storage;
+    #   else
+        UploadQueue::FlashStorage storage;
+    #   endif
+
+        UploadQueue queue{this->storage};
+    #   endif
 
     private:
         static void Handler(void *arg1, void *arg2, void *arg3);
 
-        uint8_t SendCommand(const char *command, int length, const char *expected);
         int SetSocketUp(void);
 
-        void Run(void);
+        int Post(std::size_t length);
+        int Upload(std::size_t length);
+        void Replay(void);
+        std::size_t Schedule(std::size_t *due);
+
+        static std::size_t FormatFields(char *buffer, std::size_t size, const Field *fields, std::size_t count);
+        int Select(std::size_t index);
+        std::size_t Gather(std::size_t index, int selected, char *buffer, std::size_t size);
+        std::size_t Batch(std::size_t length, std::size_t index);
 
-        int AtCommsInit(void);
+        static void EncodeFields(CborWriter &writer, const Field *fields, std::size_t count);
+        std::size_t Encode(std::size_t length, std::size_t index);
+        std::size_t Finish(std::size_t length);
+
+        void Run(void);
 
     public:
-        Socket(void);
+        Socket(AtService &at);
 
-        bool RegisterData(Data &data);
+        bool RegisterData(Data &data, int32_t period = K_SECONDS(CONFIG_SOCKET_POST_RATE), uint8_t priority = 0);
 };
@@ -0,0 +1,85 @@
+/**
+ * \file
+ *
+ * \brief The interface the socket applet posts data through
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if CONFIG_SOCKET_METRICS
+#include "examples/socket/metrics.h"
+#endif
+
+namespace NimbeLink::Examples
+{
+    class Transport;
+}
+
+// Interface class for the ways the socket applet can post data
+//
+// Posted data is either a query string or, with CONFIG_SOCKET_CBOR, a CBOR
+// map, and each transport decides how to wrap it up.
+//
+// Send() and Service() only fail if the data didn't get to the server. A post
+// the server answers with an error is counted as failed in our statistics, but
+// isn't worth sending again, so it isn't retried or queued.
+class NimbeLink::Examples::Transport
+{
+    public:
+        /**
+         * \brief Post statistics
+         */
+        struct Stats
+        {
+            // Posts the server accepted
+            uint32_t succeeded = 0;
+
+            // Posts the server rejected or never answered
+            uint32_t failed = 0;
+
+            // Connects, sends and responses that took too long
+            uint32_t timeouts = 0;
+
+            // Bytes put on the wire, including protocol overhead and
+            // retransmissions
+            uint32_t bytes = 0;
+        };
+
+    public:
+        virtual bool IsOpen(void) const = 0;
+        virtual bool NeedsOpen(void) = 0;
+
+        virtual int Open(void) = 0;
+        virtual void Close(void) = 0;
+
+        virtual int Send(const char *data, std::size_t length) = 0;
+        virtual int Service(int32_t timeout) = 0;
+
+        virtual std::size_t GetPending(void) const = 0;
+        virtual const Stats &GetStats(void) const = 0;
+
+    #   if CONFIG_SOCKET_METRICS
+        /**
+         * \brief Sets where to record connect and response times
+         *
+         * \param *metrics
+         *      Where to record times, or nullptr to stop recording them
+         *
+         * \return none
+         */
+        virtual void SetMetrics(Metrics *metrics)
+        {
+            (void)metrics;
+        }
+    #   endif
+};
@@ -0,0 +1,502 @@
+/**
+ * \file
+ *
+ * \brief Posts the socket applet's data over CoAP/UDP
+ *
+ *  Posts are sent as confirmable messages, which are retransmitted until
+ *  they're acknowledged, or, without CONFIG_SOCKET_COAP_CONFIRMABLE, as
+ *  non-confirmable messages whose responses are picked up by Service().
+ *  Anything larger than CONFIG_SOCKET_COAP_BLOCK_SIZE is sent block-wise
+ *  using the Block1 option (RFC 7959).
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+#include <kernel.h>
+#include <net/coap.h>
+#include <net/socket.h>
+
+#include "examples/socket/transports/coap.h"
+
+using namespace NimbeLink::Examples;
+
+#if CONFIG_SOCKET_COAP_CONFIRMABLE
+#define COAP_TYPE COAP_TYPE_CON
+#else
+#define COAP_TYPE COAP_TYPE_NON_CON
+#endif
+
+#if CONFIG_SOCKET_CBOR
+#define COAP_FORMAT COAP_CONTENT_FORMAT_APP_CBOR
+#else
+#define COAP_FORMAT COAP_CONTENT_FORMAT_TEXT_PLAIN
+#endif
+
+/**
+ * \brief Opens our socket if it isn't already open
+ *
+ * \param none
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int CoapTransport::Open(void)
+{
+    if (this->IsOpen())
+    {
+        return 0;
+    }
+
+#   if CONFIG_SOCKET_METRICS
+    int64_t start = k_uptime_get();
+#   endif
+
+    struct sockaddr_in address;
+
+    if (this->resolver.Resolve(this->host, address) != 0)
+    {
+        return -1;
+    }
+
+    address.sin_port = htons(this->port);
+
+    int socketId = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (socketId < 0)
+    {
+        printk("Unable to open socket\n");
+
+        return socketId;
+    }
+
+    // Connecting a UDP socket just sets where our datagrams go to and come
+    // from
+    int err = connect(socketId, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+
+    if (err != 0)
+    {
+        printk("Unable to connect to %s, err %d\n", this->host, err);
+
+        close(socketId);
+
+        return -1;
+    }
+
+    this->socketId = socketId;
+
+#   if CONFIG_SOCKET_METRICS
+    if (this->metrics != nullptr)
+    {
+        this->metrics->connect.Add(k_uptime_get() - start);
+    }
+#   endif
+
+    return 0;
+}
+
+/**
+ * \brief Closes our socket
+ *
+ * \param none
+ *
+ * \return none
+ */
+void CoapTransport::Close(void)
+{
+    if (!this->IsOpen())
+    {
+        return;
+    }
+
+    close(this->socketId);
+
+    this->socketId = -1;
+
+    // Nothing more can arrive on the old socket
+    this->awaiting = 0;
+}
+
+/**
+ * \brief Builds a POST request in our buffer
+ *
+ * \param &request
+ *      The request to build
+ * \param *block
+ *      The block-wise transfer this request is a part of, if any
+ * \param *data
+ *      The request's payload
+ * \param length
+ *      The length of the request's payload
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int CoapTransport::Build(struct coap_packet &request, struct coap_block_context *block, const char *data, std::size_t length)
+{
+    int err = coap_packet_init(
+        &request,
+        this->buffer,
+        sizeof(this->buffer),
+        COAP_VERSION_1,
+        COAP_TYPE,
+        COAP_TOKEN_MAX_LEN,
+        coap_next_token(),
+        COAP_METHOD_POST,
+        coap_next_id()
+    );
+
+    // Options have to be appended in order of their numbers
+    for (std::size_t i = 0; (err == 0) && (i < std::size(Path)); i++)
+    {
+        err = coap_packet_append_option(
+            &request,
+            COAP_OPTION_URI_PATH,
+            reinterpret_cast<const uint8_t *>(Path[i]),
+            strlen(Path[i])
+        );
+    }
+
+    if (err == 0)
+    {
+        err = coap_append_option_int(&request, COAP_OPTION_CONTENT_FORMAT, COAP_FORMAT);
+    }
+
+    if ((err == 0) && (block != nullptr))
+    {
+        err = coap_append_block1_option(&request, block);
+    }
+
+    if (err == 0)
+    {
+        err = coap_packet_append_payload_marker(&request);
+    }
+
+    if (err == 0)
+    {
+        err = coap_packet_append_payload(&request, reinterpret_cast<const uint8_t *>(data), length);
+    }
+
+    if (err != 0)
+    {
+        printk("Unable to build CoAP request, err %d\n", err);
+    }
+
+    return err;
+}
+
+/**
+ * \brief Counts a response towards our statistics
+ *
+ * \param code
+ *      The response's code
+ *
+ * \return none
+ */
+void CoapTransport::Count(uint8_t code)
+{
+    // Success codes are 2.xx
+    if ((code >> 5) == 2)
+    {
+        this->stats.succeeded++;
+    }
+    else
+    {
+        printk("Request failed with code %d.%02d\n", code >> 5, code & 0x1F);
+
+        this->stats.failed++;
+    }
+}
+
+/**
+ * \brief Sends a request, waiting for its acknowledgement if it's
+ *        confirmable
+ *
+ * \param &request
+ *      The request to send
+ *
+ * \return 0
+ *      The request was sent and isn't confirmable
+ * \return >0
+ *      The code the request was acknowledged with, or Reset if the server
+ *      reset it
+ * \return <0
+ *      The request couldn't be sent or wasn't acknowledged
+ */
+int CoapTransport::Exchange(struct coap_packet &request)
+{
+    uint16_t id = coap_header_get_id(&request);
+    int32_t timeout = AckTimeout;
+
+#   if CONFIG_SOCKET_METRICS
+    int64_t start = k_uptime_get();
+#   endif
+
+    for (uint8_t attempt = 0; attempt <= MaxRetransmit; attempt++)
+    {
+        if (send(this->socketId, request.data, request.offset, 0) < 0)
+        {
+            this->Close();
+
+            return -1;
+        }
+
+        this->stats.bytes += request.offset;
+
+        if (COAP_TYPE != COAP_TYPE_CON)
+        {
+            return 0;
+        }
+
+        int64_t deadline = k_uptime_get() + timeout;
+
+        while (true)
+        {
+            int64_t remaining = deadline - k_uptime_get();
+
+            if (remaining <= 0)
+            {
+                break;
+            }
+
+            struct pollfd sock[1];
+
+            sock[0].fd = this->socketId;
+            sock[0].events = POLLIN;
+
+            if (poll(sock, 1, static_cast<int>(remaining)) <= 0)
+            {
+                break;
+            }
+
+            // We only need the header, and the rest of the datagram is
+            // dropped
+            uint8_t header[4];
+
+            if (recv(this->socketId, header, sizeof(header), 0) < static_cast<ssize_t>(sizeof(header)))
+            {
+                continue;
+            }
+
+            uint8_t type = (header[0] >> 4) & 0x03;
+            uint16_t responseId = (header[2] << 8) | header[3];
+
+            if (responseId != id)
+            {
+                continue;
+            }
+
+            if (type == COAP_TYPE_ACK)
+            {
+            #   if CONFIG_SOCKET_METRICS
+                if (this->metrics != nullptr)
+                {
+                    this->metrics->firstByte.Add(k_uptime_get() - start);
+                }
+            #   endif
+
+                return header[1];
+            }
+
+            if (type == COAP_TYPE_RESET)
+            {
+                printk("Request was reset\n");
+
+                return Reset;
+            }
+        }
+
+        timeout *= 2;
+    }
+
+    printk("Timed out waiting for an acknowledgement\n");
+
+    this->stats.timeouts++;
+
+    return -1;
+}
+
+/**
+ * \brief Posts data
+ *
+ * \param *data
+ *      The data to post
+ * \param length
+ *      The length of the data
+ *
+ * \return 0
+ *      The data reached the server, which may have rejected it
+ * \return <0
+ *      The data couldn't be sent or wasn't acknowledged
+ */
+int CoapTransport::Send(const char *data, std::size_t length)
+{
+    struct coap_packet request;
+    struct coap_block_context block;
+    struct coap_block_context *context = nullptr;
+
+    // Anything that won't fit in one message goes out a block at a time
+    if (length > BlockSize)
+    {
+        coap_block_transfer_init(&block, GetBlockSize(), length);
+
+        context = &block;
+    }
+
+    std::size_t offset = 0;
+    int code;
+
+    do
+    {
+        std::size_t size = std::min(BlockSize, length - offset);
+
+        if (context != nullptr)
+        {
+            context->current = offset;
+        }
+
+        if (this->Build(request, context, &data[offset], size) != 0)
+        {
+            return -1;
+        }
+
+        code = this->Exchange(request);
+
+        if (code < 0)
+        {
+            this->stats.failed++;
+
+            return -1;
+        }
+
+        offset += size;
+
+        // A server that rejects a post would reject it again, so it's counted
+        // as failed but still reported as sent, which keeps it from being
+        // retried or queued
+        if (code == Reset)
+        {
+            this->stats.failed++;
+
+            break;
+        }
+
+        // Each block but the last should be acknowledged with 2.31 Continue,
+        // and the last with the response to the whole post
+        if ((code > 0) && ((offset == length) || ((code >> 5) != 2)))
+        {
+            this->Count(code);
+
+            break;
+        }
+    } while (offset < length);
+
+    // Without a response yet, it'll show up in Service()
+    if (code == 0)
+    {
+        this->awaiting++;
+    }
+
+    return 0;
+}
+
+/**
+ * \brief Handles any responses that have arrived
+ *
+ *  Responses to non-confirmable requests, and separate responses to
+ *  confirmable ones, show up here. Once every post has its response, this
+ *  returns without waiting out the timeout.
+ *
+ * \param timeout
+ *      How long to wait for responses, in milliseconds
+ *
+ * \return 0
+ *      Our socket can still be used
+ * \return -1
+ *      Our socket was closed
+ */
+int CoapTransport::Service(int32_t timeout)
+{
+    int64_t deadline = k_uptime_get() + timeout;
+
+    while (this->IsOpen())
+    {
+        if (this->awaiting == 0)
+        {
+            return 0;
+        }
+
+        int64_t remaining = deadline - k_uptime_get();
+
+        struct pollfd sock[1];
+
+        sock[0].fd = this->socketId;
+        sock[0].events = POLLIN;
+
+        int ret = poll(sock, 1, static_cast<int>(std::max<int64_t>(remaining, 0)));
+
+        if (ret < 0)
+        {
+            this->Close();
+
+            return -1;
+        }
+
+        if (ret == 0)
+        {
+            return 0;
+        }
+
+        uint8_t header[4];
+
+        if (recv(this->socketId, header, sizeof(header), 0) < static_cast<ssize_t>(sizeof(header)))
+        {
+            continue;
+        }
+
+        uint8_t type = (header[0] >> 4) & 0x03;
+
+        // A confirmable response needs an empty acknowledgement
+        if (type == COAP_TYPE_CON)
+        {
+            const uint8_t ack[] = {
+                static_cast<uint8_t>((COAP_VERSION_1 << 6) | (COAP_TYPE_ACK << 4)),
+                0,
+                header[2],
+                header[3],
+            };
+
+            if (send(this->socketId, ack, sizeof(ack), 0) > 0)
+            {
+                this->stats.bytes += sizeof(ack);
+            }
+        }
+
+        // Empty messages don't carry a response, and 2.31 Continue only
+        // answers one block of a post
+        if ((header[1] != 0) && (header[1] != COAP_RESPONSE_CODE_CONTINUE))
+        {
+            if (this->awaiting > 0)
+            {
+                this->awaiting--;
+            }
+
+            this->Count(header[1]);
+        }
+    }
+
+    return -1;
+}
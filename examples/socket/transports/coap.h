@@ -0,0 +1,203 @@
+/**
+ * \file
+ *
+ * \brief Posts the socket applet's data over CoAP/UDP
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+#include <net/coap.h>
+
+#include "examples/socket/resolver.h"
+#include "examples/socket/transport.h"
+
+namespace NimbeLink::Examples
+{
+    class CoapTransport;
+}
+
+class NimbeLink::Examples::CoapTransport : public Transport
+{
+    private:
+        // The path we post to, one segment per Uri-Path option
+        static constexpr const char *Path[] = {
+            "dweet",
+            "for",
+            "skywire_nano_socket_dial_widget",
+        };
+
+        // The most payload we'll put in a single message, with anything
+        // larger being sent block-wise
+        static constexpr const std::size_t BlockSize = CONFIG_SOCKET_COAP_BLOCK_SIZE;
+
+        static_assert((BlockSize >= 16) && (BlockSize <= 1024) && ((BlockSize & (BlockSize - 1)) == 0),
+            "CoAP block size must be a power of 2 from 16 to 1024");
+
+        // How long to wait for the first acknowledgement, which doubles with
+        // each retransmission, and how many times to retransmit (RFC 7252,
+        // section 4.8)
+        static constexpr const int32_t AckTimeout = 2000;
+        static constexpr const uint8_t MaxRetransmit = 4;
+
+        // What Exchange() gives back for a request the server reset, which
+        // can't be mistaken for a one-byte response code
+        static constexpr const int Reset = 0x100;
+
+        // Our cache of resolved hosts
+        Resolver &resolver;
+
+        // The host and port we send to
+        const char *host;
+        uint16_t port;
+
+        // Our socket's file descriptor, or -1 if we don't have one
+        int socketId = -1;
+
+        // Posts whose response hasn't shown up yet
+        std::size_t awaiting = 0;
+
+        // Our post statistics
+        Stats stats;
+
+    #   if CONFIG_SOCKET_METRICS
+        // Where to record connect and acknowledgement times
+        Metrics *metrics = nullptr;
+    #   endif
+
+        // The buffer messages are built and received in
+        //
+        // The header, token and options take up far less than the extra 64
+        // bytes.
+        uint8_t buffer[BlockSize + 64] = {0};
+
+    private:
+        static constexpr enum coap_block_size GetBlockSize(void)
+        {
+            switch (BlockSize)
+            {
+                case 16:
+                    return COAP_BLOCK_16;
+                case 32:
+                    return COAP_BLOCK_32;
+                case 64:
+                    return COAP_BLOCK_64;
+                case 128:
+                    return COAP_BLOCK_128;
+                case 256:
+                    return COAP_BLOCK_256;
+                case 512:
+                    return COAP_BLOCK_512;
+            }
+
+            return COAP_BLOCK_1024;
+        }
+
+        int Build(struct coap_packet &request, struct coap_block_context *block, const char *data, std::size_t length);
+        int Exchange(struct coap_packet &request);
+        void Count(uint8_t code);
+
+    public:
+        /**
+         * \brief Creates a new CoAP transport
+         *
+         * \param &resolver
+         *      The cache to resolve our host with
+         * \param *host
+         *      The host to post to
+         * \param port
+         *      The port to post to
+         *
+         * \return none
+         */
+        constexpr CoapTransport(Resolver &resolver, const char *host, uint16_t port):
+            resolver(resolver),
+            host(host),
+            port(port) {}
+
+        /**
+         * \brief Gets if we have a socket
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not we have a socket
+         */
+        bool IsOpen(void) const override
+        {
+            return (this->socketId >= 0);
+        }
+
+        /**
+         * \brief Checks whether our socket needs to be opened
+         *
+         *  There's no connection for the peer to close, so once we have a
+         *  socket it stays usable.
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not Open() needs to be called before sending
+         */
+        bool NeedsOpen(void) override
+        {
+            return !this->IsOpen();
+        }
+
+        /**
+         * \brief Gets how many posts are waiting on their responses
+         *
+         * \param none
+         *
+         * \return std::size_t
+         *      The number of posts
+         */
+        std::size_t GetPending(void) const override
+        {
+            return this->awaiting;
+        }
+
+        /**
+         * \brief Gets our post statistics
+         *
+         * \param none
+         *
+         * \return const Stats &
+         *      Our post statistics
+         */
+        const Stats &GetStats(void) const override
+        {
+            return this->stats;
+        }
+
+    #   if CONFIG_SOCKET_METRICS
+        /**
+         * \brief Sets where to record connect and acknowledgement times
+         *
+         * \param *metrics
+         *      Where to record times, or nullptr to stop recording them
+         *
+         * \return none
+         */
+        void SetMetrics(Metrics *metrics) override
+        {
+            this->metrics = metrics;
+        }
+    #   endif
+
+        int Open(void) override;
+        void Close(void) override;
+
+        int Send(const char *data, std::size_t length) override;
+        int Service(int32_t timeout) override;
+};
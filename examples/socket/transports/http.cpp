@@ -0,0 +1,83 @@
+/**
+ * \file
+ *
+ * \brief Posts the socket applet's data over HTTP/TCP
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <array>
+#include <cstddef>
+
+#include <kernel.h>
+#include <net/socket.h>
+
+#include "examples/socket/transports/http.h"
+#include "examples/utils.h"
+
+using namespace NimbeLink::Examples;
+
+/**
+ * \brief Posts data over our connection
+ *
+ *  The request line, data and headers are sent straight from where they live
+ *  rather than being copied into a single buffer first. The response is read
+ *  later by Service().
+ *
+ * \param *data
+ *      The data to post
+ * \param length
+ *      The length of the data
+ *
+ * \return 0
+ *      Success
+ * \return <0
+ *      Error
+ */
+int HttpTransport::Send(const char *data, std::size_t length)
+{
+#   if CONFIG_SOCKET_CBOR
+    // Our body goes behind the headers, which need its length
+    char digits[10];
+    std::size_t start = std::size(digits);
+    std::size_t remaining = length;
+
+    do
+    {
+        digits[--start] = static_cast<char>('0' + (remaining % 10));
+        remaining /= 10;
+    } while ((remaining > 0) && (start > 0));
+
+    // Set up the HTTP request ("POST ... HTTP/1.1\r\n...\r\n\r\n<payload>")
+    const struct iovec request[] = {
+        {const_cast<char *>(HTTP_POST HTTP_CBOR_HEAD), std::size(HTTP_POST HTTP_CBOR_HEAD) - 1},
+        {&digits[start], std::size(digits) - start},
+        {const_cast<char *>(HTTP_HDR_END), std::size(HTTP_HDR_END) - 1},
+        {const_cast<char *>(data), length},
+    };
+
+#   if CONFIG_SOCKET_DEBUG
+    printk("payload: %u bytes of CBOR\n", static_cast<unsigned int>(length));
+#   endif
+#   else
+    // Set up the HTTP request ("POST ...?<payload> HTTP/1.1\r\n...")
+    const struct iovec request[] = {
+        {const_cast<char *>(HTTP_POST "?"), std::size(HTTP_POST "?") - 1},
+        {const_cast<char *>(data), length},
+        {const_cast<char *>(HTTP_HEAD), HTTP_HEAD_LEN},
+    };
+
+#   if CONFIG_SOCKET_DEBUG
+    printk("payload: %s?", HTTP_POST);
+    Utils::Print(std::string_view(data, length));
+    printk("%s", HTTP_HEAD);
+#   endif
+#   endif
+
+    return this->connection.Send(request, std::size(request));
+}
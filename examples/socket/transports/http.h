@@ -0,0 +1,178 @@
+/**
+ * \file
+ *
+ * \brief Posts the socket applet's data over HTTP/TCP
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <kernel.h>
+
+#include "examples/socket/connection.h"
+#include "examples/socket/resolver.h"
+#include "examples/socket/transport.h"
+
+#define HTTP_POST "POST /dweet/for/skywire_nano_socket_dial_widget"
+#define HTTP_HEAD                                                   \
+    " HTTP/1.1\r\n"                                                 \
+    "Host: " CONFIG_SOCKET_HOST "\r\n"                              \
+    "Connection: keep-alive\r\n"                                    \
+    "Content-Length: 0\r\n\r\n"
+#define HTTP_HEAD_LEN (sizeof(HTTP_HEAD) - 1)
+#define HTTP_CBOR_HEAD                                              \
+    " HTTP/1.1\r\n"                                                 \
+    "Host: " CONFIG_SOCKET_HOST "\r\n"                              \
+    "Connection: keep-alive\r\n"                                    \
+    "Content-Type: application/cbor\r\n"                            \
+    "Content-Length: "
+#define HTTP_HDR_END "\r\n\r\n"
+
+namespace NimbeLink::Examples
+{
+    class HttpTransport;
+}
+
+class NimbeLink::Examples::HttpTransport : public Transport
+{
+    private:
+        // Our connection to the server, which is kept open between posts
+        Connection connection;
+
+    public:
+        /**
+         * \brief Creates a new HTTP transport
+         *
+         * \param &resolver
+         *      The cache to resolve our host with
+         * \param *host
+         *      The host to post to
+         * \param port
+         *      The port to post to
+         *
+         * \return none
+         */
+        constexpr HttpTransport(Resolver &resolver, const char *host, uint16_t port):
+            connection(resolver, host, port) {}
+
+        /**
+         * \brief Gets if our connection is open
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not our connection is open
+         */
+        bool IsOpen(void) const override
+        {
+            return this->connection.IsOpen();
+        }
+
+        /**
+         * \brief Checks whether our connection needs to be opened
+         *
+         * \param none
+         *
+         * \return bool
+         *      Whether or not Open() needs to be called before sending
+         */
+        bool NeedsOpen(void) override
+        {
+            return this->connection.NeedsOpen();
+        }
+
+        /**
+         * \brief Opens our connection if it isn't already open
+         *
+         * \param none
+         *
+         * \return 0
+         *      Success
+         * \return <0
+         *      Error
+         */
+        int Open(void) override
+        {
+            return this->connection.Open();
+        }
+
+        /**
+         * \brief Closes our connection
+         *
+         * \param none
+         *
+         * \return none
+         */
+        void Close(void) override
+        {
+            this->connection.Close();
+        }
+
+        /**
+         * \brief Reads any responses that have arrived
+         *
+         * \param timeout
+         *      How long to wait for outstanding responses, in milliseconds
+         *
+         * \return 0
+         *      The connection can still be used
+         * \return -1
+         *      The connection was closed
+         */
+        int Service(int32_t timeout) override
+        {
+            return this->connection.Service(timeout);
+        }
+
+        /**
+         * \brief Gets how many posts are waiting on their responses
+         *
+         * \param none
+         *
+         * \return std::size_t
+         *      The number of posts
+         */
+        std::size_t GetPending(void) const override
+        {
+            return this->connection.GetPending();
+        }
+
+        /**
+         * \brief Gets our post statistics
+         *
+         * \param none
+         *
+         * \return const Stats &
+         *      Our post statistics
+         */
+        const Stats &GetStats(void) const override
+        {
+            return this->connection.GetStats();
+        }
+
+    #   if CONFIG_SOCKET_METRICS
+        /**
+         * \brief Sets where to record connect and response times
+         *
+         * \param *metrics
+         *      Where to record times, or nullptr to stop recording them
+         *
+         * \return none
+         */
+        void SetMetrics(Metrics *metrics) override
+        {
+            this->connection.SetMetrics(metrics);
+        }
+    #   endif
+
+        int Send(const char *data, std::size_t length) override;
+};
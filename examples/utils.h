@@ -13,8 +13,12 @@
  */
 #pragma once
 
+#include <atomic>
+#include <charconv>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <type_traits>
 
 #include "nimbelink/sdk/secure_services/at.h"
 
@@ -57,4 +61,730 @@ namespace NimbeLink::Examples::Utils
                 break;
         }
     }
+
+    /**
+     * \brief Prints text that isn't null-terminated
+     *
+     *  Zephyr's printk() doesn't support a precision, so "%.*s" can't be used
+     *  for this.
+     *
+     * \param text
+     *      The text to print
+     *
+     * \return none
+     */
+    static inline void Print(std::string_view text)
+    {
+        char chunk[32];
+
+        while (!text.empty())
+        {
+            std::size_t count = text.copy(chunk, sizeof(chunk) - 1);
+
+            chunk[count] = '\0';
+
+            printk("%s", chunk);
+
+            text.remove_prefix(count);
+        }
+    }
+
+    // Shares a small struct from one writer thread with any number of readers
+    //
+    // Two copies of the struct are kept. The writer fills in whichever copy
+    // isn't current and then publishes it by bumping the sequence, so readers
+    // always copy a whole struct from a single write and never wait on the
+    // writer. A reader only has to try again if the writer managed to get
+    // back around to the copy it was reading, which takes two writes landing
+    // during a single read.
+    template <typename T>
+    class SeqLock
+    {
+        private:
+            // Even when the writer is idle, odd while it's writing, and the
+            // current copy is the one picked by the number of writes done
+            std::atomic<uint32_t> sequence = 0;
+
+            T copies[2];
+
+            static_assert(std::atomic<uint32_t>::is_always_lock_free, "Atomic variable sequence isn't lock-free!");
+            static_assert(std::is_trivially_copyable_v<T>, "SeqLock data has to be trivially copyable");
+
+        public:
+            /**
+             * \brief Creates a new sequence lock, with zeroed data
+             *
+             *  This doesn't need a zeroed copy of a large struct to start
+             *  from.
+             *
+             * \param none
+             *
+             * \return none
+             */
+            constexpr SeqLock(void):
+                copies{} {}
+
+            /**
+             * \brief Creates a new sequence lock
+             *
+             * \param &initial
+             *      What readers see before the first write
+             *
+             * \return none
+             */
+            constexpr SeqLock(const T &initial):
+                copies{initial, initial} {}
+
+            /**
+             * \brief Gets a snapshot of the data
+             *
+             * \param none
+             *
+             * \return T
+             *      The data from the latest finished write
+             */
+            T Read(void) const
+            {
+                while (true)
+                {
+                    uint32_t before = this->sequence.load(std::memory_order_acquire);
+
+                    T value = this->copies[(before >> 1) & 1];
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    // The writer starts overwriting the copy we read once
+                    // it's finished the write after the one in progress
+                    if ((this->sequence.load(std::memory_order_relaxed) - (before & ~1U)) < 3)
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            /**
+             * \brief Reads part of the data in place
+             *
+             *  This saves copying all of a large struct to get at part of it.
+             *  The reader is called on the current copy, and again if the
+             *  writer got around to overwriting it while it was reading. A
+             *  reader can be handed a copy that's partly overwritten, and
+             *  while what it returns then is thrown away, it mustn't trust
+             *  anything it reads, such as an index, to stay in bounds.
+             *
+             * \param reader
+             *      What reads the data and returns what it wants from it
+             *
+             * \return auto
+             *      What the reader returned for the latest finished write
+             */
+            template <typename Reader>
+            auto Read(Reader reader) const
+            {
+                while (true)
+                {
+                    uint32_t before = this->sequence.load(std::memory_order_acquire);
+
+                    auto value = reader(this->copies[(before >> 1) & 1]);
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+
+                    if ((this->sequence.load(std::memory_order_relaxed) - (before & ~1U)) < 3)
+                    {
+                        return value;
+                    }
+                }
+            }
+
+            /**
+             * \brief Publishes new data
+             *
+             * Only one thread may write.
+             *
+             * \param &value
+             *      The new data
+             *
+             * \return none
+             */
+            void Write(const T &value)
+            {
+                uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+
+                this->sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                this->copies[((sequence >> 1) + 1) & 1] = value;
+
+                this->sequence.store(sequence + 2, std::memory_order_release);
+            }
+
+            /**
+             * \brief Publishes a change to the data
+             *
+             *  The change is made to a copy of the current data, so a writer
+             *  that only changes part of a large struct doesn't need to keep
+             *  its own copy of the rest.
+             *
+             *  Only one thread may write.
+             *
+             * \param updater
+             *      What changes the data, which it's given to change in place
+             *
+             * \return none
+             */
+            template <typename Updater>
+            void Update(Updater updater)
+            {
+                uint32_t sequence = this->sequence.load(std::memory_order_relaxed);
+
+                this->sequence.store(sequence + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                T &next = this->copies[((sequence >> 1) + 1) & 1];
+
+                next = this->copies[(sequence >> 1) & 1];
+
+                updater(next);
+
+                this->sequence.store(sequence + 2, std::memory_order_release);
+            }
+    };
+
+    // Parses AT responses in place, without modifying or copying them
+    //
+    // A response's format is described by a prefix and the fields wanted from
+    // the line that starts with it, such as the RSRP in
+    // "+CESQ: 99,99,255,255,19,52". Fields are separated by commas, and
+    // commas inside quotes don't count.
+    namespace At
+    {
+        /**
+         * \brief Describes a field of an AT response
+         */
+        struct Field
+        {
+            enum class Type
+            {
+                // A decimal number
+                Integer,
+
+                // A number written in hex, usually quoted
+                Hex,
+
+                // Text, with any quotes removed
+                String,
+            };
+
+            // Which field of the line this is, starting at 0
+            uint8_t index;
+
+            Type type;
+        };
+
+        /**
+         * \brief Describes the fields wanted from a type of AT response
+         */
+        template <std::size_t Count>
+        struct Format
+        {
+            std::string_view prefix;
+            Field fields[Count];
+        };
+
+        /**
+         * \brief A field parsed from an AT response
+         *
+         *  The text points into the response, so it's only good for as long
+         *  as the response is.
+         */
+        struct Value
+        {
+            std::string_view text;
+            int32_t integer;
+        };
+
+        // +CESQ: <rxlev>,<ber>,<rscp>,<ecno>,<rsrq>,<rsrp>
+        static constexpr const Format<2> Cesq = {
+            "+CESQ:",
+            {
+                {5, Field::Type::Integer},
+                {4, Field::Type::Integer},
+            },
+        };
+
+        // %CESQ: <rsrp>,<rsrp_threshold_index>,<rsrq>,<rsrq_threshold_index>,
+        // as a notification
+        static constexpr const Format<2> CesqNotification = {
+            "%CESQ:",
+            {
+                {0, Field::Type::Integer},
+                {2, Field::Type::Integer},
+            },
+        };
+
+        // +COPS: <mode>,<format>,<oper>[,<AcT>]
+        static constexpr const Format<1> Cops = {
+            "+COPS:",
+            {
+                {2, Field::Type::String},
+            },
+        };
+
+        // +CEREG: <stat>[,<tac>,<ci>,<AcT>], as a notification
+        static constexpr const Format<1> Cereg = {
+            "+CEREG:",
+            {
+                {0, Field::Type::Integer},
+            },
+        };
+
+        // +CEREG: <n>,<stat>[,<tac>,<ci>,<AcT>], as a response to a query
+        static constexpr const Format<1> CeregQuery = {
+            "+CEREG:",
+            {
+                {1, Field::Type::Integer},
+            },
+        };
+
+        // %XMONITOR: <reg_status>[,<full_name>,<short_name>,<plmn>,<tac>,
+        // <AcT>,<band>,<cell_id>,<phys_cell_id>,<EARFCN>,<rsrp>,<snr>,...]
+        static constexpr const Format<8> Xmonitor = {
+            "%XMONITOR:",
+            {
+                {0, Field::Type::Integer},
+                {3, Field::Type::String},
+                {4, Field::Type::Hex},
+                {6, Field::Type::Integer},
+                {7, Field::Type::Hex},
+                {9, Field::Type::Integer},
+                {10, Field::Type::Integer},
+                {11, Field::Type::Integer},
+            },
+        };
+
+        // %NCELLMEAS: <status>[,<cell_id>,<plmn>,<tac>,<timing_advance>,
+        // <earfcn>,<phys_cell_id>,<rsrp>,<rsrq>,<measurement_time>,
+        // [<n_earfcn>,<n_phys_cell_id>,<n_rsrp>,<n_rsrq>,<time_diff>,]...],
+        // which has a group of fields for each neighbor cell and is read
+        // with a FieldReader
+        static constexpr const std::string_view Ncellmeas = "%NCELLMEAS:";
+
+        /**
+         * \brief Removes spaces from both ends of some text
+         *
+         * \param text
+         *      The text to trim
+         *
+         * \return std::string_view
+         *      The trimmed text
+         */
+        static constexpr std::string_view Trim(std::string_view text)
+        {
+            while (!text.empty() && (text.front() == ' '))
+            {
+                text.remove_prefix(1);
+            }
+
+            while (!text.empty() && (text.back() == ' '))
+            {
+                text.remove_suffix(1);
+            }
+
+            return text;
+        }
+
+        /**
+         * \brief Finds the end of a line
+         *
+         *  This is a plain loop rather than std::string_view::find_first_of(),
+         *  which searches the set of characters for every character of the
+         *  text and is several times slower.
+         *
+         * \param text
+         *      The text to search
+         *
+         * \return std::size_t
+         *      Where the first carriage return or line feed is, or
+         *      std::string_view::npos if there isn't one
+         */
+        static constexpr std::size_t FindLineEnd(std::string_view text)
+        {
+            for (std::size_t i = 0; i < std::size(text); i++)
+            {
+                if ((text[i] == '\r') || (text[i] == '\n'))
+                {
+                    return i;
+                }
+            }
+
+            return std::string_view::npos;
+        }
+
+        /**
+         * \brief Finds the line of a response that starts with a prefix
+         *
+         *  Responses to concatenated commands have a line for each command's
+         *  part of the response.
+         *
+         * \param response
+         *      The response to search
+         * \param prefix
+         *      What the line starts with
+         * \param &line
+         *      The rest of the line after the prefix
+         *
+         * \return bool
+         *      Whether or not the line was found
+         */
+        static constexpr bool FindLine(std::string_view response, std::string_view prefix, std::string_view &line)
+        {
+            while (!response.empty())
+            {
+                std::size_t end = FindLineEnd(response);
+
+                std::string_view current = response.substr(0, end);
+
+                if (current.substr(0, std::size(prefix)) == prefix)
+                {
+                    line = current.substr(std::size(prefix));
+
+                    return true;
+                }
+
+                if (end == std::string_view::npos)
+                {
+                    break;
+                }
+
+                response.remove_prefix(end + 1);
+            }
+
+            return false;
+        }
+
+        /**
+         * \brief Gets a field from a line of a response
+         *
+         * \param line
+         *      The line, without its prefix
+         * \param index
+         *      Which field to get, starting at 0
+         * \param &field
+         *      The field, trimmed and without quotes
+         *
+         * \return bool
+         *      Whether or not the line has the field
+         */
+        static constexpr bool GetField(std::string_view line, std::size_t index, std::string_view &field)
+        {
+            std::size_t start = 0;
+            bool quoted = false;
+
+            for (std::size_t i = 0; i <= std::size(line); i++)
+            {
+                if ((i < std::size(line)) && (line[i] == '"'))
+                {
+                    quoted = !quoted;
+                }
+
+                if ((i < std::size(line)) && (quoted || (line[i] != ',')))
+                {
+                    continue;
+                }
+
+                if (index-- == 0)
+                {
+                    field = Trim(line.substr(start, i - start));
+
+                    if ((std::size(field) >= 2) && (field.front() == '"') && (field.back() == '"'))
+                    {
+                        field = field.substr(1, std::size(field) - 2);
+                    }
+
+                    return true;
+                }
+
+                start = i + 1;
+            }
+
+            return false;
+        }
+
+        /**
+         * \brief Converts text to a number, with bounds checking
+         *
+         * \param text
+         *      The text to convert
+         * \param &value
+         *      The number
+         * \param base
+         *      The base the number is written in
+         *
+         * \return bool
+         *      Whether or not the text was entirely a number that fits
+         */
+        static inline bool ToInteger(std::string_view text, int32_t &value, int base = 10)
+        {
+            text = Trim(text);
+
+            const char *end = std::data(text) + std::size(text);
+
+            std::from_chars_result result = std::from_chars(std::data(text), end, value, base);
+
+            return (!text.empty() && (result.ec == std::errc()) && (result.ptr == end));
+        }
+
+        /**
+         * \brief Parses fields from a response
+         *
+         *  Fields are parsed in the order the format lists them, stopping at
+         *  the first one that's missing or isn't a valid number, which lets
+         *  shorter forms of a response be handled.
+         *
+         * \param response
+         *      The response, which can have more than one line
+         * \param &format
+         *      The format of the line to parse
+         * \param &values
+         *      The parsed fields
+         *
+         * \return -1
+         *      The response doesn't have a line with the format's prefix
+         * \return >=0
+         *      The number of fields parsed
+         */
+        template <std::size_t Count>
+        static inline int Parse(std::string_view response, const Format<Count> &format, Value (&values)[Count])
+        {
+            std::string_view line;
+
+            if (!FindLine(response, format.prefix, line))
+            {
+                return -1;
+            }
+
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                const Field &field = format.fields[i];
+                Value &value = values[i];
+
+                value = {{}, 0};
+
+                if (!GetField(line, field.index, value.text))
+                {
+                    return static_cast<int>(i);
+                }
+
+                if ((field.type == Field::Type::Integer) && !ToInteger(value.text, value.integer))
+                {
+                    return static_cast<int>(i);
+                }
+
+                if ((field.type == Field::Type::Hex) && !ToInteger(value.text, value.integer, 16))
+                {
+                    return static_cast<int>(i);
+                }
+            }
+
+            return static_cast<int>(Count);
+        }
+
+        // Walks the fields of a line one at a time
+        //
+        // Each field is found by picking up where the last one ended, so
+        // long lines with a repeating group of fields, such as the neighbor
+        // cells in %NCELLMEAS, are parsed in a single pass without needing
+        // room for every field at once.
+        class FieldReader
+        {
+            private:
+                std::string_view line;
+                bool done;
+
+            public:
+                /**
+                 * \brief Creates a new field reader
+                 *
+                 * \param line
+                 *      The line, without its prefix
+                 *
+                 * \return none
+                 */
+                constexpr FieldReader(std::string_view line):
+                    line(line),
+                    done(false) {}
+
+                /**
+                 * \brief Gets the next field
+                 *
+                 * \param &field
+                 *      The field, trimmed and without quotes
+                 *
+                 * \return bool
+                 *      Whether or not there was another field
+                 */
+                constexpr bool Next(std::string_view &field)
+                {
+                    if (this->done)
+                    {
+                        return false;
+                    }
+
+                    bool quoted = false;
+                    std::size_t end = 0;
+
+                    while ((end < std::size(this->line)) && (quoted || (this->line[end] != ',')))
+                    {
+                        if (this->line[end] == '"')
+                        {
+                            quoted = !quoted;
+                        }
+
+                        end++;
+                    }
+
+                    field = Trim(this->line.substr(0, end));
+
+                    if ((std::size(field) >= 2) && (field.front() == '"') && (field.back() == '"'))
+                    {
+                        field = field.substr(1, std::size(field) - 2);
+                    }
+
+                    if (end < std::size(this->line))
+                    {
+                        this->line.remove_prefix(end + 1);
+                    }
+                    else
+                    {
+                        this->done = true;
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * \brief Gets the next field as a number
+                 *
+                 * \param &value
+                 *      The number
+                 * \param base
+                 *      The base the number is written in
+                 *
+                 * \return bool
+                 *      Whether or not there was another field and it was a
+                 *      valid number
+                 */
+                bool NextInteger(int32_t &value, int base = 10)
+                {
+                    std::string_view field;
+
+                    return (this->Next(field) && ToInteger(field, value, base));
+                }
+        };
+
+        // Splits a response that arrives in pieces into lines
+        //
+        // Lines that are entirely within one piece are handed out in place,
+        // and only a line that's split between pieces is copied, so the
+        // buffer only needs to fit the longest line. Anything past that is
+        // dropped and the line is marked as truncated.
+        template <std::size_t Size>
+        class LineReader
+        {
+            private:
+                char line[Size] = {0};
+                std::size_t length = 0;
+                bool truncated = false;
+
+            private:
+                /**
+                 * \brief Adds part of a line to our buffer
+                 *
+                 * \param part
+                 *      The part of the line
+                 *
+                 * \return none
+                 */
+                void Append(std::string_view part)
+                {
+                    std::size_t count = std::size(part);
+
+                    if (count > (Size - this->length))
+                    {
+                        count = Size - this->length;
+
+                        this->truncated = true;
+                    }
+
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        this->line[this->length++] = part[i];
+                    }
+                }
+
+            public:
+                /**
+                 * \brief Reads the next piece of a response
+                 *
+                 * \param piece
+                 *      The piece of the response
+                 * \param &&handler
+                 *      What to call with each complete, non-empty line and
+                 *      whether it was truncated
+                 *
+                 * \return none
+                 */
+                template <typename Handler>
+                void Feed(std::string_view piece, Handler &&handler)
+                {
+                    while (!piece.empty())
+                    {
+                        std::size_t end = FindLineEnd(piece);
+
+                        if (end == std::string_view::npos)
+                        {
+                            this->Append(piece);
+
+                            return;
+                        }
+
+                        if ((this->length > 0) || this->truncated)
+                        {
+                            this->Append(piece.substr(0, end));
+
+                            handler(std::string_view(this->line, this->length), this->truncated);
+
+                            this->length = 0;
+                            this->truncated = false;
+                        }
+                        else if (end > 0)
+                        {
+                            handler(piece.substr(0, end), false);
+                        }
+
+                        piece.remove_prefix(end + 1);
+                    }
+                }
+
+                /**
+                 * \brief Hands out whatever's left after the last line break
+                 *
+                 * \param &&handler
+                 *      What to call with the last line, if there is one
+                 *
+                 * \return none
+                 */
+                template <typename Handler>
+                void Finish(Handler &&handler)
+                {
+                    if ((this->length > 0) || this->truncated)
+                    {
+                        handler(std::string_view(this->line, this->length), this->truncated);
+                    }
+
+                    this->length = 0;
+                    this->truncated = false;
+                }
+        };
+    }
 }
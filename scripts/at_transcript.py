@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+###
+ # \file
+ #
+ # \brief Builds an AT replay transcript from a recorded console log
+ #
+ # Reads a console log captured with CONFIG_AT_BACKEND_RECORD from a file (or
+ # stdin), picks out its "@AT" lines and writes a header that
+ # CONFIG_AT_BACKEND_REPLAY can build in. Anything else in the log is skipped.
+ #
+ # (C) NimbeLink Corp. 2020
+ #
+ # All rights reserved except as explicitly granted in the license agreement
+ # between NimbeLink Corp. and the designated licensee.  No other use or
+ # disclosure of this software is permitted. Portions of this software may be
+ # subject to third party license terms as specified in this software, and such
+ # portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ ##
+
+import argparse
+import re
+import sys
+
+QUOTED = r'"((?:[^"\\]|\\.)*)"'
+
+LINE = re.compile(r'@AT (\d+) (-?\d+) (-?\d+) (-?\d+) ' + QUOTED + ' ' + QUOTED)
+
+ESCAPE = re.compile(r'\\(x[0-9a-fA-F]{2}|.)')
+
+def unescape(text):
+    def replace(match):
+        escape = match.group(1)
+
+        if escape == "r":
+            return "\r"
+
+        if escape == "n":
+            return "\n"
+
+        if escape.startswith("x"):
+            return chr(int(escape[1:], 16))
+
+        return escape
+
+    return ESCAPE.sub(replace, text)
+
+def quote(text):
+    # Octal escapes always take three digits, so nothing that follows one
+    # can be mistaken for part of it
+    escaped = ""
+
+    for c in text:
+        if c == "\r":
+            escaped += "\\r"
+        elif c == "\n":
+            escaped += "\\n"
+        elif c in "\"\\":
+            escaped += "\\" + c
+        elif (c < " ") or (c > "~"):
+            escaped += "\\{:03o}".format(ord(c))
+        else:
+            escaped += c
+
+    return "\"" + escaped + "\""
+
+def main():
+    parser = argparse.ArgumentParser(description="Builds an AT replay transcript from a recorded console log")
+    parser.add_argument("input", nargs="?", help="The console log (default: stdin)")
+    parser.add_argument("-o", "--output", help="The header to write (default: stdout)")
+
+    args = parser.parse_args()
+
+    if args.input is None:
+        lines = sys.stdin.read().splitlines()
+    else:
+        with open(args.input, "r", errors="replace") as file:
+            lines = file.read().splitlines()
+
+    exchanges = []
+
+    for line in lines:
+        match = LINE.search(line)
+
+        if match is None:
+            continue
+
+        latency, ret, result, error, command, response = match.groups()
+
+        exchanges.append("    {{{}, {}, {}, {}, {}, {}}},".format(
+            quote(unescape(command)),
+            ret,
+            result,
+            error,
+            latency,
+            quote(unescape(response))
+        ))
+
+    if not exchanges:
+        sys.exit("No @AT lines found")
+
+    header = "\n".join([
+        "// Generated by scripts/at_transcript.py, do not edit",
+        "#pragma once",
+        "",
+        "#include \"examples/at/replay.h\"",
+        "",
+        "namespace NimbeLink::Examples::AtTranscript",
+        "{",
+        "    static constexpr const AtReplay::Exchange Exchanges[] = {",
+    ] + ["    " + exchange for exchange in exchanges] + [
+        "    };",
+        "}",
+        "",
+    ])
+
+    if args.output is None:
+        sys.stdout.write(header)
+    else:
+        with open(args.output, "w") as file:
+            file.write(header)
+
+if __name__ == "__main__":
+    main()
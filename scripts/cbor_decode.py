@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+###
+ # \file
+ #
+ # \brief Decodes the CBOR bodies posted by the socket widget
+ #
+ # Reads a body from a file (or stdin) as raw bytes, or as hex with --hex, and
+ # prints it as JSON. Only the CBOR the widget produces is supported: maps,
+ # arrays, integers, and byte and text strings, with definite or indefinite
+ # lengths.
+ #
+ # (C) NimbeLink Corp. 2020
+ #
+ # All rights reserved except as explicitly granted in the license agreement
+ # between NimbeLink Corp. and the designated licensee.  No other use or
+ # disclosure of this software is permitted. Portions of this software may be
+ # subject to third party license terms as specified in this software, and such
+ # portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ ##
+
+import argparse
+import json
+import sys
+
+class Break:
+    pass
+
+class Decoder:
+    def __init__(self, data):
+        self.data = data
+        self.offset = 0
+
+    def _take(self, count):
+        if self.offset + count > len(self.data):
+            raise ValueError("Truncated CBOR at offset {}".format(self.offset))
+
+        chunk = self.data[self.offset:self.offset + count]
+        self.offset += count
+
+        return chunk
+
+    def _argument(self, info):
+        if info < 24:
+            return info
+
+        if info in (24, 25, 26, 27):
+            return int.from_bytes(self._take(1 << (info - 24)), "big")
+
+        if info == 31:
+            return None
+
+        raise ValueError("Invalid additional info {}".format(info))
+
+    def _items(self, length):
+        if length is not None:
+            for _ in range(length):
+                yield self.decode()
+
+            return
+
+        while True:
+            item = self.decode()
+
+            if isinstance(item, Break):
+                return
+
+            yield item
+
+    def _chunks(self, majorType):
+        chunks = []
+
+        while True:
+            initial = self._take(1)[0]
+
+            if initial == 0xFF:
+                return b"".join(chunks)
+
+            # Each chunk is a definite length string of the same type
+            length = self._argument(initial & 0x1F)
+
+            if ((initial >> 5) != majorType) or (length is None):
+                raise ValueError("Invalid string chunk at offset {}".format(self.offset - 1))
+
+            chunks.append(self._take(length))
+
+    def decode(self):
+        initial = self._take(1)[0]
+
+        majorType = initial >> 5
+        info = initial & 0x1F
+
+        if initial == 0xFF:
+            return Break()
+
+        length = self._argument(info)
+
+        if majorType == 0:
+            return length
+
+        if majorType == 1:
+            return -1 - length
+
+        if majorType in (2, 3):
+            value = self._take(length) if length is not None else self._chunks(majorType)
+
+            return value.hex() if majorType == 2 else value.decode("utf-8")
+
+        if majorType == 4:
+            return list(self._items(length))
+
+        if majorType == 5:
+            items = self._items(None if length is None else length * 2)
+
+            return {key: value for key, value in zip(items, items)}
+
+        raise ValueError("Unsupported major type {}".format(majorType))
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes a CBOR body posted by the socket widget")
+    parser.add_argument("input", nargs="?", help="The file to decode (default: stdin)")
+    parser.add_argument("--hex", action="store_true", help="The input is hex text")
+
+    args = parser.parse_args()
+
+    if args.input is None:
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, "rb") as file:
+            data = file.read()
+
+    if args.hex:
+        data = bytes.fromhex(data.decode("ascii"))
+
+    decoder = Decoder(data)
+
+    while decoder.offset < len(data):
+        print(json.dumps(decoder.decode(), indent=4))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+###
+ # \file
+ #
+ # \brief A stand-in for dweet.io that the socket widget can post to
+ #
+ # Answers the widget's HTTP/1.1 posts over keep-alive connections, with
+ # optional added latency and loss, and prints how long each request was and
+ # how long it was held. Pointing CONFIG_SOCKET_HOST and CONFIG_SOCKET_PORT at
+ # this with CONFIG_SOCKET_METRICS enabled shows how the widget copes with a
+ # slow or lossy network.
+ #
+ # (C) NimbeLink Corp. 2020
+ #
+ # All rights reserved except as explicitly granted in the license agreement
+ # between NimbeLink Corp. and the designated licensee.  No other use or
+ # disclosure of this software is permitted. Portions of this software may be
+ # subject to third party license terms as specified in this software, and such
+ # portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ ##
+
+import argparse
+import random
+import threading
+import time
+
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+class Totals:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.dropped = 0
+        self.failed = 0
+        self.bytes = 0
+
+    def add(self, length, dropped=False, failed=False):
+        with self.lock:
+            self.requests += 1
+            self.dropped += int(dropped)
+            self.failed += int(failed)
+            self.bytes += length
+
+    def __str__(self):
+        with self.lock:
+            return "{} requests, {} dropped, {} failed, {} bytes".format(self.requests, self.dropped, self.failed, self.bytes)
+
+def makeHandler(args, totals):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            body = self.rfile.read(length)
+
+            # The request line and headers have already been read, so count
+            # them from what was parsed
+            size = len(self.requestline) + 2 + len(str(self.headers)) + 2 + len(body)
+
+            delay = max(0.0, random.gauss(args.latency, args.jitter)) / 1000
+
+            time.sleep(delay)
+
+            if random.random() < args.loss:
+                totals.add(size, dropped=True)
+
+                print("{} bytes, dropped".format(size))
+
+                self.close_connection = True
+
+                return
+
+            failed = random.random() < args.fail
+
+            totals.add(size, failed=failed)
+
+            print("{} bytes, held {:.0f} ms{}".format(size, delay * 1000, ", failed" if failed else ""))
+
+            response = b'{"this":"succeeded"}' if not failed else b'{"this":"failed"}'
+
+            self.send_response(500 if failed else 200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(response)))
+            self.end_headers()
+            self.wfile.write(response)
+
+        def log_message(self, format, *args):
+            pass
+
+    return Handler
+
+def main():
+    parser = argparse.ArgumentParser(description="Stands in for dweet.io for the socket widget")
+    parser.add_argument("--host", default="0.0.0.0", help="The address to listen on")
+    parser.add_argument("--port", type=int, default=80, help="The port to listen on")
+    parser.add_argument("--latency", type=float, default=0, help="Milliseconds to hold each request for")
+    parser.add_argument("--jitter", type=float, default=0, help="Standard deviation of the latency, in milliseconds")
+    parser.add_argument("--loss", type=float, default=0, help="Chance of closing the connection instead of responding")
+    parser.add_argument("--fail", type=float, default=0, help="Chance of responding with an error")
+    parser.add_argument("--seed", type=int, help="Seed for repeatable loss and latency")
+
+    args = parser.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    totals = Totals()
+
+    server = ThreadingHTTPServer((args.host, args.port), makeHandler(args, totals))
+
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+    print(totals)
+
+if __name__ == "__main__":
+    main()
@@ -18,6 +18,14 @@
 
 #include <zephyr.h>
 
+#if CONFIG_ASYNC_CONSOLE
+#include "examples/console/console.h"
+#endif
+
+#if CONFIG_AT_SERVICE
+#include "examples/at/at_service.h"
+#endif
+
 #if CONFIG_WIDGET_BLINKY_EXAMPLE
 #include "examples/blinky/blinky.h"
 #endif
@@ -58,6 +66,14 @@ using namespace NimbeLink::Sdk;
 
 void main(void)
 {
+#   if CONFIG_ASYNC_CONSOLE
+    static AsyncConsole console;
+#   endif
+
+#   if CONFIG_AT_SERVICE
+    static AtService at;
+#   endif
+
 #   if CONFIG_CELL_CAGE_SIM || CONFIG_WIDGET_SOCKET_EXAMPLE
     // allow the modem to boot up properly before trying to change the sim
     k_sleep(K_SECONDS(20));
@@ -70,19 +86,13 @@ void main(void)
 
     for (std::size_t i = 0; i < std::size(commands); i++)
     {
-
-        char resp[100];
-        SecureServices::At::Result result;
-        SecureServices::At::Error error;
-        int32_t ret = SecureServices::At::RunCommand(&result, &error, std::data(commands[i]), std::size(commands[i]), resp, 100, nullptr);
-
-        if (ret == 0)
-        {
-            if (result != 0)
+        // These have to happen before anything else talks to the modem
+        at.Execute(commands[i], [&](const AtService::Response &response) {
+            if (response.ret == 0)
             {
-                Utils::PrintError(commands[i], result, error);
+                Utils::PrintError(commands[i], response.result, response.error);
             }
-        }
+        }, AtService::Priority::High);
     }
 #   endif
 
@@ -100,11 +110,14 @@ void main(void)
 #   endif
 
 #   if CONFIG_WIDGET_CELL_EXAMPLE
-    static NimbeLink::Examples::Cell cell;
+    static NimbeLink::Examples::Cell cell(at);
 #   endif
 
 #   if CONFIG_WIDGET_DASHBOARD_EXAMPLE
     static Dashboard dashboard(CONFIG_DASHBOARD_X, CONFIG_DASHBOARD_Y, CONFIG_DASHBOARD_W, CONFIG_DASHBOARD_H);
+#   if CONFIG_ASYNC_CONSOLE
+    dashboard.SetConsole(console);
+#   endif
 #   if CONFIG_WIDGET_ACCEL_EXAMPLE
     dashboard.RegisterElement(accel);
 #   endif
@@ -118,7 +131,7 @@ void main(void)
 #   endif
 
 #   if CONFIG_WIDGET_SOCKET_EXAMPLE
-    static Socket socket;
+    static Socket socket(at);
 #   if CONFIG_WIDGET_CELL_EXAMPLE
     static CellPoster poster(cell);
     socket.RegisterData(poster);
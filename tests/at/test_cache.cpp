@@ -0,0 +1,220 @@
+/**
+ * \file
+ *
+ * \brief Tests the AT service's response cache against a scripted modem
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    static constexpr const char Searching[] = "+CEREG: 1,2,\"0A0B\",\"01234567\",7";
+    static constexpr const char Registered[] = "+CEREG: 1,1,\"0A0B\",\"01234567\",7";
+
+    /**
+     * \brief Makes a new AT service in front of a freshly scripted modem
+     *
+     *  Its thread never stops, so it's never destroyed. Notifications are
+     *  set up before its first command runs, so once that's answered, the
+     *  service knows whether or not they're coming.
+     *
+     * \param notifications
+     *      Whether or not the modem can send notifications
+     *
+     * \return AtService &
+     *      The AT service
+     */
+    AtService &Start(bool notifications)
+    {
+        Modem::Reset();
+        Modem::SetNotifications(notifications);
+
+        Modem::Answer("AT+CEREG=0", "");
+        Modem::Answer("AT+CEREG=1", "");
+        Modem::Answer("AT+CEREG?", Searching);
+        Modem::Answer("AT+COPS?", "+COPS: 0");
+        Modem::Answer("AT+CFUN?", "+CFUN: 1");
+
+        AtService &service = *new AtService();
+
+        service.Execute("AT+CFUN?", [](const AtService::Response &response) {
+            (void)response;
+        });
+
+        return service;
+    }
+
+    /**
+     * \brief Runs a command and gets its response
+     *
+     * \param &service
+     *      The AT service to run it through
+     * \param command
+     *      The command
+     * \param fresh
+     *      Whether or not the modem has to be asked
+     *
+     * \return std::string
+     *      The response, which is empty if the command failed
+     */
+    std::string Ask(AtService &service, std::string_view command, bool fresh = false)
+    {
+        std::string text;
+
+        service.Execute(command, [&text](const AtService::Response &response) {
+            if (response.Succeeded())
+            {
+                text = response.text;
+            }
+        }, AtService::Priority::Normal, fresh);
+
+        return text;
+    }
+}
+
+/**
+ * \brief Checks that only queries we'd hear about changes to are cached
+ *        before registration notifications are on
+ */
+static void TestUnwatched(void)
+{
+    AtService &service = Start(true);
+
+    // The first AT+CFUN? was kept
+    Ask(service, "AT+CFUN?");
+
+    TEST_CHECK(Modem::GetRuns("AT+CFUN?") == 1);
+
+    // Nobody's turned on +CEREG notifications, so a change in registration
+    // wouldn't throw these out
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+
+    Modem::Answer("AT+CEREG?", Registered);
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 2);
+
+    Ask(service, "AT+COPS?");
+    Ask(service, "AT+COPS?");
+
+    TEST_CHECK(Modem::GetRuns("AT+COPS?") == 2);
+}
+
+/**
+ * \brief Checks that registration queries are cached while notifications
+ *        are on, and thrown out when one comes in
+ */
+static void TestWatched(void)
+{
+    AtService &service = Start(true);
+
+    TEST_CHECK(Ask(service, "AT+CEREG=1") == "");
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+
+    Modem::Answer("AT+CEREG?", Registered);
+
+    // Nothing's said it changed
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 1);
+
+    Modem::Notify("+CEREG: 1,\"0A0B\",\"01234567\",7");
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 2);
+
+    // Turning the notifications off stops the caching
+    Ask(service, "AT+CEREG=0");
+
+    Modem::Answer("AT+CEREG?", Searching);
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+
+    Modem::Answer("AT+CEREG?", Registered);
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 4);
+
+    AtService::CacheStats stats = service.GetCacheStats();
+
+    TEST_CHECK(stats.invalidations >= 2);
+}
+
+/**
+ * \brief Checks that turning on registration notifications doesn't count if
+ *        they can't reach us
+ */
+static void TestNotNotified(void)
+{
+    AtService &service = Start(false);
+
+    // The modem will send them, but nothing's listening
+    TEST_CHECK(Ask(service, "AT+CEREG=1") == "");
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+
+    Modem::Answer("AT+CEREG?", Registered);
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 2);
+
+    // Anything nothing would throw out is still kept, though setting
+    // AT+CEREG threw out what was there before
+    Ask(service, "AT+CFUN?");
+    Ask(service, "AT+CFUN?");
+
+    TEST_CHECK(Modem::GetRuns("AT+CFUN?") == 2);
+}
+
+/**
+ * \brief Checks that a caller can go around the cache
+ */
+static void TestFresh(void)
+{
+    AtService &service = Start(true);
+
+    Ask(service, "AT+CEREG=1");
+    Ask(service, "AT+CEREG?");
+
+    Modem::Answer("AT+CEREG?", Registered);
+
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Searching);
+    TEST_CHECK(Ask(service, "AT+CEREG?", true) == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 2);
+
+    // What the modem said is kept for everyone else
+    TEST_CHECK(Ask(service, "AT+CEREG?") == Registered);
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 2);
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Unwatched", TestUnwatched);
+    Run("Watched", TestWatched);
+    Run("NotNotified", TestNotNotified);
+    Run("Fresh", TestFresh);
+
+    Finish();
+}
@@ -0,0 +1,177 @@
+/**
+ * \file
+ *
+ * \brief Tests the AT service answering from a recorded transcript
+ *
+ *  The transcript is built from transcript.log by scripts/at_transcript.py,
+ *  the same way one recorded on a device would be.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/utils.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    /**
+     * \brief What a command got back
+     */
+    struct Answer
+    {
+        int32_t ret = -1;
+        int32_t result = -1;
+        int32_t error = -1;
+        uint32_t latency = 0;
+        std::string text;
+    };
+
+    /**
+     * \brief Gets the AT service every test shares
+     *
+     *  Its thread never stops, so it's made once and never destroyed.
+     *
+     * \param none
+     *
+     * \return AtService &
+     *      The AT service
+     */
+    AtService &GetService(void)
+    {
+        static AtService service;
+
+        return service;
+    }
+
+    /**
+     * \brief Runs a command and gets what it got back
+     *
+     * \param command
+     *      The command
+     *
+     * \return Answer
+     *      What the command got back
+     */
+    Answer Ask(std::string_view command)
+    {
+        Answer answer;
+
+        GetService().Execute(command, [&answer](const AtService::Response &response) {
+            answer.ret = response.ret;
+            answer.result = response.result;
+            answer.error = response.error.cmeError;
+            answer.latency = response.latency;
+            answer.text = response.text;
+        });
+
+        return answer;
+    }
+
+    /**
+     * \brief Gets the signal a +CESQ response was recorded with
+     *
+     * \param command
+     *      The command to run, which should be AT+CESQ
+     *
+     * \return int32_t
+     *      The rsrp, or -1 if there wasn't one
+     */
+    int32_t Rsrp(std::string_view command)
+    {
+        Utils::At::Value values[std::size(Utils::At::Cesq.fields)];
+
+        Answer answer = Ask(command);
+
+        if (Utils::At::Parse(answer.text, Utils::At::Cesq, values) != static_cast<int>(std::size(values)))
+        {
+            return -1;
+        }
+
+        return values[0].integer;
+    }
+}
+
+/**
+ * \brief Checks that each command gets its recorded responses in order, no
+ *        matter what order the commands come in
+ */
+static void TestOrder(void)
+{
+    TEST_CHECK(Ask("AT%CESQ=1").result == 0);
+    TEST_CHECK(Ask("AT+CEREG=1").result == 0);
+
+    // Polled back to back, then the carriers caught up on
+    TEST_CHECK(Rsrp("AT+CESQ") == 45);
+    TEST_CHECK(Rsrp("AT+CESQ") == 52);
+
+    TEST_CHECK(Ask("AT+COPS?").text == "+COPS: 0,2,\"310410\",7\r\n");
+    TEST_CHECK(Ask("AT+COPS?").text == "+COPS: 0,2,\"23430\",7\r\n");
+
+    TEST_CHECK(Rsrp("AT+CESQ") == 60);
+    TEST_CHECK(Ask("AT+COPS?").text == "+COPS: 0\r\n");
+
+    // And around again from the start of the recording
+    TEST_CHECK(Rsrp("AT+CESQ") == 45);
+    TEST_CHECK(Ask("AT+COPS?").text == "+COPS: 0,2,\"310410\",7\r\n");
+}
+
+/**
+ * \brief Checks that failures are replayed as they were recorded
+ */
+static void TestFailures(void)
+{
+    Answer answer = Ask("AT#XSLEEP=2");
+
+    TEST_CHECK((answer.ret == 0) && (answer.result == 1));
+
+    answer = Ask("AT+CPIN?");
+
+    TEST_CHECK((answer.ret == 0) && (answer.result == 2) && (answer.error == 10));
+
+    // Anything that wasn't recorded doesn't get processed at all
+    TEST_CHECK(Ask("AT+CGSN").ret != 0);
+}
+
+/**
+ * \brief Checks that the replay takes as long as the modem did, scaled
+ */
+static void TestTiming(void)
+{
+    // The next AT+CESQ was recorded taking 35 ms
+    Answer answer = Ask("AT+CESQ");
+
+    uint32_t expected = (35 * CONFIG_AT_BACKEND_REPLAY_SCALE) / 100;
+
+    TEST_CHECK(answer.latency >= expected);
+    TEST_CHECK(answer.latency < (expected + 100));
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Order", TestOrder);
+    Run("Failures", TestFailures);
+    Run("Timing", TestTiming);
+
+    Finish();
+}
@@ -0,0 +1,237 @@
+/**
+ * \file
+ *
+ * \brief Measures the cell widget's poll with one combined AT command against
+ *        separate ones
+ *
+ *  Each poll runs the same commands the widget does, through the AT service,
+ *  against a scripted modem that takes a fixed time for each command it's
+ *  given, which stands in for a trip through the secure services and the
+ *  modem. The responses are parsed the way the widget parses them, so both
+ *  kinds of poll have to come up with the same values. The number of polls
+ *  and the modem's latency can be given as arguments:
+ *
+ *      cell_bench_poll [polls] [latency]
+ *
+ *  A second pass without any latency shows what the AT service and parsing
+ *  cost on their own.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/utils.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    static constexpr const char Cesq[] = "+CESQ: 99,99,255,255,20,45";
+    static constexpr const char Cops[] = "+COPS: 0,2,\"310410\",7";
+
+    /**
+     * \brief What a poll found out
+     */
+    struct Sample
+    {
+        int32_t rsrp = -1;
+        int32_t rsrq = -1;
+        std::string plmn;
+
+        bool operator==(const Sample &other) const
+        {
+            return ((this->rsrp == other.rsrp) && (this->rsrq == other.rsrq) && (this->plmn == other.plmn));
+        }
+    };
+
+    /**
+     * \brief Gets the signal from a response, the way the widget does
+     *
+     * \param resp
+     *      The response
+     * \param &sample
+     *      The sample to fill in
+     *
+     * \return none
+     */
+    void ParseSignal(std::string_view resp, Sample &sample)
+    {
+        Utils::At::Value values[std::size(Utils::At::Cesq.fields)];
+
+        if (Utils::At::Parse(resp, Utils::At::Cesq, values) == static_cast<int>(std::size(values)))
+        {
+            sample.rsrp = values[0].integer;
+            sample.rsrq = values[1].integer;
+        }
+    }
+
+    /**
+     * \brief Gets the operator from a response, the way the widget does
+     *
+     * \param resp
+     *      The response
+     * \param &sample
+     *      The sample to fill in
+     *
+     * \return none
+     */
+    void ParseOperator(std::string_view resp, Sample &sample)
+    {
+        Utils::At::Value values[std::size(Utils::At::Cops.fields)];
+
+        if (Utils::At::Parse(resp, Utils::At::Cops, values) == static_cast<int>(std::size(values)))
+        {
+            sample.plmn = values[0].text;
+        }
+    }
+
+    /**
+     * \brief Polls with both queries in one command
+     *
+     * \param &at
+     *      What to ask the modem through
+     *
+     * \return Sample
+     *      What the poll found out
+     */
+    Sample PollCombined(AtService &at)
+    {
+        Sample sample;
+
+        at.Execute("AT+CESQ;+COPS?", [&sample](const AtService::Response &response) {
+            ParseSignal(response.text, sample);
+            ParseOperator(response.text, sample);
+        });
+
+        return sample;
+    }
+
+    /**
+     * \brief Polls with a command for each query
+     *
+     * \param &at
+     *      What to ask the modem through
+     *
+     * \return Sample
+     *      What the poll found out
+     */
+    Sample PollSeparate(AtService &at)
+    {
+        Sample sample;
+
+        at.Execute("AT+CESQ", [&sample](const AtService::Response &response) {
+            ParseSignal(response.text, sample);
+        });
+
+        at.Execute("AT+COPS?", [&sample](const AtService::Response &response) {
+            ParseOperator(response.text, sample);
+        });
+
+        return sample;
+    }
+
+    /**
+     * \brief Runs polls and prints how long they took
+     *
+     * \param *name
+     *      What's being measured
+     * \param &at
+     *      What to ask the modem through
+     * \param poll
+     *      How to poll
+     * \param polls
+     *      How many polls to run
+     * \param latency
+     *      How long the modem takes for each command, in milliseconds
+     *
+     * \return Sample
+     *      What the last poll found out
+     */
+    template <typename Poll>
+    Sample Measure(const char *name, AtService &at, Poll poll, uint32_t polls, uint32_t latency)
+    {
+        Modem::Reset();
+        Modem::SetLatency(latency);
+
+        Modem::Answer("AT+CESQ", Cesq);
+        Modem::Answer("AT+COPS?", Cops);
+        Modem::Answer("AT+CESQ;+COPS?", std::string(Cesq) + "\r\n" + Cops);
+
+        Sample sample;
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < polls; i++)
+        {
+            sample = poll(at);
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        printf("%-24s %3u ms modem: %u polls, %u modem round trips, %.1f round trips and %.1f us per poll\n",
+            name,
+            static_cast<unsigned int>(latency),
+            static_cast<unsigned int>(polls),
+            static_cast<unsigned int>(Modem::GetRuns()),
+            static_cast<double>(Modem::GetRuns()) / polls,
+            static_cast<double>(elapsed.count()) / polls
+        );
+
+        return sample;
+    }
+}
+
+/**
+ * \brief Runs the measurements
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      Whether or not both kinds of poll took the expected round trips and
+ *      came up with the same values
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t polls = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100;
+    uint32_t latency = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 20;
+
+    if (polls == 0)
+    {
+        polls = 1;
+    }
+
+    // Its thread never stops, so it's never destroyed
+    AtService &at = *new AtService();
+
+    const Sample expected = {45, 20, "310410"};
+
+    TEST_CHECK(Measure("Combined", at, PollCombined, polls, latency) == expected);
+    TEST_CHECK(Modem::GetRuns() == polls);
+
+    TEST_CHECK(Measure("Separate", at, PollSeparate, polls, latency) == expected);
+    TEST_CHECK(Modem::GetRuns() == (polls * 2));
+
+    // The same again with a modem that answers right away, which leaves the
+    // AT service's own overhead
+    TEST_CHECK(Measure("Combined, no latency", at, PollCombined, polls * 10, 0) == expected);
+    TEST_CHECK(Measure("Separate, no latency", at, PollSeparate, polls * 10, 0) == expected);
+
+    Finish();
+}
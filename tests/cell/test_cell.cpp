@@ -0,0 +1,298 @@
+/**
+ * \file
+ *
+ * \brief Tests the cell widget against a scripted modem's responses and a
+ *        stream of %CESQ and +CEREG notifications
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/cell/cell.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    static constexpr const char Cesq[] = "+CESQ: 99,99,255,255,20,45";
+    static constexpr const char Cops[] = "+COPS: 0,2,\"310410\",7";
+
+    // The commands each poll sends
+#   if CONFIG_CELL_COMBINED_AT
+    static constexpr const uint32_t CommandsPerPoll = 1;
+#   else
+    static constexpr const uint32_t CommandsPerPoll = 2;
+#   endif
+
+    /**
+     * \brief Gets the AT service every test shares
+     *
+     *  Its thread never stops, so it's made once and never destroyed.
+     *
+     * \param none
+     *
+     * \return AtService &
+     *      The AT service
+     */
+    AtService &GetService(void)
+    {
+        static AtService service;
+
+        return service;
+    }
+
+    /**
+     * \brief Sets up a modem that's registered with AT&T
+     *
+     * \param notifications
+     *      Whether or not the modem can send notifications
+     *
+     * \return none
+     */
+    void Registered(bool notifications)
+    {
+        Modem::Reset();
+        Modem::SetNotifications(notifications);
+
+        Modem::Answer("AT%CESQ=1", "");
+        Modem::Answer("AT+CEREG=1", "");
+        Modem::Answer("AT+CESQ", Cesq);
+        Modem::Answer("AT+COPS?", Cops);
+        Modem::Answer("AT+CESQ;+COPS?", std::string(Cesq) + "\r\n" + Cops);
+    }
+
+    /**
+     * \brief Makes a new cell widget
+     *
+     *  Its thread never stops, so it's never destroyed.
+     *
+     * \param none
+     *
+     * \return Cell &
+     *      The cell widget
+     */
+    Cell &Start(void)
+    {
+        return *new Cell(GetService());
+    }
+
+    /**
+     * \brief Waits for a cell widget's data to be what's expected
+     *
+     * \param &cell
+     *      The cell widget
+     * \param rsrp
+     *      The expected rsrp
+     * \param rsrq
+     *      The expected rsrq
+     * \param carrier
+     *      The expected carrier
+     * \param timeout
+     *      The most time to wait, in milliseconds
+     *
+     * \return bool
+     *      Whether or not the data got there in time
+     */
+    bool WaitFor(const Cell &cell, uint8_t rsrp, uint8_t rsrq, Cell::Carrier carrier, int32_t timeout = 1000)
+    {
+        int64_t end = k_uptime_get() + timeout;
+
+        do
+        {
+            Cell::CellData data = cell.GetData();
+
+            if ((data.rsrp == rsrp) && (data.rsrq == rsrq) && (data.carrier == carrier))
+            {
+                return true;
+            }
+
+            k_sleep(5);
+        }
+        while (k_uptime_get() < end);
+
+        return false;
+    }
+}
+
+/**
+ * \brief Checks that the widget follows notifications without polling
+ */
+static void TestNotified(void)
+{
+    Registered(true);
+
+    Cell &cell = Start();
+
+    // The first poll happens right away, whether or not notifications are
+    // coming
+    TEST_CHECK(WaitFor(cell, 45, 20, Cell::Carrier::ATT));
+
+    uint32_t runs = Modem::GetRuns();
+
+    // Signal changes come in without asking
+    Modem::Notify("%CESQ: 49,2,15,3");
+
+    TEST_CHECK(WaitFor(cell, 49, 15, Cell::Carrier::ATT));
+
+    // A registration change is worth asking who we're registered with
+    Modem::Answer("AT+COPS?", "+COPS: 0,2,\"23430\",7");
+    Modem::Notify("+CEREG: 5,\"0A0B\",\"01234567\",7");
+
+    TEST_CHECK(WaitFor(cell, 49, 15, Cell::Carrier::EE));
+    TEST_CHECK(Modem::GetRuns() == (runs + 1));
+
+    // But losing registration isn't
+    Modem::Notify("+CEREG: 2");
+
+    TEST_CHECK(WaitFor(cell, 49, 15, Cell::Carrier::UKN));
+    TEST_CHECK(Modem::GetRuns() == (runs + 1));
+
+    // Notifications that aren't ours are left alone
+    Modem::Notify("+CSCON: 1");
+    Modem::Notify("%CESQ: 49");
+
+    k_sleep(50);
+
+    TEST_CHECK(WaitFor(cell, 49, 15, Cell::Carrier::UKN, 0));
+
+#   if CONFIG_CELL_HISTORY
+    // Both signals made it into the history
+    TEST_CHECK(cell.GetHistory().GetSummary(Cell::ShortWindow).rsrp.count == 2);
+#   endif
+}
+
+/**
+ * \brief Checks that a burst of notifications leaves the latest signal
+ */
+static void TestStream(void)
+{
+    Registered(true);
+
+    Cell &cell = Start();
+
+    TEST_CHECK(WaitFor(cell, 45, 20, Cell::Carrier::ATT));
+
+    uint32_t runs = Modem::GetRuns();
+
+    // The widget can fall behind, but it has to end up where the stream did
+    for (int32_t i = 0; i < 200; i++)
+    {
+        Modem::Notify("%CESQ: " + std::to_string(i % 97) + ",1," + std::to_string(i % 34) + ",1");
+
+        if ((i % 50) == 0)
+        {
+            Modem::Notify("+CEREG: 1,\"0A0B\",\"01234567\",7");
+        }
+    }
+
+    TEST_CHECK(WaitFor(cell, 199 % 97, 199 % 34, Cell::Carrier::ATT));
+
+    // Only the registration changes sent anything to the modem, and fewer
+    // than that if they were picked up together
+    TEST_CHECK((Modem::GetRuns() - runs) <= 4);
+
+    // Unknown signal levels are taken, but kept out of the history
+    Modem::Notify("%CESQ: 255,0,255,0");
+
+    TEST_CHECK(WaitFor(cell, 255, 255, Cell::Carrier::ATT));
+
+#   if CONFIG_CELL_HISTORY
+    Cell::SignalHistory::Summary summary = cell.GetHistory().GetSummary(Cell::ShortWindow);
+
+    TEST_CHECK((summary.rsrp.count >= 2) && (summary.rsrp.count <= 201));
+    TEST_CHECK(summary.rsrp.max < 255);
+#   endif
+}
+
+/**
+ * \brief Checks that notifications are picked up while a poll is under way
+ */
+static void TestUnblocked(void)
+{
+    static constexpr const uint32_t Latency = 300;
+
+    Registered(true);
+    Modem::SetLatency(Latency);
+
+    Cell &cell = Start();
+
+    // Wait for the first poll to reach the modem, after the two commands that
+    // set up notifications
+    int64_t end = k_uptime_get() + (4 * Latency);
+
+    while ((Modem::GetRuns() < 3) && (k_uptime_get() < end))
+    {
+        k_sleep(1);
+    }
+
+    TEST_CHECK(Modem::GetRuns() == 3);
+
+    // The widget isn't waiting on the poll, so it takes this in well before
+    // the poll's done
+    Modem::Notify("%CESQ: 60,1,30,1");
+
+    TEST_CHECK(WaitFor(cell, 60, 30, Cell::Carrier::UKN, Latency / 2));
+
+    // And then the poll lands
+    TEST_CHECK(WaitFor(cell, 45, 20, Cell::Carrier::ATT, 4 * Latency));
+}
+
+/**
+ * \brief Checks that the widget polls when notifications can't be set up
+ */
+static void TestPolled(void)
+{
+    Registered(false);
+
+    Cell &cell = Start();
+
+    TEST_CHECK(WaitFor(cell, 45, 20, Cell::Carrier::ATT));
+
+    // Nothing's listening, so this is ignored
+    Modem::Notify("%CESQ: 49,2,15,3");
+
+    Modem::Answer("AT+CESQ", "+CESQ: 99,99,255,255,18,52");
+    Modem::Answer("AT+CESQ;+COPS?", std::string("+CESQ: 99,99,255,255,18,52\r\n") + Cops);
+
+    int64_t start = k_uptime_get();
+
+    TEST_CHECK(WaitFor(cell, 52, 18, Cell::Carrier::ATT, K_SECONDS(CONFIG_CELL_POLL_RATE) + 1000));
+    TEST_CHECK((k_uptime_get() - start) >= (K_SECONDS(CONFIG_CELL_POLL_RATE) - 500));
+
+    // Notifications were never turned on, so the two polls are all the modem
+    // has seen
+    TEST_CHECK(Modem::GetRuns() == (2 * CommandsPerPoll));
+    TEST_CHECK(Modem::GetRuns("AT%CESQ=1") == 0);
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    // Widgets from earlier tests are still running, so the polled test goes
+    // last, where its widget's polls can't throw off another test's counts
+    Run("Notified", TestNotified);
+    Run("Stream", TestStream);
+    Run("Unblocked", TestUnblocked);
+    Run("Polled", TestPolled);
+
+    Finish();
+}
@@ -0,0 +1,222 @@
+/**
+ * \file
+ *
+ * \brief Tests the cell signal history's rolling statistics
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <atomic>
+#include <cmath>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/cell/history.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // A short and a long window, short enough for a test to wait out
+    static constexpr const uint32_t Short = 300;
+    static constexpr const uint32_t Long = 60000;
+
+    using TestHistory = History<4, 2>;
+}
+
+/**
+ * \brief Checks the statistics over a window
+ */
+static void TestStats(void)
+{
+    TestHistory history({Short, Long});
+
+    TEST_CHECK(history.GetSummary(0).rsrp.count == 0);
+
+    history.Add(40, 10);
+    history.Add(50, 12);
+    history.Add(60, 14);
+
+    TestHistory::Summary summary = history.GetSummary(0);
+
+    TEST_CHECK(summary.rsrp.count == 3);
+    TEST_CHECK((summary.rsrp.min == 40) && (summary.rsrp.max == 60));
+    TEST_CHECK(std::fabs(summary.rsrp.mean - 50.0f) < 0.01f);
+    TEST_CHECK(std::fabs(summary.rsrp.variance - (200.0f / 3.0f)) < 0.01f);
+
+    TEST_CHECK((summary.rsrq.min == 10) && (summary.rsrq.max == 14));
+    TEST_CHECK(std::fabs(summary.rsrq.mean - 12.0f) < 0.01f);
+}
+
+/**
+ * \brief Checks that samples age out of a window when no more are added
+ */
+static void TestAgesOut(void)
+{
+    TestHistory history({Short, Long});
+
+    history.Add(10, 5);
+
+    k_sleep(Short * 2 / 3);
+
+    history.Add(50, 7);
+    history.Add(30, 9);
+
+    // The first sample is still within both windows
+    TEST_CHECK(history.GetSummary(0).rsrp.count == 3);
+    TEST_CHECK(history.GetSummary(0).rsrp.min == 10);
+
+    k_sleep(Short * 2 / 3);
+
+    // Nothing's been added since, but the first sample is gone from the
+    // short window, and the minimum with it
+    TestHistory::Summary summary = history.GetSummary(0);
+
+    TEST_CHECK(summary.rsrp.count == 2);
+    TEST_CHECK((summary.rsrp.min == 30) && (summary.rsrp.max == 50));
+    TEST_CHECK(std::fabs(summary.rsrp.mean - 40.0f) < 0.01f);
+    TEST_CHECK((summary.rsrq.min == 7) && (summary.rsrq.max == 9));
+
+    // The long window still has everything
+    TEST_CHECK(history.GetSummary(1).rsrp.count == 3);
+    TEST_CHECK(history.GetSummary(1).rsrp.min == 10);
+
+    k_sleep(Short);
+
+    TEST_CHECK(history.GetSummary(0).rsrp.count == 0);
+    TEST_CHECK(history.GetSummary(1).rsrp.count == 3);
+
+    // A new sample starts the short window over
+    history.Add(20, 3);
+
+    summary = history.GetSummary(0);
+
+    TEST_CHECK((summary.rsrp.count == 1) && (summary.rsrp.min == 20) && (summary.rsrp.max == 20));
+}
+
+/**
+ * \brief Checks that samples leave every window once they're overwritten
+ */
+static void TestOverwritten(void)
+{
+    TestHistory history({Short, Long});
+
+    for (uint8_t i = 1; i <= 6; i++)
+    {
+        history.Add(i * 10, i);
+    }
+
+    TestHistory::Summary summary = history.GetSummary(1);
+
+    TEST_CHECK(summary.rsrp.count == 4);
+    TEST_CHECK((summary.rsrp.min == 30) && (summary.rsrp.max == 60));
+
+    TestHistory::Sample samples[8];
+
+    TEST_CHECK(history.GetSamples(samples, std::size(samples)) == 4);
+    TEST_CHECK((samples[0].rsrp == 30) && (samples[3].rsrp == 60));
+
+    TEST_CHECK(history.GetSamples(samples, 2) == 2);
+    TEST_CHECK((samples[0].rsrp == 50) && (samples[1].rsrp == 60));
+}
+
+/**
+ * \brief Checks that readers only see whole statistics and samples while
+ *        samples are being added
+ */
+static void TestConcurrent(void)
+{
+    History<64, 2> history({Short, Long});
+
+    std::atomic<bool> done = false;
+    std::atomic<uint32_t> bad = 0;
+    std::atomic<uint32_t> reads = 0;
+
+    // Every sample's RSRP and RSRQ are the same, so their statistics should
+    // always match
+    auto reader = [&history, &done, &bad, &reads](void) {
+        while (!done)
+        {
+            for (std::size_t window = 0; window < 2; window++)
+            {
+                History<64, 2>::Summary summary = history.GetSummary(window);
+
+                if ((summary.rsrp.count != summary.rsrq.count) ||
+                    (summary.rsrp.count > 64) ||
+                    (summary.rsrp.min != summary.rsrq.min) ||
+                    (summary.rsrp.max != summary.rsrq.max) ||
+                    (summary.rsrp.min > summary.rsrp.max) ||
+                    (summary.rsrp.mean != summary.rsrq.mean))
+                {
+                    bad++;
+                }
+            }
+
+            History<64, 2>::Sample samples[64];
+
+            std::size_t count = history.GetSamples(samples, std::size(samples));
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if ((samples[i].rsrp != samples[i].rsrq) ||
+                    ((i > 0) && (samples[i].rsrp != static_cast<uint8_t>(samples[i - 1].rsrp + 1))))
+                {
+                    bad++;
+                }
+            }
+
+            reads++;
+        }
+    };
+
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 4; i++)
+    {
+        readers.emplace_back(reader);
+    }
+
+    for (uint32_t i = 0; i < 200000; i++)
+    {
+        history.Add(static_cast<uint8_t>(i), static_cast<uint8_t>(i));
+    }
+
+    done = true;
+
+    for (std::thread &thread : readers)
+    {
+        thread.join();
+    }
+
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(reads > 0);
+    TEST_CHECK(history.GetSummary(1).rsrp.count == 64);
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Stats", TestStats);
+    Run("AgesOut", TestAgesOut);
+    Run("Overwritten", TestOverwritten);
+    Run("Concurrent", TestConcurrent);
+
+    Finish();
+}
@@ -0,0 +1,264 @@
+/**
+ * \file
+ *
+ * \brief Tests the async console's throughput over its simulated link
+ *
+ *  Writers offer output faster and slower than the link can send it, and the
+ *  console has to keep the link busy without ever making a writer wait on it,
+ *  dropping only what doesn't fit. The throughput and how long writes took
+ *  are printed.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/console/console.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // What the link can send, with ten bits for each byte
+    static constexpr const uint32_t LinkRate = CONFIG_ASYNC_CONSOLE_LOOPBACK_BAUD / 10;
+
+    /**
+     * \brief What writers offered and how it went
+     */
+    struct Offer
+    {
+        std::atomic<uint64_t> offered{0};
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<int64_t> slowest{0};
+    };
+
+    /**
+     * \brief Gets the console every test shares
+     *
+     *  Its link's timer never stops, so it's made once and never destroyed.
+     *
+     * \param none
+     *
+     * \return AsyncConsole &
+     *      The console
+     */
+    AsyncConsole &GetConsole(void)
+    {
+        static AsyncConsole console;
+
+        return console;
+    }
+
+    /**
+     * \brief Writes lines at a steady rate from a few threads at once
+     *
+     * \param writers
+     *      How many threads to write from
+     * \param length
+     *      How long each line is
+     * \param interval
+     *      How long each thread waits between lines, in milliseconds
+     * \param duration
+     *      How long to keep writing, in milliseconds
+     * \param &offer
+     *      What was offered and how it went
+     *
+     * \return none
+     */
+    void Write(uint32_t writers, std::size_t length, int32_t interval, int32_t duration, Offer &offer)
+    {
+        std::vector<std::thread> threads;
+
+        for (uint32_t i = 0; i < writers; i++)
+        {
+            threads.emplace_back([length, interval, duration, &offer](void) {
+                std::vector<char> line(length, 'x');
+
+                line.back() = '\n';
+
+                for (int32_t elapsed = 0; elapsed < duration; elapsed += interval)
+                {
+                    auto started = std::chrono::steady_clock::now();
+
+                    std::size_t count = GetConsole().Write(line.data(), std::size(line));
+
+                    auto took = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+
+                    offer.offered += std::size(line);
+                    offer.accepted += count;
+
+                    int64_t slowest = offer.slowest;
+
+                    while ((took.count() > slowest) && !offer.slowest.compare_exchange_weak(slowest, took.count()))
+                    {
+                    }
+
+                    k_sleep(interval);
+                }
+            });
+        }
+
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * \brief Waits for everything that was queued to be sent
+     *
+     * \param none
+     *
+     * \return AsyncConsole::Stats
+     *      The console's statistics once it's done
+     */
+    AsyncConsole::Stats Drain(void)
+    {
+        // Bytes are only counted once their transfer's done, so nothing's
+        // changed in the time it takes to send a full buffer means we're idle
+        static constexpr const int32_t Quiet = ((CONFIG_ASYNC_CONSOLE_BUFFER_SIZE * 10 * 1000) / CONFIG_ASYNC_CONSOLE_LOOPBACK_BAUD) + 20;
+
+        AsyncConsole::Stats stats = GetConsole().GetStats();
+
+        for (int i = 0; i < 20; i++)
+        {
+            k_sleep(Quiet);
+
+            AsyncConsole::Stats next = GetConsole().GetStats();
+
+            if ((next.bytes == stats.bytes) && (next.transfers == stats.transfers))
+            {
+                break;
+            }
+
+            stats = next;
+        }
+
+        return stats;
+    }
+}
+
+/**
+ * \brief Checks that nothing's dropped when output comes slower than the link
+ *        can send it
+ */
+static void TestUnderRate(void)
+{
+    AsyncConsole::Stats before = Drain();
+
+    Offer offer;
+
+    // About half of what the link can take
+    Write(2, 100, 35, 700, offer);
+
+    AsyncConsole::Stats after = Drain();
+
+    TEST_CHECK(offer.accepted == offer.offered);
+    TEST_CHECK(after.dropped == before.dropped);
+    TEST_CHECK((after.bytes - before.bytes) == offer.offered);
+
+    printf("under rate: %llu bytes in %u transfers, slowest write %lld us\n",
+        static_cast<unsigned long long>(offer.offered.load()),
+        static_cast<unsigned int>(after.transfers - before.transfers),
+        static_cast<long long>(offer.slowest.load())
+    );
+}
+
+/**
+ * \brief Checks that the link stays busy and writers don't wait when output
+ *        comes faster than the link can send it
+ */
+static void TestOverRate(void)
+{
+    static constexpr const int32_t Duration = 2000;
+
+    AsyncConsole::Stats before = Drain();
+
+    Offer offer;
+
+    // About a third more than the link can take, from the writers' side
+    // while the link's kept busy
+    int64_t started = k_uptime_get();
+
+    std::thread writing([&offer](void) {
+        Write(2, 200, 26, Duration, offer);
+    });
+
+    // Measure the middle of the run, once the link is saturated
+    k_sleep(Duration / 4);
+
+    AsyncConsole::Stats first = GetConsole().GetStats();
+    int64_t firstTime = k_uptime_get();
+
+    k_sleep(Duration / 2);
+
+    AsyncConsole::Stats second = GetConsole().GetStats();
+    int64_t secondTime = k_uptime_get();
+
+    writing.join();
+
+    AsyncConsole::Stats after = Drain();
+
+    uint64_t throughput = (static_cast<uint64_t>(second.bytes - first.bytes) * 1000) / std::max<int64_t>(secondTime - firstTime, 1);
+
+    // Everything taken in went out, and everything else was counted
+    TEST_CHECK((after.bytes - before.bytes) == offer.accepted);
+    TEST_CHECK((after.dropped - before.dropped) == (offer.offered - offer.accepted));
+    TEST_CHECK(offer.accepted < offer.offered);
+
+    // The link never sat idle while there was output waiting, give or take
+    // the transfer that was under way at either end, since bytes are only
+    // counted once their transfer's done
+    uint64_t sent = second.bytes - first.bytes;
+    uint64_t expected = (LinkRate * static_cast<uint64_t>(secondTime - firstTime)) / 1000;
+
+    TEST_CHECK((sent + CONFIG_ASYNC_CONSOLE_BUFFER_SIZE) >= ((expected * 95) / 100));
+    TEST_CHECK(sent <= (expected + CONFIG_ASYNC_CONSOLE_BUFFER_SIZE));
+
+    // Writes only ever copied into a buffer
+    TEST_CHECK(offer.slowest < 20000);
+
+    printf("over rate: offered %llu bytes in %lld ms, %llu accepted, %u dropped, %u transfers\n",
+        static_cast<unsigned long long>(offer.offered.load()),
+        static_cast<long long>(k_uptime_get() - started),
+        static_cast<unsigned long long>(offer.accepted.load()),
+        static_cast<unsigned int>(after.dropped - before.dropped),
+        static_cast<unsigned int>(after.transfers - before.transfers)
+    );
+
+    printf("throughput %llu bytes/s of %u, slowest write %lld us\n",
+        static_cast<unsigned long long>(throughput),
+        static_cast<unsigned int>(LinkRate),
+        static_cast<long long>(offer.slowest.load())
+    );
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("UnderRate", TestUnderRate);
+    Run("OverRate", TestOverRate);
+
+    Finish();
+}
@@ -0,0 +1,419 @@
+/**
+ * \file
+ *
+ * \brief Compares the dashboard's output with how it used to print
+ *
+ *  The dashboard used to print each element straight to the console, with
+ *  every character going through its own printk("%c") and every newline
+ *  followed by an escape sequence to get back to the window's edge. That
+ *  path is reproduced here and timed drawing the same elements the
+ *  dashboard then draws, which it does into its shadow of the screen and
+ *  sends the changes from with uart_poll_out().
+ *
+ *  The console UART's stand-in doesn't wait for each byte to go out, so the
+ *  times here are the work each path does. The bytes each sends are what
+ *  it'd spend waiting on the UART, and the time that takes at 115200 baud is
+ *  printed alongside.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/dashboard/dashboard.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // How fast the console's UART sends, in bits per second, with a start
+    // and stop bit around each byte
+    static constexpr const uint32_t Baud = 115200;
+    static constexpr const uint32_t BitsPerByte = 10;
+
+    /**
+     * \brief A window as the dashboard used to draw them, printing straight
+     *        to the console
+     */
+    class LegacyWindow
+    {
+        private:
+            // Defines the upper left corner
+            std::size_t column;
+            std::size_t row;
+
+        private:
+            /**
+             * \brief Prints a character to the window by calling the next
+             *        print function
+             *
+             * \param c
+             *      The ascii code of the character to print
+             * \param context
+             *      The window object the character should be printed to
+             *
+             * \return 0
+             */
+            static int Print(int c, void *context)
+            {
+                LegacyWindow *window = reinterpret_cast<LegacyWindow *>(context);
+                window->Print(c);
+
+                return 0;
+            }
+
+            /**
+             * \brief Prints a single character
+             *
+             * \param c
+             *      The ascii code of the character to be printed
+             *
+             * \return none
+             */
+            void Print(int c)
+            {
+                printk("%c", c);
+
+                // if a new line was printed, reset back to the start of the
+                // window
+                if (c == '\n')
+                {
+                    this->MoveCursor(this->column);
+                }
+            }
+
+            /**
+             * \brief Moves the cursor to the right using VT100 ESC codes
+             *
+             * \param count
+             *      The number of places to move the cursor over
+             *
+             * \return none
+             */
+            void MoveCursor(std::size_t count)
+            {
+                if (count > 1)
+                {
+                    printk("%c[%dC", ESC, static_cast<int>(count));
+                }
+            }
+
+        public:
+            /**
+             * \brief Creates a new window
+             *
+             * \param c
+             *      The upper-left column
+             * \param r
+             *      The upper-left row
+             */
+            LegacyWindow(std::size_t column, std::size_t row):
+                column(column),
+                row(row) {}
+
+            /**
+             * \brief Moves the cursor to the upper left of the window
+             *
+             * \param none
+             *
+             * \return none
+             */
+            void Setup(void)
+            {
+                printk("%c[%d;%dH", ESC, static_cast<int>(this->row + 2), static_cast<int>(this->column + 1));
+            }
+
+            /**
+             * \brief Takes in a format string and the arguments
+             *
+             * \param format
+             *      The string with typical format characters
+             * \param ...
+             *      Arguments to sub the format characters with
+             *
+             * \return none
+             */
+            void Print(const char *format, ...)
+            {
+                va_list list;
+                va_start(list, format);
+
+                z_vprintk(LegacyWindow::Print, reinterpret_cast<void *>(this), format, list);
+
+                va_end(list);
+            }
+    };
+
+    /**
+     * \brief An element that shows a box with a value that changes every
+     *        update and one that changes every few
+     */
+    class Gauge : public Dashboard::Element
+    {
+        private:
+            const char *name;
+            uint32_t draws = 0;
+
+        public:
+            /**
+             * \brief Creates a new element
+             *
+             * \param *name
+             *      What the box is called
+             *
+             * \return none
+             */
+            Gauge(const char *name):
+                name(name) {}
+
+            /**
+             * \brief Draws this element
+             *
+             * \param &window
+             *      The window to draw in
+             *
+             * \return none
+             */
+            template <typename Window>
+            void Draw(Window &window)
+            {
+                uint32_t draw = this->draws++;
+
+                window.Print("+---------------+\n");
+                window.Print("| %-13s |\n", this->name);
+                window.Print("|  value:%5d  |\n", static_cast<int>((draw * 37) % 2000) - 1000);
+                window.Print("|  total:%5u  |\n", static_cast<unsigned int>(draw / 4));
+                window.Print("+---------------+\n");
+            }
+
+            void Display(Dashboard::Window &window) override
+            {
+                this->Draw(window);
+            }
+
+            /**
+             * \brief Starts drawing from the first update again
+             *
+             * \param none
+             *
+             * \return none
+             */
+            void Reset(void)
+            {
+                this->draws = 0;
+            }
+    };
+
+    Gauge gauges[] = {
+        Gauge("Accel"),
+        Gauge("Button"),
+        Gauge("Cell"),
+        Gauge("Battery"),
+        Gauge("Socket"),
+        Gauge("GPS"),
+        Gauge("Temperature"),
+        Gauge("Humidity"),
+        Gauge("Pressure"),
+    };
+
+    // How many bytes have gone to the console
+    uint32_t bytes = 0;
+
+    // The end of what's been printed since the last newline or escape
+    char line[256];
+    std::size_t length = 0;
+
+    // The dashboard's benchmark reports, as they're printed
+    std::string changes;
+    std::string full;
+
+    // Signals the dashboard's first report is in
+    struct k_sem reported;
+
+    /**
+     * \brief Counts the bytes going to the console, and picks out the
+     *        dashboard's reports
+     *
+     *  Output is already serialized, and this is as little work as it can
+     *  be, so it takes as little as it can from both paths' times. The
+     *  dashboard only moves the cursor between rows, so the only newlines
+     *  are at the ends of its reports, and each report comes after its last
+     *  cursor move.
+     *
+     * \param c
+     *      The character
+     *
+     * \return int
+     *      The character
+     */
+    int Capture(int c)
+    {
+        bytes++;
+
+        if (c == ESC)
+        {
+            length = 0;
+        }
+        else if (c != '\n')
+        {
+            if (length < sizeof(line))
+            {
+                line[length++] = static_cast<char>(c);
+            }
+        }
+        else if (full.empty())
+        {
+            std::string printed(line, length);
+
+            length = 0;
+
+            std::size_t start = printed.find("Dashboard ");
+
+            if (start == std::string::npos)
+            {
+                return c;
+            }
+
+            std::string report = printed.substr(start);
+
+            if (report.compare(0, 16, "Dashboard full: ") == 0)
+            {
+                full = report;
+
+                k_sem_give(&reported);
+            }
+            else
+            {
+                changes = report;
+            }
+        }
+
+        return c;
+    }
+
+    /**
+     * \brief Gets how long some bytes take on the wire
+     *
+     * \param bytes
+     *      The number of bytes
+     *
+     * \return uint32_t
+     *      How long they take, in microseconds
+     */
+    uint32_t GetWireTime(uint32_t bytes)
+    {
+        return static_cast<uint32_t>((static_cast<uint64_t>(bytes) * BitsPerByte * 1000000) / Baud);
+    }
+
+    /**
+     * \brief Prints one of the dashboard's reports with its time on the wire
+     *
+     * \param &report
+     *      The report
+     *
+     * \return uint32_t
+     *      The bytes each update in the report sent, or 0 if it couldn't be
+     *      read
+     */
+    uint32_t PrintReport(const std::string &report)
+    {
+        unsigned int sent = 0;
+
+        if (sscanf(report.c_str(), "Dashboard %*s %*u frames, avg %*u cycles (%*u us; draw %*u, diff %*u, output %*u), %u bytes", &sent) != 1)
+        {
+            return 0;
+        }
+
+        printf("%s, %u us on the wire\n", report.c_str(), static_cast<unsigned int>(GetWireTime(sent)));
+
+        return sent;
+    }
+}
+
+/**
+ * \brief Runs the comparison
+ *
+ * \param none
+ *
+ * \return int
+ *      Whether or not both paths were measured
+ */
+int main(void)
+{
+    static constexpr const uint32_t Frames = CONFIG_DASHBOARD_BENCHMARK_FRAMES;
+
+    k_sem_init(&reported, 0, 1);
+
+    __printk_hook_install(Capture);
+
+    // Draw every element the old way, a character at a time, as many times
+    // as the dashboard's report covers
+    uint32_t started = k_cycle_get_32();
+
+    for (uint32_t frame = 0; frame < Frames; frame++)
+    {
+        for (std::size_t i = 0; i < std::size(gauges); i++)
+        {
+            std::size_t column = (i % CONFIG_DASHBOARD_X) * CONFIG_DASHBOARD_W;
+            std::size_t row = (i / CONFIG_DASHBOARD_X) * CONFIG_DASHBOARD_H;
+
+            LegacyWindow window(column, row);
+
+            window.Setup();
+
+            gauges[i].Draw(window);
+        }
+    }
+
+    uint32_t legacyCycles = (k_cycle_get_32() - started) / Frames;
+    uint32_t legacyBytes = bytes / Frames;
+
+    // Then draw the same updates through the dashboard
+    for (Gauge &gauge : gauges)
+    {
+        gauge.Reset();
+    }
+
+    // Its thread never stops, so it's never destroyed
+    Dashboard *dashboard = new Dashboard(CONFIG_DASHBOARD_X, CONFIG_DASHBOARD_Y, CONFIG_DASHBOARD_W, CONFIG_DASHBOARD_H);
+
+    for (Gauge &gauge : gauges)
+    {
+        dashboard->RegisterElement(gauge);
+    }
+
+    // Once the reports are in, they're left alone
+    TEST_CHECK(k_sem_take(&reported, K_SECONDS(10)) == 0);
+
+    printf("Window::Print everything: %u frames, avg %u cycles (%u us), %u bytes, %u us on the wire\n",
+        static_cast<unsigned int>(Frames),
+        static_cast<unsigned int>(legacyCycles),
+        static_cast<unsigned int>((static_cast<uint64_t>(legacyCycles) * 1000000) / CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC),
+        static_cast<unsigned int>(legacyBytes),
+        static_cast<unsigned int>(GetWireTime(legacyBytes))
+    );
+
+    uint32_t changesBytes = PrintReport(changes);
+    uint32_t fullBytes = PrintReport(full);
+
+    printf("\n");
+
+    // Both kinds of update were measured, and sending only changes sends
+    // less than printing everything did
+    TEST_CHECK((changesBytes > 0) && (fullBytes > 0));
+    TEST_CHECK(changesBytes < legacyBytes);
+
+    Finish();
+}
@@ -0,0 +1,400 @@
+/**
+ * \file
+ *
+ * \brief Tests what the dashboard sends to the console
+ *
+ *  The dashboard's output is taken from printk() and played through a small
+ *  VT100 emulator, and after every update the emulated screen has to show
+ *  exactly what the elements drew. The bytes each update took are printed,
+ *  so updates that only send changes can be compared with ones that send
+ *  everything.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/dashboard/dashboard.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    static constexpr const std::size_t Columns = CONFIG_DASHBOARD_X * CONFIG_DASHBOARD_W;
+    static constexpr const std::size_t Rows = CONFIG_DASHBOARD_Y * CONFIG_DASHBOARD_H;
+
+    // How many updates to watch, which takes in two full redraws
+    static constexpr const uint32_t Updates = (2 * CONFIG_DASHBOARD_FULL_REDRAW_RATE) + 1;
+
+    /**
+     * \brief A screen that follows VT100 cursor moves
+     *
+     *  Only what the dashboard sends is understood: "ESC[row;columnH" and
+     *  printable characters.
+     */
+    class Terminal
+    {
+        public:
+            // The dashboard starts on the second row, so leave room for it
+            // to be off by a few without writing out of bounds
+            char screen[Rows + 4][Columns + 4] = {};
+
+            // Whether or not anything couldn't be understood or landed off
+            // of the screen
+            bool garbled = false;
+
+        private:
+            std::size_t row = 0;
+            std::size_t column = 0;
+
+            std::string escape;
+            bool escaping = false;
+
+        public:
+            /**
+             * \brief Takes in a character from the console
+             *
+             * \param c
+             *      The character
+             *
+             * \return none
+             */
+            void Feed(char c)
+            {
+                if (this->escaping)
+                {
+                    this->escape += c;
+
+                    if (c != 'H')
+                    {
+                        return;
+                    }
+
+                    unsigned int row;
+                    unsigned int column;
+
+                    if ((sscanf(this->escape.c_str(), "[%u;%u", &row, &column) != 2) || (row == 0) || (column == 0))
+                    {
+                        this->garbled = true;
+                    }
+                    else
+                    {
+                        this->row = row - 1;
+                        this->column = column - 1;
+                    }
+
+                    this->escaping = false;
+
+                    return;
+                }
+
+                if (c == ESC)
+                {
+                    this->escape.clear();
+                    this->escaping = true;
+
+                    return;
+                }
+
+                if ((c < ' ') || (c > '~') || (this->row >= std::size(this->screen)) || (this->column >= std::size(this->screen[0])))
+                {
+                    this->garbled = true;
+
+                    return;
+                }
+
+                this->screen[this->row][this->column++] = c;
+            }
+    };
+
+    /**
+     * \brief What one update sent
+     */
+    struct Update
+    {
+        std::size_t bytes;
+        bool matched;
+    };
+
+    // Everything printed since the last update
+    std::string output;
+
+    Terminal terminal;
+
+    std::vector<Update> updates;
+
+    struct k_sem done;
+
+    /**
+     * \brief Takes in printk() output
+     *
+     * \param c
+     *      The character
+     *
+     * \return int
+     *      The character
+     */
+    int Capture(int c)
+    {
+        output += static_cast<char>(c);
+
+        return c;
+    }
+
+    /**
+     * \brief An element that shows a box with a name and two values
+     */
+    class Box : public Dashboard::Element
+    {
+        public:
+            std::string name;
+            int32_t x = 0;
+            int32_t y = 0;
+
+            /**
+             * \brief Gets the lines this element draws
+             *
+             * \param none
+             *
+             * \return std::vector<std::string>
+             *      The lines
+             */
+            std::vector<std::string> GetLines(void) const
+            {
+                char lines[3][32];
+
+                snprintf(lines[0], sizeof(lines[0]), "| %-13s |", this->name.c_str());
+                snprintf(lines[1], sizeof(lines[1]), "|    x:%4d     |", static_cast<int>(this->x));
+                snprintf(lines[2], sizeof(lines[2]), "|    y:%4d     |", static_cast<int>(this->y));
+
+                return {"+---------------+", lines[0], lines[1], lines[2], "+---------------+"};
+            }
+
+            /**
+             * \brief Draws this element
+             *
+             * \param &window
+             *      The window to draw in
+             *
+             * \return none
+             */
+            void Display(Dashboard::Window &window) override
+            {
+                for (const std::string &line : this->GetLines())
+                {
+                    window.Print("%s\n", line.c_str());
+                }
+            }
+    };
+
+    Box boxes[4];
+
+    /**
+     * \brief Checks that the emulated screen shows what the boxes drew
+     *
+     * \param none
+     *
+     * \return bool
+     *      Whether or not the screen matches
+     */
+    bool Matches(void)
+    {
+        char expected[Rows][Columns] = {};
+
+        for (std::size_t i = 0; i < std::size(boxes); i++)
+        {
+            std::size_t column = (i % CONFIG_DASHBOARD_X) * CONFIG_DASHBOARD_W;
+            std::size_t row = (i / CONFIG_DASHBOARD_X) * CONFIG_DASHBOARD_H;
+
+            for (const std::string &line : boxes[i].GetLines())
+            {
+                for (std::size_t j = 0; (j < std::size(line)) && ((column + j) < Columns); j++)
+                {
+                    expected[row][column + j] = line[j];
+                }
+
+                row++;
+            }
+        }
+
+        // The dashboard starts on the console's second row
+        for (std::size_t row = 0; row < Rows; row++)
+        {
+            for (std::size_t column = 0; column < Columns; column++)
+            {
+                if (terminal.screen[row + 1][column] != expected[row][column])
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Changes the boxes the way they'd change between updates
+     *
+     * \param update
+     *      The update about to be drawn
+     *
+     * \return none
+     */
+    void Change(uint32_t update)
+    {
+        // One value changes every time, another now and then, and one box is
+        // renamed partway through
+        boxes[0].x = static_cast<int32_t>(update);
+        boxes[0].y = static_cast<int32_t>(update * 3);
+
+        if ((update % 3) == 0)
+        {
+            boxes[2].x = static_cast<int32_t>(update * 7);
+        }
+
+        if (update == 5)
+        {
+            boxes[1].name = "Btn";
+        }
+    }
+
+    /**
+     * \brief The first box, which also keeps track of updates
+     *
+     *  The first element is drawn at the start of each update, after the
+     *  last update's output has all gone out, so that's checked here.
+     */
+    class First : public Box
+    {
+        private:
+            uint32_t drawn = 0;
+
+        public:
+            /**
+             * \brief Checks the last update, then draws this element
+             *
+             * \param &window
+             *      The window to draw in
+             *
+             * \return none
+             */
+            void Display(Dashboard::Window &window) override
+            {
+                if (this->drawn > 0)
+                {
+                    for (char c : output)
+                    {
+                        terminal.Feed(c);
+                    }
+
+                    updates.push_back({std::size(output), Matches()});
+
+                    output.clear();
+
+                    if (this->drawn == Updates)
+                    {
+                        k_sem_give(&done);
+                    }
+                }
+
+                Change(this->drawn++);
+
+                boxes[0].Display(window);
+            }
+    };
+}
+
+/**
+ * \brief Checks that the screen always shows what was drawn, and that only
+ *        sending changes sends much less
+ */
+static void TestRender(void)
+{
+    static First first;
+
+    k_sem_init(&done, 0, 1);
+
+    boxes[0].name = "Accel";
+    boxes[1].name = "Button";
+    boxes[2].name = "Cell";
+    boxes[3].name = "Four";
+
+    __printk_hook_install(Capture);
+
+    // Its thread never stops, so it's never destroyed
+    Dashboard *dashboard = new Dashboard(CONFIG_DASHBOARD_X, CONFIG_DASHBOARD_Y, CONFIG_DASHBOARD_W, CONFIG_DASHBOARD_H);
+
+    dashboard->RegisterElement(first);
+
+    for (std::size_t i = 1; i < std::size(boxes); i++)
+    {
+        dashboard->RegisterElement(boxes[i]);
+    }
+
+    TEST_CHECK(k_sem_take(&done, K_SECONDS((Updates + 2) * CONFIG_DASHBOARD_UPDATE_RATE)) == 0);
+    TEST_CHECK(std::size(updates) == Updates);
+    TEST_CHECK(!terminal.garbled);
+
+    std::size_t fullBytes = 0;
+    std::size_t fullCount = 0;
+    std::size_t changedBytes = 0;
+    std::size_t changedCount = 0;
+
+    for (std::size_t i = 0; i < std::size(updates); i++)
+    {
+        // The first update draws everything, as nothing's been shown yet,
+        // and every so often everything's sent again
+        bool full = ((i == 0) || (((i + 1) % CONFIG_DASHBOARD_FULL_REDRAW_RATE) == 0));
+
+        TEST_CHECK(updates[i].matched);
+
+        if (full)
+        {
+            fullBytes += updates[i].bytes;
+            fullCount++;
+        }
+        else
+        {
+            changedBytes += updates[i].bytes;
+            changedCount++;
+        }
+
+        printf("update %2zu: %4zu bytes%s\n", i, updates[i].bytes, full ? " (full)" : "");
+    }
+
+    TEST_CHECK((fullCount > 0) && (changedCount > 0));
+
+    if ((fullCount > 0) && (changedCount > 0))
+    {
+        printf("full: avg %zu bytes, changes: avg %zu bytes\n", fullBytes / fullCount, changedBytes / changedCount);
+
+        // A few values changing is a small fraction of the whole dashboard
+        TEST_CHECK((changedBytes / changedCount) * 5 < (fullBytes / fullCount));
+    }
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Render", TestRender);
+
+    Finish();
+}
@@ -0,0 +1,364 @@
+/**
+ * \file
+ *
+ * \brief Measures the socket widget posting for a few widgets against a
+ *        local stand-in server
+ *
+ *  The widget runs as it would on the board, with CONFIG_SOCKET_METRICS
+ *  printing the connect, first byte and cycle times after every cycle along
+ *  with the bytes each widget's data took. That report is read back here,
+ *  checked against what the widgets gave, and the last one printed. The
+ *  number of cycles per run can be given as the only argument:
+ *
+ *      socket_bench [cycles]
+ *
+ *  ctest runs a short pass to keep this building and working; run it by hand
+ *  with more cycles for numbers worth comparing.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/socket.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+#if CONFIG_SOCKET_TRANSPORT_COAP
+#include "support/coap_server.h"
+#else
+#include "support/http_server.h"
+#endif
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // How often the widgets post
+    static constexpr const int32_t Period = 100;
+
+    // A cellular link's round trip, more or less
+    static constexpr const uint32_t Latency = 30;
+
+    /**
+     * \brief A widget that posts the same record every time, and keeps
+     *        track of how much it's given
+     */
+    class Poster : public Socket::Data
+    {
+        private:
+            const char *record;
+
+            std::atomic<uint32_t> calls{0};
+            std::atomic<uint32_t> bytes{0};
+
+        public:
+            /**
+             * \brief Creates a new widget
+             *
+             * \param *record
+             *      What it posts
+             *
+             * \return none
+             */
+            Poster(const char *record):
+                record(record) {}
+
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                strncpy(buffer, this->record, max_length - 1);
+                buffer[max_length - 1] = '\0';
+
+                this->calls++;
+                this->bytes += strlen(buffer);
+            }
+
+            /**
+             * \brief Gets how many times we were asked for our record
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The number of times
+             */
+            uint32_t GetCalls(void) const
+            {
+                return this->calls;
+            }
+
+            /**
+             * \brief Gets how many bytes of records we've given
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The number of bytes
+             */
+            uint32_t GetBytes(void) const
+            {
+                return this->bytes;
+            }
+    };
+
+    // The records of a typical cycle's worth of widget data
+    Poster posters[] = {
+        Poster("accel_x=12&accel_y=-3&accel_z=998"),
+        Poster("button=0"),
+        Poster("rsrp=-97&rsrq=-11&carrier=Verizon&band=13"),
+    };
+
+    // How many cycles to measure
+    uint32_t cycles = 0;
+
+    // Signals the last cycle's report has been read
+    struct k_sem done;
+
+    // Guards everything below, which is filled in as the socket widget
+    // prints
+    std::mutex lock;
+
+    std::string line;
+    std::vector<std::string> report;
+    std::vector<std::string> last;
+
+    uint32_t reports = 0;
+    uint32_t mismatches = 0;
+
+    /**
+     * \brief Checks a widget's byte count in a report against what it gave
+     *
+     *  The socket widget's thread is the one printing the report, so
+     *  nothing's been asked for since the count was printed. Every widget's
+     *  record but the first one posted each cycle is joined to the last with
+     *  an '&', which is counted as its data.
+     *
+     * \param &line
+     *      The report's line for the widget
+     *
+     * \return bool
+     *      Whether or not it was the last widget's line
+     */
+    bool CheckPosted(const std::string &line)
+    {
+        unsigned int index;
+        unsigned int posted;
+
+        if (sscanf(line.c_str(), "Widget %u data: %u bytes total", &index, &posted) != 2)
+        {
+            return false;
+        }
+
+        if (index < std::size(posters))
+        {
+            const Poster &poster = posters[index];
+
+            uint32_t expected = poster.GetBytes() + ((index > 0) ? poster.GetCalls() : 0);
+
+            if (posted != expected)
+            {
+                mismatches++;
+            }
+        }
+
+        return ((index + 1) == std::size(posters));
+    }
+
+    /**
+     * \brief Reads the socket widget's report as it's printed
+     *
+     * \param c
+     *      The character
+     *
+     * \return int
+     *      The character
+     */
+    int Capture(int c)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        if (reports >= cycles)
+        {
+            return c;
+        }
+
+        if (c != '\n')
+        {
+            line += static_cast<char>(c);
+
+            return c;
+        }
+
+        // Each report starts with the connect times
+        if (line.compare(0, 8, "Connect:") == 0)
+        {
+            report.clear();
+        }
+
+        report.push_back(line);
+
+        if (CheckPosted(line))
+        {
+            last = report;
+
+            if (++reports == cycles)
+            {
+                k_sem_give(&done);
+            }
+        }
+
+        line.clear();
+
+        return c;
+    }
+
+    /**
+     * \brief Finds a line in a report
+     *
+     * \param &report
+     *      The report
+     * \param *start
+     *      What the line starts with
+     *
+     * \return const char *
+     *      The line, or an empty string if there isn't one
+     */
+    const char *Find(const std::vector<std::string> &report, const char *start)
+    {
+        for (const std::string &line : report)
+        {
+            if (line.compare(0, strlen(start), start) == 0)
+            {
+                return line.c_str();
+            }
+        }
+
+        return "";
+    }
+}
+
+/**
+ * \brief Runs the measurements
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      Whether or not every cycle's report added up
+ */
+int main(int argc, char *argv[])
+{
+    cycles = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100;
+
+    if (cycles == 0)
+    {
+        cycles = 1;
+    }
+
+    k_sem_init(&done, 0, 1);
+
+    Modem::Reset();
+    Modem::SetNotifications(true);
+
+    Modem::Answer("AT+CEREG=1", "");
+    Modem::Answer("AT+CEREG?", "+CEREG: 1,1,\"0A0B\",\"01234567\",7");
+
+#   if CONFIG_SOCKET_TRANSPORT_COAP
+    const char *name = "CoAP, confirmable";
+
+    CoapServer::Options options;
+#   else
+    const char *name = "HTTP, keep-alive";
+
+    HttpServer::Options options;
+    options.jitter = 10;
+#   endif
+
+    options.latency = Latency;
+    options.port = CONFIG_SOCKET_PORT;
+
+#   if CONFIG_SOCKET_TRANSPORT_COAP
+    CoapServer server(options);
+#   else
+    HttpServer server(options);
+#   endif
+
+    __printk_hook_install(Capture);
+
+    // Its thread never stops, so it's never destroyed
+    Socket *socket = new Socket(*new AtService());
+
+    for (Poster &poster : posters)
+    {
+        socket->RegisterData(poster, Period);
+    }
+
+    TEST_CHECK(k_sem_take(&done, (cycles + 10) * Period * 2) == 0);
+
+    std::lock_guard<std::mutex> guard(lock);
+
+    // Every report's byte counts matched what the widgets gave, and every
+    // cycle was timed
+    TEST_CHECK(reports == cycles);
+    TEST_CHECK(mismatches == 0);
+
+    unsigned int samples = 0;
+
+    TEST_CHECK(sscanf(Find(last, "Cycle:"), "Cycle: p50 %*u ms, p90 %*u ms, max %*u ms (%u samples)", &samples) == 1);
+    TEST_CHECK(samples == std::min<uint32_t>(cycles, Metrics::Depth));
+
+    // What went on the wire covers at least the records and the '&'s
+    // between them
+    std::size_t payload = std::size(posters) - 1;
+
+    for (const Poster &poster : posters)
+    {
+        payload += poster.GetBytes() / std::max<uint32_t>(poster.GetCalls(), 1);
+    }
+
+    unsigned int sent = 0;
+
+    TEST_CHECK(sscanf(Find(last, "Bytes sent this cycle:"), "Bytes sent this cycle: %u", &sent) == 1);
+    TEST_CHECK(sent >= payload);
+
+    printf("%s, %u widgets every %u ms, %u cycles\n",
+        name,
+        static_cast<unsigned int>(std::size(posters)),
+        static_cast<unsigned int>(Period),
+        static_cast<unsigned int>(reports)
+    );
+
+    for (const std::string &line : last)
+    {
+        printf("%s\n", line.c_str());
+    }
+
+    for (std::size_t i = 0; i < std::size(posters); i++)
+    {
+        printf("Widget %u: %u records, %u bytes per record\n",
+            static_cast<unsigned int>(i),
+            static_cast<unsigned int>(posters[i].GetCalls()),
+            static_cast<unsigned int>(posters[i].GetBytes() / std::max<uint32_t>(posters[i].GetCalls(), 1))
+        );
+    }
+
+    printf("\n");
+
+    Finish();
+}
@@ -0,0 +1,223 @@
+/**
+ * \file
+ *
+ * \brief Measures the socket widget's transports against local stand-in
+ *        servers
+ *
+ *  Each transport posts the same records to a stand-in with added latency,
+ *  jitter and loss, and the connect, first byte and cycle times the
+ *  transport records with CONFIG_SOCKET_METRICS are printed along with the
+ *  bytes each post took on the wire. The number of posts per run can be
+ *  given as the only argument:
+ *
+ *      socket_bench_transport [posts]
+ *
+ *  ctest runs a short pass to keep this building and working; run it by hand
+ *  with more posts for numbers worth comparing.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstdlib>
+#include <cstring>
+
+#include <kernel.h>
+
+#include "examples/socket/metrics.h"
+#include "examples/socket/resolver.h"
+#include "examples/socket/transports/coap.h"
+#include "examples/socket/transports/http.h"
+#include "support/coap_server.h"
+#include "support/http_server.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // A record the size of a typical cycle's worth of widget data
+    static constexpr const char Record[] =
+        "accel_x=12&accel_y=-3&accel_z=998&button=0&rsrp=-97&rsrq=-11&carrier=Verizon&band=13";
+
+    // How long to wait for each post's response
+    static constexpr const int32_t ResponseTimeout = 2000;
+
+    /**
+     * \brief Posts a record the way the socket widget does
+     *
+     *  A transport that needs opening is opened, and a failed send gets one
+     *  more try with a fresh transport in case the server dropped the
+     *  connection.
+     *
+     * \param &transport
+     *      The transport to post through
+     *
+     * \return 0
+     *      The record was sent
+     * \return -1
+     *      The record couldn't be sent
+     */
+    int Post(Transport &transport)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            if (transport.NeedsOpen() && (transport.Open() != 0))
+            {
+                return -1;
+            }
+
+            if (transport.Send(Record, strlen(Record)) == 0)
+            {
+                return 0;
+            }
+        }
+
+        return -1;
+    }
+
+    /**
+     * \brief Posts records through a transport and prints how it went
+     *
+     * \param *name
+     *      What's being measured
+     * \param &transport
+     *      The transport to post through
+     * \param posts
+     *      How many records to post
+     *
+     * \return uint32_t
+     *      How many posts got through
+     */
+    uint32_t Measure(const char *name, Transport &transport, uint32_t posts)
+    {
+        Metrics metrics;
+
+        transport.SetMetrics(&metrics);
+
+        for (uint32_t i = 0; i < posts; i++)
+        {
+            int64_t start = k_uptime_get();
+
+            if (Post(transport) == 0)
+            {
+                transport.Service(ResponseTimeout);
+            }
+
+            metrics.cycle.Add(static_cast<uint32_t>(k_uptime_get() - start));
+        }
+
+        transport.SetMetrics(nullptr);
+        transport.Close();
+
+        const Transport::Stats &stats = transport.GetStats();
+
+        printk("%s\n", name);
+
+        metrics.Print();
+
+        printk("Posts: %u succeeded, %u failed, %u timeouts, %u bytes per post\n\n",
+            static_cast<unsigned int>(stats.succeeded),
+            static_cast<unsigned int>(stats.failed),
+            static_cast<unsigned int>(stats.timeouts),
+            static_cast<unsigned int>(stats.bytes / posts)
+        );
+
+        return stats.succeeded;
+    }
+
+    /**
+     * \brief Measures the HTTP transport
+     *
+     * \param *name
+     *      What's being measured
+     * \param &options
+     *      How the stand-in behaves
+     * \param posts
+     *      How many records to post
+     *
+     * \return uint32_t
+     *      How many posts got through
+     */
+    uint32_t MeasureHttp(const char *name, const HttpServer::Options &options, uint32_t posts)
+    {
+        HttpServer server(options);
+        Resolver resolver;
+        HttpTransport transport(resolver, "localhost", server.GetPort());
+
+        return Measure(name, transport, posts);
+    }
+
+    /**
+     * \brief Measures the CoAP transport
+     *
+     * \param *name
+     *      What's being measured
+     * \param &options
+     *      How the stand-in behaves
+     * \param posts
+     *      How many records to post
+     *
+     * \return uint32_t
+     *      How many posts got through
+     */
+    uint32_t MeasureCoap(const char *name, const CoapServer::Options &options, uint32_t posts)
+    {
+        CoapServer server(options);
+        Resolver resolver;
+        CoapTransport transport(resolver, "localhost", server.GetPort());
+
+        return Measure(name, transport, posts);
+    }
+}
+
+/**
+ * \brief Runs the measurements
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      Whether or not every transport got its posts through
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t posts = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100;
+
+    if (posts == 0)
+    {
+        posts = 1;
+    }
+
+    // A cellular link's round trip, more or less
+    static constexpr const uint32_t Latency = 30;
+    static constexpr const uint32_t Jitter = 10;
+
+    HttpServer::Options keepAlive;
+    keepAlive.latency = Latency;
+    keepAlive.jitter = Jitter;
+
+    HttpServer::Options perPost = keepAlive;
+    perPost.requestsPerConnection = 1;
+
+    HttpServer::Options lossy = keepAlive;
+    lossy.loss = 0.1;
+
+    CoapServer::Options coap;
+    coap.latency = Latency;
+
+    // Everything but the lossy run should get every post through
+    TEST_CHECK(MeasureHttp("HTTP, keep-alive", keepAlive, posts) == posts);
+    TEST_CHECK(MeasureHttp("HTTP, a connection per post", perPost, posts) == posts);
+    TEST_CHECK(MeasureHttp("HTTP, keep-alive, 10% of connections dropped", lossy, posts) > 0);
+    TEST_CHECK(MeasureCoap("CoAP, confirmable", coap, posts) == posts);
+
+    Finish();
+}
@@ -0,0 +1,322 @@
+/**
+ * \file
+ *
+ * \brief Tests that the socket widget catches up on queued posts in the
+ *        order they were made
+ *
+ *  A widget posts a count that goes up every cycle while the stand-in server
+ *  comes and goes. Whatever the server gets last is what it shows, so it has
+ *  to get the counts in order, with the newest last, however long it was
+ *  gone for.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/socket.h"
+#include "support/http_server.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // How often the widget posts
+    static constexpr const int32_t Period = 100;
+
+    /**
+     * \brief A widget that posts a count that goes up every time it's asked
+     */
+    class Counter : public Socket::Data
+    {
+        private:
+            std::atomic<uint32_t> count{0};
+            std::atomic<bool> quiet{false};
+
+            /**
+             * \brief Gets the next count, unless we've gone quiet
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The next count, or 0 if there's nothing to post
+             */
+            uint32_t Next(void)
+            {
+                return this->quiet ? 0 : ++this->count;
+            }
+
+        public:
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                uint32_t count = this->Next();
+
+                if (count == 0)
+                {
+                    buffer[0] = '\0';
+
+                    return;
+                }
+
+                snprintf(buffer, max_length, "n=%u", static_cast<unsigned int>(count));
+            }
+
+            std::size_t Collect(Socket::Field *fields, std::size_t count) override
+            {
+                uint32_t next = this->Next();
+
+                if ((next == 0) || (count == 0))
+                {
+                    return 0;
+                }
+
+                fields[0] = {"n", Socket::Field::Type::Integer, static_cast<int32_t>(next), nullptr};
+
+                return 1;
+            }
+
+            /**
+             * \brief Gets the last count posted
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The count
+             */
+            uint32_t GetCount(void) const
+            {
+                return this->count;
+            }
+
+            /**
+             * \brief Sets whether there's anything to post
+             *
+             * \param quiet
+             *      Whether to stop posting
+             *
+             * \return none
+             */
+            void SetQuiet(bool quiet)
+            {
+                this->quiet = quiet;
+            }
+    };
+
+    /**
+     * \brief Gets the widget every test shares
+     *
+     *  Its socket's thread never stops, so everything's made once and never
+     *  destroyed.
+     *
+     * \param none
+     *
+     * \return Counter &
+     *      The widget
+     */
+    Counter &GetCounter(void)
+    {
+        static AtService *service = nullptr;
+        static Counter counter;
+
+        if (service == nullptr)
+        {
+            Modem::Reset();
+            Modem::SetNotifications(true);
+
+            Modem::Answer("AT+CEREG=1", "");
+            Modem::Answer("AT+CEREG?", "+CEREG: 1,1,\"0A0B\",\"01234567\",7");
+
+            service = new AtService();
+
+            Socket *socket = new Socket(*service);
+
+            socket->RegisterData(counter, Period);
+        }
+
+        return counter;
+    }
+
+    /**
+     * \brief Gets the counts the server got, in the order it got them
+     *
+     * \param &server
+     *      The server
+     *
+     * \return std::vector<uint32_t>
+     *      The counts
+     */
+    std::vector<uint32_t> GetCounts(HttpServer &server)
+    {
+        std::vector<uint32_t> counts;
+
+        for (const std::string &target : server.GetTargets())
+        {
+            std::size_t start = target.find("n=");
+
+            if (start != std::string::npos)
+            {
+                counts.push_back(static_cast<uint32_t>(strtoul(&target[start + 2], nullptr, 10)));
+            }
+        }
+
+        return counts;
+    }
+
+    /**
+     * \brief Waits for the server to get the widget's last count
+     *
+     *  The widget goes quiet first, so there's a last count to wait for.
+     *
+     * \param &server
+     *      The server
+     *
+     * \return bool
+     *      Whether or not the server got it in time
+     */
+    bool WaitCaughtUp(HttpServer &server)
+    {
+        Counter &counter = GetCounter();
+
+        counter.SetQuiet(true);
+
+        int64_t end = k_uptime_get() + 5000;
+
+        do
+        {
+            std::vector<uint32_t> counts = GetCounts(server);
+
+            if (!counts.empty() && (counts.back() == counter.GetCount()))
+            {
+                return true;
+            }
+
+            k_sleep(Period);
+        }
+        while (k_uptime_get() < end);
+
+        return false;
+    }
+
+    /**
+     * \brief Checks that counts only ever went up
+     *
+     * \param &counts
+     *      The counts
+     *
+     * \return bool
+     *      Whether or not every count was newer than the last
+     */
+    bool IsInOrder(const std::vector<uint32_t> &counts)
+    {
+        for (std::size_t i = 1; i < counts.size(); i++)
+        {
+            if (counts[i] <= counts[i - 1])
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+/**
+ * \brief Checks that a short outage is caught up on in order, without losing
+ *        anything
+ */
+static void TestShortOutage(void)
+{
+    Counter &counter = GetCounter();
+
+    // Nothing's listening yet, so the first few posts are queued
+    k_sleep(Period * 3 + (Period / 2));
+
+    uint32_t missed = counter.GetCount();
+
+    TEST_CHECK((missed >= 2) && (missed < CONFIG_SOCKET_QUEUE_DEPTH));
+
+    HttpServer::Options options;
+    options.port = CONFIG_SOCKET_PORT;
+
+    HttpServer server(options);
+
+    k_sleep(Period * 4);
+
+    TEST_CHECK(WaitCaughtUp(server));
+
+    std::vector<uint32_t> counts = GetCounts(server);
+
+    // Every count made it, oldest first
+    TEST_CHECK(IsInOrder(counts));
+    TEST_CHECK(!counts.empty() && (counts.front() == 1) && (counts.size() == counter.GetCount()));
+
+    printf("%u missed counts, %u posted in all\n",
+        static_cast<unsigned int>(missed),
+        static_cast<unsigned int>(counts.size())
+    );
+}
+
+/**
+ * \brief Checks that an outage longer than the queue holds still ends with
+ *        the newest count
+ */
+static void TestLongOutage(void)
+{
+    Counter &counter = GetCounter();
+
+    uint32_t first = counter.GetCount();
+
+    counter.SetQuiet(false);
+
+    // The last test's server is gone, so these are queued, and the oldest
+    // are dropped
+    k_sleep(Period * (CONFIG_SOCKET_QUEUE_DEPTH + 4));
+
+    TEST_CHECK((counter.GetCount() - first) > CONFIG_SOCKET_QUEUE_DEPTH);
+
+    HttpServer::Options options;
+    options.port = CONFIG_SOCKET_PORT;
+
+    HttpServer server(options);
+
+    k_sleep(Period * 4);
+
+    TEST_CHECK(WaitCaughtUp(server));
+
+    std::vector<uint32_t> counts = GetCounts(server);
+
+    // Some of the oldest are gone, but what's left is in order
+    TEST_CHECK(IsInOrder(counts));
+    TEST_CHECK(!counts.empty() && (counts.front() > (first + 1)) && (counts.back() == counter.GetCount()));
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("ShortOutage", TestShortOutage);
+    Run("LongOutage", TestLongOutage);
+
+    Finish();
+}
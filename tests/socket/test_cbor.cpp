@@ -0,0 +1,369 @@
+/**
+ * \file
+ *
+ * \brief Tests the CBOR writer and the maps the socket widget posts with it
+ *
+ *  The widget posts to the CoAP stand-in, which keeps each post's payload, so
+ *  the maps can be checked byte for byte.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/cbor.h"
+#include "examples/socket/socket.h"
+#include "support/coap_server.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    using Bytes = std::vector<uint8_t>;
+
+    /**
+     * \brief A widget with a fixed set of fields
+     */
+    class Widget : public Socket::Data
+    {
+        private:
+            std::vector<Socket::Field> fields;
+
+        public:
+            /**
+             * \brief Creates a new widget
+             *
+             * \param fields
+             *      The widget's fields
+             *
+             * \return none
+             */
+            Widget(std::vector<Socket::Field> fields):
+                fields(fields) {}
+
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                buffer[0] = '\0';
+            }
+
+            std::size_t Collect(Socket::Field *fields, std::size_t count) override
+            {
+                std::size_t collected = std::min(count, std::size(this->fields));
+
+                std::copy(this->fields.begin(), this->fields.begin() + collected, fields);
+
+                return collected;
+            }
+    };
+
+    /**
+     * \brief Makes an integer field
+     *
+     * \param *name
+     *      The field's name
+     * \param value
+     *      The field's value
+     *
+     * \return Socket::Field
+     *      The field
+     */
+    Socket::Field Integer(const char *name, int32_t value)
+    {
+        return {name, Socket::Field::Type::Integer, value, nullptr};
+    }
+
+    /**
+     * \brief Makes a string field
+     *
+     * \param *name
+     *      The field's name
+     * \param *value
+     *      The field's value
+     *
+     * \return Socket::Field
+     *      The field
+     */
+    Socket::Field String(const char *name, const char *value)
+    {
+        return {name, Socket::Field::Type::String, 0, value};
+    }
+
+    /**
+     * \brief Encodes a text string the way the writer should
+     *
+     * \param &string
+     *      The string
+     *
+     * \return Bytes
+     *      The encoded string
+     */
+    Bytes Text(const std::string &string)
+    {
+        Bytes bytes;
+
+        if (string.size() < 24)
+        {
+            bytes.push_back(static_cast<uint8_t>(0x60 | string.size()));
+        }
+        else if (string.size() <= UINT8_MAX)
+        {
+            bytes = {0x78, static_cast<uint8_t>(string.size())};
+        }
+        else
+        {
+            bytes = {0x79, static_cast<uint8_t>(string.size() >> 8), static_cast<uint8_t>(string.size())};
+        }
+
+        bytes.insert(bytes.end(), string.begin(), string.end());
+
+        return bytes;
+    }
+
+    /**
+     * \brief Encodes a single integer with the writer
+     *
+     * \param value
+     *      The integer
+     *
+     * \return Bytes
+     *      What the writer wrote
+     */
+    Bytes Encode(int32_t value)
+    {
+        uint8_t buffer[8];
+
+        CborWriter writer(buffer, sizeof(buffer));
+
+        writer.Integer(value);
+
+        return Bytes(buffer, buffer + writer.GetLength());
+    }
+
+    /**
+     * \brief Joins encoded items together
+     *
+     * \param items
+     *      The items
+     *
+     * \return Bytes
+     *      The items, in order
+     */
+    Bytes Join(std::initializer_list<Bytes> items)
+    {
+        Bytes bytes;
+
+        for (const Bytes &item : items)
+        {
+            bytes.insert(bytes.end(), item.begin(), item.end());
+        }
+
+        return bytes;
+    }
+
+    // Strings that fill up most of a post, and one that can't fit in one at
+    // all
+    const std::string Large(1200, 'a');
+    const std::string Larger(1300, 'b');
+    const std::string Huge(MAX_TRANSMISSION, 'c');
+
+    // Widgets with small fields of every size, then ones that don't all fit
+    // in one post
+    Widget Small({Integer("x", -3), Integer("y", 1000), Integer("z", 70000)});
+    Widget Mixed({String("name", "abc"), Integer("neg", -500)});
+    Widget Big({String("big", Large.c_str())});
+    Widget Bigger({String("bigger", Larger.c_str())});
+    Widget TooBig({String("huge", Huge.c_str())});
+}
+
+/**
+ * \brief Checks integers are written with the smallest header that fits
+ */
+static void TestIntegers(void)
+{
+    TEST_CHECK(Encode(0) == Bytes({0x00}));
+    TEST_CHECK(Encode(23) == Bytes({0x17}));
+    TEST_CHECK(Encode(24) == Bytes({0x18, 0x18}));
+    TEST_CHECK(Encode(255) == Bytes({0x18, 0xFF}));
+    TEST_CHECK(Encode(256) == Bytes({0x19, 0x01, 0x00}));
+    TEST_CHECK(Encode(65535) == Bytes({0x19, 0xFF, 0xFF}));
+    TEST_CHECK(Encode(65536) == Bytes({0x1A, 0x00, 0x01, 0x00, 0x00}));
+    TEST_CHECK(Encode(INT32_MAX) == Bytes({0x1A, 0x7F, 0xFF, 0xFF, 0xFF}));
+
+    // Negative integers are -1 - n
+    TEST_CHECK(Encode(-1) == Bytes({0x20}));
+    TEST_CHECK(Encode(-24) == Bytes({0x37}));
+    TEST_CHECK(Encode(-25) == Bytes({0x38, 0x18}));
+    TEST_CHECK(Encode(-256) == Bytes({0x38, 0xFF}));
+    TEST_CHECK(Encode(-257) == Bytes({0x39, 0x01, 0x00}));
+    TEST_CHECK(Encode(-65537) == Bytes({0x3A, 0x00, 0x01, 0x00, 0x00}));
+    TEST_CHECK(Encode(INT32_MIN) == Bytes({0x3A, 0x7F, 0xFF, 0xFF, 0xFF}));
+}
+
+/**
+ * \brief Checks strings are written with their length
+ */
+static void TestStrings(void)
+{
+    uint8_t buffer[400];
+
+    CborWriter writer(buffer, sizeof(buffer));
+
+    writer.String("");
+    writer.String("rsrp");
+    writer.String(std::string(24, 's'));
+    writer.String(std::string(300, 'l'));
+
+    TEST_CHECK(writer.IsValid());
+    TEST_CHECK(Bytes(buffer, buffer + writer.GetLength()) == Join({
+        Text(""),
+        Text("rsrp"),
+        Text(std::string(24, 's')),
+        Text(std::string(300, 'l')),
+    }));
+}
+
+/**
+ * \brief Checks that running out of room is caught, and that nothing's
+ *        written past the end
+ */
+static void TestOverflow(void)
+{
+    uint8_t buffer[8] = {0};
+
+    // Exactly filling the buffer still counts
+    CborWriter full(buffer, 2);
+
+    full.Integer(24);
+
+    TEST_CHECK(full.IsValid());
+    TEST_CHECK(full.GetLength() == 2);
+
+    buffer[0] = 0;
+    buffer[1] = 0;
+
+    // Writing starts after what's already there
+    CborWriter writer(buffer, 7, 1);
+
+    writer.String("ab");
+    writer.Integer(-2);
+
+    TEST_CHECK(writer.IsValid());
+    TEST_CHECK(writer.GetLength() == 5);
+
+    writer.Integer(1000);
+
+    TEST_CHECK(!writer.IsValid());
+    TEST_CHECK(writer.GetLength() == 5);
+
+    // Once something hasn't fit, nothing more goes in, even if it would
+    writer.Integer(1);
+
+    TEST_CHECK(!writer.IsValid());
+    TEST_CHECK(writer.GetLength() == 5);
+    TEST_CHECK((buffer[0] == 0) && (buffer[5] == 0) && (buffer[6] == 0) && (buffer[7] == 0));
+}
+
+/**
+ * \brief Checks the maps the widget posts, and how they're split up when
+ *        they don't fit in one post
+ */
+static void TestPosts(void)
+{
+    Modem::Reset();
+    Modem::SetNotifications(true);
+
+    Modem::Answer("AT+CEREG=1", "");
+    Modem::Answer("AT+CEREG?", "+CEREG: 1,1,\"0A0B\",\"01234567\",7");
+
+    CoapServer::Options options;
+    options.port = CONFIG_SOCKET_PORT;
+
+    CoapServer server(options);
+
+    // Its thread never stops, so it's never destroyed
+    Socket *socket = new Socket(*new AtService());
+
+    socket->RegisterData(Small, 200);
+    socket->RegisterData(Mixed, 200);
+    socket->RegisterData(Big, 200);
+    socket->RegisterData(Bigger, 200);
+    socket->RegisterData(TooBig, 200);
+
+    int64_t end = k_uptime_get() + 5000;
+
+    while ((server.GetPayloads().size() < 2) && (k_uptime_get() < end))
+    {
+        k_sleep(10);
+    }
+
+    std::vector<std::string> payloads = server.GetPayloads();
+
+    TEST_CHECK(payloads.size() >= 2);
+
+    if (payloads.size() < 2)
+    {
+        return;
+    }
+
+    // Everything up to the widget that doesn't fit goes in the first map
+    Bytes first = Join({
+        {CborWriter::MapStart},
+        Text("x"), Encode(-3),
+        Text("y"), {0x19, 0x03, 0xE8},
+        Text("z"), {0x1A, 0x00, 0x01, 0x11, 0x70},
+        Text("name"), Text("abc"),
+        Text("neg"), {0x39, 0x01, 0xF3},
+        Text("big"), Text(Large),
+        {CborWriter::Break},
+    });
+
+    // The widget that didn't fit starts the next one, and the one that can't
+    // fit in any is left out
+    Bytes second = Join({
+        {CborWriter::MapStart},
+        Text("bigger"), Text(Larger),
+        {CborWriter::Break},
+    });
+
+    TEST_CHECK(Bytes(payloads[0].begin(), payloads[0].end()) == first);
+    TEST_CHECK(Bytes(payloads[1].begin(), payloads[1].end()) == second);
+
+    // Every map fits in a post
+    for (const std::string &payload : payloads)
+    {
+        TEST_CHECK(payload.size() <= MAX_TRANSMISSION);
+    }
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Integers", TestIntegers);
+    Run("Strings", TestStrings);
+    Run("Overflow", TestOverflow);
+    Run("Posts", TestPosts);
+
+    Finish();
+}
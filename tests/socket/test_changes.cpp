@@ -0,0 +1,577 @@
+/**
+ * \file
+ *
+ * \brief Tests that only changed fields are posted, and only once the server
+ *        has acknowledged them are they left out
+ *
+ *  The change filter is checked on its own, and then the socket widget posts
+ *  through it to the stand-in server while the server fails, stalls and
+ *  finally answers.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/changes.h"
+#include "examples/socket/socket.h"
+#include "support/http_server.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // How often the widgets post
+    static constexpr const int32_t Period = 100;
+
+    // How long to let the widgets post for, to see what they send
+    static constexpr const int32_t Cycles = Period * 6;
+
+    // How far the sensor's value can move before it's posted again
+    static constexpr const int32_t Deadband = 2;
+
+    /**
+     * \brief Makes an integer field
+     *
+     * \param *name
+     *      The field's name
+     * \param value
+     *      The field's value
+     * \param deadband
+     *      How far the field can move before it's worth posting
+     * \param relative
+     *      Whether the deadband is a percentage
+     *
+     * \return Field
+     *      The field
+     */
+    Field Integer(const char *name, int32_t value, int32_t deadband = 0, bool relative = false)
+    {
+        return {name, Field::Type::Integer, value, nullptr, deadband, relative};
+    }
+
+    /**
+     * \brief Makes a string field
+     *
+     * \param *name
+     *      The field's name
+     * \param *value
+     *      The field's value
+     *
+     * \return Field
+     *      The field
+     */
+    Field String(const char *name, const char *value)
+    {
+        return {name, Field::Type::String, 0, value};
+    }
+
+    /**
+     * \brief Filters a set of fields, and gets the names of the ones kept
+     *
+     * \param &filter
+     *      The filter
+     * \param slot
+     *      Which widget the fields are from
+     * \param fields
+     *      The fields
+     *
+     * \return std::string
+     *      The names of the fields kept, in order
+     */
+    template <typename Filter>
+    std::string Kept(Filter &filter, std::size_t slot, std::vector<Field> fields)
+    {
+        std::size_t count = filter.Filter(slot, fields.data(), fields.size());
+
+        std::string names;
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            names += fields[i].name;
+        }
+
+        return names;
+    }
+
+    /**
+     * \brief A widget with one value that moves when the test says
+     */
+    class Sensor : public Socket::Data
+    {
+        private:
+            std::atomic<int32_t> value{1};
+
+        public:
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                buffer[0] = '\0';
+            }
+
+            std::size_t Collect(Socket::Field *fields, std::size_t count) override
+            {
+                fields[0] = Integer("a", this->value, Deadband);
+
+                return 1;
+            }
+
+            /**
+             * \brief Sets the widget's value
+             *
+             * \param value
+             *      The value
+             *
+             * \return none
+             */
+            void Set(int32_t value)
+            {
+                this->value = value;
+            }
+    };
+
+    /**
+     * \brief A widget with a large string that changes every cycle, and
+     *        counts how many times it's asked for it
+     */
+    class Blob : public Socket::Data
+    {
+        private:
+            const char *name;
+            std::string value;
+
+            std::atomic<bool> active{false};
+            std::atomic<uint32_t> collected{0};
+
+        public:
+            /**
+             * \brief Creates a new widget
+             *
+             * \param *name
+             *      The name of its field
+             * \param length
+             *      How long its value is
+             *
+             * \return none
+             */
+            Blob(const char *name, std::size_t length):
+                name(name),
+                value(length, 'a') {}
+
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                buffer[0] = '\0';
+            }
+
+            std::size_t Collect(Socket::Field *fields, std::size_t count) override
+            {
+                if (!this->active)
+                {
+                    return 0;
+                }
+
+                this->collected++;
+
+                // Only the widget's thread touches the value once we're
+                // active
+                this->value[0] = (this->value[0] == 'z') ? 'a' : (this->value[0] + 1);
+
+                fields[0] = String(this->name, this->value.c_str());
+
+                return 1;
+            }
+
+            /**
+             * \brief Starts posting
+             *
+             * \param none
+             *
+             * \return none
+             */
+            void Start(void)
+            {
+                this->active = true;
+            }
+
+            /**
+             * \brief Gets how many times we were asked for our fields
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The number of times
+             */
+            uint32_t GetCollected(void) const
+            {
+                return this->collected;
+            }
+    };
+
+    Sensor sensor;
+
+    // A pair that won't fit in one post together
+    Blob first("first", 1200);
+    Blob second("second", 1200);
+
+    /**
+     * \brief Starts the socket widget, if it hasn't been already
+     *
+     *  Its thread never stops, so everything's made once and never
+     *  destroyed.
+     *
+     * \param none
+     *
+     * \return none
+     */
+    void Start(void)
+    {
+        static Socket *socket = nullptr;
+
+        if (socket != nullptr)
+        {
+            return;
+        }
+
+        Modem::Reset();
+        Modem::SetNotifications(true);
+
+        Modem::Answer("AT+CEREG=1", "");
+        Modem::Answer("AT+CEREG?", "+CEREG: 1,1,\"0A0B\",\"01234567\",7");
+
+        socket = new Socket(*new AtService());
+
+        socket->RegisterData(sensor, Period);
+        socket->RegisterData(first, Period);
+        socket->RegisterData(second, Period);
+    }
+
+    /**
+     * \brief Gets the query strings the server got, in the order it got them
+     *
+     * \param &server
+     *      The server
+     *
+     * \return std::vector<std::string>
+     *      The query strings
+     */
+    std::vector<std::string> GetQueries(HttpServer &server)
+    {
+        std::vector<std::string> queries;
+
+        for (const std::string &target : server.GetTargets())
+        {
+            std::size_t start = target.find('?');
+
+            queries.push_back((start != std::string::npos) ? target.substr(start + 1) : "");
+        }
+
+        return queries;
+    }
+
+    /**
+     * \brief Checks that every query string is the same one
+     *
+     * \param &queries
+     *      The query strings
+     * \param &query
+     *      The query string they should all be
+     *
+     * \return bool
+     *      Whether or not they're all the same
+     */
+    bool AllAre(const std::vector<std::string> &queries, const std::string &query)
+    {
+        for (const std::string &posted : queries)
+        {
+            if (posted != query)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Starts a stand-in server where the widget posts to
+     *
+     * \param options
+     *      How the server behaves
+     *
+     * \return HttpServer *
+     *      The server
+     */
+    HttpServer *Serve(HttpServer::Options options)
+    {
+        options.port = CONFIG_SOCKET_PORT;
+
+        return new HttpServer(options);
+    }
+}
+
+/**
+ * \brief Checks that integers are only kept when they move past their
+ *        deadband, and strings whenever they change
+ */
+static void TestDeadband(void)
+{
+    ChangeFilter<2, 4> filter(K_SECONDS(3600));
+
+    // Nothing's been acknowledged, so everything's new
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 10, 5), String("b", "x")}) == "ab");
+
+    filter.Commit();
+
+    // Within the deadband, or exactly on it, isn't a change
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 15, 5), String("b", "x")}) == "");
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 5, 5), String("b", "x")}) == "");
+
+    // Past it is, either way
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 16, 5), String("b", "x")}) == "a");
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 4, 5), String("b", "y")}) == "ab");
+
+    // Without a commit, changes are still measured from what was last
+    // acknowledged
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 16, 5), String("b", "x")}) == "a");
+
+    filter.Commit();
+
+    // But with one, they're measured from what was sent
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 20, 5), String("b", "x")}) == "");
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 22, 5), String("b", "x")}) == "a");
+
+    // A widget with a different number of fields starts over, and a field
+    // with a different name has changed
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 16, 5)}) == "a");
+    TEST_CHECK(Kept(filter, 0, {Integer("c", 16, 5), String("b", "x")}) == "c");
+
+    // Widgets are kept track of on their own
+    TEST_CHECK(Kept(filter, 1, {Integer("a", 16, 5), String("b", "x")}) == "ab");
+}
+
+/**
+ * \brief Checks deadbands that are a percentage of what was last
+ *        acknowledged
+ */
+static void TestRelative(void)
+{
+    ChangeFilter<1, 2> filter(K_SECONDS(3600));
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 200, 10, true), Integer("b", -200, 10, true)}) == "ab");
+
+    filter.Commit();
+
+    // 10% of 200 either way, whatever the sign
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 220, 10, true), Integer("b", -180, 10, true)}) == "");
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 221, 10, true), Integer("b", -221, 10, true)}) == "ab");
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 179, 10, true), Integer("b", -200, 10, true)}) == "a");
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 0, 10, true), Integer("b", 0, 10, true)}) == "ab");
+
+    filter.Commit();
+
+    // Any change from 0 is past a percentage of it
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 0, 10, true), Integer("b", 1, 10, true)}) == "b");
+}
+
+/**
+ * \brief Checks that every field is sent once the heartbeat's due
+ */
+static void TestHeartbeat(void)
+{
+    static constexpr const int32_t Rate = 300;
+
+    ChangeFilter<2, 2> filter(Rate);
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 1), Integer("b", 2)}) == "ab");
+    TEST_CHECK(Kept(filter, 1, {Integer("c", 3)}) == "c");
+    TEST_CHECK(filter.GetHeartbeats() == 2);
+
+    filter.Commit();
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 1), Integer("b", 2)}) == "");
+    TEST_CHECK(filter.GetHeartbeats() == 0);
+
+    k_sleep(Rate + 50);
+
+    // Nothing changed, but it's been long enough
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 1), Integer("b", 2)}) == "ab");
+    TEST_CHECK(filter.GetHeartbeats() == 1);
+
+    // A heartbeat that isn't acknowledged is sent again
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 1), Integer("b", 2)}) == "ab");
+
+    filter.Commit();
+
+    filter.Begin();
+
+    TEST_CHECK(Kept(filter, 0, {Integer("a", 1), Integer("b", 2)}) == "");
+    TEST_CHECK(Kept(filter, 1, {Integer("c", 3)}) == "c");
+    TEST_CHECK(filter.GetHeartbeats() == 1);
+}
+
+/**
+ * \brief Checks that fields the server turned down are sent again
+ */
+static void TestFailed(void)
+{
+    HttpServer::Options options;
+    options.fail = 1;
+
+    HttpServer *server = Serve(options);
+
+    Start();
+
+    k_sleep(Cycles);
+
+    std::vector<std::string> queries = GetQueries(*server);
+
+    // Nothing changed, but nothing was acknowledged either
+    TEST_CHECK(queries.size() >= 3);
+    TEST_CHECK(AllAre(queries, "a=1"));
+
+    delete server;
+}
+
+/**
+ * \brief Checks that fields whose response never came are sent again
+ */
+static void TestTimedOut(void)
+{
+    HttpServer::Options options;
+    options.latency = CONFIG_SOCKET_RESPONSE_TIMEOUT * 2;
+
+    HttpServer *server = Serve(options);
+
+    k_sleep(CONFIG_SOCKET_RESPONSE_TIMEOUT * 5);
+
+    std::vector<std::string> queries = GetQueries(*server);
+
+    TEST_CHECK(queries.size() >= 2);
+    TEST_CHECK(AllAre(queries, "a=1"));
+
+    delete server;
+}
+
+/**
+ * \brief Checks that once fields are acknowledged, only changes past their
+ *        deadband are sent
+ */
+static void TestAcknowledged(void)
+{
+    HttpServer *server = Serve(HttpServer::Options());
+
+    k_sleep(Cycles);
+
+    // The first post is acknowledged, and there's been nothing new since
+    TEST_CHECK(GetQueries(*server) == std::vector<std::string>({"a=1"}));
+
+    sensor.Set(1 + Deadband);
+
+    k_sleep(Cycles);
+
+    TEST_CHECK(GetQueries(*server).size() == 1);
+
+    sensor.Set(1 + Deadband + 1);
+
+    k_sleep(Cycles);
+
+    TEST_CHECK(GetQueries(*server) == std::vector<std::string>({"a=1", "a=4"}));
+
+    delete server;
+}
+
+/**
+ * \brief Checks that a widget whose data starts a new post is only asked
+ *        for it once
+ */
+static void TestOverflow(void)
+{
+    HttpServer *server = Serve(HttpServer::Options());
+
+    first.Start();
+    second.Start();
+
+    k_sleep(Cycles);
+
+    std::vector<std::string> queries = GetQueries(*server);
+
+    uint32_t cycles = first.GetCollected();
+
+    TEST_CHECK(cycles >= 3);
+
+    // Either one hasn't been asked yet this cycle, or both have
+    TEST_CHECK((second.GetCollected() == cycles) || ((second.GetCollected() + 1) == cycles));
+
+    // Both change every cycle, and each takes a post of its own
+    TEST_CHECK(queries.size() >= (2 * (cycles - 1)));
+
+    for (const std::string &query : queries)
+    {
+        TEST_CHECK((query.compare(0, 6, "first=") == 0) || (query.compare(0, 7, "second=") == 0));
+    }
+
+    delete server;
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Deadband", TestDeadband);
+    Run("Relative", TestRelative);
+    Run("Heartbeat", TestHeartbeat);
+
+    // These run in order against the one widget
+    Run("Failed", TestFailed);
+    Run("TimedOut", TestTimedOut);
+    Run("Acknowledged", TestAcknowledged);
+    Run("Overflow", TestOverflow);
+
+    Finish();
+}
@@ -0,0 +1,204 @@
+/**
+ * \file
+ *
+ * \brief Tests the CoAP transport against a local stand-in server
+ *
+ *  This is built both with and without CONFIG_SOCKET_COAP_CONFIRMABLE.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstring>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/socket/resolver.h"
+#include "examples/socket/transports/coap.h"
+#include "support/coap_server.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // Where every post goes
+    const std::string Path = "dweet/for/skywire_nano_socket_dial_widget";
+
+    // More than fits in one block, and not a multiple of the block size
+    const std::string Large(CONFIG_SOCKET_COAP_BLOCK_SIZE * 2 + 5, 'x');
+
+    static constexpr const uint8_t BadRequest = (4 << 5) | 0;
+
+    /**
+     * \brief Posts data and picks up any response
+     *
+     * \param &transport
+     *      The transport to post with
+     * \param &data
+     *      The data to post
+     *
+     * \return 0
+     *      The data reached the server
+     * \return -1
+     *      The data couldn't be sent
+     */
+    int Post(CoapTransport &transport, const std::string &data)
+    {
+        if ((transport.Open() != 0) || (transport.Send(data.c_str(), data.size()) != 0))
+        {
+            return -1;
+        }
+
+        return transport.Service(100);
+    }
+}
+
+/**
+ * \brief Checks that a post gets to the server and is counted
+ */
+static void TestPost(void)
+{
+    CoapServer server;
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+    TEST_CHECK(Post(transport, "b=2") == 0);
+
+    TEST_CHECK(server.GetPath() == Path);
+    TEST_CHECK(server.GetPayloads() == std::vector<std::string>({"a=1", "b=2"}));
+
+    TEST_CHECK(transport.GetStats().succeeded == 2);
+    TEST_CHECK(transport.GetStats().failed == 0);
+    TEST_CHECK(transport.GetStats().bytes == server.GetTotals().bytes);
+}
+
+/**
+ * \brief Checks that a large post is sent a block at a time
+ */
+static void TestBlockWise(void)
+{
+    CoapServer server;
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, Large) == 0);
+
+    TEST_CHECK(server.GetTotals().messages == 3);
+    TEST_CHECK(server.GetPayloads() == std::vector<std::string>({Large}));
+
+    TEST_CHECK(transport.GetStats().succeeded == 1);
+    TEST_CHECK(transport.GetStats().failed == 0);
+}
+
+/**
+ * \brief Checks that a post the server rejects is counted as failed, but is
+ *        still reported as sent so that it isn't retried or queued
+ */
+static void TestRejected(void)
+{
+    CoapServer::Options options;
+    options.code = BadRequest;
+
+    CoapServer server(options);
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+
+    TEST_CHECK(server.GetTotals().messages == 1);
+
+    TEST_CHECK(transport.GetStats().succeeded == 0);
+    TEST_CHECK(transport.GetStats().failed == 1);
+    TEST_CHECK(transport.GetStats().timeouts == 0);
+}
+
+#if CONFIG_SOCKET_COAP_CONFIRMABLE
+/**
+ * \brief Checks that a block-wise post stops at the first rejected block
+ */
+static void TestRejectedBlock(void)
+{
+    CoapServer::Options options;
+    options.code = BadRequest;
+
+    CoapServer server(options);
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, Large) == 0);
+
+    TEST_CHECK(server.GetTotals().messages == 1);
+
+    TEST_CHECK(transport.GetStats().failed == 1);
+}
+
+/**
+ * \brief Checks that a post the server resets is treated like a rejection
+ */
+static void TestReset(void)
+{
+    CoapServer::Options options;
+    options.reset = true;
+
+    CoapServer server(options);
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+
+    TEST_CHECK(transport.GetStats().succeeded == 0);
+    TEST_CHECK(transport.GetStats().failed == 1);
+}
+
+/**
+ * \brief Checks that a post that isn't acknowledged is sent again
+ */
+static void TestRetransmit(void)
+{
+    CoapServer::Options options;
+    options.drop = 1;
+
+    CoapServer server(options);
+    Resolver resolver;
+    CoapTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+
+    TEST_CHECK(server.GetTotals().dropped == 1);
+    TEST_CHECK(server.GetTotals().messages == 1);
+
+    TEST_CHECK(transport.GetStats().succeeded == 1);
+    TEST_CHECK(transport.GetStats().bytes == (server.GetTotals().bytes * 2));
+}
+#endif
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Post", TestPost);
+    Run("BlockWise", TestBlockWise);
+    Run("Rejected", TestRejected);
+
+#   if CONFIG_SOCKET_COAP_CONFIRMABLE
+    Run("RejectedBlock", TestRejectedBlock);
+    Run("Reset", TestReset);
+    Run("Retransmit", TestRetransmit);
+#   endif
+
+    Finish();
+}
@@ -0,0 +1,261 @@
+/**
+ * \file
+ *
+ * \brief Tests the HTTP transport's keep-alive connection against a local
+ *        stand-in server
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstring>
+#include <string>
+
+#include <kernel.h>
+
+#include "examples/socket/resolver.h"
+#include "examples/socket/transports/http.h"
+#include "support/http_server.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // Where every request goes, ahead of its query string
+    const std::string Target = "/dweet/for/skywire_nano_socket_dial_widget";
+
+    /**
+     * \brief Posts a query string and waits for its response
+     *
+     * \param &transport
+     *      The transport to post with
+     * \param *data
+     *      The query string
+     *
+     * \return 0
+     *      The post was sent and the connection is still open
+     * \return -1
+     *      The post failed or the connection was closed
+     */
+    int Post(HttpTransport &transport, const char *data)
+    {
+        if ((transport.Open() != 0) || (transport.Send(data, strlen(data)) != 0))
+        {
+            return -1;
+        }
+
+        return transport.Service(1000);
+    }
+}
+
+/**
+ * \brief Checks that posts share one connection
+ */
+static void TestKeepAlive(void)
+{
+    HttpServer server;
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    // Nothing is opened until it's needed
+    TEST_CHECK(!transport.IsOpen());
+    TEST_CHECK(transport.NeedsOpen());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+    TEST_CHECK(Post(transport, "b=2") == 0);
+    TEST_CHECK(Post(transport, "c=3") == 0);
+
+    TEST_CHECK(!transport.NeedsOpen());
+
+    HttpServer::Totals totals = server.GetTotals();
+
+    TEST_CHECK(totals.connections == 1);
+    TEST_CHECK(totals.requests == 3);
+
+    TEST_CHECK(transport.GetStats().succeeded == 3);
+    TEST_CHECK(transport.GetStats().failed == 0);
+
+    // The host was only looked up for the one connect
+    TEST_CHECK(resolver.GetStats().misses == 1);
+    TEST_CHECK(resolver.GetStats().hits == 0);
+
+    std::vector<std::string> targets = server.GetTargets();
+
+    TEST_CHECK((targets.size() == 3) && (targets[0] == (Target + "?a=1")) && (targets[2] == (Target + "?c=3")));
+}
+
+/**
+ * \brief Checks that a connection the server closed is noticed and replaced
+ */
+static void TestPeerClose(void)
+{
+    HttpServer::Options options;
+    options.requestsPerConnection = 1;
+    options.announceClose = false;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+
+    // Give the server time to hang up
+    k_sleep(100);
+
+    TEST_CHECK(transport.NeedsOpen());
+    TEST_CHECK(!transport.IsOpen());
+
+    TEST_CHECK(Post(transport, "b=2") == 0);
+
+    TEST_CHECK(server.GetTotals().connections == 2);
+    TEST_CHECK(transport.GetStats().succeeded == 2);
+    TEST_CHECK(transport.GetStats().failed == 0);
+}
+
+/**
+ * \brief Checks that a connection the server says it's closing isn't used
+ *        again
+ */
+static void TestAnnouncedClose(void)
+{
+    HttpServer::Options options;
+    options.requestsPerConnection = 1;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    // No waiting between posts, so the hang up can't be noticed any other way
+    for (int i = 0; i < 20; i++)
+    {
+        TEST_CHECK((transport.Open() == 0) && (transport.Send("a=1", 3) == 0));
+
+        // The response is handled, and then the connection's let go
+        TEST_CHECK(transport.Service(1000) == -1);
+        TEST_CHECK(!transport.IsOpen());
+    }
+
+    TEST_CHECK(server.GetTotals().connections == 20);
+    TEST_CHECK(transport.GetStats().succeeded == 20);
+    TEST_CHECK(transport.GetStats().failed == 0);
+}
+
+/**
+ * \brief Checks that an error status is counted without dropping the
+ *        connection
+ */
+static void TestErrorStatus(void)
+{
+    HttpServer::Options options;
+    options.fail = 1;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == 0);
+
+    TEST_CHECK(!transport.NeedsOpen());
+    TEST_CHECK(transport.GetStats().succeeded == 0);
+    TEST_CHECK(transport.GetStats().failed == 1);
+}
+
+/**
+ * \brief Checks that a request the server never answers is counted as failed
+ */
+static void TestDropped(void)
+{
+    HttpServer::Options options;
+    options.loss = 1;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(Post(transport, "a=1") == -1);
+
+    TEST_CHECK(!transport.IsOpen());
+    TEST_CHECK(transport.GetStats().failed == 1);
+}
+
+/**
+ * \brief Checks that requests can be sent before earlier ones are answered
+ */
+static void TestPipelined(void)
+{
+    HttpServer::Options options;
+    options.latency = 20;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(transport.Open() == 0);
+
+    // One more than can be waiting at once, so the last send has to wait for
+    // the first response
+    for (std::size_t i = 0; i <= Connection::MaxPending; i++)
+    {
+        TEST_CHECK(transport.Send("a=1", 3) == 0);
+    }
+
+    TEST_CHECK(transport.Service(2000) == 0);
+
+    TEST_CHECK(server.GetTotals().connections == 1);
+    TEST_CHECK(transport.GetStats().succeeded == (Connection::MaxPending + 1));
+}
+
+/**
+ * \brief Checks that pipelined requests each get the full response timeout
+ *
+ *  The server answers in order, so each response can only start once the one
+ *  ahead of it is done.
+ */
+static void TestPipelinedTimeout(void)
+{
+    HttpServer::Options options;
+    options.latency = (CONFIG_SOCKET_RESPONSE_TIMEOUT * 2) / 3;
+
+    HttpServer server(options);
+    Resolver resolver;
+    HttpTransport transport(resolver, "localhost", server.GetPort());
+
+    TEST_CHECK(transport.Open() == 0);
+
+    for (std::size_t i = 0; i < Connection::MaxPending; i++)
+    {
+        TEST_CHECK(transport.Send("a=1", 3) == 0);
+    }
+
+    TEST_CHECK(transport.Service(CONFIG_SOCKET_RESPONSE_TIMEOUT * Connection::MaxPending) == 0);
+
+    TEST_CHECK(transport.GetStats().succeeded == Connection::MaxPending);
+    TEST_CHECK(transport.GetStats().timeouts == 0);
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("KeepAlive", TestKeepAlive);
+    Run("PeerClose", TestPeerClose);
+    Run("AnnouncedClose", TestAnnouncedClose);
+    Run("ErrorStatus", TestErrorStatus);
+    Run("Dropped", TestDropped);
+    Run("Pipelined", TestPipelined);
+    Run("PipelinedTimeout", TestPipelinedTimeout);
+
+    Finish();
+}
@@ -0,0 +1,186 @@
+/**
+ * \file
+ *
+ * \brief Tests network registration tracking against a scripted modem's
+ *        +CEREG responses and notifications
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <thread>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/network.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    /**
+     * \brief Gets the AT service every test shares
+     *
+     *  Its thread never stops, so it's made once and never destroyed.
+     *
+     * \param none
+     *
+     * \return AtService &
+     *      The AT service
+     */
+    AtService &GetService(void)
+    {
+        static AtService service;
+
+        return service;
+    }
+
+    /**
+     * \brief Sets up a modem that's searching for a network
+     *
+     * \param notifications
+     *      Whether or not the modem can send notifications
+     *
+     * \return none
+     */
+    void Searching(bool notifications)
+    {
+        Modem::Reset();
+        Modem::SetNotifications(notifications);
+
+        Modem::Answer("AT+CEREG=1", "");
+        Modem::Answer("AT+CEREG?", "+CEREG: 1,2,\"0A0B\",\"01234567\",7");
+    }
+
+    /**
+     * \brief Sends a notification after a while, from another thread
+     *
+     * \param delay
+     *      How long to wait before sending it, in milliseconds
+     * \param notification
+     *      The notification
+     *
+     * \return std::thread
+     *      The thread sending the notification
+     */
+    std::thread NotifyLater(int32_t delay, std::string_view notification)
+    {
+        return std::thread([delay, notification](void) {
+            k_sleep(delay);
+
+            Modem::Notify(notification);
+        });
+    }
+}
+
+/**
+ * \brief Checks that registration follows +CEREG notifications without
+ *        asking the modem
+ */
+static void TestNotified(void)
+{
+    Searching(true);
+
+    Network network(GetService());
+
+    TEST_CHECK(network.Init() == 0);
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Searching);
+    TEST_CHECK(!network.IsRegistered());
+
+    std::thread notifier = NotifyLater(50, "+CEREG: 1,\"0A0B\",\"01234567\",7");
+
+    int64_t start = k_uptime_get();
+
+    TEST_CHECK(network.WaitRegistered(2000));
+
+    notifier.join();
+
+    // Woken up by the notification, rather than by checking in
+    TEST_CHECK((k_uptime_get() - start) < 500);
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Home);
+
+    // The status was only asked for the once, when starting up
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") == 1);
+
+    // Roaming counts as registered, while being turned away doesn't
+    Modem::Notify("+CEREG: 5,\"0A0B\",\"01234567\",7");
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Roaming);
+    TEST_CHECK(network.IsRegistered());
+
+    Modem::Notify("+CEREG: 3");
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Denied);
+    TEST_CHECK(!network.WaitRegistered(50));
+
+    // Other notifications are left alone
+    Modem::Notify("%CESQ: 49,2,15,3");
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Denied);
+}
+
+/**
+ * \brief Checks that the modem is asked for its status while waiting if
+ *        notifications can't be set up
+ */
+static void TestPolled(void)
+{
+    Searching(false);
+
+    Network network(GetService());
+
+    TEST_CHECK(network.Init() != 0);
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Searching);
+
+    // Nothing's listening, so this is ignored
+    Modem::Notify("+CEREG: 1");
+
+    TEST_CHECK(!network.WaitRegistered(50));
+
+    Modem::Answer("AT+CEREG?", "+CEREG: 0,1,\"0A0B\",\"01234567\",7");
+
+    TEST_CHECK(network.WaitRegistered(3000));
+    TEST_CHECK(Modem::GetRuns("AT+CEREG?") >= 2);
+}
+
+/**
+ * \brief Checks that a modem that doesn't answer leaves the status unknown
+ */
+static void TestNoAnswer(void)
+{
+    Modem::Reset();
+
+    Network network(GetService());
+
+    TEST_CHECK(network.Init() != 0);
+
+    TEST_CHECK(network.GetRegistration() == Network::Registration::Unknown);
+    TEST_CHECK(!network.WaitRegistered(50));
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Notified", TestNotified);
+    Run("Polled", TestPolled);
+    Run("NoAnswer", TestNoAnswer);
+
+    Finish();
+}
@@ -0,0 +1,352 @@
+/**
+ * \file
+ *
+ * \brief Tests the upload queue with RAM and file-backed storage
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include <unistd.h>
+
+#include <kernel.h>
+
+#include "examples/socket/queue.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // Records big enough for anything the tests queue
+    static constexpr const std::size_t RecordSize = 64;
+
+    // Stands in for the flash storage partition, keeping each record in its
+    // own file so that it outlives the queue that wrote it, the way a record
+    // in flash outlives a reset
+    class FileStorage : public UploadQueue::Storage
+    {
+        private:
+            std::string directory;
+
+        public:
+            // How many writes each record has had
+            uint32_t writes[CONFIG_SOCKET_QUEUE_DEPTH + 1] = {};
+
+        private:
+            /**
+             * \brief Gets the file a record is kept in
+             *
+             * \param id
+             *      The record's ID
+             *
+             * \return std::string
+             *      The file's path
+             */
+            std::string GetPath(uint16_t id) const
+            {
+                return this->directory + "/" + std::to_string(id);
+            }
+
+        public:
+            /**
+             * \brief Creates new storage in a directory
+             *
+             * \param &directory
+             *      The directory to keep records in
+             *
+             * \return none
+             */
+            FileStorage(const std::string &directory):
+                directory(directory) {}
+
+            int Init(void) override
+            {
+                return 0;
+            }
+
+            int Read(uint16_t id, void *data, std::size_t length) override
+            {
+                FILE *file = fopen(this->GetPath(id).c_str(), "rb");
+
+                if (file == nullptr)
+                {
+                    return -1;
+                }
+
+                char record[RecordSize];
+
+                std::size_t read = fread(record, 1, sizeof(record), file);
+
+                fclose(file);
+
+                memcpy(data, record, std::min(read, length));
+
+                return static_cast<int>(read);
+            }
+
+            int Write(uint16_t id, const void *data, std::size_t length) override
+            {
+                FILE *file = fopen(this->GetPath(id).c_str(), "wb");
+
+                if (file == nullptr)
+                {
+                    return -1;
+                }
+
+                std::size_t written = fwrite(data, 1, length, file);
+
+                fclose(file);
+
+                if (id < std::size(this->writes))
+                {
+                    this->writes[id]++;
+                }
+
+                return (written == length) ? static_cast<int>(written) : -1;
+            }
+    };
+
+    /**
+     * \brief Makes a fresh directory for file-backed storage
+     *
+     * \param none
+     *
+     * \return std::string
+     *      The directory's path
+     */
+    std::string MakeDirectory(void)
+    {
+        char path[] = "/tmp/queue_test_XXXXXX";
+
+        if (mkdtemp(path) == nullptr)
+        {
+            perror("Unable to make a storage directory");
+
+            std::abort();
+        }
+
+        return path;
+    }
+
+    /**
+     * \brief Reads and removes the oldest record
+     *
+     * \param &queue
+     *      The queue to read from
+     *
+     * \return std::string
+     *      The record, which is empty if there wasn't one
+     */
+    std::string Take(UploadQueue &queue)
+    {
+        char record[RecordSize];
+
+        int length = queue.Peek(record, sizeof(record));
+
+        if (length < 0)
+        {
+            return "";
+        }
+
+        queue.Pop();
+
+        return std::string(record, length);
+    }
+}
+
+/**
+ * \brief Checks that records come back out in the order they went in
+ */
+static void TestOrder(void)
+{
+    UploadQueue::RamStorage<CONFIG_SOCKET_QUEUE_DEPTH + 1, RecordSize> storage;
+    UploadQueue queue(storage);
+
+    TEST_CHECK(queue.Init() == 0);
+    TEST_CHECK(queue.GetCount() == 0);
+
+    TEST_CHECK(queue.Push("a=1", 3) == 0);
+    TEST_CHECK(queue.Push("b=22", 4) == 0);
+
+    TEST_CHECK(queue.GetCount() == 2);
+
+    TEST_CHECK(Take(queue) == "a=1");
+    TEST_CHECK(Take(queue) == "b=22");
+    TEST_CHECK(Take(queue) == "");
+
+    TEST_CHECK(queue.GetCount() == 0);
+
+    // Nothing can be queued before the storage is set up, and empty records
+    // aren't worth keeping
+    UploadQueue unready(storage);
+
+    TEST_CHECK(unready.Push("a=1", 3) < 0);
+    TEST_CHECK(queue.Push("", 0) < 0);
+}
+
+/**
+ * \brief Checks that a full queue drops its oldest record
+ */
+static void TestBounded(void)
+{
+    UploadQueue::RamStorage<CONFIG_SOCKET_QUEUE_DEPTH + 1, RecordSize> storage;
+    UploadQueue queue(storage);
+
+    TEST_CHECK(queue.Init() == 0);
+
+    for (int i = 0; i < (CONFIG_SOCKET_QUEUE_DEPTH + 3); i++)
+    {
+        std::string record = "n=" + std::to_string(i);
+
+        TEST_CHECK(queue.Push(record.c_str(), record.size()) == 0);
+    }
+
+    TEST_CHECK(queue.GetCount() == CONFIG_SOCKET_QUEUE_DEPTH);
+
+    TEST_CHECK(Take(queue) == "n=3");
+}
+
+/**
+ * \brief Checks that a record that can't be read is skipped
+ */
+static void TestUnreadable(void)
+{
+    UploadQueue::RamStorage<CONFIG_SOCKET_QUEUE_DEPTH + 1, RecordSize> storage;
+    UploadQueue queue(storage);
+
+    TEST_CHECK(queue.Init() == 0);
+
+    TEST_CHECK(queue.Push("a=123456789", 11) == 0);
+    TEST_CHECK(queue.Push("b=2", 3) == 0);
+
+    // The first record doesn't fit, so it would never be sent
+    char small[4];
+
+    TEST_CHECK(queue.Peek(small, sizeof(small)) < 0);
+    TEST_CHECK(queue.GetCount() == 1);
+
+    TEST_CHECK(Take(queue) == "b=2");
+}
+
+/**
+ * \brief Checks that queued records survive a reset
+ */
+static void TestPersistence(void)
+{
+    std::string directory = MakeDirectory();
+
+    {
+        FileStorage storage(directory);
+        UploadQueue queue(storage);
+
+        TEST_CHECK(queue.Init() == 0);
+
+        TEST_CHECK(queue.Push("a=1", 3) == 0);
+        TEST_CHECK(queue.Push("b=2", 3) == 0);
+        TEST_CHECK(queue.Push("c=3", 3) == 0);
+
+        // Sending one and then losing power before the state is saved means
+        // it's sent again after the reset, rather than lost
+        TEST_CHECK(Take(queue) == "a=1");
+    }
+
+    {
+        FileStorage storage(directory);
+        UploadQueue queue(storage);
+
+        TEST_CHECK(queue.Init() == 0);
+        TEST_CHECK(queue.GetCount() == 3);
+
+        TEST_CHECK(Take(queue) == "a=1");
+        TEST_CHECK(queue.Commit() == 0);
+    }
+
+    {
+        FileStorage storage(directory);
+        UploadQueue queue(storage);
+
+        TEST_CHECK(queue.Init() == 0);
+        TEST_CHECK(queue.GetCount() == 2);
+
+        TEST_CHECK(Take(queue) == "b=2");
+        TEST_CHECK(Take(queue) == "c=3");
+    }
+
+    // Saved state that doesn't make sense is thrown out
+    {
+        FileStorage storage(directory);
+
+        const uint32_t state[2] = {0, CONFIG_SOCKET_QUEUE_DEPTH + 1};
+
+        storage.Write(0, state, sizeof(state));
+
+        UploadQueue queue(storage);
+
+        TEST_CHECK(queue.Init() == 0);
+        TEST_CHECK(queue.GetCount() == 0);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * \brief Checks that writes are spread across the records
+ */
+static void TestWear(void)
+{
+    std::string directory = MakeDirectory();
+
+    FileStorage storage(directory);
+    UploadQueue queue(storage);
+
+    TEST_CHECK(queue.Init() == 0);
+
+    static constexpr const int Cycles = 10;
+
+    for (int i = 0; i < (Cycles * CONFIG_SOCKET_QUEUE_DEPTH); i++)
+    {
+        TEST_CHECK(queue.Push("a=1", 3) == 0);
+
+        Take(queue);
+    }
+
+    // Each record slot gets the same share, and only the state is written
+    // every time
+    for (std::size_t id = 1; id < std::size(storage.writes); id++)
+    {
+        TEST_CHECK(storage.writes[id] == Cycles);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("Order", TestOrder);
+    Run("Bounded", TestBounded);
+    Run("Unreadable", TestUnreadable);
+    Run("Persistence", TestPersistence);
+    Run("Wear", TestWear);
+
+    Finish();
+}
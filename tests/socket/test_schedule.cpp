@@ -0,0 +1,580 @@
+/**
+ * \file
+ *
+ * \brief Tests when the socket widget posts each widget's data, and in what
+ *        order
+ *
+ *  Widgets post "name=count" to the stand-in server, so the order they went
+ *  out in each cycle can be read back from the requests. Built without a
+ *  group window, widgets with different periods are checked for posting at
+ *  their own rates and in priority order, and larger widgets for how they're
+ *  batched when they don't all fit in one request; built with one, widgets
+ *  due within it are checked for sharing a cycle.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/at/at_service.h"
+#include "examples/socket/socket.h"
+#include "support/http_server.h"
+#include "support/modem.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    /**
+     * \brief A widget that posts how many times it's been asked, while it's
+     *        active
+     */
+    class Poster : public Socket::Data
+    {
+        private:
+            const char *name;
+
+            std::atomic<bool> active{false};
+            std::atomic<uint32_t> calls{0};
+
+        public:
+            /**
+             * \brief Creates a new widget
+             *
+             * \param *name
+             *      The name it posts under
+             *
+             * \return none
+             */
+            Poster(const char *name):
+                name(name) {}
+
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                uint32_t calls = ++this->calls;
+
+                if (!this->active)
+                {
+                    buffer[0] = '\0';
+
+                    return;
+                }
+
+                snprintf(buffer, max_length, "%s=%u", this->name, static_cast<unsigned int>(calls));
+            }
+
+            /**
+             * \brief Sets whether there's anything to post
+             *
+             * \param active
+             *      Whether to post
+             *
+             * \return none
+             */
+            void SetActive(bool active)
+            {
+                this->active = active;
+            }
+
+            /**
+             * \brief Gets how many times we were asked for our data
+             *
+             * \param none
+             *
+             * \return uint32_t
+             *      The number of times
+             */
+            uint32_t GetCalls(void) const
+            {
+                return this->calls;
+            }
+    };
+
+    /**
+     * \brief A widget that posts a record of whatever length the test
+     *        wants
+     */
+    class Filler : public Socket::Data
+    {
+        private:
+            const char *name;
+
+            std::mutex lock;
+            std::string record;
+
+        public:
+            /**
+             * \brief Creates a new widget
+             *
+             * \param *name
+             *      The name it posts under
+             *
+             * \return none
+             */
+            Filler(const char *name):
+                name(name) {}
+
+            void Retrieve(char *buffer, uint16_t max_length) override
+            {
+                std::lock_guard<std::mutex> guard(this->lock);
+
+                strncpy(buffer, this->record.c_str(), max_length - 1);
+                buffer[max_length - 1] = '\0';
+            }
+
+            /**
+             * \brief Makes the record we post
+             *
+             * \param length
+             *      How long the record is, or 0 to post nothing
+             * \param fill
+             *      What to fill the record's value with
+             *
+             * \return std::string
+             *      The record
+             */
+            std::string MakeRecord(std::size_t length, char fill) const
+            {
+                if (length == 0)
+                {
+                    return "";
+                }
+
+                std::string record = std::string(this->name) + "=";
+
+                return record + std::string(length - record.size(), fill);
+            }
+
+            /**
+             * \brief Sets the record we post
+             *
+             * \param length
+             *      How long the record is, or 0 to post nothing
+             * \param fill
+             *      What to fill the record's value with
+             *
+             * \return none
+             */
+            void SetRecord(std::size_t length, char fill)
+            {
+                std::string record = this->MakeRecord(length, fill);
+
+                std::lock_guard<std::mutex> guard(this->lock);
+
+                this->record = record;
+            }
+    };
+
+#if CONFIG_SOCKET_GROUP_WINDOW == 0
+    // How often each widget posts
+    static constexpr const int32_t Fast = 100;
+    static constexpr const int32_t Slow = 300;
+
+    // Widgets that post at different rates, and ones that share a rate but
+    // not a priority
+    Poster fast("fast");
+    Poster slow("slow");
+    Poster high("high");
+    Poster mid("mid");
+    Poster tie("tie");
+
+    // Widgets that only post when their batching is being checked, with
+    // the others that share their period between them
+    Filler one("one");
+    Filler two("two");
+    Filler three("three");
+#else
+    // How often each widget posts, both within the group window of each
+    // other
+    static constexpr const int32_t Early = 1000;
+    static constexpr const int32_t Late = 1400;
+
+    Poster early("early");
+    Poster late("late");
+#endif
+
+    // Where the widgets post to
+    HttpServer *server = nullptr;
+
+    /**
+     * \brief Starts the socket widget, if it hasn't been already
+     *
+     *  Its thread never stops, so everything's made once and never
+     *  destroyed.
+     *
+     * \param none
+     *
+     * \return none
+     */
+    void Start(void)
+    {
+        static Socket *socket = nullptr;
+
+        if (socket != nullptr)
+        {
+            return;
+        }
+
+        Modem::Reset();
+        Modem::SetNotifications(true);
+
+        Modem::Answer("AT+CEREG=1", "");
+        Modem::Answer("AT+CEREG?", "+CEREG: 1,1,\"0A0B\",\"01234567\",7");
+
+        HttpServer::Options options;
+        options.port = CONFIG_SOCKET_PORT;
+
+        server = new HttpServer(options);
+
+        socket = new Socket(*new AtService());
+
+    #   if CONFIG_SOCKET_GROUP_WINDOW == 0
+        socket->RegisterData(fast, Fast);
+        socket->RegisterData(slow, Slow);
+        socket->RegisterData(high, Slow, 9);
+        socket->RegisterData(mid, Slow, 4);
+        socket->RegisterData(tie, Slow, 4);
+        socket->RegisterData(one, Slow, 1);
+        socket->RegisterData(two, Slow);
+        socket->RegisterData(three, Slow);
+    #   else
+        socket->RegisterData(early, Early);
+        socket->RegisterData(late, Late);
+    #   endif
+    }
+
+    /**
+     * \brief Gets the names posted in each request the server got, in order
+     *
+     * \param none
+     *
+     * \return std::vector<std::vector<std::string>>
+     *      The names in each request
+     */
+    std::vector<std::vector<std::string>> GetPosted(void)
+    {
+        std::vector<std::vector<std::string>> posted;
+
+        for (const std::string &target : server->GetTargets())
+        {
+            std::vector<std::string> names;
+
+            std::size_t start = target.find('?');
+
+            while (start != std::string::npos)
+            {
+                std::size_t end = target.find('=', start + 1);
+
+                if (end == std::string::npos)
+                {
+                    break;
+                }
+
+                names.push_back(target.substr(start + 1, end - (start + 1)));
+
+                start = target.find('&', end);
+            }
+
+            posted.push_back(names);
+        }
+
+        return posted;
+    }
+
+#if CONFIG_SOCKET_GROUP_WINDOW == 0
+    /**
+     * \brief Gets the query strings the server got, in the order it got them
+     *
+     * \param none
+     *
+     * \return std::vector<std::string>
+     *      The query strings
+     */
+    std::vector<std::string> GetQueries(void)
+    {
+        std::vector<std::string> queries;
+
+        for (const std::string &target : server->GetTargets())
+        {
+            std::size_t start = target.find('?');
+
+            queries.push_back((start != std::string::npos) ? target.substr(start + 1) : "");
+        }
+
+        return queries;
+    }
+#endif
+
+    /**
+     * \brief Checks that a count is within one of what's expected
+     *
+     * \param count
+     *      The count
+     * \param expected
+     *      What it's expected to be
+     *
+     * \return bool
+     *      Whether or not it's close enough
+     */
+    bool IsAbout(uint32_t count, uint32_t expected)
+    {
+        return ((count + 1) >= expected) && (count <= (expected + 1));
+    }
+}
+
+#if CONFIG_SOCKET_GROUP_WINDOW == 0
+/**
+ * \brief Checks that widgets with different periods are each posted at their
+ *        own rate
+ */
+static void TestRates(void)
+{
+    Start();
+
+    // Let the first cycle, with everyone in it, go by
+    k_sleep(Slow);
+
+    static constexpr const int32_t Duration = Slow * 6;
+
+    uint32_t fastCalls = fast.GetCalls();
+    uint32_t slowCalls = slow.GetCalls();
+
+    k_sleep(Duration);
+
+    fastCalls = fast.GetCalls() - fastCalls;
+    slowCalls = slow.GetCalls() - slowCalls;
+
+    TEST_CHECK(IsAbout(fastCalls, Duration / Fast));
+    TEST_CHECK(IsAbout(slowCalls, Duration / Slow));
+
+    printf("In %u ms, %u fast and %u slow posts\n",
+        static_cast<unsigned int>(Duration),
+        static_cast<unsigned int>(fastCalls),
+        static_cast<unsigned int>(slowCalls)
+    );
+
+    // The widgets sharing a period are asked together, highest priority
+    // first, so they're at most one ahead of the last one if a cycle's
+    // underway
+    slowCalls = slow.GetCalls();
+
+    for (Poster *poster : {&high, &mid, &tie})
+    {
+        uint32_t calls = poster->GetCalls();
+
+        TEST_CHECK((calls >= slowCalls) && (calls <= (slowCalls + 1)));
+    }
+}
+
+/**
+ * \brief Checks that widgets are posted highest priority first, with ties
+ *        going in the order they registered
+ */
+static void TestPriority(void)
+{
+    Start();
+
+    for (Poster *poster : {&fast, &slow, &high, &mid, &tie})
+    {
+        poster->SetActive(true);
+    }
+
+    // A cycle that was underway might only have some of them, so start
+    // after the next request
+    std::size_t skip = server->GetTargets().size() + 1;
+
+    k_sleep(Slow * 5);
+
+    std::vector<std::string> slowCycle = {"high", "mid", "tie", "slow"};
+
+    // The fast widget is only in the slow ones' cycles when it happens to be
+    // due too, and then it goes after the ones with higher priority and
+    // before the one that registered after it
+    std::vector<std::string> sharedCycle = {"high", "mid", "tie", "fast", "slow"};
+
+    uint32_t slowCycles = 0;
+
+    std::vector<std::vector<std::string>> posted = GetPosted();
+
+    for (std::size_t i = skip; i < posted.size(); i++)
+    {
+        const std::vector<std::string> &names = posted[i];
+
+        if (names.empty() || (names == std::vector<std::string>({"fast"})))
+        {
+            continue;
+        }
+
+        TEST_CHECK((names == slowCycle) || (names == sharedCycle));
+
+        slowCycles++;
+    }
+
+    TEST_CHECK(slowCycles >= 3);
+}
+
+/**
+ * \brief Posts records of the given lengths for a few cycles, and checks
+ *        they're split up as expected
+ *
+ *  Only the three fillers post, so the records they make are all that's in
+ *  each request. The widgets that post nothing still go between the first
+ *  filler and the second.
+ *
+ * \param fill
+ *      What to fill this run's records with
+ * \param lengths
+ *      How long each filler's record is
+ * \param expected
+ *      The fillers in each request each cycle should make, in order
+ *
+ * \return none
+ */
+static void CheckSplit(char fill, std::vector<std::size_t> lengths, std::vector<std::vector<std::size_t>> expected)
+{
+    Start();
+
+    for (Poster *poster : {&fast, &slow, &high, &mid, &tie})
+    {
+        poster->SetActive(false);
+    }
+
+    Filler *fillers[] = {&one, &two, &three};
+
+    for (std::size_t i = 0; i < std::size(fillers); i++)
+    {
+        fillers[i]->SetRecord(lengths[i], fill);
+    }
+
+    std::size_t skip = server->GetTargets().size() + std::size(expected);
+
+    k_sleep(Slow * 4);
+
+    // Each request is the records in it joined by '&'s
+    std::vector<std::string> cycle;
+
+    for (const std::vector<std::size_t> &request : expected)
+    {
+        std::string query;
+
+        for (std::size_t i : request)
+        {
+            query += (query.empty() ? "" : "&") + fillers[i]->MakeRecord(lengths[i], fill);
+        }
+
+        cycle.push_back(query);
+    }
+
+    std::vector<std::string> queries = GetQueries();
+
+    uint32_t cycles = 0;
+
+    for (std::size_t i = skip; (i + cycle.size()) <= queries.size(); i += cycle.size())
+    {
+        TEST_CHECK(std::equal(cycle.begin(), cycle.end(), queries.begin() + i));
+
+        cycles++;
+    }
+
+    TEST_CHECK(cycles >= 2);
+
+    // Nothing's cut short, or has a stray '&'
+    for (std::size_t i = skip; i < queries.size(); i++)
+    {
+        const std::string &query = queries[i];
+
+        TEST_CHECK(query.size() <= (MAX_TRANSMISSION - 2));
+        TEST_CHECK(!query.empty() && (query.front() != '&') && (query.back() != '&'));
+        TEST_CHECK(query.find("&&") == std::string::npos);
+    }
+}
+
+/**
+ * \brief Checks that records that just fit together go in one request
+ */
+static void TestFits(void)
+{
+    // The whole batch, and the string's terminator, exactly fill the
+    // buffer
+    CheckSplit('a', {1000, 997, 500}, {{0, 1}, {2}});
+}
+
+/**
+ * \brief Checks that a record that doesn't fit starts a new request, which
+ *        the ones after it can join
+ */
+static void TestSplits(void)
+{
+    CheckSplit('b', {1000, 998, 500}, {{0}, {1, 2}});
+
+    // One that can't go with anything goes on its own
+    CheckSplit('c', {200, 1998, 300}, {{0}, {1}, {2}});
+}
+#else
+/**
+ * \brief Checks that widgets due within the group window of each other are
+ *        posted in the same cycle
+ */
+static void TestWindow(void)
+{
+    early.SetActive(true);
+    late.SetActive(true);
+
+    Start();
+
+    static constexpr const int32_t Duration = Early * 3 + (Early / 2);
+
+    k_sleep(Duration);
+
+    std::vector<std::vector<std::string>> posted = GetPosted();
+
+    // The late widget is always due within the window of the early one, so
+    // it goes early rather than on its own
+    TEST_CHECK(IsAbout(posted.size(), Duration / Early));
+
+    for (const std::vector<std::string> &names : posted)
+    {
+        TEST_CHECK(names == std::vector<std::string>({"early", "late"}));
+    }
+
+    TEST_CHECK(early.GetCalls() == late.GetCalls());
+}
+#endif
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+#   if CONFIG_SOCKET_GROUP_WINDOW == 0
+    Run("Rates", TestRates);
+    Run("Priority", TestPriority);
+    Run("Fits", TestFits);
+    Run("Splits", TestSplits);
+#   else
+    Run("Window", TestWindow);
+#   endif
+
+    Finish();
+}
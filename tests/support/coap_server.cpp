@@ -0,0 +1,380 @@
+/**
+ * \file
+ *
+ * \brief A local CoAP stand-in that the socket widget can post to
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "support/coap_server.h"
+
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // The header fields and options we care about (RFC 7252, section 3)
+    static constexpr const uint8_t TypeCon = 0;
+    static constexpr const uint8_t TypeNon = 1;
+    static constexpr const uint8_t TypeAck = 2;
+    static constexpr const uint8_t TypeReset = 3;
+
+    static constexpr const uint16_t OptionUriPath = 11;
+    static constexpr const uint16_t OptionBlock1 = 27;
+
+    static constexpr const uint8_t CodeContinue = (2 << 5) | 31;
+
+    /**
+     * \brief Reads an option's delta or length, along with any extended bytes
+     *
+     * \param nibble
+     *      The delta or length's nibble
+     * \param *&data
+     *      The extended bytes, which is moved past them
+     * \param *end
+     *      The end of the datagram
+     * \param &value
+     *      Where to put the delta or length
+     *
+     * \return bool
+     *      Whether or not the value was valid
+     */
+    bool ReadExtended(uint8_t nibble, const uint8_t *&data, const uint8_t *end, uint32_t &value)
+    {
+        if (nibble < 13)
+        {
+            value = nibble;
+        }
+        else if ((nibble == 13) && (data < end))
+        {
+            value = 13 + data[0];
+            data += 1;
+        }
+        else if ((nibble == 14) && ((data + 1) < end))
+        {
+            value = 269 + ((data[0] << 8) | data[1]);
+            data += 2;
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+}
+
+/**
+ * \brief Starts a new server on a local port
+ *
+ * \param &options
+ *      How the server behaves
+ *
+ * \return none
+ */
+CoapServer::CoapServer(const Options &options):
+    options(options)
+{
+    this->socketId = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(options.port);
+
+    socklen_t length = sizeof(address);
+
+    if ((bind(this->socketId, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) ||
+        (getsockname(this->socketId, reinterpret_cast<struct sockaddr *>(&address), &length) != 0))
+    {
+        perror("Unable to start the CoAP stand-in");
+
+        std::abort();
+    }
+
+    this->port = ntohs(address.sin_port);
+
+    // Don't let waiting for datagrams hold up stopping
+    struct timeval timeout = {0, 100000};
+
+    setsockopt(this->socketId, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    this->server = std::thread(&CoapServer::Serve, this);
+}
+
+/**
+ * \brief Starts a new server with the default options
+ *
+ * \param none
+ *
+ * \return none
+ */
+CoapServer::CoapServer(void):
+    CoapServer(Options())
+{
+}
+
+/**
+ * \brief Stops the server
+ *
+ * \param none
+ *
+ * \return none
+ */
+CoapServer::~CoapServer(void)
+{
+    this->running = false;
+
+    this->server.join();
+
+    close(this->socketId);
+}
+
+/**
+ * \brief Answers datagrams until the server stops
+ *
+ * \param none
+ *
+ * \return none
+ */
+void CoapServer::Serve(void)
+{
+    while (this->running)
+    {
+        uint8_t datagram[2048];
+        struct sockaddr_in from;
+        socklen_t fromLength = sizeof(from);
+
+        ssize_t length = recvfrom(
+            this->socketId,
+            datagram,
+            sizeof(datagram),
+            0,
+            reinterpret_cast<struct sockaddr *>(&from),
+            &fromLength
+        );
+
+        if (length < 4)
+        {
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(this->lock);
+
+            if (this->totals.dropped < this->options.drop)
+            {
+                this->totals.dropped++;
+
+                continue;
+            }
+
+            this->totals.messages++;
+            this->totals.bytes += static_cast<uint32_t>(length);
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->options.latency));
+
+        this->Answer(datagram, length, from);
+    }
+}
+
+/**
+ * \brief Answers a request
+ *
+ * \param *datagram
+ *      The request
+ * \param length
+ *      The request's length
+ * \param &from
+ *      Where the request came from
+ *
+ * \return none
+ */
+void CoapServer::Answer(const uint8_t *datagram, std::size_t length, const struct sockaddr_in &from)
+{
+    uint8_t type = (datagram[0] >> 4) & 0x03;
+    uint8_t tokenLength = datagram[0] & 0x0F;
+
+    if ((tokenLength > 8) || ((4U + tokenLength) > length))
+    {
+        return;
+    }
+
+    const uint8_t *data = &datagram[4 + tokenLength];
+    const uint8_t *end = &datagram[length];
+
+    std::string path;
+    bool block = false;
+    bool more = false;
+    uint32_t number = 0;
+    uint32_t size = 0;
+
+    uint32_t option = 0;
+
+    while ((data < end) && (*data != 0xFF))
+    {
+        uint8_t header = *data++;
+
+        uint32_t delta;
+        uint32_t optionLength;
+
+        if (!ReadExtended(header >> 4, data, end, delta) ||
+            !ReadExtended(header & 0x0F, data, end, optionLength) ||
+            ((data + optionLength) > end))
+        {
+            return;
+        }
+
+        option += delta;
+
+        if (option == OptionUriPath)
+        {
+            path += (path.empty() ? "" : "/") + std::string(reinterpret_cast<const char *>(data), optionLength);
+        }
+        else if (option == OptionBlock1)
+        {
+            uint32_t value = 0;
+
+            for (uint32_t i = 0; i < optionLength; i++)
+            {
+                value = (value << 8) | data[i];
+            }
+
+            block = true;
+            number = value >> 4;
+            more = (value & 0x08) != 0;
+            size = 1 << ((value & 0x07) + 4);
+        }
+
+        data += optionLength;
+    }
+
+    // Skip the payload marker
+    if (data < end)
+    {
+        data++;
+    }
+
+    std::string payload(reinterpret_cast<const char *>(data), end - data);
+
+    uint8_t code = this->options.code;
+
+    {
+        std::lock_guard<std::mutex> lock(this->lock);
+
+        this->path = path;
+
+        if (!block)
+        {
+            this->payloads.push_back(payload);
+        }
+        else
+        {
+            this->assembly.resize(number * size);
+            this->assembly += payload;
+
+            if (!more)
+            {
+                this->payloads.push_back(this->assembly);
+
+                this->assembly.clear();
+            }
+            else if ((code >> 5) == 2)
+            {
+                code = CodeContinue;
+            }
+        }
+    }
+
+    uint8_t response[4 + 8];
+
+    // A reset is empty, an acknowledgement reuses the request's ID, and a
+    // non-confirmable response gets its own ID
+    if (this->options.reset)
+    {
+        response[0] = static_cast<uint8_t>((1 << 6) | (TypeReset << 4));
+        response[1] = 0;
+        response[2] = datagram[2];
+        response[3] = datagram[3];
+
+        tokenLength = 0;
+    }
+    else
+    {
+        response[0] = static_cast<uint8_t>((1 << 6) | (((type == TypeCon) ? TypeAck : TypeNon) << 4) | tokenLength);
+        response[1] = code;
+        response[2] = (type == TypeCon) ? datagram[2] : static_cast<uint8_t>(~datagram[2]);
+        response[3] = datagram[3];
+
+        memcpy(&response[4], &datagram[4], tokenLength);
+    }
+
+    sendto(
+        this->socketId,
+        response,
+        4 + tokenLength,
+        0,
+        reinterpret_cast<const struct sockaddr *>(&from),
+        sizeof(from)
+    );
+}
+
+/**
+ * \brief Gets what the server has seen
+ *
+ * \param none
+ *
+ * \return Totals
+ *      The server's totals
+ */
+CoapServer::Totals CoapServer::GetTotals(void)
+{
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return this->totals;
+}
+
+/**
+ * \brief Gets the payload of each post the server has fully received
+ *
+ * \param none
+ *
+ * \return std::vector<std::string>
+ *      The payloads, in the order they were received
+ */
+std::vector<std::string> CoapServer::GetPayloads(void)
+{
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return this->payloads;
+}
+
+/**
+ * \brief Gets the path the last request was sent to
+ *
+ * \param none
+ *
+ * \return std::string
+ *      The path, with its segments separated by '/'
+ */
+std::string CoapServer::GetPath(void)
+{
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return this->path;
+}
@@ -0,0 +1,118 @@
+/**
+ * \file
+ *
+ * \brief A local CoAP stand-in that the socket widget can post to
+ *
+ *  This answers CoAP posts over UDP, including block-wise ones, with a code
+ *  chosen by the test, and can reset requests or ignore the first few
+ *  datagrams it gets so retransmissions can be checked.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+
+namespace NimbeLink::Tests
+{
+    class CoapServer;
+}
+
+class NimbeLink::Tests::CoapServer
+{
+    public:
+        /**
+         * \brief How the server behaves
+         */
+        struct Options
+        {
+            // The code to answer each post with, which defaults to 2.04
+            // Changed
+            uint8_t code = (2 << 5) | 4;
+
+            // Whether to reset requests instead of answering them
+            bool reset = false;
+
+            // Datagrams to ignore before answering any
+            uint32_t drop = 0;
+
+            // Milliseconds to hold each request for
+            uint32_t latency = 0;
+
+            // The port to listen on, or 0 for any free one, which is what
+            // tests that can be told the port should use
+            uint16_t port = 0;
+        };
+
+        /**
+         * \brief What the server has seen
+         */
+        struct Totals
+        {
+            // Datagrams answered, with each block counting separately
+            uint32_t messages = 0;
+
+            // Datagrams ignored
+            uint32_t dropped = 0;
+
+            // Bytes of datagrams received
+            uint32_t bytes = 0;
+        };
+
+    private:
+        Options options;
+
+        int socketId = -1;
+        uint16_t port = 0;
+
+        std::atomic<bool> running{true};
+
+        std::thread server;
+
+        std::mutex lock;
+        Totals totals;
+        std::vector<std::string> payloads;
+        std::string path;
+
+        // The post being received a block at a time
+        std::string assembly;
+
+    private:
+        void Serve(void);
+        void Answer(const uint8_t *datagram, std::size_t length, const struct sockaddr_in &from);
+
+    public:
+        CoapServer(const Options &options);
+        CoapServer(void);
+        ~CoapServer(void);
+
+        /**
+         * \brief Gets the port the server is listening on
+         *
+         * \param none
+         *
+         * \return uint16_t
+         *      The port
+         */
+        uint16_t GetPort(void) const
+        {
+            return this->port;
+        }
+
+        Totals GetTotals(void);
+        std::vector<std::string> GetPayloads(void);
+        std::string GetPath(void);
+};
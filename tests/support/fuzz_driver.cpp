@@ -0,0 +1,230 @@
+/**
+ * \file
+ *
+ * \brief Runs a fuzz target without libFuzzer
+ *
+ *  Each corpus input is run as is, and then random mutations of them are run
+ *  until the given number of inputs has been tried:
+ *
+ *      <target> [inputs] [corpus file or directory]...
+ *
+ *  Mutations flip, insert, remove and duplicate bytes, favoring the ones AT
+ *  responses are made of, and splice inputs together. The seed is fixed, so
+ *  a failure happens the same way every run. A failed check aborts, and the
+ *  input that caused it is written to crash-input first.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size);
+
+namespace
+{
+    // The longest input a mutation can make
+    static constexpr const std::size_t MaxSize = 512;
+
+    // Bytes that mean something to an AT response
+    static constexpr const char Interesting[] = ",\"\r\n :+-%0123456789ABCDEF";
+
+    // The input being run, so it can be saved if it fails
+    std::string current;
+
+    /**
+     * \brief Saves the input being run when a check fails
+     *
+     * \param signal
+     *      The signal that stopped the run
+     *
+     * \return none
+     */
+    void SaveCrash(int signal)
+    {
+        if (FILE *file = fopen("crash-input", "wb"))
+        {
+            fwrite(std::data(current), 1, std::size(current), file);
+            fclose(file);
+        }
+
+        fprintf(stderr, "Failed with an input of %zu bytes, saved to crash-input\n", std::size(current));
+
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+
+    /**
+     * \brief Reads a corpus input
+     *
+     * \param &path
+     *      The input's file
+     * \param &corpus
+     *      The corpus to add it to
+     *
+     * \return none
+     */
+    void Load(const std::filesystem::path &path, std::vector<std::string> &corpus)
+    {
+        if (std::filesystem::is_directory(path))
+        {
+            for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(path))
+            {
+                Load(entry.path(), corpus);
+            }
+
+            return;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+
+        corpus.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /**
+     * \brief Makes a mutation of an input
+     *
+     * \param input
+     *      The input
+     * \param &corpus
+     *      The other inputs, for splicing
+     * \param &random
+     *      Where to get random numbers from
+     *
+     * \return std::string
+     *      The mutation
+     */
+    std::string Mutate(std::string input, const std::vector<std::string> &corpus, std::mt19937 &random)
+    {
+        auto pick = [&random](std::size_t count) {
+            return std::uniform_int_distribution<std::size_t>(0, count - 1)(random);
+        };
+
+        auto byte = [&random, &pick](void) {
+            if (pick(4) == 0)
+            {
+                return static_cast<char>(pick(256));
+            }
+
+            return Interesting[pick(std::size(Interesting) - 1)];
+        };
+
+        std::size_t mutations = 1 + pick(8);
+
+        for (std::size_t i = 0; i < mutations; i++)
+        {
+            std::size_t at = input.empty() ? 0 : pick(std::size(input) + 1);
+
+            switch (pick(5))
+            {
+                case 0:
+                    if (at < std::size(input))
+                    {
+                        input[at] = byte();
+                    }
+                    break;
+                case 1:
+                    input.insert(at, 1, byte());
+                    break;
+                case 2:
+                    input.erase(at, 1 + pick(8));
+                    break;
+                case 3:
+                    input.insert(at, input.substr(at, 1 + pick(16)));
+                    break;
+                case 4:
+                {
+                    const std::string &other = corpus[pick(std::size(corpus))];
+
+                    std::size_t from = other.empty() ? 0 : pick(std::size(other));
+
+                    input.insert(at, other.substr(from, 1 + pick(32)));
+                    break;
+                }
+            }
+        }
+
+        if (std::size(input) > MaxSize)
+        {
+            input.resize(MaxSize);
+        }
+
+        return input;
+    }
+
+    /**
+     * \brief Runs an input
+     *
+     * \param &input
+     *      The input
+     *
+     * \return none
+     */
+    void RunOne(const std::string &input)
+    {
+        current = input;
+
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(std::data(current)), std::size(current));
+    }
+}
+
+/**
+ * \brief Runs the fuzz target
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      0, if every input passed
+ */
+int main(int argc, char *argv[])
+{
+    unsigned long inputs = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::vector<std::string> corpus;
+
+    for (int i = 2; i < argc; i++)
+    {
+        Load(argv[i], corpus);
+    }
+
+    // Something to start from, even without a corpus
+    corpus.emplace_back();
+
+    std::signal(SIGABRT, SaveCrash);
+    std::signal(SIGSEGV, SaveCrash);
+
+    for (const std::string &input : corpus)
+    {
+        RunOne(input);
+    }
+
+    std::mt19937 random(1);
+
+    for (unsigned long i = std::size(corpus); i < inputs; i++)
+    {
+        const std::string &input = corpus[std::uniform_int_distribution<std::size_t>(0, std::size(corpus) - 1)(random)];
+
+        RunOne(Mutate(input, corpus, random));
+    }
+
+    printf("%lu inputs from a corpus of %zu passed\n", std::max<unsigned long>(inputs, std::size(corpus)), std::size(corpus));
+
+    return 0;
+}
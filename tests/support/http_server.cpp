@@ -0,0 +1,321 @@
+/**
+ * \file
+ *
+ * \brief A local stand-in for dweet.io that the socket widget can post to
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "support/http_server.h"
+
+using namespace NimbeLink::Tests;
+
+/**
+ * \brief Starts a new server on a local port
+ *
+ * \param &options
+ *      How the server behaves
+ *
+ * \return none
+ */
+HttpServer::HttpServer(const Options &options):
+    options(options),
+    random(options.seed)
+{
+    this->listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    int reuse = 1;
+
+    setsockopt(this->listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(options.port);
+
+    socklen_t length = sizeof(address);
+
+    if ((bind(this->listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0) ||
+        (listen(this->listener, 8) != 0) ||
+        (getsockname(this->listener, reinterpret_cast<struct sockaddr *>(&address), &length) != 0))
+    {
+        perror("Unable to start the HTTP stand-in");
+
+        std::abort();
+    }
+
+    this->port = ntohs(address.sin_port);
+
+    this->acceptor = std::thread(&HttpServer::Accept, this);
+}
+
+/**
+ * \brief Starts a new server with the default options
+ *
+ * \param none
+ *
+ * \return none
+ */
+HttpServer::HttpServer(void):
+    HttpServer(Options())
+{
+}
+
+/**
+ * \brief Stops the server, closing every connection
+ *
+ * \param none
+ *
+ * \return none
+ */
+HttpServer::~HttpServer(void)
+{
+    this->running = false;
+
+    shutdown(this->listener, SHUT_RDWR);
+    close(this->listener);
+
+    this->acceptor.join();
+
+    for (std::thread &connection : this->connections)
+    {
+        connection.join();
+    }
+}
+
+/**
+ * \brief Accepts connections until the server stops
+ *
+ * \param none
+ *
+ * \return none
+ */
+void HttpServer::Accept(void)
+{
+    while (this->running)
+    {
+        int socketId = accept(this->listener, nullptr, nullptr);
+
+        if (socketId < 0)
+        {
+            continue;
+        }
+
+        // Don't let a connection we're serving hold up stopping
+        struct timeval timeout = {0, 100000};
+
+        setsockopt(socketId, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        std::lock_guard<std::mutex> lock(this->lock);
+
+        this->totals.connections++;
+
+        this->connections.emplace_back(&HttpServer::Serve, this, socketId);
+    }
+}
+
+/**
+ * \brief Answers the requests on a connection, in order, until it closes
+ *
+ * \param socketId
+ *      The connection's socket
+ *
+ * \return none
+ */
+void HttpServer::Serve(int socketId)
+{
+    std::string received;
+    uint32_t answered = 0;
+
+    while (this->running)
+    {
+        std::size_t end = received.find("\r\n\r\n");
+        std::size_t headers = 0;
+        std::size_t contentLength = 0;
+
+        if (end != std::string::npos)
+        {
+            headers = end + 4;
+
+            for (std::size_t line = received.find("\r\n") + 2; line < end; line = received.find("\r\n", line) + 2)
+            {
+                if (strncasecmp(&received[line], "Content-Length:", 15) == 0)
+                {
+                    contentLength = strtoul(&received[line + 15], nullptr, 10);
+                }
+            }
+        }
+
+        // Keep reading until we have the whole request, body and all
+        if ((end == std::string::npos) || (received.size() < (headers + contentLength)))
+        {
+            char chunk[512];
+
+            ssize_t length = recv(socketId, chunk, sizeof(chunk), 0);
+
+            if ((length < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+            {
+                continue;
+            }
+
+            if (length <= 0)
+            {
+                break;
+            }
+
+            received.append(chunk, length);
+
+            continue;
+        }
+
+        std::string request = received.substr(0, received.find("\r\n"));
+
+        received.erase(0, headers + contentLength);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->GetDelay()));
+
+        bool dropped = this->Decide(this->options.loss);
+        bool failed = !dropped && this->Decide(this->options.fail);
+
+        {
+            std::lock_guard<std::mutex> lock(this->lock);
+
+            this->totals.requests++;
+            this->totals.dropped += dropped;
+            this->totals.failed += failed;
+            this->totals.bytes += static_cast<uint32_t>(headers + contentLength);
+
+            // "POST <target> HTTP/1.1"
+            std::size_t start = request.find(' ') + 1;
+
+            this->targets.push_back(request.substr(start, request.rfind(' ') - start));
+        }
+
+        if (dropped)
+        {
+            break;
+        }
+
+        static constexpr const char Succeeded[] = "{\"this\":\"succeeded\"}";
+        static constexpr const char Failed[] = "{\"this\":\"failed\"}";
+
+        const char *body = failed ? Failed : Succeeded;
+
+        answered++;
+
+        bool last = (this->options.requestsPerConnection != 0) && (answered >= this->options.requestsPerConnection);
+
+        char response[256];
+
+        int length = snprintf(
+            response,
+            sizeof(response),
+            "HTTP/1.1 %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\n%s\r\n%s",
+            failed ? "500 Internal Server Error" : "200 OK",
+            static_cast<unsigned int>(strlen(body)),
+            (last && this->options.announceClose) ? "Connection: close\r\n" : "",
+            body
+        );
+
+        if (send(socketId, response, length, MSG_NOSIGNAL) != length)
+        {
+            break;
+        }
+
+        if (last)
+        {
+            break;
+        }
+    }
+
+    close(socketId);
+}
+
+/**
+ * \brief Decides whether something with a chance of happening happens
+ *
+ * \param chance
+ *      The chance of it happening, from 0 to 1
+ *
+ * \return bool
+ *      Whether or not it happens
+ */
+bool HttpServer::Decide(double chance)
+{
+    if (chance <= 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return (std::uniform_real_distribution<double>(0, 1)(this->random) < chance);
+}
+
+/**
+ * \brief Gets how long to hold a request for
+ *
+ * \param none
+ *
+ * \return uint32_t
+ *      How long to hold the request for, in milliseconds
+ */
+uint32_t HttpServer::GetDelay(void)
+{
+    if (this->options.jitter == 0)
+    {
+        return this->options.latency;
+    }
+
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    double delay = std::normal_distribution<double>(this->options.latency, this->options.jitter)(this->random);
+
+    return (delay > 0) ? static_cast<uint32_t>(delay) : 0;
+}
+
+/**
+ * \brief Gets what the server has seen
+ *
+ * \param none
+ *
+ * \return Totals
+ *      The server's totals
+ */
+HttpServer::Totals HttpServer::GetTotals(void)
+{
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return this->totals;
+}
+
+/**
+ * \brief Gets the target of each request the server has seen, in order
+ *
+ * \param none
+ *
+ * \return std::vector<std::string>
+ *      The requests' targets
+ */
+std::vector<std::string> HttpServer::GetTargets(void)
+{
+    std::lock_guard<std::mutex> lock(this->lock);
+
+    return this->targets;
+}
@@ -0,0 +1,127 @@
+/**
+ * \file
+ *
+ * \brief A local stand-in for dweet.io that the socket widget can post to
+ *
+ *  This answers HTTP/1.1 posts over keep-alive connections the same way
+ *  scripts/socket_server.py does, with optional added latency, loss and
+ *  failures, but runs in the test itself so tests don't depend on anything
+ *  outside of the build.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NimbeLink::Tests
+{
+    class HttpServer;
+}
+
+class NimbeLink::Tests::HttpServer
+{
+    public:
+        /**
+         * \brief How the server behaves
+         */
+        struct Options
+        {
+            // Milliseconds to hold each request for, and the standard
+            // deviation of that
+            uint32_t latency = 0;
+            uint32_t jitter = 0;
+
+            // Chance of closing the connection instead of responding
+            double loss = 0;
+
+            // Chance of responding with an error
+            double fail = 0;
+
+            // Requests to answer on a connection before closing it, like a
+            // server's idle or request limit, or 0 to keep it open
+            uint32_t requestsPerConnection = 0;
+
+            // Whether the last response before closing says so, the way a
+            // server at its request limit does, rather than the connection
+            // just going away, the way it does at an idle timeout
+            bool announceClose = true;
+
+            // Seed for repeatable loss and latency
+            uint32_t seed = 1;
+
+            // The port to listen on, or 0 for any free one, which is what
+            // tests that can be told the port should use
+            uint16_t port = 0;
+        };
+
+        /**
+         * \brief What the server has seen
+         */
+        struct Totals
+        {
+            uint32_t connections = 0;
+            uint32_t requests = 0;
+            uint32_t dropped = 0;
+            uint32_t failed = 0;
+
+            // Bytes of requests received
+            uint32_t bytes = 0;
+        };
+
+    private:
+        Options options;
+
+        int listener = -1;
+        uint16_t port = 0;
+
+        std::atomic<bool> running{true};
+
+        std::thread acceptor;
+        std::vector<std::thread> connections;
+
+        std::mutex lock;
+        std::mt19937 random;
+        Totals totals;
+        std::vector<std::string> targets;
+
+    private:
+        void Accept(void);
+        void Serve(int socketId);
+
+        bool Decide(double chance);
+        uint32_t GetDelay(void);
+
+    public:
+        HttpServer(const Options &options);
+        HttpServer(void);
+        ~HttpServer(void);
+
+        /**
+         * \brief Gets the port the server is listening on
+         *
+         * \param none
+         *
+         * \return uint16_t
+         *      The port
+         */
+        uint16_t GetPort(void) const
+        {
+            return this->port;
+        }
+
+        Totals GetTotals(void);
+        std::vector<std::string> GetTargets(void);
+};
@@ -0,0 +1,283 @@
+/**
+ * \file
+ *
+ * \brief A scripted modem that answers AT commands and sends notifications
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <at_cmd.h>
+#include <at_notif.h>
+
+#include "nimbelink/sdk/secure_services/at.h"
+#include "support/modem.h"
+
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // What a command gets back
+    struct Script
+    {
+        std::string response;
+        int32_t result;
+    };
+
+    std::recursive_mutex lock;
+
+    std::map<std::string, Script, std::less<>> scripts;
+    std::map<std::string, uint32_t, std::less<>> runs;
+    uint32_t totalRuns = 0;
+
+    uint32_t latency = 0;
+
+    bool notifications = true;
+    std::vector<std::pair<void *, at_notif_handler_t>> handlers;
+}
+
+/**
+ * \brief Forgets everything scripted, counted and registered
+ *
+ * \param none
+ *
+ * \return none
+ */
+void Modem::Reset(void)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    scripts.clear();
+    runs.clear();
+    totalRuns = 0;
+    latency = 0;
+    notifications = true;
+    handlers.clear();
+}
+
+/**
+ * \brief Sets what a command gets back
+ *
+ * \param command
+ *      The command
+ * \param response
+ *      The response, without the trailing "OK"
+ * \param result
+ *      The command's result, which is 0 for OK
+ *
+ * \return none
+ */
+void Modem::Answer(std::string_view command, std::string_view response, int32_t result)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    scripts[std::string(command)] = {std::string(response), result};
+}
+
+/**
+ * \brief Sets how long each command takes
+ *
+ * \param latency
+ *      How long each command takes, in milliseconds
+ *
+ * \return none
+ */
+void Modem::SetLatency(uint32_t latency)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    ::latency = latency;
+}
+
+/**
+ * \brief Sets whether notification handlers can be registered
+ *
+ * \param available
+ *      Whether or not handlers can be registered
+ *
+ * \return none
+ */
+void Modem::SetNotifications(bool available)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    notifications = available;
+}
+
+/**
+ * \brief Sends a notification to everyone registered for them
+ *
+ * \param notification
+ *      The notification
+ *
+ * \return none
+ */
+void Modem::Notify(std::string_view notification)
+{
+    std::vector<std::pair<void *, at_notif_handler_t>> registered;
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+
+        registered = handlers;
+    }
+
+    std::string text(notification);
+
+    for (const auto &[context, handler] : registered)
+    {
+        handler(context, text.c_str());
+    }
+}
+
+/**
+ * \brief Gets how many times a command reached the modem
+ *
+ * \param command
+ *      The command
+ *
+ * \return uint32_t
+ *      The number of times it was run
+ */
+uint32_t Modem::GetRuns(std::string_view command)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    auto run = runs.find(command);
+
+    return (run == runs.end()) ? 0 : run->second;
+}
+
+/**
+ * \brief Gets how many commands reached the modem
+ *
+ * \param none
+ *
+ * \return uint32_t
+ *      The number of commands run
+ */
+uint32_t Modem::GetRuns(void)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    return totalRuns;
+}
+
+int32_t NimbeLink::Sdk::SecureServices::At::RunCommand(
+    Result *result,
+    Error *error,
+    const char *command,
+    uint32_t commandLength,
+    char *response,
+    uint32_t responseLength,
+    uint32_t *responseLengthActual
+)
+{
+    std::string_view text(command, commandLength);
+
+    Script script = {"", Modem::Error};
+    uint32_t delay;
+
+    {
+        std::lock_guard<std::recursive_mutex> guard(lock);
+
+        runs[std::string(text)]++;
+        totalRuns++;
+
+        auto found = scripts.find(text);
+
+        if (found != scripts.end())
+        {
+            script = found->second;
+        }
+
+        delay = latency;
+    }
+
+    if (delay > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    }
+
+    *result = script.result;
+    error->cmeError = 0;
+
+    // Like the secure service, the response is cut to fit and always
+    // terminated, with the full length reported
+    if (responseLength > 0)
+    {
+        std::size_t count = std::min<std::size_t>(script.response.size(), responseLength - 1);
+
+        memcpy(response, script.response.data(), count);
+
+        response[count] = '\0';
+    }
+
+    if (responseLengthActual != nullptr)
+    {
+        *responseLengthActual = static_cast<uint32_t>(script.response.size());
+    }
+
+    return 0;
+}
+
+int at_cmd_init(void)
+{
+    return 0;
+}
+
+int at_notif_init(void)
+{
+    return 0;
+}
+
+int at_notif_register_handler(void *context, at_notif_handler_t handler)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    if (!notifications)
+    {
+        return -1;
+    }
+
+    for (const auto &registered : handlers)
+    {
+        if ((registered.first == context) && (registered.second == handler))
+        {
+            return 0;
+        }
+    }
+
+    handlers.emplace_back(context, handler);
+
+    return 0;
+}
+
+int at_notif_deregister_handler(void *context, at_notif_handler_t handler)
+{
+    std::lock_guard<std::recursive_mutex> guard(lock);
+
+    auto found = std::find(handlers.begin(), handlers.end(), std::make_pair(context, handler));
+
+    if (found == handlers.end())
+    {
+        return -1;
+    }
+
+    handlers.erase(found);
+
+    return 0;
+}
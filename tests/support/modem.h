@@ -0,0 +1,48 @@
+/**
+ * \file
+ *
+ * \brief A scripted modem that answers AT commands and sends notifications
+ *
+ *  This stands in for the secure AT service and nRF Connect's notification
+ *  library. Tests script what each command gets back, push notifications to
+ *  whoever registered for them, and count how many commands actually reached
+ *  the modem.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace NimbeLink::Tests
+{
+    class Modem;
+}
+
+class NimbeLink::Tests::Modem
+{
+    public:
+        // The result a command the modem doesn't know gets, which is a
+        // +CME ERROR
+        static constexpr const int32_t Error = 1;
+
+    public:
+        static void Reset(void);
+
+        static void Answer(std::string_view command, std::string_view response, int32_t result = 0);
+        static void SetLatency(uint32_t latency);
+        static void SetNotifications(bool available);
+
+        static void Notify(std::string_view notification);
+
+        static uint32_t GetRuns(std::string_view command);
+        static uint32_t GetRuns(void);
+};
@@ -0,0 +1,108 @@
+/**
+ * \file
+ *
+ * \brief A minimal harness for the host tests
+ *
+ *  Each test is a function that makes checks, and each test program runs its
+ *  tests from main() and finishes with Finish(). A failed check prints where
+ *  it was and what it checked, and the test carries on, so one run shows
+ *  every failure.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace NimbeLink::Tests
+{
+    namespace Detail
+    {
+        inline unsigned int checks = 0;
+        inline unsigned int failures = 0;
+        inline const char *current = "";
+    }
+
+    /**
+     * \brief Records a check
+     *
+     * \param passed
+     *      Whether or not the check passed
+     * \param *expression
+     *      What was checked
+     * \param *file
+     *      The file the check is in
+     * \param line
+     *      The line the check is on
+     *
+     * \return bool
+     *      Whether or not the check passed
+     */
+    inline bool Check(bool passed, const char *expression, const char *file, int line)
+    {
+        Detail::checks++;
+
+        if (!passed)
+        {
+            Detail::failures++;
+
+            fprintf(stderr, "%s:%d: %s: check failed: %s\n", file, line, Detail::current, expression);
+        }
+
+        return passed;
+    }
+
+    /**
+     * \brief Runs a test
+     *
+     * \param *name
+     *      The test's name
+     * \param test
+     *      The test
+     *
+     * \return none
+     */
+    template <typename Test>
+    void Run(const char *name, Test test)
+    {
+        unsigned int failures = Detail::failures;
+
+        Detail::current = name;
+
+        test();
+
+        printf("%s %s\n", (Detail::failures == failures) ? "PASS" : "FAIL", name);
+        fflush(stdout);
+    }
+
+    /**
+     * \brief Reports how the tests went and exits
+     *
+     *  Threads the code under test started never return, the same as on the
+     *  device, so this exits without waiting on them or destroying anything
+     *  they may still be using.
+     *
+     * \param none
+     *
+     * \return none
+     */
+    [[noreturn]] inline void Finish(void)
+    {
+        printf("%u checks, %u failed\n", Detail::checks, Detail::failures);
+
+        fflush(stdout);
+        fflush(stderr);
+
+        std::_Exit((Detail::failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+}
+
+#define TEST_CHECK(expression) \
+    NimbeLink::Tests::Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
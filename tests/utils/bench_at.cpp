@@ -0,0 +1,278 @@
+/**
+ * \file
+ *
+ * \brief Measures the AT response parser
+ *
+ *  Times parsing the cell widget's responses, walking a long %NCELLMEAS line
+ *  and splitting a response into lines as it arrives in pieces. The widget's
+ *  signal and operator parsing is also timed the way it was done before the
+ *  parser, with strtok() and atoi() on a copy of the response, since strtok()
+ *  writes to what it parses. The number of times to run each can be given as
+ *  the only argument:
+ *
+ *      utils_bench_at [runs]
+ *
+ *  ctest runs a short pass to keep this building and working; run it by hand
+ *  with an optimized build and more runs for numbers worth comparing.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#include <kernel.h>
+
+#include "examples/utils.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples::Utils;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    static constexpr const char Response[] = "+CESQ: 99,99,255,255,20,45\r\n+COPS: 0,2,\"310410\",7\r\nOK\r\n";
+
+    static constexpr const char Neighbors[] =
+        " 0,\"00011B07\",\"26295\",\"00B7\",65535,5300,371,54,-5,3620,"
+        "5300,123,46,-10,12,6400,310,38,-14,18,5300,77,41,-12,25,6400,12,30,-17,31";
+
+    // Keeps the compiler from throwing away what's being measured
+    volatile int32_t sink;
+
+    /**
+     * \brief What a parse found out
+     */
+    struct Sample
+    {
+        int32_t rsrp;
+        int32_t rsrq;
+        char plmn[8];
+    };
+
+    /**
+     * \brief Parses the signal and operator with the parser
+     *
+     * \param &sample
+     *      Where to put what was found
+     *
+     * \return none
+     */
+    void Parse(Sample &sample)
+    {
+        At::Value signal[std::size(At::Cesq.fields)];
+        At::Value carrier[std::size(At::Cops.fields)];
+
+        if (At::Parse(Response, At::Cesq, signal) == static_cast<int>(std::size(signal)))
+        {
+            sample.rsrp = signal[0].integer;
+            sample.rsrq = signal[1].integer;
+        }
+
+        if (At::Parse(Response, At::Cops, carrier) == static_cast<int>(std::size(carrier)))
+        {
+            std::size_t length = std::min(std::size(carrier[0].text), sizeof(sample.plmn) - 1);
+
+            memcpy(sample.plmn, std::data(carrier[0].text), length);
+            sample.plmn[length] = '\0';
+        }
+    }
+
+    /**
+     * \brief Parses the signal and operator the way the widget used to
+     *
+     * \param &sample
+     *      Where to put what was found
+     *
+     * \return none
+     */
+    void ParseLegacy(Sample &sample)
+    {
+        char cesq[sizeof(Response)];
+        char cops[sizeof(Response)];
+
+        // The signal was the last two fields of the response, which was only
+        // the +CESQ line
+        memcpy(cesq, Response, strstr(Response, "\r\n") - Response);
+        cesq[strstr(Response, "\r\n") - Response] = '\0';
+
+        char *rsrp = nullptr;
+        char *rsrq = nullptr;
+
+        for (char *tok = strtok(cesq, ","); tok != nullptr; tok = strtok(nullptr, ","))
+        {
+            rsrq = rsrp;
+            rsrp = tok;
+        }
+
+        if ((rsrp != nullptr) && (rsrq != nullptr))
+        {
+            sample.rsrp = atoi(rsrp);
+            sample.rsrq = atoi(rsrq);
+        }
+
+        // The operator was whatever was in the first quotes
+        strcpy(cops, strstr(Response, "+COPS:"));
+
+        char *tok = strtok(cops, "\"");
+
+        if ((tok != nullptr) && ((tok = strtok(nullptr, "\"")) != nullptr))
+        {
+            strncpy(sample.plmn, tok, sizeof(sample.plmn) - 1);
+            sample.plmn[sizeof(sample.plmn) - 1] = '\0';
+        }
+    }
+
+    /**
+     * \brief Sums each neighbor cell's RSRP
+     *
+     * \param none
+     *
+     * \return int32_t
+     *      The sum
+     */
+    int32_t ReadNeighbors(void)
+    {
+        At::FieldReader reader(Neighbors);
+        std::string_view field;
+        int32_t sum = 0;
+
+        // The serving cell's fields
+        for (int i = 0; i < 10; i++)
+        {
+            reader.Next(field);
+        }
+
+        int32_t values[5];
+
+        while (reader.NextInteger(values[0]) &&
+            reader.NextInteger(values[1]) &&
+            reader.NextInteger(values[2]) &&
+            reader.NextInteger(values[3]) &&
+            reader.NextInteger(values[4]))
+        {
+            sum += values[2];
+        }
+
+        return sum;
+    }
+
+    /**
+     * \brief Splits the response into lines as it arrives in small pieces
+     *
+     * \param none
+     *
+     * \return int32_t
+     *      The number of lines
+     */
+    int32_t ReadLines(void)
+    {
+        static constexpr const std::size_t Piece = 12;
+
+        At::LineReader<32> reader;
+        std::string_view response(Response);
+        int32_t lines = 0;
+
+        auto handler = [&lines](std::string_view line, bool truncated) {
+            lines++;
+        };
+
+        for (std::size_t i = 0; i < std::size(response); i += Piece)
+        {
+            reader.Feed(response.substr(i, Piece), handler);
+        }
+
+        reader.Finish(handler);
+
+        return lines;
+    }
+
+    /**
+     * \brief Times a function and prints how long each call took
+     *
+     * \param *name
+     *      What's being measured
+     * \param runs
+     *      How many times to run it
+     * \param function
+     *      What to run
+     *
+     * \return none
+     */
+    template <typename Function>
+    void Measure(const char *name, uint32_t runs, Function function)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        for (uint32_t i = 0; i < runs; i++)
+        {
+            function();
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+        printf("%-32s %8.1f ns per call\n", name, static_cast<double>(elapsed.count()) / runs);
+    }
+}
+
+/**
+ * \brief Runs the measurements
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      Whether or not everything measured came up with the expected results
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t runs = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 1000000;
+
+    if (runs == 0)
+    {
+        runs = 1;
+    }
+
+    // Make sure everything's measuring what it should be
+    Sample sample = {};
+    Sample legacy = {};
+
+    Parse(sample);
+    ParseLegacy(legacy);
+
+    TEST_CHECK((sample.rsrp == 45) && (sample.rsrq == 20) && (strcmp(sample.plmn, "310410") == 0));
+    TEST_CHECK((legacy.rsrp == sample.rsrp) && (legacy.rsrq == sample.rsrq) && (strcmp(legacy.plmn, sample.plmn) == 0));
+    TEST_CHECK(ReadNeighbors() == (46 + 38 + 41 + 30));
+    TEST_CHECK(ReadLines() == 3);
+
+    Measure("Signal and operator", runs, [&sample](void) {
+        Parse(sample);
+
+        sink = sample.rsrp;
+    });
+
+    Measure("Signal and operator, strtok", runs, [&legacy](void) {
+        ParseLegacy(legacy);
+
+        sink = legacy.rsrp;
+    });
+
+    Measure("Neighbor cells", runs, [](void) {
+        sink = ReadNeighbors();
+    });
+
+    Measure("Lines in 12 byte pieces", runs, [](void) {
+        sink = ReadLines();
+    });
+
+    Finish();
+}
@@ -0,0 +1,301 @@
+/**
+ * \file
+ *
+ * \brief Fuzzes the AT response parser
+ *
+ *  Any input is treated as a response, and everything the parser finds has to
+ *  point back into it. A line reader's lines are checked against the
+ *  response's lines, whether the response is fed to it all at once, a byte at
+ *  a time or split at a point the input picks. A field reader has to find the
+ *  same fields as looking each of them up.
+ *
+ *  This builds with libFuzzer when the compiler is Clang, and otherwise with
+ *  support/fuzz_driver.cpp, which feeds it mutations of the corpus in
+ *  utils/corpus/at/.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/utils.h"
+
+using namespace NimbeLink::Examples::Utils;
+
+#define FUZZ_CHECK(expression) \
+    Check(static_cast<bool>(expression), #expression, __LINE__)
+
+namespace
+{
+    // A line reader's buffer, kept small so plenty of lines overflow it
+    static constexpr const std::size_t LineSize = 16;
+
+    // A line, and whether it was truncated
+    using Line = std::pair<std::string, bool>;
+
+    /**
+     * \brief Stops the run if a check failed
+     *
+     * \param passed
+     *      Whether or not the check passed
+     * \param *expression
+     *      What was checked
+     * \param line
+     *      The line the check is on
+     *
+     * \return none
+     */
+    void Check(bool passed, const char *expression, int line)
+    {
+        if (!passed)
+        {
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, line, expression);
+
+            std::abort();
+        }
+    }
+
+    /**
+     * \brief Checks that some text is part of the input
+     *
+     * \param text
+     *      The text
+     * \param input
+     *      The input
+     *
+     * \return bool
+     *      Whether or not the text is within the input
+     */
+    bool Within(std::string_view text, std::string_view input)
+    {
+        return (text.empty() ||
+            ((std::data(text) >= std::data(input)) &&
+            ((std::data(text) + std::size(text)) <= (std::data(input) + std::size(input)))));
+    }
+
+    /**
+     * \brief Parses the input with a format
+     *
+     * \param input
+     *      The input
+     * \param &format
+     *      The format
+     *
+     * \return none
+     */
+    template <std::size_t Count>
+    void CheckParse(std::string_view input, const At::Format<Count> &format)
+    {
+        At::Value values[Count];
+
+        int count = At::Parse(input, format, values);
+
+        FUZZ_CHECK((count >= -1) && (count <= static_cast<int>(Count)));
+
+        for (int i = 0; i < count; i++)
+        {
+            FUZZ_CHECK(Within(values[i].text, input));
+        }
+    }
+
+    /**
+     * \brief Checks that a field reader agrees with getting fields by index
+     *
+     * \param line
+     *      The line to read
+     *
+     * \return none
+     */
+    void CheckFields(std::string_view line)
+    {
+        At::FieldReader reader(line);
+
+        std::string_view field;
+        std::size_t index = 0;
+
+        while (reader.Next(field))
+        {
+            std::string_view expected;
+
+            FUZZ_CHECK(At::GetField(line, index, expected));
+            FUZZ_CHECK(field == expected);
+            FUZZ_CHECK(Within(field, line));
+
+            index++;
+
+            FUZZ_CHECK(index <= (std::size(line) + 1));
+        }
+
+        FUZZ_CHECK(!At::GetField(line, index, field));
+    }
+
+    /**
+     * \brief Gets the lines a line reader should hand out
+     *
+     * \param input
+     *      The input
+     * \param always
+     *      Whether every line is truncated to fit, as it is when each one is
+     *      split across pieces, rather than only an unfinished last line
+     *
+     * \return std::vector<Line>
+     *      The lines
+     */
+    std::vector<Line> Expected(std::string_view input, bool always)
+    {
+        std::vector<Line> lines;
+
+        while (!input.empty())
+        {
+            std::size_t end = input.find_first_of("\r\n");
+
+            std::string_view line = input.substr(0, end);
+
+            if (!line.empty())
+            {
+                bool truncated = (always || (end == std::string_view::npos)) && (std::size(line) > LineSize);
+
+                lines.emplace_back(std::string(truncated ? line.substr(0, LineSize) : line), truncated);
+            }
+
+            if (end == std::string_view::npos)
+            {
+                break;
+            }
+
+            input.remove_prefix(end + 1);
+        }
+
+        return lines;
+    }
+
+    /**
+     * \brief Feeds the input to a line reader in pieces
+     *
+     * \param input
+     *      The input
+     * \param piece
+     *      How big each piece is, which is 0 for the whole input at once
+     *
+     * \return std::vector<Line>
+     *      The lines the reader handed out
+     */
+    std::vector<Line> Read(std::string_view input, std::size_t piece)
+    {
+        At::LineReader<LineSize> reader;
+        std::vector<Line> lines;
+
+        auto handler = [&lines](std::string_view line, bool truncated) {
+            FUZZ_CHECK(!truncated || (std::size(line) == LineSize));
+
+            lines.emplace_back(std::string(line), truncated);
+        };
+
+        if (piece == 0)
+        {
+            reader.Feed(input, handler);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < std::size(input); i += piece)
+            {
+                reader.Feed(input.substr(i, piece), handler);
+            }
+        }
+
+        reader.Finish(handler);
+
+        return lines;
+    }
+}
+
+/**
+ * \brief Checks the parser with one input
+ *
+ * \param *data
+ *      The input
+ * \param size
+ *      The input's size
+ *
+ * \return int
+ *      Always 0
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, std::size_t size)
+{
+    std::string_view input(reinterpret_cast<const char *>(data), size);
+
+    CheckParse(input, At::Cesq);
+    CheckParse(input, At::CesqNotification);
+    CheckParse(input, At::Cops);
+    CheckParse(input, At::Cereg);
+    CheckParse(input, At::CeregQuery);
+    CheckParse(input, At::Xmonitor);
+
+    // Every line's fields, rather than just the ones with a known prefix
+    for (const Line &line : Expected(input, false))
+    {
+        if (!line.second)
+        {
+            CheckFields(line.first);
+        }
+    }
+
+    std::string_view line;
+
+    if (At::FindLine(input, At::Ncellmeas, line))
+    {
+        FUZZ_CHECK(Within(line, input));
+
+        CheckFields(line);
+    }
+
+    FUZZ_CHECK(Read(input, 0) == Expected(input, false));
+    FUZZ_CHECK(Read(input, 1) == Expected(input, true));
+
+    // Pieces somewhere in between, which leave some lines whole and split
+    // others
+    if (size > 0)
+    {
+        std::size_t piece = 1 + (data[0] % (LineSize * 2));
+
+        std::vector<Line> lines = Read(input, piece);
+        std::vector<Line> whole = Expected(input, false);
+
+        FUZZ_CHECK(std::size(lines) == std::size(whole));
+
+        for (std::size_t i = 0; i < std::min(std::size(lines), std::size(whole)); i++)
+        {
+            const std::string &expected = whole[i].first;
+
+            // Either it was handed out whole, or it was cut to fit, which an
+            // unfinished last line always is
+            if (whole[i].second)
+            {
+                FUZZ_CHECK(lines[i] == whole[i]);
+            }
+            else if (lines[i].second)
+            {
+                FUZZ_CHECK(std::size(expected) > LineSize);
+                FUZZ_CHECK(lines[i].first == expected.substr(0, LineSize));
+            }
+            else
+            {
+                FUZZ_CHECK(lines[i].first == expected);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,342 @@
+/**
+ * \file
+ *
+ * \brief Tests the AT response parser
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/utils.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples::Utils;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    // A line a LineReader handed out, and whether it was truncated
+    using Line = std::pair<std::string, bool>;
+
+    /**
+     * \brief Feeds a response to a line reader in pieces
+     *
+     * \param &reader
+     *      The line reader
+     * \param response
+     *      The response
+     * \param &splits
+     *      Where to split the response, in order
+     *
+     * \return std::vector<Line>
+     *      The lines handed out
+     */
+    template <std::size_t Size>
+    std::vector<Line> Feed(At::LineReader<Size> &reader, std::string_view response, const std::vector<std::size_t> &splits)
+    {
+        std::vector<Line> lines;
+
+        auto handler = [&lines](std::string_view line, bool truncated) {
+            lines.emplace_back(std::string(line), truncated);
+        };
+
+        std::size_t start = 0;
+
+        for (std::size_t split : splits)
+        {
+            reader.Feed(response.substr(start, split - start), handler);
+
+            start = split;
+        }
+
+        reader.Feed(response.substr(start), handler);
+        reader.Finish(handler);
+
+        return lines;
+    }
+}
+
+/**
+ * \brief Checks finding a response's line by its prefix
+ */
+static void TestFindLine(void)
+{
+    std::string_view line;
+
+    static constexpr const std::string_view Response = "+CESQ: 99,99,255,255,20,45\r\n+COPS: 0,2,\"310410\",7\r\nOK";
+
+    TEST_CHECK(At::FindLine(Response, "+CESQ:", line) && (line == " 99,99,255,255,20,45"));
+    TEST_CHECK(At::FindLine(Response, "+COPS:", line) && (line == " 0,2,\"310410\",7"));
+    TEST_CHECK(At::FindLine(Response, "OK", line) && line.empty());
+
+    // Prefixes only count at the start of a line
+    TEST_CHECK(!At::FindLine(Response, "0,2", line));
+    TEST_CHECK(!At::FindLine("x+CESQ: 1", "+CESQ:", line));
+
+    // Bare line feeds, bare carriage returns and blank lines all separate
+    // lines
+    TEST_CHECK(At::FindLine("\n\n+CEREG: 1\n", "+CEREG:", line) && (line == " 1"));
+    TEST_CHECK(At::FindLine("+CESQ: 1\r+CEREG: 5", "+CEREG:", line) && (line == " 5"));
+
+    TEST_CHECK(!At::FindLine("", "+CESQ:", line));
+    TEST_CHECK(!At::FindLine("+CES", "+CESQ:", line));
+
+    // It works at compile time too
+    static_assert(At::Trim("  a b  ") == "a b");
+}
+
+/**
+ * \brief Checks splitting a line into fields
+ */
+static void TestFields(void)
+{
+    std::string_view field;
+
+    static constexpr const std::string_view Line = " 1, \"a,b\" ,,\"\",\"x\"y, 7 ";
+
+    TEST_CHECK(At::GetField(Line, 0, field) && (field == "1"));
+
+    // Commas in quotes don't split fields, and the quotes come off
+    TEST_CHECK(At::GetField(Line, 1, field) && (field == "a,b"));
+
+    // Empty fields are still fields
+    TEST_CHECK(At::GetField(Line, 2, field) && field.empty());
+    TEST_CHECK(At::GetField(Line, 3, field) && field.empty());
+
+    // Only quotes around the whole field come off
+    TEST_CHECK(At::GetField(Line, 4, field) && (field == "\"x\"y"));
+
+    TEST_CHECK(At::GetField(Line, 5, field) && (field == "7"));
+    TEST_CHECK(!At::GetField(Line, 6, field));
+
+    // An unclosed quote runs to the end of the line
+    TEST_CHECK(At::GetField("1,\"a,b", 1, field) && (field == "\"a,b"));
+    TEST_CHECK(!At::GetField("1,\"a,b", 2, field));
+
+    // A lone quote isn't a quoted empty field
+    TEST_CHECK(At::GetField("\"", 0, field) && (field == "\""));
+
+    TEST_CHECK(At::GetField("", 0, field) && field.empty());
+    TEST_CHECK(!At::GetField("", 1, field));
+}
+
+/**
+ * \brief Checks converting fields to numbers
+ */
+static void TestIntegers(void)
+{
+    int32_t value = 0;
+
+    TEST_CHECK(At::ToInteger(" 42 ", value) && (value == 42));
+    TEST_CHECK(At::ToInteger("-140", value) && (value == -140));
+    TEST_CHECK(At::ToInteger("2147483647", value) && (value == 2147483647));
+    TEST_CHECK(At::ToInteger("0A0B", value, 16) && (value == 0x0A0B));
+    TEST_CHECK(At::ToInteger("7fffffff", value, 16) && (value == 0x7FFFFFFF));
+
+    // Anything that isn't entirely a number that fits is turned away
+    TEST_CHECK(!At::ToInteger("", value));
+    TEST_CHECK(!At::ToInteger("   ", value));
+    TEST_CHECK(!At::ToInteger("12a", value));
+    TEST_CHECK(!At::ToInteger("+12", value));
+    TEST_CHECK(!At::ToInteger("1 2", value));
+    TEST_CHECK(!At::ToInteger("2147483648", value));
+    TEST_CHECK(!At::ToInteger("-2147483649", value));
+    TEST_CHECK(!At::ToInteger("0x1F", value, 16));
+    TEST_CHECK(!At::ToInteger("FFFFFFFF", value, 16));
+}
+
+/**
+ * \brief Checks parsing whole responses with the formats
+ */
+static void TestParse(void)
+{
+    At::Value cesq[std::size(At::Cesq.fields)];
+
+    TEST_CHECK(At::Parse("+CESQ: 99,99,255,255,20,45\r\nOK", At::Cesq, cesq) == 2);
+    TEST_CHECK((cesq[0].integer == 45) && (cesq[1].integer == 20));
+
+    // Missing and bad fields stop the parse at the first one, so earlier
+    // fields can still be used
+    TEST_CHECK(At::Parse("+CESQ: 99,99,255,255", At::Cesq, cesq) == 0);
+    TEST_CHECK(At::Parse("+CESQ: 99,99,255,255,x,45", At::Cesq, cesq) == 1);
+    TEST_CHECK(cesq[0].integer == 45);
+    TEST_CHECK(At::Parse("+CESQ: 99,99,255,255,20,", At::Cesq, cesq) == 0);
+
+    TEST_CHECK(At::Parse("ERROR", At::Cesq, cesq) == -1);
+
+    At::Value cops[std::size(At::Cops.fields)];
+
+    TEST_CHECK(At::Parse("+COPS: 0,2,\"310410\",7", At::Cops, cops) == 1);
+    TEST_CHECK(cops[0].text == "310410");
+
+    // Not registered, so there's no operator
+    TEST_CHECK(At::Parse("+COPS: 0", At::Cops, cops) == 0);
+
+    At::Value cereg[1];
+
+    TEST_CHECK(At::Parse("+CEREG: 5,\"0A0B\",\"01234567\",7", At::Cereg, cereg) == 1);
+    TEST_CHECK(cereg[0].integer == 5);
+    TEST_CHECK(At::Parse("+CEREG: 1,2,\"0A0B\",\"01234567\",7", At::CeregQuery, cereg) == 1);
+    TEST_CHECK(cereg[0].integer == 2);
+    TEST_CHECK(At::Parse("+CEREG: 2", At::CeregQuery, cereg) == 0);
+
+    At::Value monitor[std::size(At::Xmonitor.fields)];
+
+    TEST_CHECK(At::Parse(
+        "%XMONITOR: 1,\"EDAV\",\"EDAV\",\"26295\",\"00B7\",7,20,\"00011B07\",7,2300,63,39,\"\",\"11100000\",\"11100000\",\"00000000\"",
+        At::Xmonitor,
+        monitor
+    ) == 8);
+
+    TEST_CHECK(monitor[0].integer == 1);
+    TEST_CHECK(monitor[1].text == "26295");
+    TEST_CHECK(monitor[2].integer == 0xB7);
+    TEST_CHECK(monitor[3].integer == 20);
+    TEST_CHECK(monitor[4].integer == 0x11B07);
+    TEST_CHECK(monitor[5].integer == 2300);
+    TEST_CHECK(monitor[6].integer == 63);
+    TEST_CHECK(monitor[7].integer == 39);
+
+    // Only the status when we aren't registered
+    TEST_CHECK(At::Parse("%XMONITOR: 2", At::Xmonitor, monitor) == 1);
+}
+
+/**
+ * \brief Checks walking a line's fields one at a time
+ */
+static void TestFieldReader(void)
+{
+    At::FieldReader reader(" 0,\"a,b\",, 12 ,\"x\"");
+    std::string_view field;
+    int32_t value;
+
+    TEST_CHECK(reader.NextInteger(value) && (value == 0));
+    TEST_CHECK(reader.Next(field) && (field == "a,b"));
+    TEST_CHECK(reader.Next(field) && field.empty());
+    TEST_CHECK(reader.NextInteger(value) && (value == 12));
+    TEST_CHECK(reader.Next(field) && (field == "x"));
+    TEST_CHECK(!reader.Next(field));
+    TEST_CHECK(!reader.Next(field));
+
+    // A trailing comma leaves an empty last field
+    At::FieldReader trailing("1,");
+
+    TEST_CHECK(trailing.Next(field) && (field == "1"));
+    TEST_CHECK(trailing.Next(field) && field.empty());
+    TEST_CHECK(!trailing.Next(field));
+
+    // An empty line is one empty field
+    At::FieldReader empty("");
+
+    TEST_CHECK(empty.Next(field) && field.empty());
+    TEST_CHECK(!empty.Next(field));
+
+    // A field that isn't a number is still used up
+    At::FieldReader bad("x,2");
+
+    TEST_CHECK(!bad.NextInteger(value));
+    TEST_CHECK(bad.NextInteger(value) && (value == 2));
+}
+
+/**
+ * \brief Checks that a line reader hands out the same lines wherever a
+ *        response is split
+ */
+static void TestLineReaderSplits(void)
+{
+    static constexpr const std::string_view Response = "+CESQ: 99,99,255,255,20,45\r\n\r\n+COPS: 0,2,\"310410\",7\r\nOK\r\n";
+
+    const std::vector<Line> expected = {
+        {"+CESQ: 99,99,255,255,20,45", false},
+        {"+COPS: 0,2,\"310410\",7", false},
+        {"OK", false},
+    };
+
+    At::LineReader<32> reader;
+
+    TEST_CHECK(Feed(reader, Response, {}) == expected);
+
+    // Every place one split can go, including between the \r and the \n
+    for (std::size_t i = 0; i <= std::size(Response); i++)
+    {
+        TEST_CHECK(Feed(reader, Response, {i}) == expected);
+    }
+
+    // Every place two splits can go, which covers pieces with no line break
+    // at all
+    for (std::size_t i = 0; i <= std::size(Response); i++)
+    {
+        for (std::size_t j = i; j <= std::size(Response); j++)
+        {
+            TEST_CHECK(Feed(reader, Response, {i, j}) == expected);
+        }
+    }
+
+    // A byte at a time
+    std::vector<std::size_t> bytes;
+
+    for (std::size_t i = 1; i < std::size(Response); i++)
+    {
+        bytes.push_back(i);
+    }
+
+    TEST_CHECK(Feed(reader, Response, bytes) == expected);
+
+    // A last line without a line break is handed out when finishing
+    TEST_CHECK(Feed(reader, "OK", {1}) == std::vector<Line>({{"OK", false}}));
+    TEST_CHECK(Feed(reader, "\r\n\r\n", {1, 3}).empty());
+}
+
+/**
+ * \brief Checks that a line reader flags lines that don't fit
+ */
+static void TestLineReaderTruncation(void)
+{
+    At::LineReader<8> reader;
+
+    // A line that fits exactly isn't truncated, even when split
+    TEST_CHECK(Feed(reader, "12345678\r\n", {4}) == std::vector<Line>({{"12345678", false}}));
+
+    // One that's too long keeps what fits, and the next line isn't affected
+    TEST_CHECK(Feed(reader, "123456789\r\nOK\r\n", {4}) == std::vector<Line>({{"12345678", true}, {"OK", false}}));
+
+    // Without a line break at all, it's still flagged when finishing
+    TEST_CHECK(Feed(reader, "1234567890", {2, 9}) == std::vector<Line>({{"12345678", true}}));
+
+    // Overflowing exactly at a piece boundary still flags it
+    TEST_CHECK(Feed(reader, "12345678X\n", {8, 9}) == std::vector<Line>({{"12345678", true}}));
+
+    // Lines that never needed copying are handed out whole, however long
+    TEST_CHECK(Feed(reader, "1234567890\r\n", {}) == std::vector<Line>({{"1234567890", false}}));
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param none
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(void)
+{
+    Run("FindLine", TestFindLine);
+    Run("Fields", TestFields);
+    Run("Integers", TestIntegers);
+    Run("Parse", TestParse);
+    Run("FieldReader", TestFieldReader);
+    Run("LineReaderSplits", TestLineReaderSplits);
+    Run("LineReaderTruncation", TestLineReaderTruncation);
+
+    Finish();
+}
@@ -0,0 +1,287 @@
+/**
+ * \file
+ *
+ * \brief Stress tests the sequence lock with one writer and several readers
+ *
+ *  The writer publishes a struct whose fields all follow from one counter as
+ *  fast as it can, and readers check that every snapshot they get is whole
+ *  and never older than the last one they got. Some readers give up the CPU
+ *  in the middle of reading, so the writer often gets around to overwriting
+ *  what they're reading. The number of readers and
+ *  writes can be given as arguments:
+ *
+ *      utils_seqlock [readers] [writes]
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <kernel.h>
+
+#include "examples/utils.h"
+#include "support/test.h"
+
+using namespace NimbeLink::Examples;
+using namespace NimbeLink::Tests;
+
+namespace
+{
+    /**
+     * \brief Data whose fields all follow from its count
+     *
+     *  It's big enough that copying it takes a while, which gives the writer
+     *  plenty of chances to land in the middle of a read.
+     */
+    struct Data
+    {
+        uint32_t count;
+        uint32_t words[63];
+
+        /**
+         * \brief Fills in the fields for a count
+         *
+         * \param count
+         *      The count
+         *
+         * \return none
+         */
+        void Set(uint32_t count)
+        {
+            this->count = count;
+
+            for (std::size_t i = 0; i < std::size(this->words); i++)
+            {
+                this->words[i] = (count * 2654435761U) + i;
+            }
+        }
+
+        /**
+         * \brief Checks that every field follows from the count
+         *
+         * \param preempt
+         *      Whether to give up the CPU halfway through, the way a reader
+         *      on the device can be preempted
+         *
+         * \return bool
+         *      Whether or not the data is whole
+         */
+        bool IsWhole(bool preempt = false) const
+        {
+            uint32_t count = this->count;
+
+            for (std::size_t i = 0; i < std::size(this->words); i++)
+            {
+                if (preempt && (i == (std::size(this->words) / 2)))
+                {
+                    std::this_thread::yield();
+                }
+
+                if (this->words[i] != ((count * 2654435761U) + i))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    /**
+     * \brief What a reader saw
+     */
+    struct Results
+    {
+        uint64_t reads = 0;
+        uint64_t torn = 0;
+        uint64_t backwards = 0;
+    };
+
+    /**
+     * \brief Reads snapshots until the writer's done, checking each one
+     *
+     * \param &lock
+     *      The lock to read from
+     * \param &done
+     *      Whether or not the writer's done
+     * \param inPlace
+     *      Whether to read in place rather than take whole copies
+     * \param &results
+     *      What the reader saw
+     *
+     * \return none
+     */
+    void Reader(const Utils::SeqLock<Data> &lock, const std::atomic<bool> &done, bool inPlace, Results &results)
+    {
+        uint32_t last = 0;
+
+        while (!done.load(std::memory_order_relaxed))
+        {
+            uint32_t count;
+            bool whole;
+
+            if (inPlace)
+            {
+                // Only the checks come out, so nothing's copied, and the
+                // writer gets plenty of chances to lap the reader
+                auto checked = lock.Read([](const Data &data) {
+                    return std::pair<uint32_t, bool>(data.count, data.IsWhole(true));
+                });
+
+                count = checked.first;
+                whole = checked.second;
+            }
+            else
+            {
+                Data data = lock.Read();
+
+                count = data.count;
+                whole = data.IsWhole();
+            }
+
+            results.reads++;
+
+            if (!whole)
+            {
+                results.torn++;
+            }
+
+            if (count < last)
+            {
+                results.backwards++;
+            }
+
+            last = count;
+        }
+    }
+}
+
+/**
+ * \brief Checks that readers only ever see whole, current snapshots
+ *
+ * \param readers
+ *      How many readers to run
+ * \param writes
+ *      How many writes to make
+ *
+ * \return none
+ */
+static void TestStress(uint32_t readers, uint32_t writes)
+{
+    Data initial;
+    initial.Set(0);
+
+    Utils::SeqLock<Data> lock(initial);
+    std::atomic<bool> done = false;
+
+    std::vector<Results> results(readers);
+    std::vector<std::thread> threads;
+
+    // Half the readers take copies and half read in place
+    for (uint32_t i = 0; i < readers; i++)
+    {
+        threads.emplace_back(Reader, std::cref(lock), std::cref(done), (i % 2) != 0, std::ref(results[i]));
+    }
+
+    // Half the writes are whole and half are changes in place
+    for (uint32_t count = 1; count <= writes; count++)
+    {
+        if ((count % 2) != 0)
+        {
+            Data data;
+            data.Set(count);
+
+            lock.Write(data);
+        }
+        else
+        {
+            lock.Update([](Data &data) {
+                data.Set(data.count + 1);
+            });
+        }
+    }
+
+    done = true;
+
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    uint64_t reads = 0;
+
+    for (const Results &result : results)
+    {
+        TEST_CHECK(result.torn == 0);
+        TEST_CHECK(result.backwards == 0);
+
+        reads += result.reads;
+    }
+
+    TEST_CHECK(reads > 0);
+
+    Data last = lock.Read();
+
+    TEST_CHECK((last.count == writes) && last.IsWhole());
+
+    printf("%u writes, %llu reads by %u readers\n",
+        static_cast<unsigned int>(writes),
+        static_cast<unsigned long long>(reads),
+        static_cast<unsigned int>(readers)
+    );
+}
+
+/**
+ * \brief Checks what readers see before anything's written
+ */
+static void TestInitial(void)
+{
+    Utils::SeqLock<Data> zeroed;
+
+    TEST_CHECK(zeroed.Read().count == 0);
+    TEST_CHECK(zeroed.Read([](const Data &data) { return data.words[62]; }) == 0);
+
+    Data initial;
+    initial.Set(7);
+
+    Utils::SeqLock<Data> lock(initial);
+
+    TEST_CHECK((lock.Read().count == 7) && lock.Read().IsWhole());
+
+    // Changes start from what's current
+    lock.Update([](Data &data) { data.Set(data.count + 1); });
+    lock.Update([](Data &data) { data.Set(data.count + 1); });
+
+    TEST_CHECK((lock.Read().count == 9) && lock.Read().IsWhole());
+}
+
+/**
+ * \brief Runs the tests
+ *
+ * \param argc
+ *      The number of arguments
+ * \param *argv[]
+ *      The arguments
+ *
+ * \return int
+ *      The tests' status
+ */
+int main(int argc, char *argv[])
+{
+    uint32_t readers = (argc > 1) ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 4;
+    uint32_t writes = (argc > 2) ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 10)) : 1000000;
+
+    Run("Initial", TestInitial);
+    Run("Stress", [readers, writes](void) { TestStress(readers, writes); });
+
+    Finish();
+}
@@ -0,0 +1,19 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for nRF Connect's AT command library
+ *
+ *  Commands themselves go through the secure AT service, which
+ *  support/modem.cpp stands in for, so this only needs setting up.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+int at_cmd_init(void);
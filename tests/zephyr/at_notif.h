@@ -0,0 +1,23 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for nRF Connect's AT notification library
+ *
+ *  Notifications come from the scripted modem in support/modem.cpp.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+typedef void (*at_notif_handler_t)(void *context, const char *response);
+
+int at_notif_init(void);
+
+int at_notif_register_handler(void *context, at_notif_handler_t handler);
+int at_notif_deregister_handler(void *context, at_notif_handler_t handler);
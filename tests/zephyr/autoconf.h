@@ -0,0 +1,219 @@
+/**
+ * \file
+ *
+ * \brief The configuration values the host tests build with
+ *
+ *  This takes the place of the autoconf.h Kconfig generates, with each value
+ *  defaulting to what examples/Kconfig defaults it to. Tests turn options on
+ *  and override values with compile definitions, and, as with Kconfig, a
+ *  boolean option that isn't defined is off.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+////////////////////////////////////////////////////////////////
+//
+// Zephyr
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC
+#define CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC          32768000
+#endif
+
+#ifndef CONFIG_UART_CONSOLE_ON_DEV_NAME
+#define CONFIG_UART_CONSOLE_ON_DEV_NAME             "UART_1"
+#endif
+
+////////////////////////////////////////////////////////////////
+//
+// Console
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_ASYNC_CONSOLE_BUFFER_SIZE
+#define CONFIG_ASYNC_CONSOLE_BUFFER_SIZE            1024
+#endif
+
+#ifndef CONFIG_ASYNC_CONSOLE_LOOPBACK_BAUD
+#define CONFIG_ASYNC_CONSOLE_LOOPBACK_BAUD          115200
+#endif
+
+#ifndef CONFIG_ASYNC_CONSOLE_METRICS_RATE
+#define CONFIG_ASYNC_CONSOLE_METRICS_RATE           60
+#endif
+
+////////////////////////////////////////////////////////////////
+//
+// AT service
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_AT_SERVICE_QUEUE_DEPTH
+#define CONFIG_AT_SERVICE_QUEUE_DEPTH               8
+#endif
+
+#ifndef CONFIG_AT_SERVICE_RESPONSE_SIZE
+#define CONFIG_AT_SERVICE_RESPONSE_SIZE             256
+#endif
+
+#ifndef CONFIG_AT_SERVICE_METRICS_RATE
+#define CONFIG_AT_SERVICE_METRICS_RATE              60
+#endif
+
+#ifndef CONFIG_AT_SERVICE_CACHE_CFUN_TTL
+#define CONFIG_AT_SERVICE_CACHE_CFUN_TTL            300
+#endif
+
+#ifndef CONFIG_AT_SERVICE_CACHE_CEREG_TTL
+#define CONFIG_AT_SERVICE_CACHE_CEREG_TTL           60
+#endif
+
+#ifndef CONFIG_AT_SERVICE_CACHE_COPS_TTL
+#define CONFIG_AT_SERVICE_CACHE_COPS_TTL            60
+#endif
+
+#ifndef CONFIG_AT_SERVICE_CACHE_SIMSELECT_TTL
+#define CONFIG_AT_SERVICE_CACHE_SIMSELECT_TTL       3600
+#endif
+
+#ifndef CONFIG_AT_BACKEND_REPLAY_TRANSCRIPT
+#define CONFIG_AT_BACKEND_REPLAY_TRANSCRIPT         "at_transcript.h"
+#endif
+
+#ifndef CONFIG_AT_BACKEND_REPLAY_SCALE
+#define CONFIG_AT_BACKEND_REPLAY_SCALE              100
+#endif
+
+////////////////////////////////////////////////////////////////
+//
+// Dashboard
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_DASHBOARD_UPDATE_RATE
+#define CONFIG_DASHBOARD_UPDATE_RATE                5
+#endif
+
+#ifndef CONFIG_DASHBOARD_X
+#define CONFIG_DASHBOARD_X                          3
+#endif
+
+#ifndef CONFIG_DASHBOARD_Y
+#define CONFIG_DASHBOARD_Y                          3
+#endif
+
+#ifndef CONFIG_DASHBOARD_W
+#define CONFIG_DASHBOARD_W                          20
+#endif
+
+#ifndef CONFIG_DASHBOARD_H
+#define CONFIG_DASHBOARD_H                          5
+#endif
+
+#ifndef CONFIG_DASHBOARD_FULL_REDRAW_RATE
+#define CONFIG_DASHBOARD_FULL_REDRAW_RATE           12
+#endif
+
+#ifndef CONFIG_DASHBOARD_BENCHMARK_FRAMES
+#define CONFIG_DASHBOARD_BENCHMARK_FRAMES           12
+#endif
+
+////////////////////////////////////////////////////////////////
+//
+// Cell
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_CELL_POLL_RATE
+#define CONFIG_CELL_POLL_RATE                       5
+#endif
+
+#ifndef CONFIG_CELL_FALLBACK_RATE
+#define CONFIG_CELL_FALLBACK_RATE                   300
+#endif
+
+#ifndef CONFIG_CELL_EXTENDED_RATE
+#define CONFIG_CELL_EXTENDED_RATE                   60
+#endif
+
+#ifndef CONFIG_CELL_NEIGHBORS
+#define CONFIG_CELL_NEIGHBORS                       4
+#endif
+
+#ifndef CONFIG_CELL_HISTORY_DEPTH
+#define CONFIG_CELL_HISTORY_DEPTH                   128
+#endif
+
+#ifndef CONFIG_CELL_HISTORY_SHORT_WINDOW
+#define CONFIG_CELL_HISTORY_SHORT_WINDOW            60
+#endif
+
+#ifndef CONFIG_CELL_HISTORY_LONG_WINDOW
+#define CONFIG_CELL_HISTORY_LONG_WINDOW             600
+#endif
+
+////////////////////////////////////////////////////////////////
+//
+// Socket
+//
+////////////////////////////////////////////////////////////////
+
+#ifndef CONFIG_SOCKET_POST_RATE
+#define CONFIG_SOCKET_POST_RATE                     120
+#endif
+
+#ifndef CONFIG_SOCKET_GROUP_WINDOW
+#define CONFIG_SOCKET_GROUP_WINDOW                  10
+#endif
+
+#ifndef CONFIG_SOCKET_HOST
+#define CONFIG_SOCKET_HOST                          "localhost"
+#endif
+
+#ifndef CONFIG_SOCKET_PORT
+#define CONFIG_SOCKET_PORT                          80
+#endif
+
+#ifndef CONFIG_SOCKET_COAP_BLOCK_SIZE
+#define CONFIG_SOCKET_COAP_BLOCK_SIZE               256
+#endif
+
+#ifndef CONFIG_SOCKET_CONNECT_TIMEOUT
+#define CONFIG_SOCKET_CONNECT_TIMEOUT               30000
+#endif
+
+#ifndef CONFIG_SOCKET_SEND_TIMEOUT
+#define CONFIG_SOCKET_SEND_TIMEOUT                  10000
+#endif
+
+#ifndef CONFIG_SOCKET_RESPONSE_TIMEOUT
+#define CONFIG_SOCKET_RESPONSE_TIMEOUT              10000
+#endif
+
+#ifndef CONFIG_SOCKET_NETWORK_TIMEOUT
+#define CONFIG_SOCKET_NETWORK_TIMEOUT               10000
+#endif
+
+#ifndef CONFIG_SOCKET_DNS_TTL
+#define CONFIG_SOCKET_DNS_TTL                       3600
+#endif
+
+#ifndef CONFIG_SOCKET_QUEUE_DEPTH
+#define CONFIG_SOCKET_QUEUE_DEPTH                   8
+#endif
+
+#ifndef CONFIG_SOCKET_QUEUE_BATCH
+#define CONFIG_SOCKET_QUEUE_BATCH                   4
+#endif
+
+#ifndef CONFIG_SOCKET_HEARTBEAT_RATE
+#define CONFIG_SOCKET_HEARTBEAT_RATE                3600
+#endif
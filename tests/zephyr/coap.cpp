@@ -0,0 +1,244 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for Zephyr's CoAP library
+ *
+ *  Messages are encoded as RFC 7252 and RFC 7959 lay them out, which is what
+ *  Zephyr's library produces.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <cerrno>
+#include <cstring>
+
+#include <net/coap.h>
+
+namespace
+{
+    /**
+     * \brief Appends bytes to a packet
+     *
+     * \param *cpkt
+     *      The packet
+     * \param *data
+     *      The bytes
+     * \param length
+     *      The number of bytes
+     *
+     * \return 0
+     *      Success
+     * \return -EINVAL
+     *      The bytes don't fit
+     */
+    int Append(struct coap_packet *cpkt, const uint8_t *data, uint16_t length)
+    {
+        if ((cpkt->offset + length) > cpkt->max_len)
+        {
+            return -EINVAL;
+        }
+
+        memcpy(&cpkt->data[cpkt->offset], data, length);
+
+        cpkt->offset += length;
+
+        return 0;
+    }
+
+    /**
+     * \brief Splits an option delta or length into its nibble and extended
+     *        bytes
+     *
+     * \param value
+     *      The delta or length
+     * \param *extended
+     *      Where to put the extended bytes
+     * \param *count
+     *      Where to put the number of extended bytes
+     *
+     * \return uint8_t
+     *      The nibble
+     */
+    uint8_t Encode(uint16_t value, uint8_t *extended, uint8_t *count)
+    {
+        if (value < 13)
+        {
+            *count = 0;
+
+            return static_cast<uint8_t>(value);
+        }
+
+        if (value < 269)
+        {
+            extended[0] = static_cast<uint8_t>(value - 13);
+            *count = 1;
+
+            return 13;
+        }
+
+        value -= 269;
+
+        extended[0] = static_cast<uint8_t>(value >> 8);
+        extended[1] = static_cast<uint8_t>(value);
+        *count = 2;
+
+        return 14;
+    }
+}
+
+int coap_packet_init(
+    struct coap_packet *cpkt,
+    uint8_t *data,
+    uint16_t max_len,
+    uint8_t ver,
+    uint8_t type,
+    uint8_t token_len,
+    const uint8_t *token,
+    uint8_t code,
+    uint16_t id
+)
+{
+    if ((cpkt == nullptr) || (data == nullptr) || (token_len > COAP_TOKEN_MAX_LEN))
+    {
+        return -EINVAL;
+    }
+
+    cpkt->data = data;
+    cpkt->offset = 0;
+    cpkt->max_len = max_len;
+    cpkt->delta = 0;
+    cpkt->opt_len = 0;
+
+    const uint8_t header[] = {
+        static_cast<uint8_t>(((ver & 0x03) << 6) | ((type & 0x03) << 4) | (token_len & 0x0F)),
+        code,
+        static_cast<uint8_t>(id >> 8),
+        static_cast<uint8_t>(id),
+    };
+
+    int err = Append(cpkt, header, sizeof(header));
+
+    if ((err == 0) && (token_len > 0))
+    {
+        err = Append(cpkt, token, token_len);
+    }
+
+    cpkt->hdr_len = static_cast<uint8_t>(cpkt->offset);
+
+    return err;
+}
+
+int coap_packet_append_option(struct coap_packet *cpkt, uint16_t code, const uint8_t *value, uint16_t len)
+{
+    // Options are delta encoded, so they have to be added in order
+    if (code < cpkt->delta)
+    {
+        return -EINVAL;
+    }
+
+    uint8_t header[5];
+    uint8_t deltaCount;
+    uint8_t lengthCount;
+
+    uint8_t delta = Encode(code - cpkt->delta, &header[1], &deltaCount);
+    uint8_t length = Encode(len, &header[1 + deltaCount], &lengthCount);
+
+    header[0] = static_cast<uint8_t>((delta << 4) | length);
+
+    uint16_t start = cpkt->offset;
+
+    int err = Append(cpkt, header, 1 + deltaCount + lengthCount);
+
+    if ((err == 0) && (len > 0))
+    {
+        err = Append(cpkt, value, len);
+    }
+
+    if (err != 0)
+    {
+        return err;
+    }
+
+    cpkt->opt_len += cpkt->offset - start;
+    cpkt->delta = code;
+
+    return 0;
+}
+
+int coap_append_option_int(struct coap_packet *cpkt, uint16_t code, unsigned int val)
+{
+    // Integers take as few bytes as they need, with 0 taking none
+    uint8_t data[4];
+    uint16_t length = 0;
+
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        if ((length > 0) || ((val >> shift) & 0xFF))
+        {
+            data[length++] = static_cast<uint8_t>(val >> shift);
+        }
+    }
+
+    return coap_packet_append_option(cpkt, code, data, length);
+}
+
+int coap_packet_append_payload_marker(struct coap_packet *cpkt)
+{
+    static constexpr const uint8_t Marker = 0xFF;
+
+    return Append(cpkt, &Marker, 1);
+}
+
+int coap_packet_append_payload(struct coap_packet *cpkt, const uint8_t *payload, uint16_t payload_len)
+{
+    return Append(cpkt, payload, payload_len);
+}
+
+uint16_t coap_header_get_id(const struct coap_packet *cpkt)
+{
+    return static_cast<uint16_t>((cpkt->data[2] << 8) | cpkt->data[3]);
+}
+
+uint16_t coap_next_id(void)
+{
+    static uint16_t id;
+
+    return ++id;
+}
+
+uint8_t *coap_next_token(void)
+{
+    static uint8_t token[COAP_TOKEN_MAX_LEN];
+    static uint32_t count;
+
+    count++;
+
+    memset(token, 0, sizeof(token));
+    memcpy(token, &count, sizeof(count));
+
+    return token;
+}
+
+int coap_block_transfer_init(struct coap_block_context *ctx, enum coap_block_size block_size, size_t total_size)
+{
+    ctx->block_size = block_size;
+    ctx->total_size = total_size;
+    ctx->current = 0;
+
+    return 0;
+}
+
+int coap_append_block1_option(struct coap_packet *cpkt, struct coap_block_context *ctx)
+{
+    uint16_t bytes = coap_block_size_to_bytes(ctx->block_size);
+
+    // NUM | M | SZX
+    unsigned int value = ((ctx->current / bytes) << 4) | (((ctx->current + bytes) < ctx->total_size) << 3) | ctx->block_size;
+
+    return coap_append_option_int(cpkt, COAP_OPTION_BLOCK1, value);
+}
@@ -0,0 +1,24 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for Zephyr's device model
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct device
+{
+    const char *name;
+};
+
+struct device *device_get_binding(const char *name);
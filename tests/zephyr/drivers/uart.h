@@ -0,0 +1,21 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for Zephyr's UART API
+ *
+ *  Only polled output is stood in for. The console's UART writes to wherever
+ *  printk() output goes, as it would on the board.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <device.h>
+
+void uart_poll_out(struct device *dev, unsigned char out_char);
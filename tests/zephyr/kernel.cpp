@@ -0,0 +1,330 @@
+/**
+ * \file
+ *
+ * \brief Host stand-ins for the parts of the Zephyr kernel, device and UART
+ *        APIs the examples use
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <device.h>
+#include <drivers/uart.h>
+#include <kernel.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // When we started, which uptime counts from
+    const Clock::time_point start = Clock::now();
+
+    // Stands in for interrupts being locked out
+    std::recursive_mutex interrupts;
+
+    // Serializes output, so lines from different threads don't mix
+    std::recursive_mutex output;
+
+    // Where printk() output goes, if something has taken it over
+    int (*hook)(int c) = nullptr;
+
+    /**
+     * \brief A counting semaphore
+     */
+    struct Semaphore
+    {
+        std::mutex lock;
+        std::condition_variable available;
+        unsigned int count;
+        unsigned int limit;
+    };
+
+    /**
+     * \brief Gets a timeout as a host duration
+     *
+     * \param timeout
+     *      The timeout, in milliseconds
+     *
+     * \return std::chrono::milliseconds
+     *      The timeout
+     */
+    std::chrono::milliseconds ToDuration(int32_t timeout)
+    {
+        return std::chrono::milliseconds(timeout);
+    }
+
+    /**
+     * \brief Writes a character to wherever printk() output goes
+     *
+     * \param c
+     *      The character
+     * \param *context
+     *      Unused
+     *
+     * \return int
+     *      The character
+     */
+    int Output(int c, void *context)
+    {
+        (void)context;
+
+        if (hook != nullptr)
+        {
+            return hook(c);
+        }
+
+        return fputc(c, stdout);
+    }
+}
+
+int32_t k_sleep(int32_t duration)
+{
+    if (duration > 0)
+    {
+        std::this_thread::sleep_for(ToDuration(duration));
+    }
+
+    return 0;
+}
+
+void k_yield(void)
+{
+    std::this_thread::yield();
+}
+
+int64_t k_uptime_get(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+uint32_t k_uptime_get_32(void)
+{
+    return static_cast<uint32_t>(k_uptime_get());
+}
+
+uint32_t k_cycle_get_32(void)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    return static_cast<uint32_t>((elapsed * (CONFIG_SYS_CLOCK_HW_CYCLES_PER_SEC / 1000000)) / 1000);
+}
+
+k_tid_t k_thread_create(
+    struct k_thread *thread,
+    struct _k_thread_stack_element *stack,
+    size_t size,
+    k_thread_entry_t entry,
+    void *p1,
+    void *p2,
+    void *p3,
+    int priority,
+    uint32_t options,
+    int32_t delay
+)
+{
+    (void)stack;
+    (void)size;
+    (void)priority;
+    (void)options;
+
+    // Threads run until the test exits, like they run until the device resets
+    std::thread([=](void) {
+        k_sleep(delay);
+
+        entry(p1, p2, p3);
+    }).detach();
+
+    return thread;
+}
+
+void k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit)
+{
+    sem->impl = new Semaphore{{}, {}, initial, limit};
+}
+
+int k_sem_take(struct k_sem *sem, int32_t timeout)
+{
+    Semaphore &semaphore = *static_cast<Semaphore *>(sem->impl);
+
+    std::unique_lock<std::mutex> lock(semaphore.lock);
+
+    auto available = [&semaphore](void) {
+        return (semaphore.count > 0);
+    };
+
+    if (timeout == K_FOREVER)
+    {
+        semaphore.available.wait(lock, available);
+    }
+    else if (!semaphore.available.wait_for(lock, ToDuration(timeout), available))
+    {
+        return -EAGAIN;
+    }
+
+    semaphore.count--;
+
+    return 0;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+    Semaphore &semaphore = *static_cast<Semaphore *>(sem->impl);
+
+    std::lock_guard<std::mutex> lock(semaphore.lock);
+
+    if (semaphore.count < semaphore.limit)
+    {
+        semaphore.count++;
+    }
+
+    semaphore.available.notify_one();
+}
+
+void k_mutex_init(struct k_mutex *mutex)
+{
+    mutex->impl = new std::recursive_timed_mutex();
+}
+
+int k_mutex_lock(struct k_mutex *mutex, int32_t timeout)
+{
+    auto &lock = *static_cast<std::recursive_timed_mutex *>(mutex->impl);
+
+    if (timeout == K_FOREVER)
+    {
+        lock.lock();
+
+        return 0;
+    }
+
+    return lock.try_lock_for(ToDuration(timeout)) ? 0 : -EAGAIN;
+}
+
+int k_mutex_unlock(struct k_mutex *mutex)
+{
+    static_cast<std::recursive_timed_mutex *>(mutex->impl)->unlock();
+
+    return 0;
+}
+
+unsigned int irq_lock(void)
+{
+    interrupts.lock();
+
+    return 0;
+}
+
+void irq_unlock(unsigned int key)
+{
+    (void)key;
+
+    interrupts.unlock();
+}
+
+void k_timer_init(struct k_timer *timer, k_timer_expiry_t expiry, k_timer_stop_t stop)
+{
+    (void)stop;
+
+    timer->expiry = expiry;
+}
+
+void k_timer_start(struct k_timer *timer, int32_t duration, int32_t period)
+{
+    (void)period;
+
+    // Expiry functions run in interrupt context on the device, which is
+    // locked out by irq_lock()
+    std::thread([timer, duration](void) {
+        k_sleep(duration);
+
+        std::lock_guard<std::recursive_mutex> lock(interrupts);
+
+        timer->expiry(timer);
+    }).detach();
+}
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler)
+{
+    work->work.handler = handler;
+}
+
+int k_delayed_work_submit(struct k_delayed_work *work, int32_t delay)
+{
+    std::thread([work, delay](void) {
+        k_sleep(delay);
+
+        work->work.handler(&work->work);
+    }).detach();
+
+    return 0;
+}
+
+void printk(const char *format, ...)
+{
+    va_list list;
+
+    va_start(list, format);
+    z_vprintk(Output, nullptr, format, list);
+    va_end(list);
+}
+
+int z_vprintk(int (*out)(int c, void *context), void *context, const char *format, va_list list)
+{
+    char buffer[512];
+
+    int length = vsnprintf(buffer, sizeof(buffer), format, list);
+
+    if (length < 0)
+    {
+        return length;
+    }
+
+    length = std::min(length, static_cast<int>(sizeof(buffer) - 1));
+
+    std::lock_guard<std::recursive_mutex> lock(output);
+
+    for (int i = 0; i < length; i++)
+    {
+        out(buffer[i], context);
+    }
+
+    return length;
+}
+
+extern "C" void __printk_hook_install(int (*fn)(int c))
+{
+    hook = fn;
+}
+
+struct device *device_get_binding(const char *name)
+{
+    // The console's UART is the only device there is
+    static struct device console = {CONFIG_UART_CONSOLE_ON_DEV_NAME};
+
+    if ((name == nullptr) || (strcmp(name, console.name) != 0))
+    {
+        return nullptr;
+    }
+
+    return &console;
+}
+
+void uart_poll_out(struct device *dev, unsigned char out_char)
+{
+    (void)dev;
+
+    std::lock_guard<std::recursive_mutex> lock(output);
+
+    Output(out_char, nullptr);
+}
@@ -0,0 +1,216 @@
+/**
+ * \file
+ *
+ * \brief Host stand-ins for the parts of the Zephyr kernel API the examples
+ *        use
+ *
+ *  Threads are real host threads, semaphores and mutexes are built on the
+ *  standard library's, and time is the host's monotonic clock, so code under
+ *  test runs concurrently the way it does on the device.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////
+//
+// Helpers
+//
+////////////////////////////////////////////////////////////////
+
+#define BIT(n)                      (1UL << (n))
+
+#define __ASSERT(test, ...)         ((void)(test))
+#define __ASSERT_NO_MSG(test)       ((void)(test))
+
+////////////////////////////////////////////////////////////////
+//
+// Time
+//
+////////////////////////////////////////////////////////////////
+
+#define K_NO_WAIT                   0
+#define K_FOREVER                   (-1)
+#define K_MSEC(ms)                  (ms)
+#define K_SECONDS(s)                K_MSEC((s) * 1000)
+
+int32_t k_sleep(int32_t duration);
+void k_yield(void);
+
+int64_t k_uptime_get(void);
+uint32_t k_uptime_get_32(void);
+
+uint32_t k_cycle_get_32(void);
+
+////////////////////////////////////////////////////////////////
+//
+// Threads
+//
+////////////////////////////////////////////////////////////////
+
+#define STACK_ALIGN                 8
+#define MPU_GUARD_ALIGN_AND_SIZE    0
+
+#define K_LOWEST_APPLICATION_THREAD_PRIO    14
+
+struct _k_thread_stack_element
+{
+    char data;
+};
+
+#define K_THREAD_STACK_DEFINE(name, size) \
+    struct _k_thread_stack_element name[size]
+
+struct k_thread
+{
+    void *impl;
+};
+
+typedef struct k_thread *k_tid_t;
+
+typedef void (*k_thread_entry_t)(void *p1, void *p2, void *p3);
+
+k_tid_t k_thread_create(
+    struct k_thread *thread,
+    struct _k_thread_stack_element *stack,
+    size_t size,
+    k_thread_entry_t entry,
+    void *p1,
+    void *p2,
+    void *p3,
+    int priority,
+    uint32_t options,
+    int32_t delay
+);
+
+////////////////////////////////////////////////////////////////
+//
+// Synchronization
+//
+////////////////////////////////////////////////////////////////
+
+struct k_sem
+{
+    void *impl;
+};
+
+void k_sem_init(struct k_sem *sem, unsigned int initial, unsigned int limit);
+int k_sem_take(struct k_sem *sem, int32_t timeout);
+void k_sem_give(struct k_sem *sem);
+
+struct k_mutex
+{
+    void *impl;
+};
+
+void k_mutex_init(struct k_mutex *mutex);
+int k_mutex_lock(struct k_mutex *mutex, int32_t timeout);
+int k_mutex_unlock(struct k_mutex *mutex);
+
+// There's no interrupt context off of the device, so this just keeps
+// everything else that locks out of the way
+unsigned int irq_lock(void);
+void irq_unlock(unsigned int key);
+
+typedef long atomic_t;
+typedef atomic_t atomic_val_t;
+
+#define ATOMIC_INIT(value)          (value)
+
+static inline atomic_val_t atomic_get(const atomic_t *target)
+{
+    return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *target, atomic_val_t value)
+{
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_or(atomic_t *target, atomic_val_t value)
+{
+    return __atomic_fetch_or(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_add(atomic_t *target, atomic_val_t value)
+{
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_inc(atomic_t *target)
+{
+    return atomic_add(target, 1);
+}
+
+////////////////////////////////////////////////////////////////
+//
+// Timers and work
+//
+////////////////////////////////////////////////////////////////
+
+struct k_timer;
+
+typedef void (*k_timer_expiry_t)(struct k_timer *timer);
+typedef void (*k_timer_stop_t)(struct k_timer *timer);
+
+struct k_timer
+{
+    void *impl;
+    k_timer_expiry_t expiry;
+    void *user_data;
+};
+
+void k_timer_init(struct k_timer *timer, k_timer_expiry_t expiry, k_timer_stop_t stop);
+void k_timer_start(struct k_timer *timer, int32_t duration, int32_t period);
+
+static inline void k_timer_user_data_set(struct k_timer *timer, void *data)
+{
+    timer->user_data = data;
+}
+
+static inline void *k_timer_user_data_get(struct k_timer *timer)
+{
+    return timer->user_data;
+}
+
+struct k_work;
+
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work
+{
+    k_work_handler_t handler;
+};
+
+struct k_delayed_work
+{
+    struct k_work work;
+    void *impl;
+};
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler);
+int k_delayed_work_submit(struct k_delayed_work *work, int32_t delay);
+
+////////////////////////////////////////////////////////////////
+//
+// Printing
+//
+////////////////////////////////////////////////////////////////
+
+void printk(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+int z_vprintk(int (*out)(int c, void *context), void *context, const char *format, va_list list);
+
+extern "C" void __printk_hook_install(int (*fn)(int c));
@@ -0,0 +1,123 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for Zephyr's CoAP library
+ *
+ *  Only what the socket widget's CoAP transport uses is here, with the same
+ *  names, values and encoding as Zephyr's.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define COAP_VERSION_1              1U
+#define COAP_TOKEN_MAX_LEN          8UL
+
+#define COAP_MAKE_RESPONSE_CODE(clas, det) ((clas << 5) | (det))
+
+enum coap_msgtype
+{
+    COAP_TYPE_CON       = 0,
+    COAP_TYPE_NON_CON   = 1,
+    COAP_TYPE_ACK       = 2,
+    COAP_TYPE_RESET     = 3,
+};
+
+enum coap_method
+{
+    COAP_METHOD_GET     = 1,
+    COAP_METHOD_POST    = 2,
+    COAP_METHOD_PUT     = 3,
+    COAP_METHOD_DELETE  = 4,
+};
+
+enum coap_response_code
+{
+    COAP_RESPONSE_CODE_OK                   = COAP_MAKE_RESPONSE_CODE(2, 0),
+    COAP_RESPONSE_CODE_CREATED              = COAP_MAKE_RESPONSE_CODE(2, 1),
+    COAP_RESPONSE_CODE_CHANGED              = COAP_MAKE_RESPONSE_CODE(2, 4),
+    COAP_RESPONSE_CODE_CONTINUE             = COAP_MAKE_RESPONSE_CODE(2, 31),
+    COAP_RESPONSE_CODE_BAD_REQUEST          = COAP_MAKE_RESPONSE_CODE(4, 0),
+    COAP_RESPONSE_CODE_INTERNAL_ERROR       = COAP_MAKE_RESPONSE_CODE(5, 0),
+};
+
+enum coap_option_num
+{
+    COAP_OPTION_URI_PATH        = 11,
+    COAP_OPTION_CONTENT_FORMAT  = 12,
+    COAP_OPTION_BLOCK1          = 27,
+};
+
+enum coap_content_format
+{
+    COAP_CONTENT_FORMAT_TEXT_PLAIN  = 0,
+    COAP_CONTENT_FORMAT_APP_CBOR    = 60,
+};
+
+enum coap_block_size
+{
+    COAP_BLOCK_16,
+    COAP_BLOCK_32,
+    COAP_BLOCK_64,
+    COAP_BLOCK_128,
+    COAP_BLOCK_256,
+    COAP_BLOCK_512,
+    COAP_BLOCK_1024,
+};
+
+struct coap_packet
+{
+    uint8_t *data;
+    uint16_t offset;
+    uint16_t max_len;
+    uint8_t hdr_len;
+    uint16_t opt_len;
+    uint16_t delta;
+};
+
+struct coap_block_context
+{
+    size_t total_size;
+    size_t current;
+    enum coap_block_size block_size;
+};
+
+static inline uint16_t coap_block_size_to_bytes(enum coap_block_size block_size)
+{
+    return (1 << (block_size + 4));
+}
+
+int coap_packet_init(
+    struct coap_packet *cpkt,
+    uint8_t *data,
+    uint16_t max_len,
+    uint8_t ver,
+    uint8_t type,
+    uint8_t token_len,
+    const uint8_t *token,
+    uint8_t code,
+    uint16_t id
+);
+
+int coap_packet_append_option(struct coap_packet *cpkt, uint16_t code, const uint8_t *value, uint16_t len);
+int coap_append_option_int(struct coap_packet *cpkt, uint16_t code, unsigned int val);
+
+int coap_packet_append_payload_marker(struct coap_packet *cpkt);
+int coap_packet_append_payload(struct coap_packet *cpkt, const uint8_t *payload, uint16_t payload_len);
+
+uint16_t coap_header_get_id(const struct coap_packet *cpkt);
+
+uint16_t coap_next_id(void);
+uint8_t *coap_next_token(void);
+
+int coap_block_transfer_init(struct coap_block_context *ctx, enum coap_block_size block_size, size_t total_size);
+int coap_append_block1_option(struct coap_packet *cpkt, struct coap_block_context *ctx);
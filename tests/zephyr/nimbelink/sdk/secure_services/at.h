@@ -0,0 +1,41 @@
+/**
+ * \file
+ *
+ * \brief Host stand-in for the Skywire Nano SDK's secure AT service
+ *
+ *  Tests that run AT commands link in support/modem.cpp, which answers them
+ *  from a scripted modem.
+ *
+ * (C) NimbeLink Corp. 2020
+ *
+ * All rights reserved except as explicitly granted in the license agreement
+ * between NimbeLink Corp. and the designated licensee.  No other use or
+ * disclosure of this software is permitted. Portions of this software may be
+ * subject to third party license terms as specified in this software, and such
+ * portions are excluded from the preceding copyright notice of NimbeLink Corp.
+ */
+#pragma once
+
+#include <cstdint>
+
+namespace NimbeLink::Sdk::SecureServices::At
+{
+    using Result = int32_t;
+
+    union Error
+    {
+        int32_t cmeError;
+        int32_t cmsError;
+        int32_t extendedCmeError;
+    };
+
+    int32_t RunCommand(
+        Result *result,
+        Error *error,
+        const char *command,
+        uint32_t commandLength,
+        char *response,
+        uint32_t responseLength,
+        uint32_t *responseLengthActual
+    );
+}